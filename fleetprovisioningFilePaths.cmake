@@ -7,7 +7,22 @@
 
 # Fleet Provisioning library source files.
 set( FLEET_PROVISIONING_SOURCES
-     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning.c" )
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_parser.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_pem.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_serializer.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_session.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_session_pool.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_timer_wheel.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_rate_limiter.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_concurrency.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_correlator.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_shard.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_schedule.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_dedup.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_perf.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_binary_log.c"
+     "${CMAKE_CURRENT_LIST_DIR}/source/fleet_provisioning_histogram.c" )
 
 # Fleet Provisioning library public include directories.
 set( FLEET_PROVISIONING_INCLUDE_PUBLIC_DIRS
@@ -35,6 +35,12 @@
 /* Fleet Provisioning API include. */
 #include "fleet_provisioning.h"
 
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/* Fleet Provisioning binary log include. */
+#include "fleet_provisioning_binary_log.h"
+
 /**
  * @brief Identifier for which of the topic suffixes for a given format and
  * Fleet Provisioning MQTT API.
@@ -61,6 +67,50 @@ typedef enum
     TopicInvalidFormatSuffix
 } TopicFormatSuffix_t;
 
+/**
+ * @brief Number of topics of each API in #FleetProvisioningTopic_t: the
+ * publish, accepted and rejected topics.
+ */
+#define TOPICS_PER_API    ( 3U )
+
+/**
+ * @brief The 32-bit FNV prime.
+ */
+#define FNV1A_PRIME       ( 16777619U )
+
+/**
+ * @brief Value in #FleetProvisioningTopic_t of the topic of a format, API
+ * and kind, as #FleetProvisioning_GetTopicInfo reads it.
+ */
+#define TOPIC_VALUE( format, api, kind )                                        \
+    ( ( ( ( ( uint32_t ) ( format ) * FP_API_COUNT ) + ( uint32_t ) ( api ) ) * \
+        TOPICS_PER_API ) + ( uint32_t ) ( kind ) + 1U )
+
+/**
+ * @brief Fails to compile if #FleetProvisioningTopic_t is reordered: each
+ * format must list the publish, accepted and rejected topics of each API, in
+ * the order of #FleetProvisioningFormat_t, #FleetProvisioningApi_t and
+ * #FleetProvisioningApiTopics_t.
+ */
+typedef char TopicLayoutCheck_t[ ( ( ( uint32_t ) FleetProvJsonCreateCertFromCsrPublish == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonCreateCertFromCsrAccepted == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonCreateCertFromCsrRejected == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningRejected ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonCreateKeysAndCertPublish == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonCreateKeysAndCertAccepted == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonCreateKeysAndCertRejected == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningRejected ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonRegisterThingPublish == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningRegisterThingApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonRegisterThingAccepted == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningRegisterThingApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvJsonRegisterThingRejected == TOPIC_VALUE( FleetProvisioningJson, FleetProvisioningRegisterThingApi, FleetProvisioningRejected ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateCertFromCsrPublish == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateCertFromCsrAccepted == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateCertFromCsrRejected == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningRejected ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateKeysAndCertPublish == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateKeysAndCertAccepted == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvCborCreateKeysAndCertRejected == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningCreateKeysAndCertApi, FleetProvisioningRejected ) ) &&
+                                 ( ( uint32_t ) FleetProvCborRegisterThingPublish == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningRegisterThingApi, FleetProvisioningPublish ) ) &&
+                                 ( ( uint32_t ) FleetProvCborRegisterThingAccepted == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningRegisterThingApi, FleetProvisioningAccepted ) ) &&
+                                 ( ( uint32_t ) FleetProvCborRegisterThingRejected == TOPIC_VALUE( FleetProvisioningCbor, FleetProvisioningRegisterThingApi, FleetProvisioningRejected ) ) ) ? 1 : -1 ];
+
 /**
  * @brief Get the topic length for a given RegisterThing topic.
  *
@@ -303,6 +353,14 @@ static FleetProvisioningStatus_t GetRegisterThingTopicCheckParams( const char *
                     ( const void * ) pTemplateName,
                     ( unsigned int ) templateNameLength,
                     ( const void * ) pOutLength ) );
+        FP_BINARY_LOG( FleetProvisioningLogGetRegisterThingTopicBadParameter,
+                       FP_BINARY_LOG_POINTER( pTopicBuffer ),
+                       format,
+                       topic,
+                       FP_BINARY_LOG_POINTER( pTemplateName ),
+                       templateNameLength,
+                       FP_BINARY_LOG_POINTER( pOutLength ) );
+        FP_TRACE_PROBE( get_register_thing_topic_bad_parameter, pTopicBuffer, pTemplateName );
     }
     else
     {
@@ -643,10 +701,13 @@ FleetProvisioningStatus_t FleetProvisioning_GetRegisterThingTopic( char * pTopic
                                                                    uint16_t templateNameLength,
                                                                    uint16_t * pOutLength )
 {
+    FP_PERF_START( perfStart )
     FleetProvisioningStatus_t status = FleetProvisioningError;
     uint16_t topicLength = 0U;
     char * pBufferCursor = pTopicBuffer;
 
+    FP_TRACE_PROBE( get_register_thing_topic_entry, format, topic );
+
     status = GetRegisterThingTopicCheckParams( pTopicBuffer,
                                                format,
                                                topic,
@@ -666,6 +727,14 @@ FleetProvisioningStatus_t FleetProvisioning_GetRegisterThingTopic( char * pTopic
                         "Provided buffer size: %u, Required buffer size: %u.",
                         ( unsigned int ) bufferLength,
                         ( unsigned int ) topicLength ) );
+            FP_BINARY_LOG( FleetProvisioningLogGetRegisterThingTopicBufferTooSmall,
+                           bufferLength,
+                           topicLength,
+                           0U,
+                           0U,
+                           0U,
+                           0U );
+            FP_TRACE_PROBE( get_register_thing_topic_buffer_too_small, bufferLength, topicLength );
         }
     }
 
@@ -722,6 +791,9 @@ FleetProvisioningStatus_t FleetProvisioning_GetRegisterThingTopic( char * pTopic
         *pOutLength = topicLength;
     }
 
+    FP_TRACE_PROBE( get_register_thing_topic_return, status, topicLength );
+    FP_PERF_RECORD( FleetProvisioningPerfGetRegisterThingTopic, status, perfStart );
+
     return status;
 }
 /*-----------------------------------------------------------*/
@@ -730,14 +802,25 @@ FleetProvisioningStatus_t FleetProvisioning_MatchTopic( const char * pTopic,
                                                         uint16_t topicLength,
                                                         FleetProvisioningTopic_t * pOutApi )
 {
+    FP_PERF_START( perfStart )
     FleetProvisioningStatus_t ret = FleetProvisioningNoMatch;
 
+    FP_TRACE_PROBE( match_topic_entry, pTopic, topicLength );
+
     if( ( pTopic == NULL ) || ( pOutApi == NULL ) )
     {
         ret = FleetProvisioningBadParameter;
         LogError( ( "Invalid input parameter. pTopic: %p, pOutApi: %p.",
                     ( const void * ) pTopic,
                     ( void * ) pOutApi ) );
+        FP_BINARY_LOG( FleetProvisioningLogMatchTopicBadParameter,
+                       FP_BINARY_LOG_POINTER( pTopic ),
+                       FP_BINARY_LOG_POINTER( pOutApi ),
+                       0U,
+                       0U,
+                       0U,
+                       0U );
+        FP_TRACE_PROBE( match_topic_bad_parameter, pTopic, pOutApi );
     }
     else
     {
@@ -756,9 +839,66 @@ FleetProvisioningStatus_t FleetProvisioning_MatchTopic( const char * pTopic,
         if( *pOutApi != FleetProvisioningInvalidTopic )
         {
             ret = FleetProvisioningSuccess;
+            FP_TRACE_PROBE( match_topic_matched, *pOutApi, topicLength );
         }
+        else
+        {
+            FP_TRACE_PROBE( match_topic_no_match, pTopic, topicLength );
+        }
+
+        FP_PERF_RECORD_TOPIC( *pOutApi );
     }
 
+    FP_TRACE_PROBE( match_topic_return, ret, topicLength );
+    FP_PERF_RECORD( FleetProvisioningPerfMatchTopic, ret, perfStart );
+
     return ret;
 }
 /*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetTopicInfo( FleetProvisioningTopic_t topic,
+                                                          FleetProvisioningTopicInfo_t * pOutInfo )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t index;
+
+    if( ( pOutInfo == NULL ) || ( topic == FleetProvisioningInvalidTopic ) ||
+        ( topic > FleetProvCborRegisterThingRejected ) )
+    {
+        LogError( ( "Invalid input parameter. topic: %d, pOutInfo: %p.",
+                    ( int ) topic,
+                    ( void * ) pOutInfo ) );
+    }
+    else
+    {
+        /* The inverse of TOPIC_VALUE. */
+        index = ( uint32_t ) topic - 1U;
+        pOutInfo->format = ( FleetProvisioningFormat_t ) ( index / ( FP_API_COUNT * TOPICS_PER_API ) );
+        pOutInfo->api = ( FleetProvisioningApi_t ) ( ( index / TOPICS_PER_API ) % FP_API_COUNT );
+        pOutInfo->kind = ( FleetProvisioningApiTopics_t ) ( index % TOPICS_PER_API );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetTopicInfo, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t FleetProvisioning_HashFnv1a( uint32_t hash,
+                                      const char * pData,
+                                      size_t length )
+{
+    uint32_t result = hash;
+    size_t i;
+
+    for( i = 0U; i < length; i++ )
+    {
+        result ^= ( uint32_t ) ( uint8_t ) pData[ i ];
+        result *= FNV1A_PRIME;
+    }
+
+    return result;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,193 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_binary_log.c
+ * @brief Implementation of the binary error log of the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Fleet Provisioning binary log include. */
+#include "fleet_provisioning_binary_log.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+#if ( FP_BINARY_LOG_SIZE == 0U ) || ( FP_BINARY_LOG_SIZE > 65536U ) || \
+    ( ( FP_BINARY_LOG_SIZE & ( FP_BINARY_LOG_SIZE - 1U ) ) != 0U )
+    #error "FP_BINARY_LOG_SIZE must be a power of two from 1 to 65536."
+#endif
+
+#if ( FP_ENABLE_BINARY_LOG != 0 )
+
+/**
+ * @brief The log set with #FleetProvisioning_BinaryLogSet.
+ */
+    static FleetProvisioningBinaryLog_t * pBinaryLog = NULL;
+#endif
+
+/**
+ * @brief Copy a record of a log other threads may be writing to.
+ *
+ * @param[in] pRecord The record to copy.
+ * @param[out] pCopy The copy, with a sequence of 0 if the record was
+ * written while it was copied.
+ */
+static void copyRecord( const FleetProvisioningBinaryLogRecord_t * pRecord,
+                        FleetProvisioningBinaryLogRecord_t * pCopy );
+
+/*-----------------------------------------------------------*/
+
+static void copyRecord( const FleetProvisioningBinaryLogRecord_t * pRecord,
+                        FleetProvisioningBinaryLogRecord_t * pCopy )
+{
+    uint32_t sequence;
+
+    /* The record is read as a sequence lock: the arguments read between two
+     * reads of the same sequence are all from the write of that sequence. */
+    sequence = FP_ATOMIC_LOAD_ACQUIRE( &( pRecord->sequence ) );
+    pCopy->message = pRecord->message;
+    ( void ) memcpy( pCopy->args, pRecord->args, sizeof( pCopy->args ) );
+    FP_ATOMIC_THREAD_FENCE();
+
+    if( FP_ATOMIC_LOAD_ACQUIRE( &( pRecord->sequence ) ) != sequence )
+    {
+        sequence = 0U;
+    }
+
+    pCopy->sequence = sequence;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_BinaryLogInit( FleetProvisioningBinaryLog_t * pLog )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pLog == NULL )
+    {
+        LogError( ( "Invalid input parameter. pLog: %p.",
+                    ( void * ) pLog ) );
+    }
+    else
+    {
+        ( void ) memset( pLog, 0, sizeof( FleetProvisioningBinaryLog_t ) );
+        pLog->magic = FP_BINARY_LOG_MAGIC;
+        pLog->size = FP_BINARY_LOG_SIZE;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfBinaryLogInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_BinaryLogCopy( const FleetProvisioningBinaryLog_t * pLog,
+                                                           FleetProvisioningBinaryLog_t * pCopy )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    if( ( pLog == NULL ) || ( pCopy == NULL ) || ( pLog == pCopy ) )
+    {
+        LogError( ( "Invalid input parameter. pLog: %p, pCopy: %p.",
+                    ( const void * ) pLog,
+                    ( void * ) pCopy ) );
+    }
+    else
+    {
+        pCopy->magic = pLog->magic;
+        pCopy->size = pLog->size;
+        pCopy->next = FP_ATOMIC_LOAD_ACQUIRE( &( pLog->next ) );
+        pCopy->reserved = 0U;
+
+        for( i = 0U; i < FP_BINARY_LOG_SIZE; i++ )
+        {
+            copyRecord( &( pLog->records[ i ] ), &( pCopy->records[ i ] ) );
+        }
+
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfBinaryLogCopy, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+#if ( FP_ENABLE_BINARY_LOG != 0 )
+
+    void FleetProvisioning_BinaryLogSet( FleetProvisioningBinaryLog_t * pLog )
+    {
+        pBinaryLog = pLog;
+    }
+/*-----------------------------------------------------------*/
+
+    void FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMessage_t message,
+                                           uint64_t arg0,
+                                           uint64_t arg1,
+                                           uint64_t arg2,
+                                           uint64_t arg3,
+                                           uint64_t arg4,
+                                           uint64_t arg5 )
+    {
+        FleetProvisioningBinaryLog_t * pLog = pBinaryLog;
+        FleetProvisioningBinaryLogRecord_t * pRecord;
+        uint32_t ticket;
+
+        if( pLog != NULL )
+        {
+            /* Each writer takes its own record, so that writers never wait
+             * for each other. A writer only collides with another one if
+             * FP_BINARY_LOG_SIZE records are written while it writes. */
+            ticket = FP_ATOMIC_FETCH_ADD( &pLog->next, 1U );
+            pRecord = &( pLog->records[ ticket % FP_BINARY_LOG_SIZE ] );
+
+            /* A record with a sequence of 0 is skipped by decoders. The
+             * fence keeps the writes of the arguments after the sequence is
+             * cleared, so that #FleetProvisioning_BinaryLogCopy sees the
+             * sequence change if it reads any of them. The sequence also
+             * wraps to 0 once every 2^32 records. */
+            FP_ATOMIC_STORE_RELEASE( &pRecord->sequence, 0U );
+            FP_ATOMIC_THREAD_FENCE();
+            pRecord->message = ( uint32_t ) message;
+            pRecord->args[ 0 ] = arg0;
+            pRecord->args[ 1 ] = arg1;
+            pRecord->args[ 2 ] = arg2;
+            pRecord->args[ 3 ] = arg3;
+            pRecord->args[ 4 ] = arg4;
+            pRecord->args[ 5 ] = arg5;
+            FP_ATOMIC_STORE_RELEASE( &pRecord->sequence, ticket + 1U );
+        }
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* if ( FP_ENABLE_BINARY_LOG != 0 ) */
@@ -0,0 +1,293 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_concurrency.c
+ * @brief Implementation of the adaptive concurrency limit for the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning concurrency include. */
+#include "fleet_provisioning_concurrency.h"
+
+/* Fleet Provisioning parser include. */
+#include "fleet_provisioning_parser.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Status code of rejected responses when the request rate is too
+ * high.
+ */
+#define STATUS_CODE_TOO_MANY_REQUESTS      ( 429U )
+
+/**
+ * @brief Status code of rejected responses when the service is overloaded.
+ */
+#define STATUS_CODE_SERVICE_UNAVAILABLE    ( 503U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check whether a rejected response reports throttling.
+ *
+ * @param[in] format The format of the response.
+ * @param[in] pPayload The payload of the response.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return 1 if the status code of the response is a throttling one; 0
+ * otherwise, including for payloads without a readable status code.
+ */
+static uint8_t isThrottled( FleetProvisioningFormat_t format,
+                            const char * pPayload,
+                            size_t payloadLength );
+
+/**
+ * @brief Raise the limit for an accepted response.
+ *
+ * @param[in] pController The controller.
+ */
+static void increaseLimit( FleetProvisioningConcurrency_t * pController );
+
+/**
+ * @brief Cut the limit for a throttled response, unless the previous cut
+ * already covers it.
+ *
+ * @param[in] pController The controller.
+ */
+static void decreaseLimit( FleetProvisioningConcurrency_t * pController );
+
+/*-----------------------------------------------------------*/
+
+static uint8_t isThrottled( FleetProvisioningFormat_t format,
+                            const char * pPayload,
+                            size_t payloadLength )
+{
+    uint32_t statusCode = 0U;
+    uint8_t throttled = 0U;
+
+    if( ( FleetProvisioning_GetResponseStatusCode( pPayload, payloadLength, format,
+                                                   &statusCode ) == FleetProvisioningSuccess ) &&
+        ( ( statusCode == STATUS_CODE_TOO_MANY_REQUESTS ) ||
+          ( statusCode == STATUS_CODE_SERVICE_UNAVAILABLE ) ) )
+    {
+        throttled = 1U;
+    }
+
+    return throttled;
+}
+/*-----------------------------------------------------------*/
+
+static void increaseLimit( FleetProvisioningConcurrency_t * pController )
+{
+    if( pController->holdoff > 0U )
+    {
+        pController->holdoff--;
+    }
+
+    pController->acceptedCount++;
+
+    /* One step per round trip of the whole window. */
+    if( pController->acceptedCount >= pController->limit )
+    {
+        pController->acceptedCount = 0U;
+
+        if( pController->limit < pController->maxLimit )
+        {
+            pController->limit++;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void decreaseLimit( FleetProvisioningConcurrency_t * pController )
+{
+    uint32_t decrease;
+
+    if( pController->holdoff > 0U )
+    {
+        /* The request was sent before the last cut took effect. */
+        pController->holdoff--;
+    }
+    else
+    {
+        decrease = ( pController->limit * pController->decreasePercent ) / 100U;
+        decrease = ( decrease == 0U ) ? 1U : decrease;
+
+        if( ( pController->limit - decrease ) < pController->minLimit )
+        {
+            pController->limit = pController->minLimit;
+        }
+        else
+        {
+            pController->limit -= decrease;
+        }
+
+        pController->acceptedCount = 0U;
+        pController->holdoff = pController->inFlight;
+    }
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyInit( FleetProvisioningConcurrency_t * pController,
+                                                             const FleetProvisioningConcurrencyConfig_t * pConfig )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pController == NULL ) || ( pConfig == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pController: %p, pConfig: %p.",
+                    ( void * ) pController,
+                    ( const void * ) pConfig ) );
+    }
+    else if( ( pConfig->minLimit == 0U ) ||
+             ( pConfig->initialLimit < pConfig->minLimit ) ||
+             ( pConfig->maxLimit < pConfig->initialLimit ) ||
+             ( pConfig->maxLimit > FP_CONCURRENCY_MAX_LIMIT ) ||
+             ( pConfig->decreasePercent == 0U ) ||
+             ( pConfig->decreasePercent > 99U ) )
+    {
+        LogError( ( "Invalid concurrency limits. minLimit: %lu, initialLimit: %lu, maxLimit: %lu,"
+                    " decreasePercent: %lu.",
+                    ( unsigned long ) pConfig->minLimit,
+                    ( unsigned long ) pConfig->initialLimit,
+                    ( unsigned long ) pConfig->maxLimit,
+                    ( unsigned long ) pConfig->decreasePercent ) );
+    }
+    else
+    {
+        pController->limit = pConfig->initialLimit;
+        pController->minLimit = pConfig->minLimit;
+        pController->maxLimit = pConfig->maxLimit;
+        pController->decreasePercent = pConfig->decreasePercent;
+        pController->inFlight = 0U;
+        pController->acceptedCount = 0U;
+        pController->holdoff = 0U;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfConcurrencyInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyTryStart( FleetProvisioningConcurrency_t * pController )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pController == NULL )
+    {
+        LogError( ( "Invalid input parameter. pController: %p.", ( void * ) pController ) );
+    }
+    else if( pController->inFlight >= pController->limit )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else
+    {
+        pController->inFlight++;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfConcurrencyTryStart, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyFinish( FleetProvisioningConcurrency_t * pController )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pController == NULL )
+    {
+        LogError( ( "Invalid input parameter. pController: %p.", ( void * ) pController ) );
+    }
+    else
+    {
+        if( pController->inFlight > 0U )
+        {
+            pController->inFlight--;
+        }
+
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfConcurrencyFinish, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyOnResponse( FleetProvisioningConcurrency_t * pController,
+                                                                   FleetProvisioningTopic_t topic,
+                                                                   const char * pPayload,
+                                                                   size_t payloadLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+
+    if( pController == NULL )
+    {
+        LogError( ( "Invalid input parameter. pController: %p.", ( void * ) pController ) );
+    }
+    else
+    {
+        status = FleetProvisioning_GetTopicInfo( topic, &info );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        if( info.kind == FleetProvisioningAccepted )
+        {
+            increaseLimit( pController );
+        }
+        else if( info.kind == FleetProvisioningRejected )
+        {
+            if( isThrottled( info.format, pPayload, payloadLength ) == 1U )
+            {
+                decreaseLimit( pController );
+            }
+        }
+        else
+        {
+            status = FleetProvisioningNoMatch;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfConcurrencyOnResponse, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,363 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_correlator.c
+ * @brief Implementation of the response correlator for the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Fleet Provisioning correlator include. */
+#include "fleet_provisioning_correlator.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Queue of the requests of a format and API.
+ */
+#define QUEUE_INDEX( info )    ( ( ( uint32_t ) ( info ).format * FP_API_COUNT ) + ( uint32_t ) ( info ).api )
+
+#if ( FP_CORRELATOR_MAX_PENDING == 0U ) || ( FP_CORRELATOR_MAX_PENDING >= FP_CORRELATOR_INVALID_INDEX )
+    #error "FP_CORRELATOR_MAX_PENDING must be from 1 to 65534."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check whether the topic of a RegisterThing response names the
+ * template of a request.
+ *
+ * @param[in] pRequest The request.
+ * @param[in] pTopic The response topic, which is a RegisterThing topic.
+ * @param[in] topicLength The length of @p pTopic.
+ *
+ * @return 1 if the template names match; 0 otherwise.
+ */
+static uint8_t templateMatches( const FleetProvisioningPendingRequest_t * pRequest,
+                                const char * pTopic,
+                                uint16_t topicLength );
+
+/**
+ * @brief Unlink a request from its queue and return it to the free list.
+ *
+ * @param[in] pCorrelator The correlator.
+ * @param[in] queue The queue of the request.
+ * @param[in] previous The request before it in the queue, or
+ * #FP_CORRELATOR_INVALID_INDEX if it is the oldest.
+ * @param[in] index The request.
+ */
+static void removeRequest( FleetProvisioningCorrelator_t * pCorrelator,
+                           uint32_t queue,
+                           uint16_t previous,
+                           uint16_t index );
+
+/*-----------------------------------------------------------*/
+
+static uint8_t templateMatches( const FleetProvisioningPendingRequest_t * pRequest,
+                                const char * pTopic,
+                                uint16_t topicLength )
+{
+    uint8_t matches = 0U;
+    size_t end = ( size_t ) FP_REGISTER_API_LENGTH_PREFIX + pRequest->templateNameLength;
+
+    /* A matched RegisterThing topic is the prefix, the template name and
+     * the rest of the topic, starting with a slash. */
+    if( ( end < topicLength ) && ( pTopic[ end ] == '/' ) &&
+        ( memcmp( &( pTopic[ FP_REGISTER_API_LENGTH_PREFIX ] ), pRequest->pTemplateName,
+                  pRequest->templateNameLength ) == 0 ) )
+    {
+        matches = 1U;
+    }
+
+    return matches;
+}
+/*-----------------------------------------------------------*/
+
+static void removeRequest( FleetProvisioningCorrelator_t * pCorrelator,
+                           uint32_t queue,
+                           uint16_t previous,
+                           uint16_t index )
+{
+    uint16_t next = pCorrelator->requests[ index ].next;
+
+    if( previous == FP_CORRELATOR_INVALID_INDEX )
+    {
+        pCorrelator->heads[ queue ] = next;
+    }
+    else
+    {
+        pCorrelator->requests[ previous ].next = next;
+    }
+
+    if( pCorrelator->tails[ queue ] == index )
+    {
+        pCorrelator->tails[ queue ] = previous;
+    }
+
+    pCorrelator->counts[ queue ]--;
+    pCorrelator->requests[ index ].next = pCorrelator->freeHead;
+    pCorrelator->freeHead = index;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorInit( FleetProvisioningCorrelator_t * pCorrelator,
+                                                            uint16_t pipelineDepth )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    if( ( pCorrelator == NULL ) || ( pipelineDepth == 0U ) || ( pipelineDepth > FP_CORRELATOR_MAX_PENDING ) )
+    {
+        LogError( ( "Invalid input parameter. pCorrelator: %p, pipelineDepth: %u.",
+                    ( void * ) pCorrelator,
+                    ( unsigned int ) pipelineDepth ) );
+    }
+    else
+    {
+        for( i = 0U; i < FP_CORRELATOR_MAX_PENDING; i++ )
+        {
+            pCorrelator->requests[ i ].next = ( uint16_t ) ( i + 1U );
+        }
+
+        pCorrelator->requests[ FP_CORRELATOR_MAX_PENDING - 1U ].next = FP_CORRELATOR_INVALID_INDEX;
+
+        for( i = 0U; i < FP_CORRELATOR_QUEUE_COUNT; i++ )
+        {
+            pCorrelator->heads[ i ] = FP_CORRELATOR_INVALID_INDEX;
+            pCorrelator->tails[ i ] = FP_CORRELATOR_INVALID_INDEX;
+            pCorrelator->counts[ i ] = 0U;
+        }
+
+        pCorrelator->freeHead = 0U;
+        pCorrelator->pipelineDepth = pipelineDepth;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfCorrelatorInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorPush( FleetProvisioningCorrelator_t * pCorrelator,
+                                                            FleetProvisioningTopic_t request,
+                                                            const char * pTemplateName,
+                                                            uint16_t templateNameLength,
+                                                            uint32_t tag )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningPendingRequest_t * pRequest;
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+    uint32_t queue = 0U;
+    uint16_t index;
+
+    if( pCorrelator == NULL )
+    {
+        LogError( ( "Invalid input parameter. pCorrelator: %p.", ( void * ) pCorrelator ) );
+    }
+    else if( ( FleetProvisioning_GetTopicInfo( request, &info ) != FleetProvisioningSuccess ) ||
+             ( info.kind != FleetProvisioningPublish ) )
+    {
+        LogError( ( "Invalid input parameter. request: %d.", ( int ) request ) );
+    }
+    else
+    {
+        queue = QUEUE_INDEX( info );
+        status = FleetProvisioningSuccess;
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( info.api == FleetProvisioningRegisterThingApi ) &&
+        ( ( pTemplateName == NULL ) || ( templateNameLength == 0U ) ||
+          ( templateNameLength > FP_TEMPLATENAME_MAX_LENGTH ) ) )
+    {
+        LogError( ( "Invalid template name. pTemplateName: %p, templateNameLength: %u.",
+                    ( const void * ) pTemplateName,
+                    ( unsigned int ) templateNameLength ) );
+        status = FleetProvisioningBadParameter;
+    }
+
+    if( status != FleetProvisioningSuccess )
+    {
+        /* Invalid parameters. */
+    }
+    else if( pCorrelator->counts[ queue ] >= pCorrelator->pipelineDepth )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else if( pCorrelator->freeHead == FP_CORRELATOR_INVALID_INDEX )
+    {
+        LogError( ( "All %u pending requests are in use.", ( unsigned int ) FP_CORRELATOR_MAX_PENDING ) );
+        status = FleetProvisioningBufferTooSmall;
+    }
+    else
+    {
+        index = pCorrelator->freeHead;
+        pRequest = &( pCorrelator->requests[ index ] );
+        pCorrelator->freeHead = pRequest->next;
+
+        pRequest->pTemplateName = pTemplateName;
+        pRequest->templateNameLength = templateNameLength;
+        pRequest->tag = tag;
+        pRequest->next = FP_CORRELATOR_INVALID_INDEX;
+
+        if( pCorrelator->tails[ queue ] == FP_CORRELATOR_INVALID_INDEX )
+        {
+            pCorrelator->heads[ queue ] = index;
+        }
+        else
+        {
+            pCorrelator->requests[ pCorrelator->tails[ queue ] ].next = index;
+        }
+
+        pCorrelator->tails[ queue ] = index;
+        pCorrelator->counts[ queue ]++;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfCorrelatorPush, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorMatch( FleetProvisioningCorrelator_t * pCorrelator,
+                                                             const char * pTopic,
+                                                             uint16_t topicLength,
+                                                             FleetProvisioningTopic_t * pOutTopic,
+                                                             uint32_t * pOutTag )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+    uint32_t queue = 0U;
+    uint16_t previous = FP_CORRELATOR_INVALID_INDEX;
+    uint16_t index = FP_CORRELATOR_INVALID_INDEX;
+
+    if( ( pCorrelator == NULL ) || ( pTopic == NULL ) || ( pOutTopic == NULL ) || ( pOutTag == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pCorrelator: %p, pTopic: %p, pOutTopic: %p, pOutTag: %p.",
+                    ( void * ) pCorrelator,
+                    ( const void * ) pTopic,
+                    ( void * ) pOutTopic,
+                    ( void * ) pOutTag ) );
+    }
+    else if( FleetProvisioning_MatchTopic( pTopic, topicLength, &topic ) != FleetProvisioningSuccess )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else
+    {
+        /* A matched topic is always valid. Publish topics are not
+         * responses. */
+        ( void ) FleetProvisioning_GetTopicInfo( topic, &info );
+        status = FleetProvisioningNoMatch;
+
+        if( info.kind != FleetProvisioningPublish )
+        {
+            queue = QUEUE_INDEX( info );
+            index = pCorrelator->heads[ queue ];
+        }
+    }
+
+    /* Responses of other templates may be answered out of order, so
+     * RegisterThing responses go to the oldest request of their template. */
+    if( info.api == FleetProvisioningRegisterThingApi )
+    {
+        while( ( index != FP_CORRELATOR_INVALID_INDEX ) &&
+               ( templateMatches( &( pCorrelator->requests[ index ] ), pTopic, topicLength ) == 0U ) )
+        {
+            previous = index;
+            index = pCorrelator->requests[ index ].next;
+        }
+    }
+
+    if( index != FP_CORRELATOR_INVALID_INDEX )
+    {
+        *pOutTopic = topic;
+        *pOutTag = pCorrelator->requests[ index ].tag;
+        removeRequest( pCorrelator, queue, previous, index );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfCorrelatorMatch, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorCancel( FleetProvisioningCorrelator_t * pCorrelator,
+                                                              uint32_t tag )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t queue;
+    uint16_t previous;
+    uint16_t index;
+    uint16_t next;
+
+    if( pCorrelator == NULL )
+    {
+        LogError( ( "Invalid input parameter. pCorrelator: %p.", ( void * ) pCorrelator ) );
+    }
+    else
+    {
+        status = FleetProvisioningNoMatch;
+
+        for( queue = 0U; queue < FP_CORRELATOR_QUEUE_COUNT; queue++ )
+        {
+            previous = FP_CORRELATOR_INVALID_INDEX;
+            index = pCorrelator->heads[ queue ];
+
+            while( index != FP_CORRELATOR_INVALID_INDEX )
+            {
+                next = pCorrelator->requests[ index ].next;
+
+                if( pCorrelator->requests[ index ].tag == tag )
+                {
+                    removeRequest( pCorrelator, queue, previous, index );
+                    status = FleetProvisioningSuccess;
+                }
+                else
+                {
+                    previous = index;
+                }
+
+                index = next;
+            }
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfCorrelatorCancel, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,164 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_dedup.c
+ * @brief Implementation of the response deduplication window for the AWS
+ * IoT Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning dedup include. */
+#include "fleet_provisioning_dedup.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+#if ( FP_DEDUP_WINDOW_SIZE == 0U ) || ( FP_DEDUP_WINDOW_SIZE > UINT16_MAX )
+    #error "FP_DEDUP_WINDOW_SIZE must be from 1 to 65535."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compute the fingerprint of a response.
+ *
+ * @param[in] topic The topic of the response.
+ * @param[in] pPayload The payload of the response.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return The FNV-1a hash of the topic and the payload.
+ */
+static uint32_t fingerprint( FleetProvisioningTopic_t topic,
+                             const char * pPayload,
+                             size_t payloadLength );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t fingerprint( FleetProvisioningTopic_t topic,
+                             const char * pPayload,
+                             size_t payloadLength )
+{
+    /* Every topic value fits one byte. */
+    const char topicByte = ( char ) topic;
+    uint32_t hash;
+
+    hash = FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, &topicByte, 1U );
+
+    return FleetProvisioning_HashFnv1a( hash, pPayload, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_DedupInit( FleetProvisioningDedupWindow_t * pWindow )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pWindow == NULL )
+    {
+        LogError( ( "Invalid input parameter. pWindow: %p.",
+                    ( void * ) pWindow ) );
+    }
+    else
+    {
+        pWindow->count = 0U;
+        pWindow->next = 0U;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfDedupInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_DedupCheck( FleetProvisioningDedupWindow_t * pWindow,
+                                                        FleetProvisioningTopic_t topic,
+                                                        const char * pPayload,
+                                                        size_t payloadLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningDedupEntry_t entry = { 0U, 0U };
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+    uint32_t i;
+
+    if( ( pWindow == NULL ) || ( ( pPayload == NULL ) && ( payloadLength > 0U ) ) )
+    {
+        LogError( ( "Invalid input parameter. pWindow: %p, pPayload: %p, payloadLength: %lu.",
+                    ( void * ) pWindow,
+                    ( const void * ) pPayload,
+                    ( unsigned long ) payloadLength ) );
+    }
+    else if( ( FleetProvisioning_GetTopicInfo( topic, &info ) != FleetProvisioningSuccess ) ||
+             ( info.kind == FleetProvisioningPublish ) )
+    {
+        /* Only responses are delivered to the device. */
+        LogError( ( "Invalid input parameter. topic: %d.", ( int ) topic ) );
+    }
+    else if( info.kind == FleetProvisioningRejected )
+    {
+        /* A rejection carries nothing of its request: the throttled requests
+         * of two sessions get the same response. Rejections always pass, and
+         * are not remembered. */
+        status = FleetProvisioningSuccess;
+    }
+    else
+    {
+        entry.fingerprint = fingerprint( topic, pPayload, payloadLength );
+        /* Lengths beyond 32 bits are truncated; the hash still covers
+         * every byte. */
+        entry.payloadLength = ( uint32_t ) payloadLength;
+        status = FleetProvisioningSuccess;
+
+        for( i = 0U; ( status == FleetProvisioningSuccess ) && ( i < pWindow->count ); i++ )
+        {
+            if( ( pWindow->entries[ i ].fingerprint == entry.fingerprint ) &&
+                ( pWindow->entries[ i ].payloadLength == entry.payloadLength ) )
+            {
+                status = FleetProvisioningNoMatch;
+            }
+        }
+
+        if( status == FleetProvisioningSuccess )
+        {
+            /* Replace the oldest entry once the window is full. */
+            pWindow->entries[ pWindow->next ] = entry;
+            pWindow->next = ( uint16_t ) ( ( pWindow->next + 1U ) % FP_DEDUP_WINDOW_SIZE );
+
+            if( pWindow->count < FP_DEDUP_WINDOW_SIZE )
+            {
+                pWindow->count++;
+            }
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfDedupCheck, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,624 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file fleet_provisioning_histogram.c
+ * @brief Implementation of the latency histograms for the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Fleet Provisioning histogram include. */
+#include "fleet_provisioning_histogram.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Number of buckets each power of two is split into.
+ */
+#define SUB_BUCKETS           ( 1U << FP_HISTOGRAM_SUB_BUCKET_BITS )
+
+/**
+ * @brief Longest decimal representation of a 64-bit value.
+ */
+#define MAX_DECIMAL_LENGTH    ( 20U )
+
+/**
+ * @brief Longest labels written by #FleetProvisioning_LatencyExportPrometheus.
+ */
+#define MAX_LABELS_LENGTH     ( 96U )
+
+/**
+ * @brief A string literal and its length.
+ */
+#define TEXT( literal )       { ( literal ), sizeof( literal ) - 1U }
+
+#if ( FP_HISTOGRAM_SUB_BUCKET_BITS > 8U )
+    #error "FP_HISTOGRAM_SUB_BUCKET_BITS must be from 0 to 8."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A string and its length.
+ */
+typedef struct ExportText
+{
+    const char * pText; /**< @brief The string. */
+    size_t length;      /**< @brief The length of the string. */
+} ExportText_t;
+
+/**
+ * @brief A buffer being written by an export.
+ */
+typedef struct ExportBuffer
+{
+    char * pBuffer;   /**< @brief The buffer. */
+    size_t length;    /**< @brief The length of the buffer. */
+    size_t used;      /**< @brief The length written so far. */
+    uint8_t overflow; /**< @brief 1 if some text did not fit, 0 otherwise. */
+} ExportBuffer_t;
+
+/**
+ * @brief The `format` labels of the topics, by format.
+ */
+static const ExportText_t formatLabels[ 2 ] =
+{
+    TEXT( "format=\"json\",api=\"" ),
+    TEXT( "format=\"cbor\",api=\"" )
+};
+
+/**
+ * @brief The `api` labels of the topics, by API.
+ */
+static const ExportText_t apiLabels[ FP_API_COUNT ] =
+{
+    TEXT( "create_certificate_from_csr\",response=\"" ),
+    TEXT( "create_keys_and_certificate\",response=\"" ),
+    TEXT( "register_thing\",response=\"" )
+};
+
+/**
+ * @brief The `response` labels of the topics, by kind of topic.
+ */
+static const ExportText_t responseLabels[ 3 ] =
+{
+    TEXT( "request\"" ),
+    TEXT( "accepted\"" ),
+    TEXT( "rejected\"" )
+};
+
+/**
+ * @brief The metrics written by #FleetProvisioning_LatencyExportPrometheus.
+ */
+static const ExportText_t latencyMetrics[ 2 ] =
+{
+    TEXT( "fleet_provisioning_response_ticks" ),
+    TEXT( "fleet_provisioning_handle_cycles" )
+};
+
+/**
+ * @brief The `# HELP` text of the metrics of
+ * #FleetProvisioning_LatencyExportPrometheus.
+ */
+static const ExportText_t latencyHelp[ 2 ] =
+{
+    TEXT( " Ticks from the publish of a request to its response.\n" ),
+    TEXT( " Cycles taken to handle a response.\n" )
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the bucket of a value.
+ *
+ * @param[in] value The value.
+ *
+ * @return The index of the bucket.
+ */
+static uint32_t bucketIndex( uint32_t value );
+
+/**
+ * @brief Get the highest value counted by a bucket.
+ *
+ * @param[in] index The index of the bucket.
+ *
+ * @return The highest value of the bucket.
+ */
+static uint64_t bucketUpperBound( uint32_t index );
+
+/**
+ * @brief Append text to an export buffer.
+ *
+ * @param[in] pOut The buffer.
+ * @param[in] pText The text.
+ * @param[in] length The length of @p pText.
+ */
+static void appendText( ExportBuffer_t * pOut,
+                        const char * pText,
+                        size_t length );
+
+/**
+ * @brief Append the decimal representation of a value to an export buffer.
+ *
+ * @param[in] pOut The buffer.
+ * @param[in] value The value.
+ */
+static void appendDecimal( ExportBuffer_t * pOut,
+                           uint64_t value );
+
+/**
+ * @brief Append a sample line to an export buffer.
+ *
+ * @param[in] pOut The buffer.
+ * @param[in] pName The metric name.
+ * @param[in] nameLength The length of @p pName.
+ * @param[in] pSuffix The suffix of the metric name.
+ * @param[in] pLabels The labels, or NULL for none.
+ * @param[in] labelsLength The length of @p pLabels.
+ * @param[in] pLe The `le` label, or NULL for none.
+ * @param[in] value The value of the sample.
+ */
+static void appendSample( ExportBuffer_t * pOut,
+                          const char * pName,
+                          size_t nameLength,
+                          const ExportText_t * pSuffix,
+                          const char * pLabels,
+                          size_t labelsLength,
+                          const ExportText_t * pLe,
+                          uint64_t value );
+
+/**
+ * @brief Append the samples of a histogram to an export buffer.
+ *
+ * @param[in] pOut The buffer.
+ * @param[in] pHistogram The histogram.
+ * @param[in] pName The metric name.
+ * @param[in] nameLength The length of @p pName.
+ * @param[in] pLabels The labels, or NULL for none.
+ * @param[in] labelsLength The length of @p pLabels.
+ */
+static void appendHistogram( ExportBuffer_t * pOut,
+                             const FleetProvisioningHistogram_t * pHistogram,
+                             const char * pName,
+                             size_t nameLength,
+                             const char * pLabels,
+                             size_t labelsLength );
+
+/**
+ * @brief Check whether a histogram holds any value.
+ *
+ * @param[in] pHistogram The histogram.
+ *
+ * @return 1 if the histogram holds a value, 0 otherwise.
+ */
+static uint8_t hasValues( const FleetProvisioningHistogram_t * pHistogram );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t bucketIndex( uint32_t value )
+{
+    uint32_t shift = 0U;
+
+    /* Values below 2 * SUB_BUCKETS are counted exactly. Higher values keep
+     * their leading one and the next FP_HISTOGRAM_SUB_BUCKET_BITS bits. */
+    while( ( value >> shift ) >= ( 2U * SUB_BUCKETS ) )
+    {
+        shift++;
+    }
+
+    return ( shift * SUB_BUCKETS ) + ( value >> shift );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t bucketUpperBound( uint32_t index )
+{
+    uint32_t shift = ( index < SUB_BUCKETS ) ? 0U : ( ( index / SUB_BUCKETS ) - 1U );
+    uint64_t mantissa = ( uint64_t ) index - ( ( uint64_t ) shift * SUB_BUCKETS );
+
+    return ( ( mantissa + 1U ) << shift ) - 1U;
+}
+/*-----------------------------------------------------------*/
+
+static void appendText( ExportBuffer_t * pOut,
+                        const char * pText,
+                        size_t length )
+{
+    if( ( pOut->overflow == 0U ) && ( length <= ( pOut->length - pOut->used ) ) )
+    {
+        ( void ) memcpy( ( void * ) &( pOut->pBuffer[ pOut->used ] ), ( const void * ) pText, length );
+        pOut->used += length;
+    }
+    else
+    {
+        pOut->overflow = 1U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void appendDecimal( ExportBuffer_t * pOut,
+                           uint64_t value )
+{
+    char digits[ MAX_DECIMAL_LENGTH ];
+    size_t start = MAX_DECIMAL_LENGTH;
+    uint64_t remaining = value;
+
+    do
+    {
+        start--;
+        digits[ start ] = ( char ) ( '0' + ( char ) ( remaining % 10U ) );
+        remaining /= 10U;
+    } while( remaining > 0U );
+
+    appendText( pOut, &( digits[ start ] ), MAX_DECIMAL_LENGTH - start );
+}
+/*-----------------------------------------------------------*/
+
+static void appendSample( ExportBuffer_t * pOut,
+                          const char * pName,
+                          size_t nameLength,
+                          const ExportText_t * pSuffix,
+                          const char * pLabels,
+                          size_t labelsLength,
+                          const ExportText_t * pLe,
+                          uint64_t value )
+{
+    appendText( pOut, pName, nameLength );
+    appendText( pOut, pSuffix->pText, pSuffix->length );
+
+    if( ( labelsLength > 0U ) || ( pLe != NULL ) )
+    {
+        appendText( pOut, "{", 1U );
+
+        if( labelsLength > 0U )
+        {
+            appendText( pOut, pLabels, labelsLength );
+        }
+
+        if( pLe != NULL )
+        {
+            if( labelsLength > 0U )
+            {
+                appendText( pOut, ",", 1U );
+            }
+
+            appendText( pOut, "le=\"", 4U );
+            appendText( pOut, pLe->pText, pLe->length );
+            appendText( pOut, "\"", 1U );
+        }
+
+        appendText( pOut, "}", 1U );
+    }
+
+    appendText( pOut, " ", 1U );
+    appendDecimal( pOut, value );
+    appendText( pOut, "\n", 1U );
+}
+/*-----------------------------------------------------------*/
+
+static void appendHistogram( ExportBuffer_t * pOut,
+                             const FleetProvisioningHistogram_t * pHistogram,
+                             const char * pName,
+                             size_t nameLength,
+                             const char * pLabels,
+                             size_t labelsLength )
+{
+    static const ExportText_t bucketSuffix = TEXT( "_bucket" );
+    static const ExportText_t sumSuffix = TEXT( "_sum" );
+    static const ExportText_t countSuffix = TEXT( "_count" );
+    static const ExportText_t infinity = TEXT( "+Inf" );
+    char leDigits[ MAX_DECIMAL_LENGTH ];
+    ExportBuffer_t le;
+    ExportText_t leText;
+    uint64_t cumulative = 0U;
+    uint32_t count;
+    uint32_t i;
+
+    for( i = 0U; i < FP_HISTOGRAM_BUCKETS; i++ )
+    {
+        /* Each count is read once, as other threads may be recording. */
+        count = pHistogram->counts[ i ];
+
+        if( count > 0U )
+        {
+            cumulative += count;
+            le.pBuffer = leDigits;
+            le.length = sizeof( leDigits );
+            le.used = 0U;
+            le.overflow = 0U;
+            appendDecimal( &le, bucketUpperBound( i ) );
+            leText.pText = leDigits;
+            leText.length = le.used;
+            appendSample( pOut, pName, nameLength, &bucketSuffix, pLabels, labelsLength, &leText, cumulative );
+        }
+    }
+
+    appendSample( pOut, pName, nameLength, &bucketSuffix, pLabels, labelsLength, &infinity, cumulative );
+    appendSample( pOut, pName, nameLength, &sumSuffix, pLabels, labelsLength, NULL, pHistogram->sum );
+    appendSample( pOut, pName, nameLength, &countSuffix, pLabels, labelsLength, NULL, cumulative );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t hasValues( const FleetProvisioningHistogram_t * pHistogram )
+{
+    uint8_t found = 0U;
+    uint32_t i;
+
+    for( i = 0U; ( found == 0U ) && ( i < FP_HISTOGRAM_BUCKETS ); i++ )
+    {
+        if( pHistogram->counts[ i ] > 0U )
+        {
+            found = 1U;
+        }
+    }
+
+    return found;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_HistogramRecord( FleetProvisioningHistogram_t * pHistogram,
+                                                             uint32_t value )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pHistogram == NULL )
+    {
+        LogError( ( "Invalid input parameter. pHistogram: %p.",
+                    ( void * ) pHistogram ) );
+    }
+    else
+    {
+        FP_ATOMIC_ADD_RELAXED( &( pHistogram->counts[ bucketIndex( value ) ] ), 1U );
+        FP_ATOMIC_ADD_RELAXED( &( pHistogram->sum ), ( uint64_t ) value );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfHistogramRecord, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_HistogramMerge( FleetProvisioningHistogram_t * pDestination,
+                                                            const FleetProvisioningHistogram_t * pSource )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    if( ( pDestination == NULL ) || ( pSource == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pDestination: %p, pSource: %p.",
+                    ( void * ) pDestination,
+                    ( const void * ) pSource ) );
+    }
+    else
+    {
+        for( i = 0U; i < FP_HISTOGRAM_BUCKETS; i++ )
+        {
+            FP_ATOMIC_ADD_RELAXED( &( pDestination->counts[ i ] ), pSource->counts[ i ] );
+        }
+
+        FP_ATOMIC_ADD_RELAXED( &( pDestination->sum ), pSource->sum );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfHistogramMerge, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_HistogramExportPrometheus( const FleetProvisioningHistogram_t * pHistogram,
+                                                                       const char * pName,
+                                                                       size_t nameLength,
+                                                                       const char * pLabels,
+                                                                       size_t labelsLength,
+                                                                       char * pBuffer,
+                                                                       size_t bufferLength,
+                                                                       size_t * pOutLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    ExportBuffer_t out;
+
+    if( ( pHistogram == NULL ) || ( pName == NULL ) || ( nameLength == 0U ) ||
+        ( ( pLabels == NULL ) && ( labelsLength > 0U ) ) ||
+        ( pBuffer == NULL ) || ( pOutLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pHistogram: %p, pName: %p, nameLength: %lu, "
+                    "pLabels: %p, labelsLength: %lu, pBuffer: %p, pOutLength: %p.",
+                    ( const void * ) pHistogram,
+                    ( const void * ) pName,
+                    ( unsigned long ) nameLength,
+                    ( const void * ) pLabels,
+                    ( unsigned long ) labelsLength,
+                    ( void * ) pBuffer,
+                    ( void * ) pOutLength ) );
+    }
+    else
+    {
+        out.pBuffer = pBuffer;
+        out.length = bufferLength;
+        out.used = 0U;
+        out.overflow = 0U;
+        appendHistogram( &out, pHistogram, pName, nameLength, pLabels, labelsLength );
+
+        if( out.overflow == 0U )
+        {
+            *pOutLength = out.used;
+            status = FleetProvisioningSuccess;
+        }
+        else
+        {
+            LogError( ( "Buffer too small for the histogram. bufferLength: %lu.",
+                        ( unsigned long ) bufferLength ) );
+            status = FleetProvisioningBufferTooSmall;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfHistogramExportPrometheus, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_LatencyInit( FleetProvisioningLatency_t * pLatency )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pLatency == NULL )
+    {
+        LogError( ( "Invalid input parameter. pLatency: %p.",
+                    ( void * ) pLatency ) );
+    }
+    else
+    {
+        ( void ) memset( ( void * ) pLatency, 0, sizeof( FleetProvisioningLatency_t ) );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfLatencyInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_LatencyMerge( FleetProvisioningLatency_t * pDestination,
+                                                          const FleetProvisioningLatency_t * pSource )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    if( ( pDestination == NULL ) || ( pSource == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pDestination: %p, pSource: %p.",
+                    ( void * ) pDestination,
+                    ( const void * ) pSource ) );
+    }
+    else
+    {
+        for( i = 0U; i < FP_LATENCY_TOPIC_COUNT; i++ )
+        {
+            ( void ) FleetProvisioning_HistogramMerge( &( pDestination->responseTicks[ i ] ),
+                                                       &( pSource->responseTicks[ i ] ) );
+            ( void ) FleetProvisioning_HistogramMerge( &( pDestination->handleCycles[ i ] ),
+                                                       &( pSource->handleCycles[ i ] ) );
+        }
+
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfLatencyMerge, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_LatencyExportPrometheus( const FleetProvisioningLatency_t * pLatency,
+                                                                     char * pBuffer,
+                                                                     size_t bufferLength,
+                                                                     size_t * pOutLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    const FleetProvisioningHistogram_t * pHistogram;
+    const ExportText_t * pMetric;
+    char labelsBuffer[ MAX_LABELS_LENGTH ];
+    ExportBuffer_t labels;
+    ExportBuffer_t out;
+    uint32_t metric;
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+    uint32_t topic;
+
+    if( ( pLatency == NULL ) || ( pBuffer == NULL ) || ( pOutLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pLatency: %p, pBuffer: %p, pOutLength: %p.",
+                    ( const void * ) pLatency,
+                    ( void * ) pBuffer,
+                    ( void * ) pOutLength ) );
+    }
+    else
+    {
+        out.pBuffer = pBuffer;
+        out.length = bufferLength;
+        out.used = 0U;
+        out.overflow = 0U;
+
+        for( metric = 0U; metric < 2U; metric++ )
+        {
+            pMetric = &( latencyMetrics[ metric ] );
+            appendText( &out, "# HELP ", 7U );
+            appendText( &out, pMetric->pText, pMetric->length );
+            appendText( &out, latencyHelp[ metric ].pText, latencyHelp[ metric ].length );
+            appendText( &out, "# TYPE ", 7U );
+            appendText( &out, pMetric->pText, pMetric->length );
+            appendText( &out, " histogram\n", 11U );
+
+            for( topic = 1U; topic < FP_LATENCY_TOPIC_COUNT; topic++ )
+            {
+                pHistogram = ( metric == 0U ) ? &( pLatency->responseTicks[ topic ] ) :
+                             &( pLatency->handleCycles[ topic ] );
+
+                if( hasValues( pHistogram ) == 1U )
+                {
+                    labels.pBuffer = labelsBuffer;
+                    labels.length = sizeof( labelsBuffer );
+                    labels.used = 0U;
+                    labels.overflow = 0U;
+                    ( void ) FleetProvisioning_GetTopicInfo( ( FleetProvisioningTopic_t ) topic, &info );
+                    appendText( &labels, formatLabels[ info.format ].pText, formatLabels[ info.format ].length );
+                    appendText( &labels, apiLabels[ info.api ].pText, apiLabels[ info.api ].length );
+                    appendText( &labels, responseLabels[ info.kind ].pText, responseLabels[ info.kind ].length );
+                    appendHistogram( &out, pHistogram, pMetric->pText, pMetric->length,
+                                     labelsBuffer, labels.used );
+                }
+            }
+        }
+
+        if( out.overflow == 0U )
+        {
+            *pOutLength = out.used;
+            status = FleetProvisioningSuccess;
+        }
+        else
+        {
+            LogError( ( "Buffer too small for the latency histograms. bufferLength: %lu.",
+                        ( unsigned long ) bufferLength ) );
+            status = FleetProvisioningBufferTooSmall;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfLatencyExportPrometheus, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
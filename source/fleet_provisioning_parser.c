@@ -0,0 +1,1389 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_parser.c
+ * @brief Implementation of the AWS IoT Fleet Provisioning response parser.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Fleet Provisioning parser include. */
+#include "fleet_provisioning_parser.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Length of the thing name key.
+ */
+#define FP_API_LENGTH_THING_NAME_KEY       ( sizeof( FP_API_THING_NAME_KEY ) - 1U )
+
+/**
+ * @brief Length of the device configuration key.
+ */
+#define FP_API_LENGTH_DEVICE_CONFIG_KEY    ( sizeof( FP_API_DEVICE_CONFIG_KEY ) - 1U )
+
+/**
+ * @brief Length of the status code key of rejected responses.
+ */
+#define FP_API_LENGTH_STATUS_CODE_KEY      ( sizeof( FP_API_STATUS_CODE_KEY ) - 1U )
+
+/**
+ * @brief CBOR major type of an unsigned integer.
+ */
+#define CBOR_MAJOR_TYPE_UNSIGNED           ( 0U )
+
+/**
+ * @brief CBOR major type of a byte string.
+ */
+#define CBOR_MAJOR_TYPE_BYTE_STRING        ( 2U )
+
+/**
+ * @brief CBOR major type of a text string.
+ */
+#define CBOR_MAJOR_TYPE_TEXT_STRING        ( 3U )
+
+/**
+ * @brief CBOR major type of an array.
+ */
+#define CBOR_MAJOR_TYPE_ARRAY              ( 4U )
+
+/**
+ * @brief CBOR major type of a map.
+ */
+#define CBOR_MAJOR_TYPE_MAP                ( 5U )
+
+/**
+ * @brief CBOR major type of a tagged item.
+ */
+#define CBOR_MAJOR_TYPE_TAG                ( 6U )
+
+/**
+ * @brief Smallest CBOR additional information value that is followed by
+ * argument bytes.
+ */
+#define CBOR_ARGUMENT_ONE_BYTE             ( 24U )
+
+/**
+ * @brief Largest valid CBOR additional information value.
+ *
+ * Indefinite length items are not used by AWS IoT and are not supported.
+ */
+#define CBOR_ARGUMENT_EIGHT_BYTES          ( 27U )
+
+#if ( FP_DEVICE_CONFIG_MAX_ENTRIES == 0U ) || ( FP_DEVICE_CONFIG_MAX_ENTRIES > 127U )
+    #error "FP_DEVICE_CONFIG_MAX_ENTRIES must be between 1 and 127."
+#endif
+
+/**
+ * @brief Read position in a payload.
+ */
+typedef struct PayloadCursor
+{
+    const char * pBuffer; /**< @brief The payload. */
+    size_t length;        /**< @brief Length of the payload. */
+    size_t index;         /**< @brief Offset of the next unread byte. */
+} PayloadCursor_t;
+
+/**
+ * @brief Offset and length of a region of the payload.
+ */
+typedef struct PayloadRegion
+{
+    size_t offset; /**< @brief Offset of the region. */
+    size_t length; /**< @brief Length of the region. */
+} PayloadRegion_t;
+
+/**
+ * @brief State for iterating over the members of a JSON object or CBOR map.
+ */
+typedef struct PayloadMap
+{
+    FleetProvisioningFormat_t format; /**< @brief Format of the payload. */
+    size_t remaining;                 /**< @brief CBOR members not yet read. */
+    uint8_t isFirst;                  /**< @brief No JSON member read yet. */
+} PayloadMap_t;
+
+/**
+ * @brief Check whether a region of the payload holds the given string.
+ *
+ * @param[in] pCursor The payload.
+ * @param[in] pRegion The region to compare.
+ * @param[in] pString The string to compare against.
+ * @param[in] stringLength The length of @p pString.
+ *
+ * @return 1 if the region matches the string; 0 otherwise.
+ */
+static uint8_t regionEquals( const PayloadCursor_t * pCursor,
+                             const PayloadRegion_t * pRegion,
+                             const char * pString,
+                             size_t stringLength );
+
+/**
+ * @brief Advance the cursor past any JSON whitespace.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ */
+static void skipJsonWhitespace( PayloadCursor_t * pCursor );
+
+/**
+ * @brief Skip whitespace and consume the given JSON structural character.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in] expected The character to consume.
+ *
+ * @return FleetProvisioningSuccess if the character is consumed;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t consumeJsonChar( PayloadCursor_t * pCursor,
+                                                  char expected );
+
+/**
+ * @brief Read a JSON string starting at the cursor.
+ *
+ * @param[in,out] pCursor The payload cursor, positioned at the opening quote.
+ * @param[out] pRegion The contents of the string, without quotes.
+ *
+ * @return FleetProvisioningSuccess if a string is read;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readJsonString( PayloadCursor_t * pCursor,
+                                                 PayloadRegion_t * pRegion );
+
+/**
+ * @brief Skip over a JSON object or array starting at the cursor.
+ *
+ * @param[in,out] pCursor The payload cursor, positioned at the opening
+ * bracket.
+ *
+ * @return FleetProvisioningSuccess if the value is skipped;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t skipJsonCompound( PayloadCursor_t * pCursor );
+
+/**
+ * @brief Skip over a JSON number or literal starting at the cursor.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ *
+ * @return FleetProvisioningSuccess if the value is skipped;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t skipJsonScalar( PayloadCursor_t * pCursor );
+
+/**
+ * @brief Read a JSON value.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[out] pRegion The string contents, or the complete value if not a
+ * string.
+ * @param[out] pIsString Set to 1 if the value is a string; 0 otherwise.
+ *
+ * @return FleetProvisioningSuccess if a value is read;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readJsonValue( PayloadCursor_t * pCursor,
+                                                PayloadRegion_t * pRegion,
+                                                uint8_t * pIsString );
+
+/**
+ * @brief Read the separator before the next JSON object member.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in,out] pMap The object iteration state.
+ *
+ * @return FleetProvisioningSuccess if another member follows;
+ * FleetProvisioningNoMatch at the end of the object;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readJsonSeparator( PayloadCursor_t * pCursor,
+                                                    PayloadMap_t * pMap );
+
+/**
+ * @brief Read the key of the next JSON object member, and the colon after it.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in,out] pMap The object iteration state.
+ * @param[out] pKey The key of the member.
+ *
+ * @return FleetProvisioningSuccess if a key is read;
+ * FleetProvisioningNoMatch at the end of the object;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readJsonKey( PayloadCursor_t * pCursor,
+                                              PayloadMap_t * pMap,
+                                              PayloadRegion_t * pKey );
+
+/**
+ * @brief Read the header of a CBOR data item.
+ *
+ * Arguments that do not fit in 32 bits are saturated, which makes any length
+ * checks against the payload fail.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[out] pMajorType The major type of the item.
+ * @param[out] pArgument The argument of the item.
+ *
+ * @return FleetProvisioningSuccess if a header is read;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readCborHeader( PayloadCursor_t * pCursor,
+                                                 uint8_t * pMajorType,
+                                                 uint32_t * pArgument );
+
+/**
+ * @brief Consume the content of a CBOR item whose header has been read, and
+ * account for any nested items.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in] majorType The major type of the item.
+ * @param[in] argument The argument of the item.
+ * @param[in,out] pPending The number of items left to skip.
+ *
+ * @return FleetProvisioningSuccess if the content is consumed;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t consumeCborContent( PayloadCursor_t * pCursor,
+                                                     uint8_t majorType,
+                                                     uint32_t argument,
+                                                     size_t * pPending );
+
+/**
+ * @brief Skip over a complete CBOR data item, including nested items.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ *
+ * @return FleetProvisioningSuccess if the item is skipped;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t skipCborItem( PayloadCursor_t * pCursor );
+
+/**
+ * @brief Read a CBOR value.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[out] pRegion The string contents, or the complete item if not a
+ * string.
+ * @param[out] pIsString Set to 1 if the value is a text or byte string; 0
+ * otherwise.
+ *
+ * @return FleetProvisioningSuccess if a value is read;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readCborValue( PayloadCursor_t * pCursor,
+                                                PayloadRegion_t * pRegion,
+                                                uint8_t * pIsString );
+
+/**
+ * @brief Start iterating over a JSON object or CBOR map.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in] format The format of the payload.
+ * @param[out] pMap The iteration state.
+ *
+ * @return FleetProvisioningSuccess if the cursor is at an object or map;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readMapBegin( PayloadCursor_t * pCursor,
+                                               FleetProvisioningFormat_t format,
+                                               PayloadMap_t * pMap );
+
+/**
+ * @brief Read the key of the next map member. The cursor is left at the
+ * member value.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in,out] pMap The iteration state.
+ * @param[out] pKey The key of the member.
+ *
+ * @return FleetProvisioningSuccess if a key is read;
+ * FleetProvisioningNoMatch if there are no more members;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readMapKey( PayloadCursor_t * pCursor,
+                                             PayloadMap_t * pMap,
+                                             PayloadRegion_t * pKey );
+
+/**
+ * @brief Read the value of a map member.
+ *
+ * @param[in,out] pCursor The payload cursor.
+ * @param[in] pMap The iteration state.
+ * @param[out] pRegion The string contents, or the complete value if not a
+ * string.
+ * @param[out] pIsString Set to 1 if the value is a string; 0 otherwise.
+ *
+ * @return FleetProvisioningSuccess if a value is read;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readMapValue( PayloadCursor_t * pCursor,
+                                               const PayloadMap_t * pMap,
+                                               PayloadRegion_t * pRegion,
+                                               uint8_t * pIsString );
+
+/**
+ * @brief Find the first member of the top level map with the given key.
+ *
+ * @param[in,out] pCursor The payload cursor, positioned at the map.
+ * @param[in] format The format of the payload.
+ * @param[in] pKey The key to look up.
+ * @param[in] keyLength The length of @p pKey.
+ * @param[out] pValue The value of the member, as read by #readMapValue.
+ * @param[out] pIsString Set to 1 if the value is a string; 0 otherwise.
+ *
+ * @return FleetProvisioningSuccess if the key is found;
+ * FleetProvisioningNoMatch if the map has no such key;
+ * FleetProvisioningError if the payload is malformed.
+ */
+static FleetProvisioningStatus_t findMember( PayloadCursor_t * pCursor,
+                                             FleetProvisioningFormat_t format,
+                                             const char * pKey,
+                                             size_t keyLength,
+                                             PayloadRegion_t * pValue,
+                                             uint8_t * pIsString );
+
+/**
+ * @brief Read an unsigned integer value found by #findMember.
+ *
+ * JSON values must be plain decimal digits; CBOR values must be of major
+ * type 0.
+ *
+ * @param[in] pCursor The payload.
+ * @param[in] format The format of the payload.
+ * @param[in] pValue The value region.
+ * @param[out] pOutValue The integer.
+ *
+ * @return FleetProvisioningSuccess if the value is an unsigned integer that
+ * fits in 32 bits; FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t readUnsignedValue( const PayloadCursor_t * pCursor,
+                                                    FleetProvisioningFormat_t format,
+                                                    const PayloadRegion_t * pValue,
+                                                    uint32_t * pOutValue );
+
+/**
+ * @brief Add a device configuration entry to the index.
+ *
+ * @param[in,out] pResponse The response being built.
+ * @param[in] pCursor The payload.
+ * @param[in] pKey The key of the entry.
+ * @param[in] pValue The value of the entry.
+ *
+ * @return FleetProvisioningSuccess if the entry is added;
+ * FleetProvisioningBufferTooSmall if the index is full;
+ * FleetProvisioningError if the key is too long.
+ */
+static FleetProvisioningStatus_t addDeviceConfigEntry( FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                       const PayloadCursor_t * pCursor,
+                                                       const PayloadRegion_t * pKey,
+                                                       const PayloadRegion_t * pValue );
+
+/**
+ * @brief Index the members of the device configuration map.
+ *
+ * @param[in,out] pCursor The payload cursor, positioned at the map.
+ * @param[in] format The format of the payload.
+ * @param[in,out] pResponse The response being built.
+ *
+ * @return FleetProvisioningSuccess if the map is indexed;
+ * FleetProvisioningBufferTooSmall if the index is full;
+ * FleetProvisioningError if the map is malformed.
+ */
+static FleetProvisioningStatus_t parseDeviceConfig( PayloadCursor_t * pCursor,
+                                                    FleetProvisioningFormat_t format,
+                                                    FleetProvisioningRegisterThingResponse_t * pResponse );
+
+/**
+ * @brief Parse one member of the RegisterThing accepted response.
+ *
+ * @param[in,out] pCursor The payload cursor, positioned at the member value.
+ * @param[in] pMap The iteration state of the top level map.
+ * @param[in] pKey The key of the member.
+ * @param[in,out] pResponse The response being built.
+ *
+ * @return FleetProvisioningSuccess if the member is parsed;
+ * FleetProvisioningBufferTooSmall if the index is full;
+ * FleetProvisioningError if the member is malformed.
+ */
+static FleetProvisioningStatus_t parseResponseMember( PayloadCursor_t * pCursor,
+                                                      const PayloadMap_t * pMap,
+                                                      const PayloadRegion_t * pKey,
+                                                      FleetProvisioningRegisterThingResponse_t * pResponse );
+/*-----------------------------------------------------------*/
+
+static uint8_t regionEquals( const PayloadCursor_t * pCursor,
+                             const PayloadRegion_t * pRegion,
+                             const char * pString,
+                             size_t stringLength )
+{
+    uint8_t ret = 0U;
+
+    if( pRegion->length == stringLength )
+    {
+        if( memcmp( &( pCursor->pBuffer[ pRegion->offset ] ), pString, stringLength ) == 0 )
+        {
+            ret = 1U;
+        }
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+static void skipJsonWhitespace( PayloadCursor_t * pCursor )
+{
+    char c;
+
+    while( pCursor->index < pCursor->length )
+    {
+        c = pCursor->pBuffer[ pCursor->index ];
+
+        if( ( c != ' ' ) && ( c != '\t' ) && ( c != '\r' ) && ( c != '\n' ) )
+        {
+            break;
+        }
+
+        pCursor->index++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t consumeJsonChar( PayloadCursor_t * pCursor,
+                                                  char expected )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+
+    skipJsonWhitespace( pCursor );
+
+    if( pCursor->index < pCursor->length )
+    {
+        if( pCursor->pBuffer[ pCursor->index ] == expected )
+        {
+            pCursor->index++;
+            status = FleetProvisioningSuccess;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readJsonString( PayloadCursor_t * pCursor,
+                                                 PayloadRegion_t * pRegion )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    size_t i = pCursor->index + 1U;
+
+    assert( pCursor->index < pCursor->length );
+    assert( pCursor->pBuffer[ pCursor->index ] == '"' );
+
+    while( i < pCursor->length )
+    {
+        if( pCursor->pBuffer[ i ] == '"' )
+        {
+            status = FleetProvisioningSuccess;
+            break;
+        }
+
+        /* Skip the escaped character so an escaped quote does not end the
+         * string. */
+        i += ( pCursor->pBuffer[ i ] == '\\' ) ? 2U : 1U;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pRegion->offset = pCursor->index + 1U;
+        pRegion->length = i - pRegion->offset;
+        pCursor->index = i + 1U;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t skipJsonCompound( PayloadCursor_t * pCursor )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    PayloadRegion_t stringRegion;
+    size_t depth = 0U;
+    char c;
+
+    do
+    {
+        c = pCursor->pBuffer[ pCursor->index ];
+
+        if( c == '"' )
+        {
+            status = readJsonString( pCursor, &stringRegion );
+        }
+        else
+        {
+            if( ( c == '{' ) || ( c == '[' ) )
+            {
+                depth++;
+            }
+            else if( ( c == '}' ) || ( c == ']' ) )
+            {
+                depth--;
+            }
+            else
+            {
+                /* Other characters do not change the nesting depth. */
+            }
+
+            pCursor->index++;
+        }
+    } while( ( status == FleetProvisioningSuccess ) &&
+             ( depth > 0U ) &&
+             ( pCursor->index < pCursor->length ) );
+
+    if( depth > 0U )
+    {
+        status = FleetProvisioningError;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t skipJsonScalar( PayloadCursor_t * pCursor )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    size_t start = pCursor->index;
+    char c;
+
+    while( pCursor->index < pCursor->length )
+    {
+        c = pCursor->pBuffer[ pCursor->index ];
+
+        if( ( c == ',' ) || ( c == '}' ) || ( c == ']' ) || ( c == ' ' ) ||
+            ( c == '\t' ) || ( c == '\r' ) || ( c == '\n' ) )
+        {
+            break;
+        }
+
+        pCursor->index++;
+    }
+
+    if( pCursor->index > start )
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readJsonValue( PayloadCursor_t * pCursor,
+                                                PayloadRegion_t * pRegion,
+                                                uint8_t * pIsString )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    char c;
+
+    skipJsonWhitespace( pCursor );
+    pRegion->offset = pCursor->index;
+    *pIsString = 0U;
+
+    if( pCursor->index < pCursor->length )
+    {
+        c = pCursor->pBuffer[ pCursor->index ];
+
+        if( c == '"' )
+        {
+            status = readJsonString( pCursor, pRegion );
+            *pIsString = 1U;
+        }
+        else if( ( c == '{' ) || ( c == '[' ) )
+        {
+            status = skipJsonCompound( pCursor );
+        }
+        else
+        {
+            status = skipJsonScalar( pCursor );
+        }
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( *pIsString == 0U ) )
+    {
+        pRegion->length = pCursor->index - pRegion->offset;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readJsonSeparator( PayloadCursor_t * pCursor,
+                                                    PayloadMap_t * pMap )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+
+    if( consumeJsonChar( pCursor, '}' ) == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else if( pMap->isFirst == 1U )
+    {
+        status = FleetProvisioningSuccess;
+    }
+    else
+    {
+        status = consumeJsonChar( pCursor, ',' );
+
+        if( status != FleetProvisioningSuccess )
+        {
+            status = FleetProvisioningError;
+        }
+    }
+
+    pMap->isFirst = 0U;
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readJsonKey( PayloadCursor_t * pCursor,
+                                              PayloadMap_t * pMap,
+                                              PayloadRegion_t * pKey )
+{
+    FleetProvisioningStatus_t status;
+    uint8_t isString = 0U;
+
+    status = readJsonSeparator( pCursor, pMap );
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = readJsonValue( pCursor, pKey, &isString );
+
+        if( isString == 0U )
+        {
+            status = FleetProvisioningError;
+        }
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        if( consumeJsonChar( pCursor, ':' ) != FleetProvisioningSuccess )
+        {
+            status = FleetProvisioningError;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readCborHeader( PayloadCursor_t * pCursor,
+                                                 uint8_t * pMajorType,
+                                                 uint32_t * pArgument )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    uint8_t initialByte;
+    uint8_t additionalInfo;
+    size_t argumentBytes = 0U;
+    size_t i;
+
+    if( pCursor->index < pCursor->length )
+    {
+        initialByte = ( uint8_t ) pCursor->pBuffer[ pCursor->index ];
+        *pMajorType = ( uint8_t ) ( initialByte >> 5U );
+        additionalInfo = ( uint8_t ) ( initialByte & 0x1FU );
+        pCursor->index++;
+
+        if( additionalInfo < CBOR_ARGUMENT_ONE_BYTE )
+        {
+            *pArgument = additionalInfo;
+            status = FleetProvisioningSuccess;
+        }
+        else if( additionalInfo <= CBOR_ARGUMENT_EIGHT_BYTES )
+        {
+            argumentBytes = ( size_t ) 1U << ( additionalInfo - CBOR_ARGUMENT_ONE_BYTE );
+            status = ( argumentBytes <= ( pCursor->length - pCursor->index ) ) ?
+                     FleetProvisioningSuccess : FleetProvisioningError;
+        }
+        else
+        {
+            /* Reserved values and indefinite lengths are not supported. */
+        }
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( argumentBytes > 0U ) )
+    {
+        *pArgument = 0U;
+
+        for( i = 0U; i < argumentBytes; i++ )
+        {
+            *pArgument = ( *pArgument > 0x00FFFFFFU ) ? UINT32_MAX :
+                         ( ( *pArgument << 8U ) | ( uint8_t ) pCursor->pBuffer[ pCursor->index + i ] );
+        }
+
+        pCursor->index += argumentBytes;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t consumeCborContent( PayloadCursor_t * pCursor,
+                                                     uint8_t majorType,
+                                                     uint32_t argument,
+                                                     size_t * pPending )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    size_t remaining = pCursor->length - pCursor->index;
+
+    /* Every nested item is at least one byte long, so a count larger than the
+     * remaining payload is malformed. This also bounds the pending count. */
+    if( ( majorType == CBOR_MAJOR_TYPE_BYTE_STRING ) ||
+        ( majorType == CBOR_MAJOR_TYPE_TEXT_STRING ) )
+    {
+        status = ( argument <= remaining ) ? FleetProvisioningSuccess : FleetProvisioningError;
+        pCursor->index += ( status == FleetProvisioningSuccess ) ? ( size_t ) argument : 0U;
+    }
+    else if( majorType == CBOR_MAJOR_TYPE_ARRAY )
+    {
+        status = ( argument <= remaining ) ? FleetProvisioningSuccess : FleetProvisioningError;
+        *pPending += ( status == FleetProvisioningSuccess ) ? ( size_t ) argument : 0U;
+    }
+    else if( majorType == CBOR_MAJOR_TYPE_MAP )
+    {
+        status = ( argument <= ( remaining / 2U ) ) ? FleetProvisioningSuccess : FleetProvisioningError;
+        *pPending += ( status == FleetProvisioningSuccess ) ? ( 2U * ( size_t ) argument ) : 0U;
+    }
+    else if( majorType == CBOR_MAJOR_TYPE_TAG )
+    {
+        *pPending += 1U;
+    }
+    else
+    {
+        /* Integers and simple values are fully contained in the header. */
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t skipCborItem( PayloadCursor_t * pCursor )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    size_t pending = 1U;
+    uint8_t majorType = 0U;
+    uint32_t argument = 0U;
+
+    /* Nested items are counted rather than recursed into, so the stack usage
+     * does not depend on the payload. */
+    while( ( status == FleetProvisioningSuccess ) && ( pending > 0U ) )
+    {
+        status = readCborHeader( pCursor, &majorType, &argument );
+        pending--;
+
+        if( status == FleetProvisioningSuccess )
+        {
+            status = consumeCborContent( pCursor, majorType, argument, &pending );
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readCborValue( PayloadCursor_t * pCursor,
+                                                PayloadRegion_t * pRegion,
+                                                uint8_t * pIsString )
+{
+    FleetProvisioningStatus_t status;
+    size_t start = pCursor->index;
+    uint8_t majorType = 0U;
+    uint32_t argument = 0U;
+
+    *pIsString = 0U;
+    status = readCborHeader( pCursor, &majorType, &argument );
+
+    if( ( status == FleetProvisioningSuccess ) &&
+        ( ( majorType == CBOR_MAJOR_TYPE_TEXT_STRING ) ||
+          ( majorType == CBOR_MAJOR_TYPE_BYTE_STRING ) ) )
+    {
+        *pIsString = 1U;
+        pRegion->offset = pCursor->index;
+        pRegion->length = argument;
+        status = ( argument <= ( pCursor->length - pCursor->index ) ) ?
+                 FleetProvisioningSuccess : FleetProvisioningError;
+        pCursor->index += ( status == FleetProvisioningSuccess ) ? ( size_t ) argument : 0U;
+    }
+    else if( status == FleetProvisioningSuccess )
+    {
+        pCursor->index = start;
+        status = skipCborItem( pCursor );
+        pRegion->offset = start;
+        pRegion->length = pCursor->index - start;
+    }
+    else
+    {
+        /* Malformed header. */
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readMapBegin( PayloadCursor_t * pCursor,
+                                               FleetProvisioningFormat_t format,
+                                               PayloadMap_t * pMap )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    uint8_t majorType = 0U;
+    uint32_t argument = 0U;
+
+    pMap->format = format;
+    pMap->remaining = 0U;
+    pMap->isFirst = 1U;
+
+    if( format == FleetProvisioningJson )
+    {
+        if( consumeJsonChar( pCursor, '{' ) == FleetProvisioningSuccess )
+        {
+            status = FleetProvisioningSuccess;
+        }
+    }
+    else
+    {
+        status = readCborHeader( pCursor, &majorType, &argument );
+
+        if( ( status == FleetProvisioningSuccess ) &&
+            ( ( majorType != CBOR_MAJOR_TYPE_MAP ) ||
+              ( argument > ( ( pCursor->length - pCursor->index ) / 2U ) ) ) )
+        {
+            status = FleetProvisioningError;
+        }
+
+        pMap->remaining = argument;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readMapKey( PayloadCursor_t * pCursor,
+                                             PayloadMap_t * pMap,
+                                             PayloadRegion_t * pKey )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    uint8_t majorType = 0U;
+    uint32_t argument = 0U;
+
+    if( pMap->format == FleetProvisioningJson )
+    {
+        status = readJsonKey( pCursor, pMap, pKey );
+    }
+    else if( pMap->remaining > 0U )
+    {
+        pMap->remaining--;
+        status = readCborHeader( pCursor, &majorType, &argument );
+
+        if( ( status == FleetProvisioningSuccess ) &&
+            ( ( majorType != CBOR_MAJOR_TYPE_TEXT_STRING ) ||
+              ( argument > ( pCursor->length - pCursor->index ) ) ) )
+        {
+            status = FleetProvisioningError;
+        }
+
+        if( status == FleetProvisioningSuccess )
+        {
+            pKey->offset = pCursor->index;
+            pKey->length = argument;
+            pCursor->index += argument;
+        }
+    }
+    else
+    {
+        /* All members of the CBOR map have been read. */
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readMapValue( PayloadCursor_t * pCursor,
+                                               const PayloadMap_t * pMap,
+                                               PayloadRegion_t * pRegion,
+                                               uint8_t * pIsString )
+{
+    FleetProvisioningStatus_t status;
+
+    if( pMap->format == FleetProvisioningJson )
+    {
+        status = readJsonValue( pCursor, pRegion, pIsString );
+    }
+    else
+    {
+        status = readCborValue( pCursor, pRegion, pIsString );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t findMember( PayloadCursor_t * pCursor,
+                                             FleetProvisioningFormat_t format,
+                                             const char * pKey,
+                                             size_t keyLength,
+                                             PayloadRegion_t * pValue,
+                                             uint8_t * pIsString )
+{
+    FleetProvisioningStatus_t status;
+    PayloadMap_t map = { FleetProvisioningJson, 0U, 0U };
+    PayloadRegion_t key = { 0 };
+    uint8_t found = 0U;
+
+    status = readMapBegin( pCursor, format, &map );
+
+    while( ( status == FleetProvisioningSuccess ) && ( found == 0U ) )
+    {
+        status = readMapKey( pCursor, &map, &key );
+
+        if( status == FleetProvisioningSuccess )
+        {
+            status = readMapValue( pCursor, &map, pValue, pIsString );
+            found = regionEquals( pCursor, &key, pKey, keyLength );
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t readUnsignedValue( const PayloadCursor_t * pCursor,
+                                                    FleetProvisioningFormat_t format,
+                                                    const PayloadRegion_t * pValue,
+                                                    uint32_t * pOutValue )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    PayloadCursor_t item = { NULL, 0U, 0U };
+    uint8_t majorType = 0U;
+    uint32_t value = 0U;
+    uint32_t digit;
+    size_t i;
+
+    if( format == FleetProvisioningJson )
+    {
+        for( i = 0U; ( i < pValue->length ) && ( status == FleetProvisioningSuccess ); i++ )
+        {
+            digit = ( uint32_t ) ( uint8_t ) pCursor->pBuffer[ pValue->offset + i ] - ( uint32_t ) '0';
+
+            if( ( digit > 9U ) || ( value > ( ( UINT32_MAX - digit ) / 10U ) ) )
+            {
+                status = FleetProvisioningError;
+            }
+            else
+            {
+                value = ( value * 10U ) + digit;
+            }
+        }
+    }
+    else
+    {
+        item.pBuffer = pCursor->pBuffer;
+        item.length = pValue->offset + pValue->length;
+        item.index = pValue->offset;
+
+        /* #readCborValue already read this header when it found the value. */
+        ( void ) readCborHeader( &item, &majorType, &value );
+
+        /* Arguments saturated by #readCborHeader are out of range. */
+        if( ( majorType != CBOR_MAJOR_TYPE_UNSIGNED ) || ( value == UINT32_MAX ) )
+        {
+            status = FleetProvisioningError;
+        }
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        *pOutValue = value;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t addDeviceConfigEntry( FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                       const PayloadCursor_t * pCursor,
+                                                       const PayloadRegion_t * pKey,
+                                                       const PayloadRegion_t * pValue )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    FleetProvisioningDeviceConfigEntry_t * pEntry;
+    size_t slot;
+
+    if( pResponse->entryCount >= FP_DEVICE_CONFIG_MAX_ENTRIES )
+    {
+        status = FleetProvisioningBufferTooSmall;
+
+        LogError( ( "Device configuration has more than %u entries.",
+                    ( unsigned int ) FP_DEVICE_CONFIG_MAX_ENTRIES ) );
+    }
+    else if( pKey->length > UINT16_MAX )
+    {
+        status = FleetProvisioningError;
+
+        LogError( ( "Device configuration key is longer than %u bytes.",
+                    ( unsigned int ) UINT16_MAX ) );
+    }
+    else
+    {
+        pEntry = &( pResponse->entries[ pResponse->entryCount ] );
+        pEntry->keyHash = FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS,
+                                                       &( pCursor->pBuffer[ pKey->offset ] ),
+                                                       pKey->length );
+        pEntry->keyOffset = ( uint32_t ) pKey->offset;
+        pEntry->keyLength = ( uint16_t ) pKey->length;
+        pEntry->valueOffset = ( uint32_t ) pValue->offset;
+        pEntry->valueLength = ( uint32_t ) pValue->length;
+
+        /* Linear probing. The table is never more than half full, so a free
+         * slot is always found. */
+        slot = pEntry->keyHash % FP_DEVICE_CONFIG_INDEX_SLOTS;
+
+        while( pResponse->slots[ slot ] != 0U )
+        {
+            slot = ( slot + 1U ) % FP_DEVICE_CONFIG_INDEX_SLOTS;
+        }
+
+        pResponse->entryCount++;
+        pResponse->slots[ slot ] = ( uint8_t ) pResponse->entryCount;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t parseDeviceConfig( PayloadCursor_t * pCursor,
+                                                    FleetProvisioningFormat_t format,
+                                                    FleetProvisioningRegisterThingResponse_t * pResponse )
+{
+    FleetProvisioningStatus_t status;
+    PayloadMap_t map;
+    PayloadRegion_t key = { 0 };
+    PayloadRegion_t value = { 0 };
+    uint8_t isString = 0U;
+
+    status = readMapBegin( pCursor, format, &map );
+
+    while( status == FleetProvisioningSuccess )
+    {
+        status = readMapKey( pCursor, &map, &key );
+
+        if( status == FleetProvisioningSuccess )
+        {
+            status = readMapValue( pCursor, &map, &value, &isString );
+        }
+
+        if( status == FleetProvisioningSuccess )
+        {
+            status = addDeviceConfigEntry( pResponse, pCursor, &key, &value );
+        }
+    }
+
+    if( status == FleetProvisioningNoMatch )
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t parseResponseMember( PayloadCursor_t * pCursor,
+                                                      const PayloadMap_t * pMap,
+                                                      const PayloadRegion_t * pKey,
+                                                      FleetProvisioningRegisterThingResponse_t * pResponse )
+{
+    FleetProvisioningStatus_t status;
+    PayloadRegion_t value = { 0 };
+    uint8_t isString = 0U;
+
+    if( regionEquals( pCursor, pKey, FP_API_DEVICE_CONFIG_KEY, FP_API_LENGTH_DEVICE_CONFIG_KEY ) == 1U )
+    {
+        status = parseDeviceConfig( pCursor, pMap->format, pResponse );
+    }
+    else
+    {
+        status = readMapValue( pCursor, pMap, &value, &isString );
+
+        if( ( status == FleetProvisioningSuccess ) &&
+            ( regionEquals( pCursor, pKey, FP_API_THING_NAME_KEY, FP_API_LENGTH_THING_NAME_KEY ) == 1U ) )
+        {
+            status = ( isString == 1U ) ? FleetProvisioningSuccess : FleetProvisioningError;
+            pResponse->thingName.pData = &( pCursor->pBuffer[ value.offset ] );
+            pResponse->thingName.length = value.length;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ParseRegisterThingAccepted( const char * pPayload,
+                                                                        size_t payloadLength,
+                                                                        FleetProvisioningFormat_t format,
+                                                                        FleetProvisioningRegisterThingResponse_t * pOutResponse )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadCursor_t cursor = { NULL, 0U, 0U };
+    PayloadMap_t map = { FleetProvisioningJson, 0U, 0U };
+    PayloadRegion_t key = { 0 };
+
+    if( ( pPayload == NULL ) ||
+        ( payloadLength == 0U ) ||
+        ( ( uint64_t ) payloadLength > UINT32_MAX ) ||
+        ( ( format != FleetProvisioningJson ) && ( format != FleetProvisioningCbor ) ) ||
+        ( pOutResponse == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPayload: %p, payloadLength: %lu, format: %d,"
+                    " pOutResponse: %p.",
+                    ( const void * ) pPayload,
+                    ( unsigned long ) payloadLength,
+                    ( int ) format,
+                    ( void * ) pOutResponse ) );
+    }
+    else
+    {
+        ( void ) memset( pOutResponse, 0, sizeof( *pOutResponse ) );
+        pOutResponse->pPayload = pPayload;
+
+        cursor.pBuffer = pPayload;
+        cursor.length = payloadLength;
+        cursor.index = 0U;
+
+        status = readMapBegin( &cursor, format, &map );
+    }
+
+    while( status == FleetProvisioningSuccess )
+    {
+        status = readMapKey( &cursor, &map, &key );
+
+        if( status == FleetProvisioningSuccess )
+        {
+            status = parseResponseMember( &cursor, &map, &key, pOutResponse );
+        }
+    }
+
+    if( status == FleetProvisioningNoMatch )
+    {
+        status = ( pOutResponse->thingName.pData != NULL ) ? FleetProvisioningSuccess : FleetProvisioningError;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfParseRegisterThingAccepted, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetDeviceConfigValue( const FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                                  const char * pKey,
+                                                                  size_t keyLength,
+                                                                  FleetProvisioningSpan_t * pOutValue )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    const FleetProvisioningDeviceConfigEntry_t * pEntry;
+    uint32_t hash;
+    size_t slot;
+    size_t probes;
+
+    if( ( pResponse == NULL ) || ( pKey == NULL ) || ( pOutValue == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pResponse: %p, pKey: %p, pOutValue: %p.",
+                    ( const void * ) pResponse,
+                    ( const void * ) pKey,
+                    ( void * ) pOutValue ) );
+    }
+    else
+    {
+        status = FleetProvisioningNoMatch;
+        hash = FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, pKey, keyLength );
+        slot = hash % FP_DEVICE_CONFIG_INDEX_SLOTS;
+
+        for( probes = 0U; ( probes < FP_DEVICE_CONFIG_INDEX_SLOTS ) && ( pResponse->slots[ slot ] != 0U ); probes++ )
+        {
+            pEntry = &( pResponse->entries[ pResponse->slots[ slot ] - 1U ] );
+
+            if( ( pEntry->keyHash == hash ) &&
+                ( pEntry->keyLength == keyLength ) &&
+                ( memcmp( &( pResponse->pPayload[ pEntry->keyOffset ] ), pKey, keyLength ) == 0 ) )
+            {
+                pOutValue->pData = &( pResponse->pPayload[ pEntry->valueOffset ] );
+                pOutValue->length = pEntry->valueLength;
+                status = FleetProvisioningSuccess;
+                break;
+            }
+
+            slot = ( slot + 1U ) % FP_DEVICE_CONFIG_INDEX_SLOTS;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetDeviceConfigValue, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetDeviceConfigEntry( const FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                                  size_t index,
+                                                                  FleetProvisioningSpan_t * pOutKey,
+                                                                  FleetProvisioningSpan_t * pOutValue )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    const FleetProvisioningDeviceConfigEntry_t * pEntry;
+
+    if( ( pResponse == NULL ) || ( pOutKey == NULL ) || ( pOutValue == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pResponse: %p, pOutKey: %p, pOutValue: %p.",
+                    ( const void * ) pResponse,
+                    ( void * ) pOutKey,
+                    ( void * ) pOutValue ) );
+    }
+    else if( index >= pResponse->entryCount )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else
+    {
+        pEntry = &( pResponse->entries[ index ] );
+        pOutKey->pData = &( pResponse->pPayload[ pEntry->keyOffset ] );
+        pOutKey->length = pEntry->keyLength;
+        pOutValue->pData = &( pResponse->pPayload[ pEntry->valueOffset ] );
+        pOutValue->length = pEntry->valueLength;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetDeviceConfigEntry, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetResponseString( const char * pPayload,
+                                                               size_t payloadLength,
+                                                               FleetProvisioningFormat_t format,
+                                                               const char * pKey,
+                                                               size_t keyLength,
+                                                               FleetProvisioningSpan_t * pOutValue )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadCursor_t cursor = { NULL, 0U, 0U };
+    PayloadRegion_t value = { 0 };
+    uint8_t isString = 0U;
+
+    if( ( pPayload == NULL ) || ( payloadLength == 0U ) ||
+        ( ( format != FleetProvisioningJson ) && ( format != FleetProvisioningCbor ) ) ||
+        ( pKey == NULL ) || ( pOutValue == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPayload: %p, payloadLength: %lu, format: %d,"
+                    " pKey: %p, pOutValue: %p.",
+                    ( const void * ) pPayload,
+                    ( unsigned long ) payloadLength,
+                    ( int ) format,
+                    ( const void * ) pKey,
+                    ( void * ) pOutValue ) );
+    }
+    else
+    {
+        cursor.pBuffer = pPayload;
+        cursor.length = payloadLength;
+        cursor.index = 0U;
+
+        status = findMember( &cursor, format, pKey, keyLength, &value, &isString );
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( isString == 0U ) )
+    {
+        status = FleetProvisioningError;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pOutValue->pData = &( pPayload[ value.offset ] );
+        pOutValue->length = value.length;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetResponseString, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetResponseStatusCode( const char * pPayload,
+                                                                   size_t payloadLength,
+                                                                   FleetProvisioningFormat_t format,
+                                                                   uint32_t * pOutStatusCode )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadCursor_t cursor = { NULL, 0U, 0U };
+    PayloadRegion_t value = { 0 };
+    uint8_t isString = 0U;
+
+    if( ( pPayload == NULL ) || ( payloadLength == 0U ) ||
+        ( ( format != FleetProvisioningJson ) && ( format != FleetProvisioningCbor ) ) ||
+        ( pOutStatusCode == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPayload: %p, payloadLength: %lu, format: %d,"
+                    " pOutStatusCode: %p.",
+                    ( const void * ) pPayload,
+                    ( unsigned long ) payloadLength,
+                    ( int ) format,
+                    ( void * ) pOutStatusCode ) );
+    }
+    else
+    {
+        cursor.pBuffer = pPayload;
+        cursor.length = payloadLength;
+        cursor.index = 0U;
+
+        status = findMember( &cursor, format, FP_API_STATUS_CODE_KEY,
+                             FP_API_LENGTH_STATUS_CODE_KEY, &value, &isString );
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( isString == 1U ) )
+    {
+        status = FleetProvisioningError;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = readUnsignedValue( &cursor, format, &value, pOutStatusCode );
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetResponseStatusCode, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
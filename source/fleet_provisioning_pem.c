@@ -0,0 +1,1207 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_pem.c
+ * @brief Implementation of PEM and DER conversion for the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Fleet Provisioning PEM include. */
+#include "fleet_provisioning_pem.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+#if ( FP_ENABLE_SIMD_BASE64 == 1 ) && defined( __SSSE3__ )
+    #include <tmmintrin.h>
+    #define FP_BASE64_USE_SSSE3
+#elif ( FP_ENABLE_SIMD_BASE64 == 1 ) && defined( __ARM_NEON )
+    #include <arm_neon.h>
+    #define FP_BASE64_USE_NEON
+#endif
+
+/**
+ * @brief Start of the PEM header line.
+ */
+#define PEM_BEGIN_MARKER           "-----BEGIN "
+
+/**
+ * @brief Length of #PEM_BEGIN_MARKER.
+ */
+#define PEM_BEGIN_MARKER_LENGTH    ( sizeof( PEM_BEGIN_MARKER ) - 1U )
+
+/**
+ * @brief Start of the PEM footer line.
+ */
+#define PEM_END_MARKER             "-----END "
+
+/**
+ * @brief Length of #PEM_END_MARKER.
+ */
+#define PEM_END_MARKER_LENGTH      ( sizeof( PEM_END_MARKER ) - 1U )
+
+/**
+ * @brief Dashes closing the PEM header and footer lines.
+ */
+#define PEM_DASHES                 "-----"
+
+/**
+ * @brief Length of #PEM_DASHES.
+ */
+#define PEM_DASHES_LENGTH          ( sizeof( PEM_DASHES ) - 1U )
+
+/**
+ * @brief Value in #base64DecodeTable of characters outside the alphabet.
+ */
+#define BASE64_INVALID             ( 0xFFU )
+
+/**
+ * @brief Base64 padding character.
+ */
+#define BASE64_PAD                 '='
+
+/**
+ * @brief Line break written between PEM lines in JSON payloads.
+ */
+#define PEM_JSON_LINE_BREAK        "\\n"
+
+/**
+ * @brief Length of #PEM_JSON_LINE_BREAK.
+ */
+#define PEM_JSON_LINE_BREAK_LENGTH ( sizeof( PEM_JSON_LINE_BREAK ) - 1U )
+
+/**
+ * @brief Line break written between PEM lines in CBOR payloads.
+ */
+#define PEM_CBOR_LINE_BREAK        "\n"
+
+/**
+ * @brief Length of #PEM_CBOR_LINE_BREAK.
+ */
+#define PEM_CBOR_LINE_BREAK_LENGTH ( sizeof( PEM_CBOR_LINE_BREAK ) - 1U )
+
+/**
+ * @brief Number of DER bytes encoded on each 64 character PEM body line.
+ */
+#define PEM_LINE_BYTES             ( 48U )
+
+/**
+ * @brief Largest DER length accepted for encoding, which keeps the length
+ * calculation of the PEM data from overflowing.
+ */
+#define PEM_MAX_DER_LENGTH         ( SIZE_MAX / 2U )
+
+/**
+ * @brief Largest PEM label length accepted for encoding.
+ */
+#define PEM_MAX_LABEL_LENGTH       ( 64U )
+
+/**
+ * @brief Base64 characters of each value.
+ */
+static const char base64EncodeTable[ 64 ] =
+{
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+/**
+ * @brief Base64 values of each character, or #BASE64_INVALID.
+ */
+static const uint8_t base64DecodeTable[ 256 ] =
+{
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0x3EU, 0xFFU, 0xFFU, 0xFFU, 0x3FU,
+    0x34U, 0x35U, 0x36U, 0x37U, 0x38U, 0x39U, 0x3AU, 0x3BU, 0x3CU, 0x3DU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0x00U, 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU,
+    0x0FU, 0x10U, 0x11U, 0x12U, 0x13U, 0x14U, 0x15U, 0x16U, 0x17U, 0x18U, 0x19U, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0x1AU, 0x1BU, 0x1CU, 0x1DU, 0x1EU, 0x1FU, 0x20U, 0x21U, 0x22U, 0x23U, 0x24U, 0x25U, 0x26U, 0x27U, 0x28U,
+    0x29U, 0x2AU, 0x2BU, 0x2CU, 0x2DU, 0x2EU, 0x2FU, 0x30U, 0x31U, 0x32U, 0x33U, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+    0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU
+};
+
+/**
+ * @brief Get the number of characters making up a line break, whitespace,
+ * or JSON line break escape at the start of the given data.
+ *
+ * @param[in] pData The data to check.
+ * @param[in] length The length of @p pData.
+ *
+ * @return The number of characters to skip, or 0 if @p pData does not start
+ * with a line break or whitespace.
+ */
+static size_t lineBreakLength( const char * pData,
+                               size_t length );
+
+/**
+ * @brief Find the given string in the data.
+ *
+ * @param[in] pData The data to search.
+ * @param[in] length The length of @p pData.
+ * @param[in] pString The string to find.
+ * @param[in] stringLength The length of @p pString.
+ * @param[out] pOutIndex The index of the first occurrence of @p pString.
+ *
+ * @return FleetProvisioningSuccess if the string is found;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t findString( const char * pData,
+                                             size_t length,
+                                             const char * pString,
+                                             size_t stringLength,
+                                             size_t * pOutIndex );
+
+/**
+ * @brief Skip the PEM header line.
+ *
+ * @param[in] pPem The PEM data.
+ * @param[in] pemLength The length of @p pPem.
+ * @param[out] pOutBodyStart The index of the first character after the
+ * header line.
+ *
+ * @return FleetProvisioningSuccess if a header is found;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t skipPemHeader( const char * pPem,
+                                                size_t pemLength,
+                                                size_t * pOutBodyStart );
+
+/**
+ * @brief Move the base64 characters of the PEM body to the start of the
+ * buffer, dropping line breaks and unescaping JSON escaped slashes, and
+ * check that the footer follows the body.
+ *
+ * @param[in,out] pPem The PEM data.
+ * @param[in] pemLength The length of @p pPem.
+ * @param[in] bodyStart The index of the first character of the body.
+ * @param[out] pOutBase64Length The number of base64 characters.
+ *
+ * @return FleetProvisioningSuccess if the body is compacted;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t compactPemBody( char * pPem,
+                                                 size_t pemLength,
+                                                 size_t bodyStart,
+                                                 size_t * pOutBase64Length );
+
+/**
+ * @brief Decode one group of four base64 characters without padding.
+ *
+ * @param[in] pIn The four characters to decode.
+ * @param[out] pOut The three decoded bytes. May overlap @p pIn.
+ *
+ * @return FleetProvisioningSuccess if the characters are valid;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t decodeQuantum( const char * pIn,
+                                                char * pOut );
+
+/**
+ * @brief Decode the last group of four base64 characters, which may be
+ * padded.
+ *
+ * @param[in] pIn The four characters to decode.
+ * @param[out] pOut The decoded bytes. May overlap @p pIn.
+ * @param[out] pOutLength The number of decoded bytes.
+ *
+ * @return FleetProvisioningSuccess if the characters are valid;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t decodeFinalQuantum( const char * pIn,
+                                                     char * pOut,
+                                                     size_t * pOutLength );
+
+/**
+ * @brief Decode base64 data in place.
+ *
+ * @param[in,out] pData The base64 data, overwritten with the decoded bytes.
+ * @param[in] length The length of the base64 data.
+ * @param[out] pOutLength The number of decoded bytes.
+ *
+ * @return FleetProvisioningSuccess if the data is decoded;
+ * FleetProvisioningError otherwise.
+ */
+static FleetProvisioningStatus_t decodeBase64( char * pData,
+                                               size_t length,
+                                               size_t * pOutLength );
+
+/**
+ * @brief Get the line break written between PEM lines in the given format.
+ *
+ * @param[in] format The format of the payload the PEM data is placed in.
+ * @param[out] pOutLength The length of the line break.
+ *
+ * @return The line break.
+ */
+static const char * pemLineBreak( FleetProvisioningFormat_t format,
+                                  size_t * pOutLength );
+
+/**
+ * @brief Get the length of the PEM encoding of DER data.
+ *
+ * @param[in] derLength The length of the DER data.
+ * @param[in] labelLength The length of the PEM label.
+ * @param[in] lineBreakLength The length of each line break.
+ *
+ * @return The length of the PEM data.
+ */
+static size_t getPemLength( size_t derLength,
+                            size_t labelLength,
+                            size_t lineBreakLength );
+
+/**
+ * @brief Write a PEM header or footer line, followed by a line break.
+ *
+ * @param[out] pOut The buffer to write to.
+ * @param[in] pMarker #PEM_BEGIN_MARKER or #PEM_END_MARKER.
+ * @param[in] markerLength The length of @p pMarker.
+ * @param[in] pLabel The PEM label.
+ * @param[in] labelLength The length of @p pLabel.
+ * @param[in] format The format of the payload the PEM data is placed in.
+ *
+ * @return The number of characters written.
+ */
+static size_t writeArmorLine( char * pOut,
+                              const char * pMarker,
+                              size_t markerLength,
+                              const char * pLabel,
+                              size_t labelLength,
+                              FleetProvisioningFormat_t format );
+
+/**
+ * @brief Encode up to three bytes as a group of four base64 characters,
+ * padding the group if fewer than three bytes are given.
+ *
+ * @param[in] pIn The bytes to encode.
+ * @param[in] length The number of bytes to encode, from 1 to 3.
+ * @param[out] pOut The four base64 characters.
+ */
+static void encodeQuantum( const uint8_t * pIn,
+                           size_t length,
+                           char * pOut );
+
+/**
+ * @brief Encode one line of the PEM body.
+ *
+ * @param[in] pIn The bytes to encode.
+ * @param[in] length The number of bytes to encode, at most #PEM_LINE_BYTES.
+ * @param[in] available The number of bytes that may be read from @p pIn,
+ * which may exceed @p length.
+ * @param[out] pOut The base64 characters.
+ *
+ * @return The number of characters written.
+ */
+static size_t encodeBase64Line( const uint8_t * pIn,
+                                size_t length,
+                                size_t available,
+                                char * pOut );
+
+/**
+ * @brief Write the PEM encoding of DER data.
+ *
+ * @param[in] pDer The DER data to encode.
+ * @param[in] derLength The length of @p pDer.
+ * @param[in] pLabel The PEM label.
+ * @param[in] labelLength The length of @p pLabel.
+ * @param[in] format The format of the payload the PEM data is placed in.
+ * @param[out] pBuffer The buffer to write to, large enough for the PEM data.
+ */
+static void writePem( const uint8_t * pDer,
+                      size_t derLength,
+                      const char * pLabel,
+                      size_t labelLength,
+                      FleetProvisioningFormat_t format,
+                      char * pBuffer );
+
+/**
+ * @brief Validate the parameters of #FleetProvisioning_DerToPem.
+ *
+ * @param[in] pDer The DER data to encode.
+ * @param[in] derLength The length of @p pDer.
+ * @param[in] pLabel The PEM label.
+ * @param[in] labelLength The length of @p pLabel.
+ * @param[in] format The format of the payload the PEM data is placed in.
+ *
+ * @return FleetProvisioningSuccess if the parameters are valid;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t validateDerToPemParameters( const uint8_t * pDer,
+                                                             size_t derLength,
+                                                             const char * pLabel,
+                                                             size_t labelLength,
+                                                             FleetProvisioningFormat_t format );
+
+#if defined( FP_BASE64_USE_SSSE3 ) || defined( FP_BASE64_USE_NEON )
+
+/**
+ * @brief Encode whole blocks of bytes as base64 with SIMD instructions.
+ *
+ * Stops before the bytes that do not fill a block, leaving them to the
+ * portable implementation to encode.
+ *
+ * @param[in] pIn The bytes to encode.
+ * @param[in] length The number of bytes to encode.
+ * @param[in] available The number of bytes that may be read from @p pIn,
+ * which may exceed @p length.
+ * @param[out] pOut The base64 characters.
+ *
+ * @return The number of bytes encoded, a multiple of 3.
+ */
+    static size_t encodeBase64Simd( const uint8_t * pIn,
+                                    size_t length,
+                                    size_t available,
+                                    char * pOut );
+
+/**
+ * @brief Decode whole blocks of base64 data with SIMD instructions.
+ *
+ * Stops before the last group of four characters, which may be padded, and
+ * at the first block holding a character outside the alphabet, leaving it to
+ * the portable implementation to handle.
+ *
+ * @param[in,out] pData The base64 data, overwritten with the decoded bytes.
+ * @param[in] length The length of the base64 data.
+ * @param[out] pOutLength The number of decoded bytes.
+ *
+ * @return The number of base64 characters decoded.
+ */
+    static size_t decodeBase64Simd( char * pData,
+                                    size_t length,
+                                    size_t * pOutLength );
+#endif
+/*-----------------------------------------------------------*/
+
+static size_t lineBreakLength( const char * pData,
+                               size_t length )
+{
+    size_t ret = 0U;
+
+    if( ( pData[ 0 ] == '\n' ) || ( pData[ 0 ] == '\r' ) ||
+        ( pData[ 0 ] == ' ' ) || ( pData[ 0 ] == '\t' ) )
+    {
+        ret = 1U;
+    }
+    else if( ( length >= 2U ) && ( pData[ 0 ] == '\\' ) &&
+             ( ( pData[ 1 ] == 'n' ) || ( pData[ 1 ] == 'r' ) ) )
+    {
+        ret = 2U;
+    }
+    else
+    {
+        /* Not a line break. */
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t findString( const char * pData,
+                                             size_t length,
+                                             const char * pString,
+                                             size_t stringLength,
+                                             size_t * pOutIndex )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    size_t i;
+
+    for( i = 0U; ( i + stringLength ) <= length; i++ )
+    {
+        if( memcmp( &( pData[ i ] ), pString, stringLength ) == 0 )
+        {
+            *pOutIndex = i;
+            status = FleetProvisioningSuccess;
+            break;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t skipPemHeader( const char * pPem,
+                                                size_t pemLength,
+                                                size_t * pOutBodyStart )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    size_t index = 0U;
+    size_t skip = 1U;
+    size_t labelEnd = 0U;
+
+    /* Skip any line breaks before the header. */
+    while( ( index < pemLength ) && ( skip > 0U ) )
+    {
+        skip = lineBreakLength( &( pPem[ index ] ), pemLength - index );
+        index += skip;
+    }
+
+    if( ( ( pemLength - index ) >= PEM_BEGIN_MARKER_LENGTH ) &&
+        ( memcmp( &( pPem[ index ] ), PEM_BEGIN_MARKER, PEM_BEGIN_MARKER_LENGTH ) == 0 ) )
+    {
+        index += PEM_BEGIN_MARKER_LENGTH;
+
+        /* The label, such as CERTIFICATE, ends at the closing dashes. */
+        if( findString( &( pPem[ index ] ),
+                        pemLength - index,
+                        PEM_DASHES,
+                        PEM_DASHES_LENGTH,
+                        &labelEnd ) == FleetProvisioningSuccess )
+        {
+            *pOutBodyStart = index + labelEnd + PEM_DASHES_LENGTH;
+            status = FleetProvisioningSuccess;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t compactPemBody( char * pPem,
+                                                 size_t pemLength,
+                                                 size_t bodyStart,
+                                                 size_t * pOutBase64Length )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    size_t readIndex = bodyStart;
+    size_t writeIndex = 0U;
+    size_t skip;
+
+    /* The write index never passes the read index, so the body can be moved
+     * within the same buffer. */
+    while( ( readIndex < pemLength ) && ( pPem[ readIndex ] != '-' ) )
+    {
+        skip = lineBreakLength( &( pPem[ readIndex ] ), pemLength - readIndex );
+
+        if( skip > 0U )
+        {
+            readIndex += skip;
+        }
+        else
+        {
+            /* JSON encoders may escape the base64 character '/' as "\/". */
+            if( ( pPem[ readIndex ] == '\\' ) &&
+                ( ( pemLength - readIndex ) >= 2U ) &&
+                ( pPem[ readIndex + 1U ] == '/' ) )
+            {
+                readIndex++;
+            }
+
+            pPem[ writeIndex ] = pPem[ readIndex ];
+            writeIndex++;
+            readIndex++;
+        }
+    }
+
+    if( ( ( pemLength - readIndex ) >= PEM_END_MARKER_LENGTH ) &&
+        ( memcmp( &( pPem[ readIndex ] ), PEM_END_MARKER, PEM_END_MARKER_LENGTH ) == 0 ) )
+    {
+        *pOutBase64Length = writeIndex;
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t decodeQuantum( const char * pIn,
+                                                char * pOut )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    uint32_t a = base64DecodeTable[ ( uint8_t ) pIn[ 0 ] ];
+    uint32_t b = base64DecodeTable[ ( uint8_t ) pIn[ 1 ] ];
+    uint32_t c = base64DecodeTable[ ( uint8_t ) pIn[ 2 ] ];
+    uint32_t d = base64DecodeTable[ ( uint8_t ) pIn[ 3 ] ];
+    uint32_t bits;
+
+    /* All four characters are read before any output is written, as the
+     * output may overlap the input. */
+    if( ( ( a | b | c | d ) & 0x80U ) == 0U )
+    {
+        bits = ( a << 18U ) | ( b << 12U ) | ( c << 6U ) | d;
+        pOut[ 0 ] = ( char ) ( uint8_t ) ( bits >> 16U );
+        pOut[ 1 ] = ( char ) ( uint8_t ) ( bits >> 8U );
+        pOut[ 2 ] = ( char ) ( uint8_t ) bits;
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t decodeFinalQuantum( const char * pIn,
+                                                     char * pOut,
+                                                     size_t * pOutLength )
+{
+    FleetProvisioningStatus_t status;
+    char quantum[ 4 ];
+    size_t padding = 0U;
+
+    ( void ) memcpy( quantum, pIn, sizeof( quantum ) );
+
+    /* Decode padding as zero bits, then drop the bytes it stands for. */
+    if( quantum[ 3 ] == BASE64_PAD )
+    {
+        quantum[ 3 ] = 'A';
+        padding = 1U;
+
+        if( quantum[ 2 ] == BASE64_PAD )
+        {
+            quantum[ 2 ] = 'A';
+            padding = 2U;
+        }
+    }
+
+    status = decodeQuantum( quantum, quantum );
+
+    if( status == FleetProvisioningSuccess )
+    {
+        *pOutLength = 3U - padding;
+        ( void ) memcpy( pOut, quantum, *pOutLength );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+#if defined( FP_BASE64_USE_SSSE3 )
+
+    static size_t decodeBase64Simd( char * pData,
+                                    size_t length,
+                                    size_t * pOutLength )
+    {
+        /* Lookup tables classifying each character by its low and high nibble,
+         * and giving the offset from ASCII to the base64 value. A character is
+         * outside the alphabet if its two classes have a bit in common. */
+        const __m128i lutLow = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+        const __m128i lutHigh = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+        const __m128i lutRoll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71,
+                                               0, 0, 0, 0, 0, 0, 0, 0 );
+        const __m128i mask2F = _mm_set1_epi8( 0x2F );
+        const __m128i packPairs = _mm_set1_epi32( 0x01400140 );
+        const __m128i packQuads = _mm_set1_epi32( 0x00011000 );
+        const __m128i packBytes = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9,
+                                                 8, 14, 13, 12, -1, -1, -1, -1 );
+        __m128i input;
+        __m128i highNibbles;
+        __m128i lowClass;
+        __m128i highClass;
+        __m128i roll;
+        __m128i values;
+        size_t in = 0U;
+        size_t out = 0U;
+
+        /* 16 characters decode to 12 bytes, stored with a 16 byte write that
+         * never reaches input not yet loaded. */
+        while( ( length - in ) >= 20U )
+        {
+            input = _mm_loadu_si128( ( const __m128i * ) &( pData[ in ] ) );
+            highNibbles = _mm_and_si128( _mm_srli_epi32( input, 4 ), mask2F );
+            lowClass = _mm_shuffle_epi8( lutLow, _mm_and_si128( input, mask2F ) );
+            highClass = _mm_shuffle_epi8( lutHigh, highNibbles );
+
+            if( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_and_si128( lowClass, highClass ),
+                                                   _mm_setzero_si128() ) ) != 0xFFFF )
+            {
+                break;
+            }
+
+            roll = _mm_shuffle_epi8( lutRoll,
+                                     _mm_add_epi8( _mm_cmpeq_epi8( input, mask2F ), highNibbles ) );
+            values = _mm_add_epi8( input, roll );
+            values = _mm_maddubs_epi16( values, packPairs );
+            values = _mm_madd_epi16( values, packQuads );
+            values = _mm_shuffle_epi8( values, packBytes );
+            _mm_storeu_si128( ( __m128i * ) &( pData[ out ] ), values );
+
+            in += 16U;
+            out += 12U;
+        }
+
+        *pOutLength = out;
+
+        return in;
+    }
+
+    static size_t encodeBase64Simd( const uint8_t * pIn,
+                                    size_t length,
+                                    size_t available,
+                                    char * pOut )
+    {
+        /* Shuffle spreading each group of 3 bytes over a 32 bit lane, and the
+         * masks and multipliers moving its four 6 bit values to separate
+         * bytes. */
+        const __m128i spreadBytes = _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4,
+                                                   7, 6, 8, 7, 10, 9, 11, 10 );
+        const __m128i maskAC = _mm_set1_epi32( 0x0FC0FC00 );
+        const __m128i shiftAC = _mm_set1_epi32( 0x04000040 );
+        const __m128i maskBD = _mm_set1_epi32( 0x003F03F0 );
+        const __m128i shiftBD = _mm_set1_epi32( 0x01000010 );
+
+        /* Offset from each value to its character, indexed by the range the
+         * value falls in. */
+        const __m128i lutOffset = _mm_setr_epi8( 71, -4, -4, -4, -4, -4, -4, -4,
+                                                 -4, -4, -4, -19, -16, 65, 0, 0 );
+        __m128i input;
+        __m128i values;
+        __m128i ranges;
+        size_t in = 0U;
+        size_t out = 0U;
+
+        /* 12 bytes encode to 16 characters, using a 16 byte load that must
+         * stay within the readable input. */
+        while( ( ( length - in ) >= 12U ) && ( ( available - in ) >= 16U ) )
+        {
+            input = _mm_loadu_si128( ( const __m128i * ) &( pIn[ in ] ) );
+            input = _mm_shuffle_epi8( input, spreadBytes );
+            values = _mm_or_si128( _mm_mulhi_epu16( _mm_and_si128( input, maskAC ), shiftAC ),
+                                   _mm_mullo_epi16( _mm_and_si128( input, maskBD ), shiftBD ) );
+
+            /* Values 0 to 25 map to range 13, 26 to 51 to range 0, and 52 to
+             * 63 to ranges 1 to 12. */
+            ranges = _mm_subs_epu8( values, _mm_set1_epi8( 51 ) );
+            ranges = _mm_or_si128( ranges,
+                                   _mm_and_si128( _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), values ),
+                                                  _mm_set1_epi8( 13 ) ) );
+            values = _mm_add_epi8( values, _mm_shuffle_epi8( lutOffset, ranges ) );
+            _mm_storeu_si128( ( __m128i * ) &( pOut[ out ] ), values );
+
+            in += 12U;
+            out += 16U;
+        }
+
+        return in;
+    }
+
+#elif defined( FP_BASE64_USE_NEON )
+
+/**
+ * @brief Convert 16 base64 characters to their values.
+ *
+ * @param[in] chars The characters to convert.
+ * @param[in,out] pInvalid Accumulates set bits for characters outside the
+ * alphabet.
+ *
+ * @return The base64 values.
+ */
+    static uint8x16_t translateNeon( uint8x16_t chars,
+                                     uint8x16_t * pInvalid )
+    {
+        uint8x16_t upper = vandq_u8( vcgeq_u8( chars, vdupq_n_u8( ( uint8_t ) 'A' ) ),
+                                     vcleq_u8( chars, vdupq_n_u8( ( uint8_t ) 'Z' ) ) );
+        uint8x16_t lower = vandq_u8( vcgeq_u8( chars, vdupq_n_u8( ( uint8_t ) 'a' ) ),
+                                     vcleq_u8( chars, vdupq_n_u8( ( uint8_t ) 'z' ) ) );
+        uint8x16_t digit = vandq_u8( vcgeq_u8( chars, vdupq_n_u8( ( uint8_t ) '0' ) ),
+                                     vcleq_u8( chars, vdupq_n_u8( ( uint8_t ) '9' ) ) );
+        uint8x16_t plus = vceqq_u8( chars, vdupq_n_u8( ( uint8_t ) '+' ) );
+        uint8x16_t slash = vceqq_u8( chars, vdupq_n_u8( ( uint8_t ) '/' ) );
+        uint8x16_t offset;
+
+        /* Offsets are added modulo 256. */
+        offset = vandq_u8( upper, vdupq_n_u8( ( uint8_t ) ( 256U - 65U ) ) );
+        offset = vbslq_u8( lower, vdupq_n_u8( ( uint8_t ) ( 256U - 71U ) ), offset );
+        offset = vbslq_u8( digit, vdupq_n_u8( 4U ), offset );
+        offset = vbslq_u8( plus, vdupq_n_u8( 19U ), offset );
+        offset = vbslq_u8( slash, vdupq_n_u8( 16U ), offset );
+
+        *pInvalid = vorrq_u8( *pInvalid,
+                              vmvnq_u8( vorrq_u8( vorrq_u8( upper, lower ),
+                                                  vorrq_u8( digit, vorrq_u8( plus, slash ) ) ) ) );
+
+        return vaddq_u8( chars, offset );
+    }
+
+    static size_t decodeBase64Simd( char * pData,
+                                    size_t length,
+                                    size_t * pOutLength )
+    {
+        uint8x16x4_t input;
+        uint8x16x3_t output;
+        uint8x16_t a;
+        uint8x16_t b;
+        uint8x16_t c;
+        uint8x16_t d;
+        uint8x16_t invalid;
+        uint64x2_t invalidLanes;
+        size_t in = 0U;
+        size_t out = 0U;
+
+        /* 64 characters, loaded de-interleaved into the four positions of each
+         * group, decode to 48 bytes. */
+        while( ( length - in ) >= 68U )
+        {
+            input = vld4q_u8( ( const uint8_t * ) &( pData[ in ] ) );
+            invalid = vdupq_n_u8( 0U );
+            a = translateNeon( input.val[ 0 ], &invalid );
+            b = translateNeon( input.val[ 1 ], &invalid );
+            c = translateNeon( input.val[ 2 ], &invalid );
+            d = translateNeon( input.val[ 3 ], &invalid );
+            invalidLanes = vreinterpretq_u64_u8( invalid );
+
+            if( ( vgetq_lane_u64( invalidLanes, 0 ) | vgetq_lane_u64( invalidLanes, 1 ) ) != 0U )
+            {
+                break;
+            }
+
+            output.val[ 0 ] = vorrq_u8( vshlq_n_u8( a, 2 ), vshrq_n_u8( b, 4 ) );
+            output.val[ 1 ] = vorrq_u8( vshlq_n_u8( b, 4 ), vshrq_n_u8( c, 2 ) );
+            output.val[ 2 ] = vorrq_u8( vshlq_n_u8( c, 6 ), d );
+            vst3q_u8( ( uint8_t * ) &( pData[ out ] ), output );
+
+            in += 64U;
+            out += 48U;
+        }
+
+        *pOutLength = out;
+
+        return in;
+    }
+
+
+/**
+ * @brief Convert 16 base64 values to their characters.
+ *
+ * @param[in] values The base64 values, from 0 to 63.
+ *
+ * @return The base64 characters.
+ */
+    static uint8x16_t valuesToCharsNeon( uint8x16_t values )
+    {
+        uint8x16_t offset = vdupq_n_u8( ( uint8_t ) 'A' );
+
+        /* Offsets are added modulo 256. */
+        offset = vbslq_u8( vcgeq_u8( values, vdupq_n_u8( 26U ) ),
+                           vdupq_n_u8( ( uint8_t ) ( 'a' - 26 ) ), offset );
+        offset = vbslq_u8( vcgeq_u8( values, vdupq_n_u8( 52U ) ),
+                           vdupq_n_u8( ( uint8_t ) ( 256U - 4U ) ), offset );
+        offset = vbslq_u8( vceqq_u8( values, vdupq_n_u8( 62U ) ),
+                           vdupq_n_u8( ( uint8_t ) ( 256U - 19U ) ), offset );
+        offset = vbslq_u8( vceqq_u8( values, vdupq_n_u8( 63U ) ),
+                           vdupq_n_u8( ( uint8_t ) ( 256U - 16U ) ), offset );
+
+        return vaddq_u8( values, offset );
+    }
+
+    static size_t encodeBase64Simd( const uint8_t * pIn,
+                                    size_t length,
+                                    size_t available,
+                                    char * pOut )
+    {
+        uint8x16x3_t input;
+        uint8x16x4_t output;
+        size_t in = 0U;
+        size_t out = 0U;
+
+        /* The loads never read past the bytes to encode. */
+        ( void ) available;
+
+        /* 48 bytes, loaded de-interleaved into the three positions of each
+         * group, encode to 64 characters. */
+        while( ( length - in ) >= 48U )
+        {
+            input = vld3q_u8( &( pIn[ in ] ) );
+            output.val[ 0 ] = vshrq_n_u8( input.val[ 0 ], 2 );
+            output.val[ 1 ] = vorrq_u8( vshlq_n_u8( vandq_u8( input.val[ 0 ], vdupq_n_u8( 0x03U ) ), 4 ),
+                                        vshrq_n_u8( input.val[ 1 ], 4 ) );
+            output.val[ 2 ] = vorrq_u8( vshlq_n_u8( vandq_u8( input.val[ 1 ], vdupq_n_u8( 0x0FU ) ), 2 ),
+                                        vshrq_n_u8( input.val[ 2 ], 6 ) );
+            output.val[ 3 ] = vandq_u8( input.val[ 2 ], vdupq_n_u8( 0x3FU ) );
+            output.val[ 0 ] = valuesToCharsNeon( output.val[ 0 ] );
+            output.val[ 1 ] = valuesToCharsNeon( output.val[ 1 ] );
+            output.val[ 2 ] = valuesToCharsNeon( output.val[ 2 ] );
+            output.val[ 3 ] = valuesToCharsNeon( output.val[ 3 ] );
+            vst4q_u8( ( uint8_t * ) &( pOut[ out ] ), output );
+
+            in += 48U;
+            out += 64U;
+        }
+
+        return in;
+    }
+
+#endif /* if defined( FP_BASE64_USE_SSSE3 ) */
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t decodeBase64( char * pData,
+                                               size_t length,
+                                               size_t * pOutLength )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningError;
+    size_t in = 0U;
+    size_t out = 0U;
+    size_t finalLength = 0U;
+
+    if( ( length > 0U ) && ( ( length % 4U ) == 0U ) )
+    {
+        status = FleetProvisioningSuccess;
+
+        #if defined( FP_BASE64_USE_SSSE3 ) || defined( FP_BASE64_USE_NEON )
+            in = decodeBase64Simd( pData, length, &out );
+        #endif
+    }
+
+    while( ( status == FleetProvisioningSuccess ) && ( ( length - in ) > 4U ) )
+    {
+        status = decodeQuantum( &( pData[ in ] ), &( pData[ out ] ) );
+        in += 4U;
+        out += 3U;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = decodeFinalQuantum( &( pData[ in ] ), &( pData[ out ] ), &finalLength );
+        *pOutLength = out + finalLength;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static const char * pemLineBreak( FleetProvisioningFormat_t format,
+                                  size_t * pOutLength )
+{
+    const char * pLineBreak = PEM_CBOR_LINE_BREAK;
+
+    *pOutLength = PEM_CBOR_LINE_BREAK_LENGTH;
+
+    /* JSON strings cannot hold literal newlines, so they are escaped. */
+    if( format == FleetProvisioningJson )
+    {
+        pLineBreak = PEM_JSON_LINE_BREAK;
+        *pOutLength = PEM_JSON_LINE_BREAK_LENGTH;
+    }
+
+    return pLineBreak;
+}
+/*-----------------------------------------------------------*/
+
+static size_t getPemLength( size_t derLength,
+                            size_t labelLength,
+                            size_t lineBreakLength )
+{
+    size_t base64Length = ( ( derLength + 2U ) / 3U ) * 4U;
+    size_t lineCount = ( derLength + ( PEM_LINE_BYTES - 1U ) ) / PEM_LINE_BYTES;
+
+    /* Header line, body lines and footer line, each ending in a line break. */
+    return ( PEM_BEGIN_MARKER_LENGTH + labelLength + PEM_DASHES_LENGTH + lineBreakLength ) +
+           ( base64Length + ( lineCount * lineBreakLength ) ) +
+           ( PEM_END_MARKER_LENGTH + labelLength + PEM_DASHES_LENGTH + lineBreakLength );
+}
+/*-----------------------------------------------------------*/
+
+static size_t writeArmorLine( char * pOut,
+                              const char * pMarker,
+                              size_t markerLength,
+                              const char * pLabel,
+                              size_t labelLength,
+                              FleetProvisioningFormat_t format )
+{
+    const char * pLineBreak;
+    size_t lineBreakLength = 0U;
+    size_t index = 0U;
+
+    pLineBreak = pemLineBreak( format, &lineBreakLength );
+
+    ( void ) memcpy( &( pOut[ index ] ), pMarker, markerLength );
+    index += markerLength;
+    ( void ) memcpy( &( pOut[ index ] ), pLabel, labelLength );
+    index += labelLength;
+    ( void ) memcpy( &( pOut[ index ] ), PEM_DASHES, PEM_DASHES_LENGTH );
+    index += PEM_DASHES_LENGTH;
+    ( void ) memcpy( &( pOut[ index ] ), pLineBreak, lineBreakLength );
+    index += lineBreakLength;
+
+    return index;
+}
+/*-----------------------------------------------------------*/
+
+static void encodeQuantum( const uint8_t * pIn,
+                           size_t length,
+                           char * pOut )
+{
+    uint32_t bits = ( uint32_t ) pIn[ 0 ] << 16U;
+
+    assert( ( length > 0U ) && ( length <= 3U ) );
+
+    pOut[ 2 ] = BASE64_PAD;
+    pOut[ 3 ] = BASE64_PAD;
+
+    if( length > 1U )
+    {
+        bits |= ( uint32_t ) pIn[ 1 ] << 8U;
+    }
+
+    if( length > 2U )
+    {
+        bits |= ( uint32_t ) pIn[ 2 ];
+        pOut[ 3 ] = base64EncodeTable[ bits & 0x3FU ];
+    }
+
+    if( length > 1U )
+    {
+        pOut[ 2 ] = base64EncodeTable[ ( bits >> 6U ) & 0x3FU ];
+    }
+
+    pOut[ 0 ] = base64EncodeTable[ ( bits >> 18U ) & 0x3FU ];
+    pOut[ 1 ] = base64EncodeTable[ ( bits >> 12U ) & 0x3FU ];
+}
+/*-----------------------------------------------------------*/
+
+static size_t encodeBase64Line( const uint8_t * pIn,
+                                size_t length,
+                                size_t available,
+                                char * pOut )
+{
+    size_t in = 0U;
+    size_t out = 0U;
+    size_t remaining;
+
+    assert( length <= available );
+
+    #if defined( FP_BASE64_USE_SSSE3 ) || defined( FP_BASE64_USE_NEON )
+        in = encodeBase64Simd( pIn, length, available, pOut );
+        out = ( in / 3U ) * 4U;
+    #else
+        ( void ) available;
+    #endif
+
+    while( in < length )
+    {
+        remaining = length - in;
+
+        if( remaining > 3U )
+        {
+            remaining = 3U;
+        }
+
+        encodeQuantum( &( pIn[ in ] ), remaining, &( pOut[ out ] ) );
+        in += remaining;
+        out += 4U;
+    }
+
+    return out;
+}
+/*-----------------------------------------------------------*/
+
+static void writePem( const uint8_t * pDer,
+                      size_t derLength,
+                      const char * pLabel,
+                      size_t labelLength,
+                      FleetProvisioningFormat_t format,
+                      char * pBuffer )
+{
+    const char * pLineBreak;
+    size_t lineBreakLength = 0U;
+    size_t lineStart;
+    size_t lineLength;
+    size_t index = 0U;
+
+    pLineBreak = pemLineBreak( format, &lineBreakLength );
+    index += writeArmorLine( &( pBuffer[ index ] ), PEM_BEGIN_MARKER, PEM_BEGIN_MARKER_LENGTH,
+                             pLabel, labelLength, format );
+
+    for( lineStart = 0U; lineStart < derLength; lineStart += lineLength )
+    {
+        lineLength = derLength - lineStart;
+
+        if( lineLength > PEM_LINE_BYTES )
+        {
+            lineLength = PEM_LINE_BYTES;
+        }
+
+        /* All of the remaining DER data may be read, letting the SIMD path
+         * load whole vectors up to the end of the line. */
+        index += encodeBase64Line( &( pDer[ lineStart ] ), lineLength,
+                                   derLength - lineStart, &( pBuffer[ index ] ) );
+        ( void ) memcpy( &( pBuffer[ index ] ), pLineBreak, lineBreakLength );
+        index += lineBreakLength;
+    }
+
+    index += writeArmorLine( &( pBuffer[ index ] ), PEM_END_MARKER, PEM_END_MARKER_LENGTH,
+                             pLabel, labelLength, format );
+
+    assert( index == getPemLength( derLength, labelLength, lineBreakLength ) );
+    ( void ) index;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t validateDerToPemParameters( const uint8_t * pDer,
+                                                             size_t derLength,
+                                                             const char * pLabel,
+                                                             size_t labelLength,
+                                                             FleetProvisioningFormat_t format )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pDer == NULL ) || ( derLength == 0U ) || ( derLength > PEM_MAX_DER_LENGTH ) )
+    {
+        LogError( ( "Invalid DER data. pDer: %p, derLength: %lu.",
+                    ( const void * ) pDer,
+                    ( unsigned long ) derLength ) );
+    }
+    else if( ( pLabel == NULL ) || ( labelLength == 0U ) || ( labelLength > PEM_MAX_LABEL_LENGTH ) )
+    {
+        LogError( ( "Invalid PEM label. pLabel: %p, labelLength: %lu.",
+                    ( const void * ) pLabel,
+                    ( unsigned long ) labelLength ) );
+    }
+    else if( ( format != FleetProvisioningJson ) && ( format != FleetProvisioningCbor ) )
+    {
+        LogError( ( "Invalid format: %d.", ( int ) format ) );
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_PemToDer( char * pPem,
+                                                      size_t pemLength,
+                                                      size_t * pOutDerLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    size_t bodyStart = 0U;
+    size_t base64Length = 0U;
+
+    if( ( pPem == NULL ) || ( pOutDerLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPem: %p, pOutDerLength: %p.",
+                    ( void * ) pPem,
+                    ( void * ) pOutDerLength ) );
+    }
+    else
+    {
+        status = skipPemHeader( pPem, pemLength, &bodyStart );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = compactPemBody( pPem, pemLength, bodyStart, &base64Length );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = decodeBase64( pPem, base64Length, pOutDerLength );
+    }
+
+    if( ( status != FleetProvisioningSuccess ) && ( status != FleetProvisioningBadParameter ) )
+    {
+        LogError( ( "Failed to decode PEM data." ) );
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfPemToDer, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_DerToPem( const uint8_t * pDer,
+                                                      size_t derLength,
+                                                      const char * pLabel,
+                                                      size_t labelLength,
+                                                      FleetProvisioningFormat_t format,
+                                                      char * pBuffer,
+                                                      size_t bufferLength,
+                                                      size_t * pOutLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    size_t lineBreakLength = 0U;
+    size_t requiredLength;
+
+    if( ( pBuffer == NULL ) || ( pOutLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pBuffer: %p, pOutLength: %p.",
+                    ( void * ) pBuffer,
+                    ( void * ) pOutLength ) );
+    }
+    else
+    {
+        status = validateDerToPemParameters( pDer, derLength, pLabel, labelLength, format );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        ( void ) pemLineBreak( format, &lineBreakLength );
+        requiredLength = getPemLength( derLength, labelLength, lineBreakLength );
+
+        if( bufferLength < requiredLength )
+        {
+            LogError( ( "Buffer too small for PEM data. Required: %lu, provided: %lu.",
+                        ( unsigned long ) requiredLength,
+                        ( unsigned long ) bufferLength ) );
+            status = FleetProvisioningBufferTooSmall;
+        }
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        writePem( pDer, derLength, pLabel, labelLength, format, pBuffer );
+        *pOutLength = requiredLength;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfDerToPem, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+size_t FleetProvisioning_GetPemLength( size_t derLength,
+                                       size_t labelLength,
+                                       FleetProvisioningFormat_t format )
+{
+    size_t pemLength = 0U;
+    size_t lineBreakLength = 0U;
+
+    if( ( derLength > 0U ) && ( derLength <= PEM_MAX_DER_LENGTH ) &&
+        ( labelLength > 0U ) && ( labelLength <= PEM_MAX_LABEL_LENGTH ) &&
+        ( ( format == FleetProvisioningJson ) || ( format == FleetProvisioningCbor ) ) )
+    {
+        ( void ) pemLineBreak( format, &lineBreakLength );
+        pemLength = getPemLength( derLength, labelLength, lineBreakLength );
+    }
+
+    return pemLength;
+}
+/*-----------------------------------------------------------*/
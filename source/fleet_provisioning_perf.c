@@ -0,0 +1,101 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_perf.c
+ * @brief Implementation of the optional performance counters of the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+
+/**
+ * @brief The counters set with #FleetProvisioning_PerfSetCounters.
+ */
+    static FleetProvisioningPerfCounters_t * pPerfCounters = NULL;
+
+/*-----------------------------------------------------------*/
+
+    void FleetProvisioning_PerfSetCounters( FleetProvisioningPerfCounters_t * pCounters )
+    {
+        pPerfCounters = pCounters;
+    }
+/*-----------------------------------------------------------*/
+
+    void FleetProvisioning_PerfRecord( FleetProvisioningPerfApi_t api,
+                                       FleetProvisioningStatus_t status,
+                                       uint32_t startCycles )
+    {
+        FleetProvisioningPerfCounters_t * pCounters = pPerfCounters;
+
+        #if ( FP_ENABLE_PERF_HISTOGRAMS != 0 )
+            uint32_t cycles = FP_PERF_READ_CYCLES() - startCycles;
+            uint32_t bucket = 0U;
+        #else
+            ( void ) startCycles;
+        #endif
+
+        if( pCounters != NULL )
+        {
+            FP_ATOMIC_ADD_RELAXED( &pCounters->calls[ api ][ status ], 1U );
+
+            #if ( FP_ENABLE_PERF_HISTOGRAMS != 0 )
+                while( cycles > 1U )
+                {
+                    cycles >>= 1U;
+                    bucket++;
+                }
+
+                FP_ATOMIC_ADD_RELAXED( &pCounters->cycles[ api ][ bucket ], 1U );
+            #endif
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void FleetProvisioning_PerfRecordTopic( FleetProvisioningTopic_t topic )
+    {
+        FleetProvisioningPerfCounters_t * pCounters = pPerfCounters;
+
+        if( pCounters != NULL )
+        {
+            FP_ATOMIC_ADD_RELAXED( &pCounters->topics[ topic ], 1U );
+        }
+    }
+/*-----------------------------------------------------------*/
+
+#else /* if ( FP_ENABLE_PERF_COUNTERS != 0 ) */
+
+/**
+ * @brief ISO C does not allow an empty translation unit.
+ */
+    typedef int FleetProvisioningPerfDisabled_t;
+
+#endif /* if ( FP_ENABLE_PERF_COUNTERS != 0 ) */
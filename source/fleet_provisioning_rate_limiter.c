@@ -0,0 +1,210 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_rate_limiter.c
+ * @brief Implementation of the token-bucket rate limiter for the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning rate limiter include. */
+#include "fleet_provisioning_rate_limiter.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Largest number of ticks between two calls that is counted. Larger
+ * differences come from a tick counter that wrapped while the bucket was
+ * idle.
+ */
+#define MAX_ELAPSED_TICKS    ( 0x7FFFFFFFU )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the credits earned since the last refill to a bucket.
+ *
+ * @param[in] pBucket The bucket, which must be limited.
+ * @param[in] now The current tick.
+ */
+static void refillBucket( FleetProvisioningTokenBucket_t * pBucket,
+                          uint32_t now );
+
+/**
+ * @brief Check the limit of an API.
+ *
+ * @param[in] pLimit The limit.
+ *
+ * @return FleetProvisioningSuccess if the limit is valid;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t checkLimit( const FleetProvisioningRateLimit_t * pLimit );
+
+/*-----------------------------------------------------------*/
+
+static void refillBucket( FleetProvisioningTokenBucket_t * pBucket,
+                          uint32_t now )
+{
+    uint32_t elapsed = now - pBucket->lastTick;
+    uint32_t headroom = pBucket->capacity - pBucket->credits;
+
+    /* A bucket idle for 2^31 ticks or more is full, however many ticks the
+     * wrapped difference shows. Otherwise, compare before multiplying, so
+     * the product cannot wrap. */
+    if( ( elapsed > MAX_ELAPSED_TICKS ) || ( elapsed > ( headroom / pBucket->creditsPerTick ) ) )
+    {
+        pBucket->credits = pBucket->capacity;
+    }
+    else
+    {
+        pBucket->credits += elapsed * pBucket->creditsPerTick;
+    }
+
+    pBucket->lastTick = now;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t checkLimit( const FleetProvisioningRateLimit_t * pLimit )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+
+    if( pLimit->requestsPerPeriod == 0U )
+    {
+        /* No limit. */
+    }
+    else if( ( pLimit->periodTicks == 0U ) || ( pLimit->burst == 0U ) ||
+             ( pLimit->burst > ( UINT32_MAX / pLimit->periodTicks ) ) )
+    {
+        LogError( ( "Invalid rate limit. requestsPerPeriod: %lu, periodTicks: %lu, burst: %lu.",
+                    ( unsigned long ) pLimit->requestsPerPeriod,
+                    ( unsigned long ) pLimit->periodTicks,
+                    ( unsigned long ) pLimit->burst ) );
+        status = FleetProvisioningBadParameter;
+    }
+    else
+    {
+        /* Valid limit. */
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_RateLimiterInit( FleetProvisioningRateLimiter_t * pLimiter,
+                                                             const FleetProvisioningRateLimit_t * pLimits,
+                                                             uint32_t now )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningTokenBucket_t * pBucket;
+    size_t i;
+
+    if( ( pLimiter == NULL ) || ( pLimits == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pLimiter: %p, pLimits: %p.",
+                    ( void * ) pLimiter,
+                    ( const void * ) pLimits ) );
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+
+        for( i = 0U; ( status == FleetProvisioningSuccess ) && ( i < FP_API_COUNT ); i++ )
+        {
+            status = checkLimit( &( pLimits[ i ] ) );
+        }
+    }
+
+    for( i = 0U; ( status == FleetProvisioningSuccess ) && ( i < FP_API_COUNT ); i++ )
+    {
+        pBucket = &( pLimiter->buckets[ i ] );
+        pBucket->creditsPerTick = pLimits[ i ].requestsPerPeriod;
+        pBucket->cost = pLimits[ i ].periodTicks;
+        pBucket->capacity = pLimits[ i ].burst * pLimits[ i ].periodTicks;
+        pBucket->credits = pBucket->capacity;
+        pBucket->lastTick = now;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfRateLimiterInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_RateLimiterTryAcquire( FleetProvisioningRateLimiter_t * pLimiter,
+                                                                   FleetProvisioningTopic_t request,
+                                                                   uint32_t now,
+                                                                   uint32_t * pOutWaitTicks )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+    FleetProvisioningTokenBucket_t * pBucket;
+    uint32_t missing;
+
+    if( pLimiter == NULL )
+    {
+        LogError( ( "Invalid input parameter. pLimiter: %p.", ( void * ) pLimiter ) );
+    }
+    else
+    {
+        status = FleetProvisioning_GetTopicInfo( request, &info );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pBucket = &( pLimiter->buckets[ info.api ] );
+
+        if( pBucket->creditsPerTick != 0U )
+        {
+            refillBucket( pBucket, now );
+
+            if( pBucket->credits >= pBucket->cost )
+            {
+                pBucket->credits -= pBucket->cost;
+            }
+            else
+            {
+                status = FleetProvisioningNoMatch;
+
+                if( pOutWaitTicks != NULL )
+                {
+                    missing = pBucket->cost - pBucket->credits;
+                    *pOutWaitTicks = ( missing / pBucket->creditsPerTick ) +
+                                     ( ( ( missing % pBucket->creditsPerTick ) != 0U ) ? 1U : 0U );
+                }
+            }
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfRateLimiterTryAcquire, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,149 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_schedule.c
+ * @brief Implementation of the request scheduling helpers for the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning schedule include. */
+#include "fleet_provisioning_schedule.h"
+
+/* Fleet Provisioning shard include. */
+#include "fleet_provisioning_shard.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+#if ( FP_ROTATION_WINDOW_START_PERCENT >= FP_ROTATION_WINDOW_END_PERCENT ) || ( FP_ROTATION_WINDOW_END_PERCENT > 100U )
+    #error "FP_ROTATION_WINDOW_START_PERCENT must be below FP_ROTATION_WINDOW_END_PERCENT, which must be at most 100."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Spread a device over a window.
+ *
+ * @param[in] pDeviceId The ID of the device.
+ * @param[in] deviceIdLength The length of @p pDeviceId.
+ * @param[in] window The length of the window.
+ *
+ * @return The offset of the device in the window, below @p window; 0 if the
+ * window is empty.
+ */
+static uint32_t spreadDevice( const char * pDeviceId,
+                              size_t deviceIdLength,
+                              uint32_t window );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t spreadDevice( const char * pDeviceId,
+                              size_t deviceIdLength,
+                              uint32_t window )
+{
+    uint32_t offset = 0U;
+
+    /* The offset is the shard of the device among one-unit shards of the
+     * window, which spreads devices evenly. The ID is already checked, so
+     * the status is always success. */
+    if( window > 0U )
+    {
+        ( void ) FleetProvisioning_GetShard( pDeviceId, deviceIdLength, window, &offset );
+    }
+
+    return offset;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetStartDelay( const char * pDeviceId,
+                                                           size_t deviceIdLength,
+                                                           uint32_t windowTicks,
+                                                           uint32_t * pOutDelayTicks )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pDeviceId == NULL ) || ( deviceIdLength == 0U ) || ( pOutDelayTicks == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pDeviceId: %p, deviceIdLength: %lu, pOutDelayTicks: %p.",
+                    ( const void * ) pDeviceId,
+                    ( unsigned long ) deviceIdLength,
+                    ( void * ) pOutDelayTicks ) );
+    }
+    else
+    {
+        *pOutDelayTicks = spreadDevice( pDeviceId, deviceIdLength, windowTicks );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetStartDelay, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetRotationTime( const char * pDeviceId,
+                                                             size_t deviceIdLength,
+                                                             uint32_t notBefore,
+                                                             uint32_t notAfter,
+                                                             uint32_t * pOutRotationTime )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint64_t lifetime;
+    uint32_t windowStart;
+    uint32_t windowEnd;
+
+    if( ( pDeviceId == NULL ) || ( deviceIdLength == 0U ) || ( notAfter <= notBefore ) ||
+        ( pOutRotationTime == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pDeviceId: %p, deviceIdLength: %lu, notBefore: %u, notAfter: %u, pOutRotationTime: %p.",
+                    ( const void * ) pDeviceId,
+                    ( unsigned long ) deviceIdLength,
+                    ( unsigned int ) notBefore,
+                    ( unsigned int ) notAfter,
+                    ( void * ) pOutRotationTime ) );
+    }
+    else
+    {
+        /* Both window bounds are within the lifetime, so they fit. */
+        lifetime = ( uint64_t ) notAfter - notBefore;
+        windowStart = ( uint32_t ) ( ( lifetime * FP_ROTATION_WINDOW_START_PERCENT ) / 100U );
+        windowEnd = ( uint32_t ) ( ( lifetime * FP_ROTATION_WINDOW_END_PERCENT ) / 100U );
+
+        *pOutRotationTime = notBefore + windowStart +
+                            spreadDevice( pDeviceId, deviceIdLength, windowEnd - windowStart );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetRotationTime, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
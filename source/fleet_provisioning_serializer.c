@@ -0,0 +1,887 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_serializer.c
+ * @brief Implementation of request payload serialization for the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Fleet Provisioning serializer include. */
+#include "fleet_provisioning_serializer.h"
+
+/* Fleet Provisioning PEM include. */
+#include "fleet_provisioning_pem.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief CBOR major type of text strings, in the top three bits.
+ */
+#define CBOR_MAJOR_TYPE_TEXT      ( 0x60U )
+
+/**
+ * @brief CBOR major type of maps, in the top three bits.
+ */
+#define CBOR_MAJOR_TYPE_MAP       ( 0xA0U )
+
+/**
+ * @brief Largest CBOR argument held in the initial byte.
+ */
+#define CBOR_MAX_SHORT_ARGUMENT   ( 23U )
+
+/**
+ * @brief Additional information of a CBOR argument held in the next byte.
+ */
+#define CBOR_ARGUMENT_8_BITS      ( 24U )
+
+/**
+ * @brief Additional information of a CBOR argument held in the next two
+ * bytes.
+ */
+#define CBOR_ARGUMENT_16_BITS     ( 25U )
+
+/**
+ * @brief Additional information of a CBOR argument held in the next four
+ * bytes.
+ */
+#define CBOR_ARGUMENT_32_BITS     ( 26U )
+
+/**
+ * @brief Largest length of a CBOR header.
+ */
+#define CBOR_MAX_HEADER_LENGTH    ( 5U )
+
+/**
+ * @brief Largest string length held in a CBOR header, and largest template
+ * buffer length, so that slot offsets fit in 32 bits.
+ */
+#define MAX_STRING_LENGTH         ( 0xFFFFFFFFU )
+
+/**
+ * @brief Length of #FP_API_CSR_KEY.
+ */
+#define CSR_KEY_LENGTH            ( sizeof( FP_API_CSR_KEY ) - 1U )
+
+/**
+ * @brief Length of #FP_API_PARAMETERS_KEY.
+ */
+#define PARAMETERS_KEY_LENGTH     ( sizeof( FP_API_PARAMETERS_KEY ) - 1U )
+
+/**
+ * @brief Length of #FP_API_OWNERSHIP_TOKEN_KEY.
+ */
+#define TOKEN_KEY_LENGTH          ( sizeof( FP_API_OWNERSHIP_TOKEN_KEY ) - 1U )
+
+/**
+ * @brief Length of the JSON text around the CSR: the braces, the quoted key
+ * and colon, and the quotes of the value.
+ */
+#define CSR_JSON_OVERHEAD         ( CSR_KEY_LENGTH + 7U )
+
+/**
+ * @brief Closing characters of a JSON RegisterThing request, after the token.
+ */
+#define JSON_TOKEN_SUFFIX         "\"}"
+
+/**
+ * @brief Length of #JSON_TOKEN_SUFFIX.
+ */
+#define JSON_TOKEN_SUFFIX_LENGTH  ( sizeof( JSON_TOKEN_SUFFIX ) - 1U )
+
+/**
+ * @brief Character written to template slots before they are set.
+ */
+#define SLOT_FILL_CHARACTER       ( '0' )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Writes a payload into a buffer, checking that it fits.
+ */
+typedef struct PayloadWriter
+{
+    char * pBuffer;                   /**< @brief Buffer to write to. */
+    size_t bufferLength;              /**< @brief Length of the buffer. */
+    size_t index;                     /**< @brief Index of the next byte to write. */
+    FleetProvisioningStatus_t status; /**< @brief FleetProvisioningBufferTooSmall once a write does not fit. */
+} PayloadWriter_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the length of a CBOR header with the given argument.
+ *
+ * @param[in] argument The argument, such as a string length or map size.
+ *
+ * @return The length of the header.
+ */
+static size_t cborHeaderLength( uint32_t argument );
+
+/**
+ * @brief Reserve space for the given number of bytes in the payload.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] length The number of bytes.
+ *
+ * @return The index of the reserved space, valid if the writer status is
+ * still FleetProvisioningSuccess.
+ */
+static size_t reserveBytes( PayloadWriter_t * pWriter,
+                            size_t length );
+
+/**
+ * @brief Write bytes to the payload.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] pData The bytes to write.
+ * @param[in] length The number of bytes.
+ */
+static void writeBytes( PayloadWriter_t * pWriter,
+                        const char * pData,
+                        size_t length );
+
+/**
+ * @brief Write a CBOR header with the smallest encoding of its argument.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] majorType The major type, such as #CBOR_MAJOR_TYPE_TEXT.
+ * @param[in] argument The argument, such as a string length or map size.
+ */
+static void writeCborHeader( PayloadWriter_t * pWriter,
+                             uint8_t majorType,
+                             uint32_t argument );
+
+/**
+ * @brief Write a map key: quoted and followed by a colon for JSON, or as a
+ * text string for CBOR.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] format The format of the payload.
+ * @param[in] pKey The key.
+ * @param[in] keyLength The length of @p pKey.
+ */
+static void writeKey( PayloadWriter_t * pWriter,
+                      FleetProvisioningFormat_t format,
+                      const char * pKey,
+                      size_t keyLength );
+
+/**
+ * @brief Write a string value: quoted for JSON, or as a text string for
+ * CBOR.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] format The format of the payload.
+ * @param[in] pValue The value, or NULL to fill the value with
+ * #SLOT_FILL_CHARACTER.
+ * @param[in] valueLength The length of the value.
+ *
+ * @return The index of the value bytes, valid if the writer status is still
+ * FleetProvisioningSuccess.
+ */
+static size_t writeStringValue( PayloadWriter_t * pWriter,
+                                FleetProvisioningFormat_t format,
+                                const char * pValue,
+                                size_t valueLength );
+
+/**
+ * @brief Check that a string can be written in a JSON payload without
+ * escaping.
+ *
+ * @param[in] pString The string to check.
+ * @param[in] length The length of @p pString.
+ *
+ * @return FleetProvisioningSuccess if no character needs escaping;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t checkJsonSafe( const char * pString,
+                                                size_t length );
+
+/**
+ * @brief Validate a parameter given to
+ * #FleetProvisioning_InitRegisterThingTemplate.
+ *
+ * @param[in] format The format of the payload.
+ * @param[in] pParameter The parameter.
+ *
+ * @return FleetProvisioningSuccess if the parameter is valid;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t validateTemplateParameter( FleetProvisioningFormat_t format,
+                                                            const FleetProvisioningTemplateParameter_t * pParameter );
+
+/**
+ * @brief Write the parameters map of a RegisterThing template, recording
+ * the location of each slot.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in,out] pTemplate The template, with its format set.
+ * @param[in] pParameters The parameters.
+ * @param[in] parameterCount The number of parameters.
+ */
+static void writeTemplateParameters( PayloadWriter_t * pWriter,
+                                     FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                     const FleetProvisioningTemplateParameter_t * pParameters,
+                                     size_t parameterCount );
+
+/**
+ * @brief Write the part of a CreateCertificateFromCSR request before the
+ * PEM value.
+ *
+ * @param[in,out] pWriter The payload writer.
+ * @param[in] format The format of the payload.
+ * @param[in] pemLength The length of the PEM value.
+ */
+static void writeCsrRequestPrefix( PayloadWriter_t * pWriter,
+                                   FleetProvisioningFormat_t format,
+                                   size_t pemLength );
+
+/**
+ * @brief Get the length of a CreateCertificateFromCSR request.
+ *
+ * @param[in] format The format of the payload.
+ * @param[in] pemLength The length of the PEM value.
+ *
+ * @return The length of the payload.
+ */
+static size_t getCsrRequestLength( FleetProvisioningFormat_t format,
+                                   size_t pemLength );
+
+/*-----------------------------------------------------------*/
+
+static size_t cborHeaderLength( uint32_t argument )
+{
+    size_t length = CBOR_MAX_HEADER_LENGTH;
+
+    if( argument <= CBOR_MAX_SHORT_ARGUMENT )
+    {
+        length = 1U;
+    }
+    else if( argument <= 0xFFU )
+    {
+        length = 2U;
+    }
+    else if( argument <= 0xFFFFU )
+    {
+        length = 3U;
+    }
+    else
+    {
+        /* Four byte argument. */
+    }
+
+    return length;
+}
+/*-----------------------------------------------------------*/
+
+static size_t reserveBytes( PayloadWriter_t * pWriter,
+                            size_t length )
+{
+    size_t index = pWriter->index;
+
+    if( pWriter->status == FleetProvisioningSuccess )
+    {
+        if( ( pWriter->bufferLength - pWriter->index ) < length )
+        {
+            pWriter->status = FleetProvisioningBufferTooSmall;
+        }
+        else
+        {
+            pWriter->index += length;
+        }
+    }
+
+    return index;
+}
+/*-----------------------------------------------------------*/
+
+static void writeBytes( PayloadWriter_t * pWriter,
+                        const char * pData,
+                        size_t length )
+{
+    size_t index = reserveBytes( pWriter, length );
+
+    if( pWriter->status == FleetProvisioningSuccess )
+    {
+        ( void ) memcpy( &( pWriter->pBuffer[ index ] ), pData, length );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void writeCborHeader( PayloadWriter_t * pWriter,
+                             uint8_t majorType,
+                             uint32_t argument )
+{
+    char header[ CBOR_MAX_HEADER_LENGTH ];
+    size_t length = cborHeaderLength( argument );
+    size_t i;
+
+    if( length == 1U )
+    {
+        header[ 0 ] = ( char ) ( uint8_t ) ( majorType | argument );
+    }
+    else
+    {
+        if( length == 2U )
+        {
+            header[ 0 ] = ( char ) ( uint8_t ) ( majorType | CBOR_ARGUMENT_8_BITS );
+        }
+        else if( length == 3U )
+        {
+            header[ 0 ] = ( char ) ( uint8_t ) ( majorType | CBOR_ARGUMENT_16_BITS );
+        }
+        else
+        {
+            header[ 0 ] = ( char ) ( uint8_t ) ( majorType | CBOR_ARGUMENT_32_BITS );
+        }
+
+        /* The argument follows in network byte order. */
+        for( i = 1U; i < length; i++ )
+        {
+            header[ i ] = ( char ) ( uint8_t ) ( argument >> ( 8U * ( length - 1U - i ) ) );
+        }
+    }
+
+    writeBytes( pWriter, header, length );
+}
+/*-----------------------------------------------------------*/
+
+static void writeKey( PayloadWriter_t * pWriter,
+                      FleetProvisioningFormat_t format,
+                      const char * pKey,
+                      size_t keyLength )
+{
+    ( void ) writeStringValue( pWriter, format, pKey, keyLength );
+
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, ":", 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static size_t writeStringValue( PayloadWriter_t * pWriter,
+                                FleetProvisioningFormat_t format,
+                                const char * pValue,
+                                size_t valueLength )
+{
+    size_t index;
+
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, "\"", 1U );
+    }
+    else
+    {
+        writeCborHeader( pWriter, CBOR_MAJOR_TYPE_TEXT, ( uint32_t ) valueLength );
+    }
+
+    index = reserveBytes( pWriter, valueLength );
+
+    if( pWriter->status == FleetProvisioningSuccess )
+    {
+        if( pValue != NULL )
+        {
+            ( void ) memcpy( &( pWriter->pBuffer[ index ] ), pValue, valueLength );
+        }
+        else
+        {
+            ( void ) memset( &( pWriter->pBuffer[ index ] ), SLOT_FILL_CHARACTER, valueLength );
+        }
+    }
+
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, "\"", 1U );
+    }
+
+    return index;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t checkJsonSafe( const char * pString,
+                                                size_t length )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    size_t i;
+
+    for( i = 0U; i < length; i++ )
+    {
+        if( ( pString[ i ] == '"' ) || ( pString[ i ] == '\\' ) ||
+            ( ( uint8_t ) pString[ i ] < 0x20U ) )
+        {
+            status = FleetProvisioningBadParameter;
+            break;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t validateTemplateParameter( FleetProvisioningFormat_t format,
+                                                            const FleetProvisioningTemplateParameter_t * pParameter )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pParameter->pKey == NULL ) || ( pParameter->keyLength == 0U ) ||
+        ( pParameter->keyLength > MAX_STRING_LENGTH ) || ( pParameter->valueLength > MAX_STRING_LENGTH ) )
+    {
+        LogError( ( "Invalid template parameter. pKey: %p, keyLength: %lu, valueLength: %lu.",
+                    ( const void * ) pParameter->pKey,
+                    ( unsigned long ) pParameter->keyLength,
+                    ( unsigned long ) pParameter->valueLength ) );
+    }
+    else if( ( pParameter->pValue == NULL ) && ( pParameter->valueLength == 0U ) )
+    {
+        LogError( ( "Template slot must not be empty." ) );
+    }
+    else if( format == FleetProvisioningJson )
+    {
+        status = checkJsonSafe( pParameter->pKey, pParameter->keyLength );
+
+        if( ( status == FleetProvisioningSuccess ) && ( pParameter->pValue != NULL ) )
+        {
+            status = checkJsonSafe( pParameter->pValue, pParameter->valueLength );
+        }
+
+        if( status != FleetProvisioningSuccess )
+        {
+            LogError( ( "Template parameter needs JSON escaping." ) );
+        }
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static void writeTemplateParameters( PayloadWriter_t * pWriter,
+                                     FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                     const FleetProvisioningTemplateParameter_t * pParameters,
+                                     size_t parameterCount )
+{
+    FleetProvisioningFormat_t format = pTemplate->format;
+    size_t offset;
+    size_t i;
+
+    writeKey( pWriter, format, FP_API_PARAMETERS_KEY, PARAMETERS_KEY_LENGTH );
+
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, "{", 1U );
+    }
+    else
+    {
+        writeCborHeader( pWriter, CBOR_MAJOR_TYPE_MAP, ( uint32_t ) parameterCount );
+    }
+
+    for( i = 0U; i < parameterCount; i++ )
+    {
+        if( ( format == FleetProvisioningJson ) && ( i > 0U ) )
+        {
+            writeBytes( pWriter, ",", 1U );
+        }
+
+        writeKey( pWriter, format, pParameters[ i ].pKey, pParameters[ i ].keyLength );
+        offset = writeStringValue( pWriter, format, pParameters[ i ].pValue, pParameters[ i ].valueLength );
+
+        if( pParameters[ i ].pValue == NULL )
+        {
+            if( pTemplate->slotCount < FP_TEMPLATE_MAX_SLOTS )
+            {
+                pTemplate->slots[ pTemplate->slotCount ].offset = ( uint32_t ) offset;
+                pTemplate->slots[ pTemplate->slotCount ].length = ( uint32_t ) pParameters[ i ].valueLength;
+                pTemplate->slotCount++;
+            }
+            else
+            {
+                pWriter->status = FleetProvisioningBufferTooSmall;
+            }
+        }
+    }
+
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, "},", 2U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void writeCsrRequestPrefix( PayloadWriter_t * pWriter,
+                                   FleetProvisioningFormat_t format,
+                                   size_t pemLength )
+{
+    if( format == FleetProvisioningJson )
+    {
+        writeBytes( pWriter, "{", 1U );
+        writeKey( pWriter, format, FP_API_CSR_KEY, CSR_KEY_LENGTH );
+        writeBytes( pWriter, "\"", 1U );
+    }
+    else
+    {
+        writeCborHeader( pWriter, CBOR_MAJOR_TYPE_MAP, 1U );
+        writeKey( pWriter, format, FP_API_CSR_KEY, CSR_KEY_LENGTH );
+        writeCborHeader( pWriter, CBOR_MAJOR_TYPE_TEXT, ( uint32_t ) pemLength );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static size_t getCsrRequestLength( FleetProvisioningFormat_t format,
+                                   size_t pemLength )
+{
+    size_t length = CSR_JSON_OVERHEAD + pemLength;
+
+    if( format == FleetProvisioningCbor )
+    {
+        length = cborHeaderLength( 1U ) +
+                 cborHeaderLength( ( uint32_t ) CSR_KEY_LENGTH ) + CSR_KEY_LENGTH +
+                 cborHeaderLength( ( uint32_t ) pemLength ) + pemLength;
+    }
+
+    return length;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SerializeCreateCertFromCsrRequest( const uint8_t * pCsrDer,
+                                                                               size_t csrDerLength,
+                                                                               FleetProvisioningFormat_t format,
+                                                                               char * pBuffer,
+                                                                               size_t bufferLength,
+                                                                               size_t * pOutLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadWriter_t writer = { 0 };
+    size_t pemLength = 0U;
+    size_t payloadLength = 0U;
+
+    if( ( pCsrDer == NULL ) || ( pBuffer == NULL ) || ( pOutLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pCsrDer: %p, pBuffer: %p, pOutLength: %p.",
+                    ( const void * ) pCsrDer,
+                    ( void * ) pBuffer,
+                    ( void * ) pOutLength ) );
+    }
+    else
+    {
+        /* A length of 0 also rejects an empty CSR and an invalid format. */
+        pemLength = FleetProvisioning_GetPemLength( csrDerLength, FP_CSR_PEM_LABEL_LENGTH, format );
+
+        if( ( pemLength == 0U ) || ( pemLength > MAX_STRING_LENGTH ) )
+        {
+            LogError( ( "Invalid CSR. csrDerLength: %lu, format: %d.",
+                        ( unsigned long ) csrDerLength,
+                        ( int ) format ) );
+        }
+        else
+        {
+            payloadLength = getCsrRequestLength( format, pemLength );
+            status = FleetProvisioningSuccess;
+        }
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( bufferLength < payloadLength ) )
+    {
+        LogError( ( "Buffer too small for CreateCertificateFromCSR request. Required: %lu, provided: %lu.",
+                    ( unsigned long ) payloadLength,
+                    ( unsigned long ) bufferLength ) );
+        status = FleetProvisioningBufferTooSmall;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        writer.pBuffer = pBuffer;
+        writer.bufferLength = bufferLength;
+        writer.status = FleetProvisioningSuccess;
+        writeCsrRequestPrefix( &writer, format, pemLength );
+
+        /* The PEM value is encoded straight into its place in the payload. */
+        status = FleetProvisioning_DerToPem( pCsrDer, csrDerLength,
+                                             FP_CSR_PEM_LABEL, FP_CSR_PEM_LABEL_LENGTH,
+                                             format, &( pBuffer[ writer.index ] ),
+                                             bufferLength - writer.index, &pemLength );
+        assert( status == FleetProvisioningSuccess );
+        writer.index += pemLength;
+
+        if( format == FleetProvisioningJson )
+        {
+            writeBytes( &writer, "\"}", 2U );
+        }
+
+        assert( ( writer.status == FleetProvisioningSuccess ) && ( writer.index == payloadLength ) );
+        *pOutLength = writer.index;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSerializeCreateCertFromCsrRequest, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_InitRegisterThingTemplate( FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                       FleetProvisioningFormat_t format,
+                                                                       const FleetProvisioningTemplateParameter_t * pParameters,
+                                                                       size_t parameterCount,
+                                                                       char * pBuffer,
+                                                                       size_t bufferLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadWriter_t writer = { 0 };
+    size_t i;
+
+    if( ( pTemplate == NULL ) || ( pBuffer == NULL ) || ( bufferLength > MAX_STRING_LENGTH ) ||
+        ( ( pParameters == NULL ) && ( parameterCount > 0U ) ) )
+    {
+        LogError( ( "Invalid input parameter. pTemplate: %p, pParameters: %p, pBuffer: %p, bufferLength: %lu.",
+                    ( void * ) pTemplate,
+                    ( const void * ) pParameters,
+                    ( void * ) pBuffer,
+                    ( unsigned long ) bufferLength ) );
+    }
+    else if( ( format != FleetProvisioningJson ) && ( format != FleetProvisioningCbor ) )
+    {
+        LogError( ( "Invalid format: %d.", ( int ) format ) );
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    for( i = 0U; ( status == FleetProvisioningSuccess ) && ( i < parameterCount ); i++ )
+    {
+        status = validateTemplateParameter( format, &( pParameters[ i ] ) );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pTemplate->pBuffer = pBuffer;
+        pTemplate->bufferLength = bufferLength;
+        pTemplate->format = format;
+        pTemplate->slotCount = 0U;
+        writer.pBuffer = pBuffer;
+        writer.bufferLength = bufferLength;
+        writer.status = FleetProvisioningSuccess;
+
+        /* The ownership token has a different length for each device, so
+         * it is placed last, after the parameters. */
+        if( format == FleetProvisioningJson )
+        {
+            writeBytes( &writer, "{", 1U );
+            writeTemplateParameters( &writer, pTemplate, pParameters, parameterCount );
+            writeKey( &writer, format, FP_API_OWNERSHIP_TOKEN_KEY, TOKEN_KEY_LENGTH );
+            writeBytes( &writer, "\"", 1U );
+        }
+        else
+        {
+            writeCborHeader( &writer, CBOR_MAJOR_TYPE_MAP, 2U );
+            writeTemplateParameters( &writer, pTemplate, pParameters, parameterCount );
+            writeKey( &writer, format, FP_API_OWNERSHIP_TOKEN_KEY, TOKEN_KEY_LENGTH );
+        }
+
+        pTemplate->prefixLength = writer.index;
+        status = writer.status;
+
+        if( status != FleetProvisioningSuccess )
+        {
+            LogError( ( "Buffer too small for RegisterThing template, or more than %u slots.",
+                        ( unsigned int ) FP_TEMPLATE_MAX_SLOTS ) );
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfInitRegisterThingTemplate, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SetTemplateSlot( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                             size_t slotIndex,
+                                                             const char * pValue,
+                                                             size_t valueLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pTemplate == NULL ) || ( pValue == NULL ) || ( slotIndex >= pTemplate->slotCount ) )
+    {
+        LogError( ( "Invalid input parameter. pTemplate: %p, pValue: %p, slotIndex: %lu.",
+                    ( const void * ) pTemplate,
+                    ( const void * ) pValue,
+                    ( unsigned long ) slotIndex ) );
+    }
+    else if( valueLength != pTemplate->slots[ slotIndex ].length )
+    {
+        LogError( ( "Slot value has the wrong length. Expected: %lu, provided: %lu.",
+                    ( unsigned long ) pTemplate->slots[ slotIndex ].length,
+                    ( unsigned long ) valueLength ) );
+    }
+    else if( ( pTemplate->format == FleetProvisioningJson ) &&
+             ( checkJsonSafe( pValue, valueLength ) != FleetProvisioningSuccess ) )
+    {
+        LogError( ( "Slot value needs JSON escaping." ) );
+    }
+    else
+    {
+        ( void ) memcpy( &( pTemplate->pBuffer[ pTemplate->slots[ slotIndex ].offset ] ),
+                         pValue,
+                         valueLength );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSetTemplateSlot, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_CompleteRegisterThingTemplate( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                           const char * pToken,
+                                                                           size_t tokenLength,
+                                                                           size_t * pOutLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadWriter_t writer = { 0 };
+
+    if( ( pTemplate == NULL ) || ( pToken == NULL ) || ( tokenLength == 0U ) ||
+        ( tokenLength > MAX_STRING_LENGTH ) || ( pOutLength == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pTemplate: %p, pToken: %p, tokenLength: %lu, pOutLength: %p.",
+                    ( const void * ) pTemplate,
+                    ( const void * ) pToken,
+                    ( unsigned long ) tokenLength,
+                    ( void * ) pOutLength ) );
+    }
+    else
+    {
+        writer.pBuffer = pTemplate->pBuffer;
+        writer.bufferLength = pTemplate->bufferLength;
+        writer.index = pTemplate->prefixLength;
+        writer.status = FleetProvisioningSuccess;
+
+        if( pTemplate->format == FleetProvisioningJson )
+        {
+            writeBytes( &writer, pToken, tokenLength );
+            writeBytes( &writer, JSON_TOKEN_SUFFIX, JSON_TOKEN_SUFFIX_LENGTH );
+        }
+        else
+        {
+            writeCborHeader( &writer, CBOR_MAJOR_TYPE_TEXT, ( uint32_t ) tokenLength );
+            writeBytes( &writer, pToken, tokenLength );
+        }
+
+        status = writer.status;
+
+        if( status == FleetProvisioningSuccess )
+        {
+            *pOutLength = writer.index;
+        }
+        else
+        {
+            LogError( ( "Buffer too small for ownership token of length %lu.",
+                        ( unsigned long ) tokenLength ) );
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfCompleteRegisterThingTemplate, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GatherRegisterThingTemplate( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                         const char * pToken,
+                                                                         size_t tokenLength,
+                                                                         FleetProvisioningPayloadGather_t * pOutGather )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    PayloadWriter_t writer = { 0 };
+
+    if( ( pTemplate == NULL ) || ( pToken == NULL ) || ( tokenLength == 0U ) ||
+        ( tokenLength > MAX_STRING_LENGTH ) || ( pOutGather == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pTemplate: %p, pToken: %p, tokenLength: %lu, pOutGather: %p.",
+                    ( const void * ) pTemplate,
+                    ( const void * ) pToken,
+                    ( unsigned long ) tokenLength,
+                    ( void * ) pOutGather ) );
+    }
+    else
+    {
+        writer.pBuffer = pTemplate->pBuffer;
+        writer.bufferLength = pTemplate->bufferLength;
+        writer.index = pTemplate->prefixLength;
+        writer.status = FleetProvisioningSuccess;
+
+        if( pTemplate->format == FleetProvisioningCbor )
+        {
+            writeCborHeader( &writer, CBOR_MAJOR_TYPE_TEXT, ( uint32_t ) tokenLength );
+        }
+
+        status = writer.status;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pOutGather->segments[ 0 ].pData = pTemplate->pBuffer;
+        pOutGather->segments[ 0 ].length = writer.index;
+        pOutGather->segments[ 1 ].pData = pToken;
+        pOutGather->segments[ 1 ].length = tokenLength;
+        pOutGather->segmentCount = 2U;
+        pOutGather->payloadLength = writer.index + tokenLength;
+
+        if( pTemplate->format == FleetProvisioningJson )
+        {
+            pOutGather->segments[ 2 ].pData = JSON_TOKEN_SUFFIX;
+            pOutGather->segments[ 2 ].length = JSON_TOKEN_SUFFIX_LENGTH;
+            pOutGather->segmentCount = 3U;
+            pOutGather->payloadLength += JSON_TOKEN_SUFFIX_LENGTH;
+        }
+    }
+    else if( status == FleetProvisioningBufferTooSmall )
+    {
+        LogError( ( "Buffer too small for ownership token header." ) );
+    }
+    else
+    {
+        /* Invalid parameters are logged above. */
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGatherRegisterThingTemplate, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
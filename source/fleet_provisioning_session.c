@@ -0,0 +1,773 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session.c
+ * @brief Implementation of the event-driven session state machine for the
+ * AWS IoT Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Fleet Provisioning session include. */
+#include "fleet_provisioning_session.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Index of the CreateCertificateFromCSR API in #sessionTopics.
+ */
+#define SESSION_API_CREATE_CERT    ( 0U )
+
+/**
+ * @brief Index of the CreateKeysAndCertificate API in #sessionTopics.
+ */
+#define SESSION_API_CREATE_KEYS    ( 1U )
+
+/**
+ * @brief Index of the RegisterThing API in #sessionTopics.
+ */
+#define SESSION_API_REGISTER       ( 2U )
+
+/**
+ * @brief Payload of a JSON CreateKeysAndCertificate request.
+ */
+#define JSON_EMPTY_REQUEST         "{}"
+
+/**
+ * @brief Payload of a CBOR CreateKeysAndCertificate request, an empty map.
+ */
+#define CBOR_EMPTY_REQUEST         "\xA0"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A topic of a Fleet Provisioning API.
+ */
+typedef struct SessionTopic
+{
+    FleetProvisioningTopic_t topic; /**< @brief Value of the topic. */
+    const char * pTopic;            /**< @brief Topic string, or NULL for RegisterThing topics. */
+    uint16_t length;                /**< @brief Length of the topic string. */
+} SessionTopic_t;
+
+/**
+ * @brief Topics of each API, indexed by format, API and
+ * #FleetProvisioningApiTopics_t. RegisterThing topic strings depend on the
+ * template name, so are held by each session.
+ */
+static const SessionTopic_t sessionTopics[ 2 ][ 3 ][ 3 ] =
+{
+    {
+        {
+            { FleetProvJsonCreateCertFromCsrPublish,  FP_JSON_CREATE_CERT_PUBLISH_TOPIC,  FP_JSON_CREATE_CERT_PUBLISH_LENGTH  },
+            { FleetProvJsonCreateCertFromCsrAccepted, FP_JSON_CREATE_CERT_ACCEPTED_TOPIC, FP_JSON_CREATE_CERT_ACCEPTED_LENGTH },
+            { FleetProvJsonCreateCertFromCsrRejected, FP_JSON_CREATE_CERT_REJECTED_TOPIC, FP_JSON_CREATE_CERT_REJECTED_LENGTH }
+        },
+        {
+            { FleetProvJsonCreateKeysAndCertPublish,  FP_JSON_CREATE_KEYS_PUBLISH_TOPIC,  FP_JSON_CREATE_KEYS_PUBLISH_LENGTH  },
+            { FleetProvJsonCreateKeysAndCertAccepted, FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH },
+            { FleetProvJsonCreateKeysAndCertRejected, FP_JSON_CREATE_KEYS_REJECTED_TOPIC, FP_JSON_CREATE_KEYS_REJECTED_LENGTH }
+        },
+        {
+            { FleetProvJsonRegisterThingPublish,      NULL,                               0U                                  },
+            { FleetProvJsonRegisterThingAccepted,     NULL,                               0U                                  },
+            { FleetProvJsonRegisterThingRejected,     NULL,                               0U                                  }
+        }
+    },
+    {
+        {
+            { FleetProvCborCreateCertFromCsrPublish,  FP_CBOR_CREATE_CERT_PUBLISH_TOPIC,  FP_CBOR_CREATE_CERT_PUBLISH_LENGTH  },
+            { FleetProvCborCreateCertFromCsrAccepted, FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC, FP_CBOR_CREATE_CERT_ACCEPTED_LENGTH },
+            { FleetProvCborCreateCertFromCsrRejected, FP_CBOR_CREATE_CERT_REJECTED_TOPIC, FP_CBOR_CREATE_CERT_REJECTED_LENGTH }
+        },
+        {
+            { FleetProvCborCreateKeysAndCertPublish,  FP_CBOR_CREATE_KEYS_PUBLISH_TOPIC,  FP_CBOR_CREATE_KEYS_PUBLISH_LENGTH  },
+            { FleetProvCborCreateKeysAndCertAccepted, FP_CBOR_CREATE_KEYS_ACCEPTED_TOPIC, FP_CBOR_CREATE_KEYS_ACCEPTED_LENGTH },
+            { FleetProvCborCreateKeysAndCertRejected, FP_CBOR_CREATE_KEYS_REJECTED_TOPIC, FP_CBOR_CREATE_KEYS_REJECTED_LENGTH }
+        },
+        {
+            { FleetProvCborRegisterThingPublish,      NULL,                               0U                                  },
+            { FleetProvCborRegisterThingAccepted,     NULL,                               0U                                  },
+            { FleetProvCborRegisterThingRejected,     NULL,                               0U                                  }
+        }
+    }
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the index of the API a session requests its credentials with.
+ *
+ * @param[in] pSession The session.
+ *
+ * @return #SESSION_API_CREATE_CERT or #SESSION_API_CREATE_KEYS.
+ */
+static size_t credentialsApi( const FleetProvisioningSession_t * pSession );
+
+/**
+ * @brief Get a topic of an API for a session.
+ *
+ * @param[in] pSession The session.
+ * @param[in] api The index of the API.
+ * @param[in] topic Which topic of the API.
+ * @param[out] pOutTopic The topic string.
+ *
+ * @return The value of the topic.
+ */
+static FleetProvisioningTopic_t getSessionTopic( const FleetProvisioningSession_t * pSession,
+                                                 size_t api,
+                                                 FleetProvisioningApiTopics_t topic,
+                                                 FleetProvisioningSpan_t * pOutTopic );
+
+/**
+ * @brief Request a subscription to the accepted and rejected topics of an
+ * API.
+ *
+ * @param[in] pSession The session.
+ * @param[in] api The index of the API.
+ * @param[out] pAction The action to fill.
+ */
+static void setSubscribeAction( const FleetProvisioningSession_t * pSession,
+                                size_t api,
+                                FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Request the publish of the request of an API, which is already
+ * built.
+ *
+ * @param[in] pSession The session.
+ * @param[in] api The index of the API.
+ * @param[out] pAction The action to fill.
+ */
+static void setPublishAction( const FleetProvisioningSession_t * pSession,
+                              size_t api,
+                              FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Build the CreateKeysAndCertificate or CreateCertificateFromCSR
+ * request.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the request is built; otherwise the
+ * status of the serializer.
+ */
+static FleetProvisioningStatus_t setCredentialsRequest( FleetProvisioningSession_t * pSession,
+                                                        FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Build the RegisterThing request from a credentials accepted
+ * response.
+ *
+ * @param[in] pSession The session.
+ * @param[in] pEvent The accepted response.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the request is built; otherwise the
+ * status of the parser or serializer.
+ */
+static FleetProvisioningStatus_t setRegisterRequest( FleetProvisioningSession_t * pSession,
+                                                     const FleetProvisioningEvent_t * pEvent,
+                                                     FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Publish the credentials request, moving the session to
+ * #FleetProvisioningSessionAwaitingCredentials, or fail the session.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ */
+static void publishCredentialsRequest( FleetProvisioningSession_t * pSession,
+                                       FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Fail a session.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ */
+static void failSession( FleetProvisioningSession_t * pSession,
+                         FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Handle #FleetProvisioningEventStart.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the session is started;
+ * FleetProvisioningNoMatch if it was already started.
+ */
+static FleetProvisioningStatus_t handleStart( FleetProvisioningSession_t * pSession,
+                                              FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Handle #FleetProvisioningEventSubscribed.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the session was subscribing;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t handleSubscribed( FleetProvisioningSession_t * pSession,
+                                                   FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Handle an accepted response to the request of a session.
+ *
+ * @param[in] pSession The session.
+ * @param[in] api The index of the API of the request.
+ * @param[in] pEvent The event.
+ * @param[out] pAction The action to fill.
+ */
+static void handleAccepted( FleetProvisioningSession_t * pSession,
+                            size_t api,
+                            const FleetProvisioningEvent_t * pEvent,
+                            FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Handle #FleetProvisioningEventMessage.
+ *
+ * @param[in] pSession The session.
+ * @param[in] pEvent The event.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the message is a response to the
+ * request of the session; FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t handleMessage( FleetProvisioningSession_t * pSession,
+                                                const FleetProvisioningEvent_t * pEvent,
+                                                FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Handle #FleetProvisioningEventTimeout.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pAction The action to fill.
+ *
+ * @return FleetProvisioningSuccess if the session was waiting;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t handleTimeout( FleetProvisioningSession_t * pSession,
+                                                FleetProvisioningAction_t * pAction );
+
+/*-----------------------------------------------------------*/
+
+static size_t credentialsApi( const FleetProvisioningSession_t * pSession )
+{
+    return ( pSession->pCsrDer != NULL ) ? SESSION_API_CREATE_CERT : SESSION_API_CREATE_KEYS;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningTopic_t getSessionTopic( const FleetProvisioningSession_t * pSession,
+                                                 size_t api,
+                                                 FleetProvisioningApiTopics_t topic,
+                                                 FleetProvisioningSpan_t * pOutTopic )
+{
+    const SessionTopic_t * pEntry = &( sessionTopics[ pSession->format ][ api ][ topic ] );
+
+    if( pEntry->pTopic != NULL )
+    {
+        pOutTopic->pData = pEntry->pTopic;
+        pOutTopic->length = pEntry->length;
+    }
+    else if( topic == FleetProvisioningRejected )
+    {
+        pOutTopic->pData = &( pSession->pTopicBuffer[ pSession->acceptedTopicLength ] );
+        pOutTopic->length = pSession->rejectedTopicLength;
+    }
+    else
+    {
+        /* The publish topic is the accepted topic without its suffix. */
+        pOutTopic->pData = pSession->pTopicBuffer;
+        pOutTopic->length = pSession->acceptedTopicLength;
+
+        if( topic == FleetProvisioningPublish )
+        {
+            pOutTopic->length -= FP_API_LENGTH_ACCEPTED_SUFFIX;
+        }
+    }
+
+    return pEntry->topic;
+}
+/*-----------------------------------------------------------*/
+
+static void setSubscribeAction( const FleetProvisioningSession_t * pSession,
+                                size_t api,
+                                FleetProvisioningAction_t * pAction )
+{
+    pAction->type = FleetProvisioningActionSubscribe;
+    ( void ) getSessionTopic( pSession, api, FleetProvisioningAccepted, &( pAction->topics[ 0 ] ) );
+    ( void ) getSessionTopic( pSession, api, FleetProvisioningRejected, &( pAction->topics[ 1 ] ) );
+    pAction->topicCount = 2U;
+}
+/*-----------------------------------------------------------*/
+
+static void setPublishAction( const FleetProvisioningSession_t * pSession,
+                              size_t api,
+                              FleetProvisioningAction_t * pAction )
+{
+    pAction->type = FleetProvisioningActionPublish;
+    pAction->request = getSessionTopic( pSession, api, FleetProvisioningPublish, &( pAction->topics[ 0 ] ) );
+    pAction->topicCount = 1U;
+
+    if( api != SESSION_API_CREATE_KEYS )
+    {
+        pAction->payload.pData = pSession->pPayloadBuffer;
+        pAction->payload.length = pSession->requestLength;
+    }
+    else if( pSession->format == FleetProvisioningJson )
+    {
+        pAction->payload.pData = JSON_EMPTY_REQUEST;
+        pAction->payload.length = sizeof( JSON_EMPTY_REQUEST ) - 1U;
+    }
+    else
+    {
+        pAction->payload.pData = CBOR_EMPTY_REQUEST;
+        pAction->payload.length = sizeof( CBOR_EMPTY_REQUEST ) - 1U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t setCredentialsRequest( FleetProvisioningSession_t * pSession,
+                                                        FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    size_t api = credentialsApi( pSession );
+
+    if( api == SESSION_API_CREATE_CERT )
+    {
+        status = FleetProvisioning_SerializeCreateCertFromCsrRequest( pSession->pCsrDer,
+                                                                      pSession->csrDerLength,
+                                                                      pSession->format,
+                                                                      pSession->pPayloadBuffer,
+                                                                      pSession->payloadBufferLength,
+                                                                      &( pSession->requestLength ) );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        setPublishAction( pSession, api, pAction );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t setRegisterRequest( FleetProvisioningSession_t * pSession,
+                                                     const FleetProvisioningEvent_t * pEvent,
+                                                     FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status;
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningSpan_t token = { 0 };
+
+    status = FleetProvisioning_GetResponseString( pEvent->pPayload,
+                                                  pEvent->payloadLength,
+                                                  pSession->format,
+                                                  FP_API_OWNERSHIP_TOKEN_KEY,
+                                                  sizeof( FP_API_OWNERSHIP_TOKEN_KEY ) - 1U,
+                                                  &token );
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioning_InitRegisterThingTemplate( &registerTemplate,
+                                                              pSession->format,
+                                                              pSession->pParameters,
+                                                              pSession->parameterCount,
+                                                              pSession->pPayloadBuffer,
+                                                              pSession->payloadBufferLength );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate,
+                                                                  token.pData,
+                                                                  token.length,
+                                                                  &( pSession->requestLength ) );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        /* The credentials are optional for the session, so missing ones are
+         * left empty for the application to deal with. */
+        ( void ) FleetProvisioning_GetResponseString( pEvent->pPayload,
+                                                      pEvent->payloadLength,
+                                                      pSession->format,
+                                                      FP_API_CERTIFICATE_ID_KEY,
+                                                      sizeof( FP_API_CERTIFICATE_ID_KEY ) - 1U,
+                                                      &( pAction->credentials.certificateId ) );
+        ( void ) FleetProvisioning_GetResponseString( pEvent->pPayload,
+                                                      pEvent->payloadLength,
+                                                      pSession->format,
+                                                      FP_API_CERTIFICATE_PEM_KEY,
+                                                      sizeof( FP_API_CERTIFICATE_PEM_KEY ) - 1U,
+                                                      &( pAction->credentials.certificatePem ) );
+        ( void ) FleetProvisioning_GetResponseString( pEvent->pPayload,
+                                                      pEvent->payloadLength,
+                                                      pSession->format,
+                                                      FP_API_PRIVATE_KEY_KEY,
+                                                      sizeof( FP_API_PRIVATE_KEY_KEY ) - 1U,
+                                                      &( pAction->credentials.privateKey ) );
+
+        setPublishAction( pSession, SESSION_API_REGISTER, pAction );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static void publishCredentialsRequest( FleetProvisioningSession_t * pSession,
+                                       FleetProvisioningAction_t * pAction )
+{
+    if( setCredentialsRequest( pSession, pAction ) == FleetProvisioningSuccess )
+    {
+        pSession->state = FleetProvisioningSessionAwaitingCredentials;
+    }
+    else
+    {
+        LogError( ( "Failed to build the credentials request." ) );
+        failSession( pSession, pAction );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void failSession( FleetProvisioningSession_t * pSession,
+                         FleetProvisioningAction_t * pAction )
+{
+    ( void ) memset( pAction, 0, sizeof( FleetProvisioningAction_t ) );
+    pAction->type = FleetProvisioningActionFailed;
+    pSession->state = FleetProvisioningSessionFailed;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t handleStart( FleetProvisioningSession_t * pSession,
+                                              FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+
+    if( pSession->state == FleetProvisioningSessionIdle )
+    {
+        status = FleetProvisioningSuccess;
+
+        if( pSession->sharedSubscriptions == 0U )
+        {
+            setSubscribeAction( pSession, credentialsApi( pSession ), pAction );
+            pSession->state = FleetProvisioningSessionSubscribingCredentials;
+        }
+        else
+        {
+            publishCredentialsRequest( pSession, pAction );
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t handleSubscribed( FleetProvisioningSession_t * pSession,
+                                                   FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+
+    if( pSession->state == FleetProvisioningSessionSubscribingCredentials )
+    {
+        setSubscribeAction( pSession, SESSION_API_REGISTER, pAction );
+        pSession->state = FleetProvisioningSessionSubscribingRegister;
+    }
+    else if( pSession->state == FleetProvisioningSessionSubscribingRegister )
+    {
+        publishCredentialsRequest( pSession, pAction );
+    }
+    else
+    {
+        status = FleetProvisioningNoMatch;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static void handleAccepted( FleetProvisioningSession_t * pSession,
+                            size_t api,
+                            const FleetProvisioningEvent_t * pEvent,
+                            FleetProvisioningAction_t * pAction )
+{
+    if( api != SESSION_API_REGISTER )
+    {
+        if( setRegisterRequest( pSession, pEvent, pAction ) == FleetProvisioningSuccess )
+        {
+            pSession->state = FleetProvisioningSessionAwaitingRegister;
+        }
+        else
+        {
+            LogError( ( "Failed to build the RegisterThing request." ) );
+            failSession( pSession, pAction );
+        }
+    }
+    else if( FleetProvisioning_GetResponseString( pEvent->pPayload,
+                                                  pEvent->payloadLength,
+                                                  pSession->format,
+                                                  FP_API_THING_NAME_KEY,
+                                                  sizeof( FP_API_THING_NAME_KEY ) - 1U,
+                                                  &( pAction->thingName ) ) == FleetProvisioningSuccess )
+    {
+        pAction->type = FleetProvisioningActionDone;
+        pSession->state = FleetProvisioningSessionDone;
+    }
+    else
+    {
+        LogError( ( "RegisterThing accepted response has no thing name." ) );
+        failSession( pSession, pAction );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t handleMessage( FleetProvisioningSession_t * pSession,
+                                                const FleetProvisioningEvent_t * pEvent,
+                                                FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    size_t api = ( pSession->state == FleetProvisioningSessionAwaitingCredentials ) ?
+                 credentialsApi( pSession ) : SESSION_API_REGISTER;
+    const SessionTopic_t * pTopics = sessionTopics[ pSession->format ][ api ];
+
+    if( ( pSession->state != FleetProvisioningSessionAwaitingCredentials ) &&
+        ( pSession->state != FleetProvisioningSessionAwaitingRegister ) )
+    {
+        /* No response is expected. */
+    }
+    else if( pEvent->topic == pTopics[ FleetProvisioningRejected ].topic )
+    {
+        LogError( ( "Request rejected. Topic: %d.", ( int ) pEvent->topic ) );
+        failSession( pSession, pAction );
+        status = FleetProvisioningSuccess;
+    }
+    else if( pEvent->topic != pTopics[ FleetProvisioningAccepted ].topic )
+    {
+        /* A response to another request. */
+    }
+    else
+    {
+        handleAccepted( pSession, api, pEvent, pAction );
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t handleTimeout( FleetProvisioningSession_t * pSession,
+                                                FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+
+    if( ( pSession->state != FleetProvisioningSessionIdle ) &&
+        ( pSession->state != FleetProvisioningSessionDone ) &&
+        ( pSession->state != FleetProvisioningSessionFailed ) )
+    {
+        LogError( ( "Session timed out in state %d.", ( int ) pSession->state ) );
+        failSession( pSession, pAction );
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionInit( FleetProvisioningSession_t * pSession,
+                                                         const FleetProvisioningSessionConfig_t * pConfig,
+                                                         char * pTopicBuffer,
+                                                         size_t topicBufferLength,
+                                                         char * pPayloadBuffer,
+                                                         size_t payloadBufferLength )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint16_t bufferLength = ( topicBufferLength > UINT16_MAX ) ? UINT16_MAX : ( uint16_t ) topicBufferLength;
+    uint16_t acceptedLength = 0U;
+    uint16_t rejectedLength = 0U;
+    size_t i;
+
+    if( ( pSession == NULL ) || ( pConfig == NULL ) || ( pTopicBuffer == NULL ) || ( pPayloadBuffer == NULL ) ||
+        ( ( pConfig->pCsrDer == NULL ) && ( pConfig->csrDerLength > 0U ) ) ||
+        ( ( pConfig->pParameters == NULL ) && ( pConfig->parameterCount > 0U ) ) )
+    {
+        LogError( ( "Invalid input parameter. pSession: %p, pConfig: %p, pTopicBuffer: %p, pPayloadBuffer: %p.",
+                    ( void * ) pSession,
+                    ( const void * ) pConfig,
+                    ( void * ) pTopicBuffer,
+                    ( void * ) pPayloadBuffer ) );
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    /* Each request is built when it is sent, so the values cannot be set
+     * through template slots. */
+    for( i = 0U; ( status == FleetProvisioningSuccess ) && ( i < pConfig->parameterCount ); i++ )
+    {
+        if( pConfig->pParameters[ i ].pValue == NULL )
+        {
+            LogError( ( "Session parameter %lu has no value.", ( unsigned long ) i ) );
+            status = FleetProvisioningBadParameter;
+        }
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioning_GetRegisterThingTopic( pTopicBuffer,
+                                                          bufferLength,
+                                                          pConfig->format,
+                                                          FleetProvisioningAccepted,
+                                                          pConfig->pTemplateName,
+                                                          pConfig->templateNameLength,
+                                                          &acceptedLength );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioning_GetRegisterThingTopic( &( pTopicBuffer[ acceptedLength ] ),
+                                                          bufferLength - acceptedLength,
+                                                          pConfig->format,
+                                                          FleetProvisioningRejected,
+                                                          pConfig->pTemplateName,
+                                                          pConfig->templateNameLength,
+                                                          &rejectedLength );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pSession->state = FleetProvisioningSessionIdle;
+        pSession->format = pConfig->format;
+        pSession->pCsrDer = pConfig->pCsrDer;
+        pSession->csrDerLength = pConfig->csrDerLength;
+        pSession->pParameters = pConfig->pParameters;
+        pSession->parameterCount = pConfig->parameterCount;
+        pSession->pTopicBuffer = pTopicBuffer;
+        pSession->acceptedTopicLength = acceptedLength;
+        pSession->rejectedTopicLength = rejectedLength;
+        pSession->pPayloadBuffer = pPayloadBuffer;
+        pSession->payloadBufferLength = payloadBufferLength;
+        pSession->requestLength = 0U;
+        pSession->sharedSubscriptions = pConfig->sharedSubscriptions;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionHandleEvent( FleetProvisioningSession_t * pSession,
+                                                                const FleetProvisioningEvent_t * pEvent,
+                                                                FleetProvisioningAction_t * pOutAction )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pSession == NULL ) || ( pEvent == NULL ) || ( pOutAction == NULL ) ||
+        ( ( pEvent->type == FleetProvisioningEventMessage ) && ( pEvent->pPayload == NULL ) ) )
+    {
+        LogError( ( "Invalid input parameter. pSession: %p, pEvent: %p, pOutAction: %p.",
+                    ( void * ) pSession,
+                    ( const void * ) pEvent,
+                    ( void * ) pOutAction ) );
+    }
+    else
+    {
+        ( void ) memset( pOutAction, 0, sizeof( FleetProvisioningAction_t ) );
+
+        switch( pEvent->type )
+        {
+            case FleetProvisioningEventStart:
+                status = handleStart( pSession, pOutAction );
+                break;
+
+            case FleetProvisioningEventSubscribed:
+                status = handleSubscribed( pSession, pOutAction );
+                break;
+
+            case FleetProvisioningEventMessage:
+                status = handleMessage( pSession, pEvent, pOutAction );
+                break;
+
+            case FleetProvisioningEventTimeout:
+                status = handleTimeout( pSession, pOutAction );
+                break;
+
+            default:
+                LogError( ( "Invalid event type: %d.", ( int ) pEvent->type ) );
+                break;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionHandleEvent, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionGetRequest( const FleetProvisioningSession_t * pSession,
+                                                               FleetProvisioningAction_t * pOutAction )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pSession == NULL ) || ( pOutAction == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pSession: %p, pOutAction: %p.",
+                    ( const void * ) pSession,
+                    ( void * ) pOutAction ) );
+    }
+    else if( pSession->state == FleetProvisioningSessionAwaitingCredentials )
+    {
+        ( void ) memset( pOutAction, 0, sizeof( FleetProvisioningAction_t ) );
+        setPublishAction( pSession, credentialsApi( pSession ), pOutAction );
+        status = FleetProvisioningSuccess;
+    }
+    else if( pSession->state == FleetProvisioningSessionAwaitingRegister )
+    {
+        ( void ) memset( pOutAction, 0, sizeof( FleetProvisioningAction_t ) );
+        setPublishAction( pSession, SESSION_API_REGISTER, pOutAction );
+        status = FleetProvisioningSuccess;
+    }
+    else
+    {
+        status = FleetProvisioningNoMatch;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionGetRequest, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
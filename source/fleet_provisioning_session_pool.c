@@ -0,0 +1,897 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session_pool.c
+ * @brief Implementation of the session pool for the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning session pool include. */
+#include "fleet_provisioning_session_pool.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Number of deferred queues of the requests that start a flow. They
+ * are the queues of the APIs before #FleetProvisioningRegisterThingApi.
+ */
+#define NEW_FLOW_QUEUE_COUNT    ( ( uint32_t ) FleetProvisioningRegisterThingApi )
+
+#if ( FP_SESSION_POOL_STARVATION_LIMIT == 0U )
+    #error "FP_SESSION_POOL_STARVATION_LIMIT must be positive."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check that a session configuration fits the buffers of a pooled
+ * session.
+ *
+ * @param[in] pConfig The configuration.
+ *
+ * @return FleetProvisioningSuccess if the configuration fits;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t checkSessionLimits( const FleetProvisioningSessionConfig_t * pConfig );
+
+/**
+ * @brief Check that a session of a pool is acquired.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ *
+ * @return FleetProvisioningSuccess if the session is acquired;
+ * FleetProvisioningBadParameter otherwise.
+ */
+static FleetProvisioningStatus_t checkAcquired( const FleetProvisioningSessionPool_t * pPool,
+                                                uint32_t index );
+
+/**
+ * @brief Arm or cancel the timeout timer of a session for the action it
+ * requested.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ * @param[in] pAction The action requested by the session.
+ */
+static void updateTimer( FleetProvisioningSessionPool_t * pPool,
+                         uint32_t index,
+                         const FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Remember the tick of a publish action, for the latency of its
+ * response.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ * @param[in] pAction The action requested by the session.
+ */
+static void recordPublish( FleetProvisioningSessionPool_t * pPool,
+                           uint32_t index,
+                           const FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Record the latency of a response handled by a session.
+ *
+ * @param[in] pPool The pool, which has latency histograms.
+ * @param[in] index The index of the session.
+ * @param[in] topic The topic of the response.
+ * @param[in] startCycles The cycle count before the session handled the
+ * response.
+ */
+static void recordResponse( FleetProvisioningSessionPool_t * pPool,
+                            uint32_t index,
+                            FleetProvisioningTopic_t topic,
+                            uint32_t startCycles );
+
+/**
+ * @brief Add a session at the end of a deferred queue.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ * @param[in] queue The queue.
+ */
+static void enqueueDeferred( FleetProvisioningSessionPool_t * pPool,
+                             uint32_t index,
+                             uint32_t queue );
+
+/**
+ * @brief Remove a session from its deferred queue.
+ *
+ * This is O(1) for the first session of the queue, and otherwise walks the
+ * queue.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session, which must be queued.
+ */
+static void removeDeferred( FleetProvisioningSessionPool_t * pPool,
+                            uint32_t index );
+
+/**
+ * @brief Check whether a publish must wait behind deferred requests or for
+ * a token.
+ *
+ * @param[in] pPool The pool, which has a rate limiter.
+ * @param[in] api The API of the request.
+ * @param[in] request The publish topic of the request.
+ *
+ * @return 1 if the publish must be deferred; 0 otherwise.
+ */
+static uint8_t mustDefer( FleetProvisioningSessionPool_t * pPool,
+                          FleetProvisioningApi_t api,
+                          FleetProvisioningTopic_t request );
+
+/**
+ * @brief Defer a publish action if the rate limiter does not allow it now.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ * @param[in,out] pAction The action requested by the session, changed to
+ * #FleetProvisioningActionDeferred if deferred.
+ */
+static void gatePublish( FleetProvisioningSessionPool_t * pPool,
+                         uint32_t index,
+                         FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Take the first publish of a deferred queue if the rate limiter
+ * allows it.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] queue The queue.
+ * @param[out] pOutIndex The index of the session.
+ * @param[out] pOutAction The publish action.
+ *
+ * @return FleetProvisioningSuccess if a publish is taken;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t takeDeferred( FleetProvisioningSessionPool_t * pPool,
+                                               uint32_t queue,
+                                               uint32_t * pOutIndex,
+                                               FleetProvisioningAction_t * pOutAction );
+
+/**
+ * @brief Take the first deferred publish of a new flow that the rate
+ * limiter allows, with the new flow queues taking turns.
+ *
+ * @param[in] pPool The pool.
+ * @param[out] pOutIndex The index of the session.
+ * @param[out] pOutAction The publish action.
+ *
+ * @return FleetProvisioningSuccess if a publish is taken;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t takeNewFlow( FleetProvisioningSessionPool_t * pPool,
+                                              uint32_t * pOutIndex,
+                                              FleetProvisioningAction_t * pOutAction );
+
+/**
+ * @brief Take the first deferred RegisterThing publish if the rate limiter
+ * allows it, counting it against the new flows waiting.
+ *
+ * @param[in] pPool The pool.
+ * @param[out] pOutIndex The index of the session.
+ * @param[out] pOutAction The publish action.
+ *
+ * @return FleetProvisioningSuccess if a publish is taken;
+ * FleetProvisioningNoMatch otherwise.
+ */
+static FleetProvisioningStatus_t takeRegister( FleetProvisioningSessionPool_t * pPool,
+                                               uint32_t * pOutIndex,
+                                               FleetProvisioningAction_t * pOutAction );
+
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t checkSessionLimits( const FleetProvisioningSessionConfig_t * pConfig )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningSuccess;
+    size_t parametersLength = 0U;
+    size_t i;
+
+    if( pConfig->csrDerLength > FP_SESSION_MAX_CSR_LENGTH )
+    {
+        LogError( ( "CSR of length %lu is longer than FP_SESSION_MAX_CSR_LENGTH.",
+                    ( unsigned long ) pConfig->csrDerLength ) );
+        status = FleetProvisioningBadParameter;
+    }
+
+    /* Each length is at most the limit, so the sum cannot wrap. */
+    for( i = 0U; ( status == FleetProvisioningSuccess ) && ( pConfig->pParameters != NULL ) &&
+         ( i < pConfig->parameterCount ); i++ )
+    {
+        if( ( pConfig->pParameters[ i ].keyLength > FP_SESSION_MAX_PARAMETERS_LENGTH ) ||
+            ( pConfig->pParameters[ i ].valueLength > FP_SESSION_MAX_PARAMETERS_LENGTH ) )
+        {
+            parametersLength = FP_SESSION_MAX_PARAMETERS_LENGTH + 1U;
+        }
+        else
+        {
+            parametersLength += pConfig->pParameters[ i ].keyLength + pConfig->pParameters[ i ].valueLength + 6U;
+        }
+
+        if( parametersLength > FP_SESSION_MAX_PARAMETERS_LENGTH )
+        {
+            LogError( ( "Parameters are longer than FP_SESSION_MAX_PARAMETERS_LENGTH." ) );
+            status = FleetProvisioningBadParameter;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t checkAcquired( const FleetProvisioningSessionPool_t * pPool,
+                                                uint32_t index )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pPool == NULL ) || ( index >= pPool->capacity ) )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p, index: %lu.",
+                    ( const void * ) pPool,
+                    ( unsigned long ) index ) );
+    }
+    else if( pPool->pStates[ index ] == FP_SESSION_STATE_FREE )
+    {
+        LogError( ( "Session %lu is not acquired.", ( unsigned long ) index ) );
+    }
+    else
+    {
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static void updateTimer( FleetProvisioningSessionPool_t * pPool,
+                         uint32_t index,
+                         const FleetProvisioningAction_t * pAction )
+{
+    if( pPool->timeoutTicks == 0U )
+    {
+        /* Timeouts are disabled. */
+    }
+    else if( ( pAction->type == FleetProvisioningActionSubscribe ) ||
+             ( pAction->type == FleetProvisioningActionPublish ) )
+    {
+        ( void ) FleetProvisioning_TimerWheelArm( &( pPool->wheel ), index, pPool->timeoutTicks );
+    }
+    else
+    {
+        /* Done, failed or deferred: the session waits for no response. */
+        ( void ) FleetProvisioning_TimerWheelCancel( &( pPool->wheel ), index );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void recordPublish( FleetProvisioningSessionPool_t * pPool,
+                           uint32_t index,
+                           const FleetProvisioningAction_t * pAction )
+{
+    if( pAction->type == FleetProvisioningActionPublish )
+    {
+        pPool->pSentTicks[ index ] = pPool->wheel.now;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void recordResponse( FleetProvisioningSessionPool_t * pPool,
+                            uint32_t index,
+                            FleetProvisioningTopic_t topic,
+                            uint32_t startCycles )
+{
+    uint32_t cycles = FP_PERF_READ_CYCLES() - startCycles;
+
+    /* A session only handles the response to the request it published, so
+     * its publish tick is set. */
+    ( void ) FleetProvisioning_HistogramRecord( &( pPool->pLatency->responseTicks[ topic ] ),
+                                                pPool->wheel.now - pPool->pSentTicks[ index ] );
+    ( void ) FleetProvisioning_HistogramRecord( &( pPool->pLatency->handleCycles[ topic ] ), cycles );
+}
+/*-----------------------------------------------------------*/
+
+static void enqueueDeferred( FleetProvisioningSessionPool_t * pPool,
+                             uint32_t index,
+                             uint32_t queue )
+{
+    pPool->pQueues[ index ] = ( uint8_t ) queue;
+    pPool->pNext[ index ] = FP_SESSION_POOL_INVALID_INDEX;
+
+    if( pPool->queueTails[ queue ] != FP_SESSION_POOL_INVALID_INDEX )
+    {
+        pPool->pNext[ pPool->queueTails[ queue ] ] = index;
+    }
+    else
+    {
+        pPool->queueHeads[ queue ] = index;
+    }
+
+    pPool->queueTails[ queue ] = index;
+}
+/*-----------------------------------------------------------*/
+
+static void removeDeferred( FleetProvisioningSessionPool_t * pPool,
+                            uint32_t index )
+{
+    uint32_t queue = pPool->pQueues[ index ];
+    uint32_t previous = FP_SESSION_POOL_INVALID_INDEX;
+    uint32_t current = pPool->queueHeads[ queue ];
+
+    while( current != index )
+    {
+        previous = current;
+        current = pPool->pNext[ current ];
+    }
+
+    if( previous == FP_SESSION_POOL_INVALID_INDEX )
+    {
+        pPool->queueHeads[ queue ] = pPool->pNext[ index ];
+    }
+    else
+    {
+        pPool->pNext[ previous ] = pPool->pNext[ index ];
+    }
+
+    if( pPool->queueTails[ queue ] == index )
+    {
+        pPool->queueTails[ queue ] = previous;
+    }
+
+    pPool->pQueues[ index ] = FP_SESSION_POOL_NOT_QUEUED;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t mustDefer( FleetProvisioningSessionPool_t * pPool,
+                          FleetProvisioningApi_t api,
+                          FleetProvisioningTopic_t request )
+{
+    uint8_t defer = 0U;
+
+    /* Requests of an API go out in order, so a request only skips the queue
+     * when it is empty. New flows also wait for the deferred RegisterThing
+     * requests, which complete flows already holding a certificate. */
+    if( ( pPool->queueHeads[ api ] != FP_SESSION_POOL_INVALID_INDEX ) ||
+        ( ( api != FleetProvisioningRegisterThingApi ) &&
+          ( pPool->queueHeads[ FleetProvisioningRegisterThingApi ] != FP_SESSION_POOL_INVALID_INDEX ) ) ||
+        ( FleetProvisioning_RateLimiterTryAcquire( pPool->pLimiter, request, pPool->wheel.now,
+                                                   NULL ) != FleetProvisioningSuccess ) )
+    {
+        defer = 1U;
+    }
+
+    return defer;
+}
+/*-----------------------------------------------------------*/
+
+static void gatePublish( FleetProvisioningSessionPool_t * pPool,
+                         uint32_t index,
+                         FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningTopicInfo_t info = { FleetProvisioningJson, FleetProvisioningCreateCertFromCsrApi, FleetProvisioningPublish };
+
+    /* A request deferred earlier is replaced by whatever the session does
+     * now. */
+    if( pPool->pQueues[ index ] != FP_SESSION_POOL_NOT_QUEUED )
+    {
+        removeDeferred( pPool, index );
+    }
+
+    if( ( pPool->pLimiter != NULL ) && ( pAction->type == FleetProvisioningActionPublish ) )
+    {
+        /* The request of a publish action is always a publish topic. */
+        ( void ) FleetProvisioning_GetTopicInfo( pAction->request, &info );
+
+        if( mustDefer( pPool, info.api, pAction->request ) == 1U )
+        {
+            enqueueDeferred( pPool, index, ( uint32_t ) info.api );
+            pAction->type = FleetProvisioningActionDeferred;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t takeDeferred( FleetProvisioningSessionPool_t * pPool,
+                                               uint32_t queue,
+                                               uint32_t * pOutIndex,
+                                               FleetProvisioningAction_t * pOutAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    FleetProvisioningAction_t action;
+    uint32_t index = pPool->queueHeads[ queue ];
+
+    if( index != FP_SESSION_POOL_INVALID_INDEX )
+    {
+        /* Any other event handled by the session takes it out of the queue,
+         * so it is still waiting to publish its request. */
+        ( void ) FleetProvisioning_SessionGetRequest( &( pPool->pSessions[ index ] ), &action );
+
+        if( ( pPool->pLimiter == NULL ) ||
+            ( FleetProvisioning_RateLimiterTryAcquire( pPool->pLimiter,
+                                                       action.request,
+                                                       pPool->wheel.now,
+                                                       NULL ) == FleetProvisioningSuccess ) )
+        {
+            removeDeferred( pPool, index );
+            updateTimer( pPool, index, &action );
+            recordPublish( pPool, index, &action );
+            *pOutIndex = index;
+            *pOutAction = action;
+            status = FleetProvisioningSuccess;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t takeNewFlow( FleetProvisioningSessionPool_t * pPool,
+                                              uint32_t * pOutIndex,
+                                              FleetProvisioningAction_t * pOutAction )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    uint32_t queue = 0U;
+    uint32_t i;
+
+    for( i = 0U; ( status == FleetProvisioningNoMatch ) && ( i < NEW_FLOW_QUEUE_COUNT ); i++ )
+    {
+        queue = ( pPool->nextQueue + i ) % NEW_FLOW_QUEUE_COUNT;
+        status = takeDeferred( pPool, queue, pOutIndex, pOutAction );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        pPool->nextQueue = ( queue + 1U ) % NEW_FLOW_QUEUE_COUNT;
+        pPool->registerStreak = 0U;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static FleetProvisioningStatus_t takeRegister( FleetProvisioningSessionPool_t * pPool,
+                                               uint32_t * pOutIndex,
+                                               FleetProvisioningAction_t * pOutAction )
+{
+    FleetProvisioningStatus_t status;
+    uint32_t i;
+    uint8_t newFlowWaiting = 0U;
+
+    status = takeDeferred( pPool, ( uint32_t ) FleetProvisioningRegisterThingApi, pOutIndex, pOutAction );
+
+    for( i = 0U; i < NEW_FLOW_QUEUE_COUNT; i++ )
+    {
+        if( pPool->queueHeads[ i ] != FP_SESSION_POOL_INVALID_INDEX )
+        {
+            newFlowWaiting = 1U;
+        }
+    }
+
+    if( newFlowWaiting == 0U )
+    {
+        pPool->registerStreak = 0U;
+    }
+    else if( ( status == FleetProvisioningSuccess ) &&
+             ( pPool->registerStreak < FP_SESSION_POOL_STARVATION_LIMIT ) )
+    {
+        pPool->registerStreak++;
+    }
+    else
+    {
+        /* Nothing sent, or new flows already have the next turn. */
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolInit( FleetProvisioningSessionPool_t * pPool,
+                                                             void * pArena,
+                                                             size_t arenaLength,
+                                                             size_t capacity,
+                                                             uint32_t timeoutTicks )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint8_t * pCursor = ( uint8_t * ) pArena;
+    uint32_t i;
+
+    if( ( pPool == NULL ) || ( pArena == NULL ) || ( capacity == 0U ) ||
+        ( capacity >= FP_SESSION_POOL_INVALID_INDEX ) || ( timeoutTicks > 0x7FFFFFFFU ) ||
+        ( ( ( ( uintptr_t ) pArena ) % sizeof( void * ) ) != 0U ) )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p, pArena: %p, capacity: %lu, timeoutTicks: %lu.",
+                    ( void * ) pPool,
+                    pArena,
+                    ( unsigned long ) capacity,
+                    ( unsigned long ) timeoutTicks ) );
+    }
+    else if( arenaLength / FP_SESSION_POOL_SLOT_LENGTH < capacity )
+    {
+        LogError( ( "Arena too small. Required: %lu per session, provided: %lu in total.",
+                    ( unsigned long ) FP_SESSION_POOL_SLOT_LENGTH,
+                    ( unsigned long ) arenaLength ) );
+        status = FleetProvisioningBufferTooSmall;
+    }
+    else
+    {
+        /* The arrays are laid out by decreasing alignment, so only the arena
+         * itself needs to be aligned. */
+        pPool->pSessions = ( FleetProvisioningSession_t * ) pCursor;
+        pCursor = &( pCursor[ capacity * sizeof( FleetProvisioningSession_t ) ] );
+        ( void ) FleetProvisioning_TimerWheelInit( &( pPool->wheel ),
+                                                   ( FleetProvisioningTimerNode_t * ) pCursor,
+                                                   capacity );
+        pCursor = &( pCursor[ capacity * sizeof( FleetProvisioningTimerNode_t ) ] );
+        pPool->pNext = ( uint32_t * ) pCursor;
+        pCursor = &( pCursor[ capacity * sizeof( uint32_t ) ] );
+        pPool->pSentTicks = ( uint32_t * ) pCursor;
+        pCursor = &( pCursor[ capacity * sizeof( uint32_t ) ] );
+        pPool->pStates = pCursor;
+        pCursor = &( pCursor[ capacity ] );
+        pPool->pQueues = pCursor;
+        pCursor = &( pCursor[ capacity ] );
+        pPool->pTopicBuffers = ( char * ) pCursor;
+        pCursor = &( pCursor[ capacity * FP_SESSION_TOPIC_BUFFER_LENGTH ] );
+        pPool->pPayloadBuffers = ( char * ) pCursor;
+        pPool->capacity = ( uint32_t ) capacity;
+        pPool->inUseCount = 0U;
+        pPool->timeoutTicks = timeoutTicks;
+        pPool->pLimiter = NULL;
+        pPool->pConcurrency = NULL;
+        pPool->pLatency = NULL;
+        pPool->nextQueue = 0U;
+        pPool->registerStreak = 0U;
+
+        for( i = 0U; i < FP_API_COUNT; i++ )
+        {
+            pPool->queueHeads[ i ] = FP_SESSION_POOL_INVALID_INDEX;
+            pPool->queueTails[ i ] = FP_SESSION_POOL_INVALID_INDEX;
+        }
+
+        for( i = 0U; i < pPool->capacity; i++ )
+        {
+            pPool->pStates[ i ] = FP_SESSION_STATE_FREE;
+            pPool->pQueues[ i ] = FP_SESSION_POOL_NOT_QUEUED;
+            pPool->pNext[ i ] = i + 1U;
+        }
+
+        pPool->pNext[ pPool->capacity - 1U ] = FP_SESSION_POOL_INVALID_INDEX;
+        pPool->freeHead = 0U;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolAcquire( FleetProvisioningSessionPool_t * pPool,
+                                                                const FleetProvisioningSessionConfig_t * pConfig,
+                                                                uint32_t * pOutIndex )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t index;
+
+    if( ( pPool == NULL ) || ( pConfig == NULL ) || ( pOutIndex == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p, pConfig: %p, pOutIndex: %p.",
+                    ( void * ) pPool,
+                    ( const void * ) pConfig,
+                    ( void * ) pOutIndex ) );
+    }
+    else if( pPool->freeHead == FP_SESSION_POOL_INVALID_INDEX )
+    {
+        LogError( ( "All %lu sessions are in use.", ( unsigned long ) pPool->capacity ) );
+        status = FleetProvisioningBufferTooSmall;
+    }
+    else
+    {
+        status = checkSessionLimits( pConfig );
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        index = pPool->freeHead;
+        status = FleetProvisioning_SessionInit( &( pPool->pSessions[ index ] ),
+                                                pConfig,
+                                                &( pPool->pTopicBuffers[ ( size_t ) index * FP_SESSION_TOPIC_BUFFER_LENGTH ] ),
+                                                FP_SESSION_TOPIC_BUFFER_LENGTH,
+                                                &( pPool->pPayloadBuffers[ ( size_t ) index * FP_SESSION_PAYLOAD_BUFFER_LENGTH ] ),
+                                                FP_SESSION_PAYLOAD_BUFFER_LENGTH );
+
+        if( ( status == FleetProvisioningSuccess ) && ( pPool->pConcurrency != NULL ) )
+        {
+            status = FleetProvisioning_ConcurrencyTryStart( pPool->pConcurrency );
+        }
+
+        /* The session is only taken off the free list once it is set up. */
+        if( status == FleetProvisioningSuccess )
+        {
+            pPool->freeHead = pPool->pNext[ index ];
+            pPool->pStates[ index ] = ( uint8_t ) pPool->pSessions[ index ].state;
+            pPool->inUseCount++;
+            *pOutIndex = index;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolAcquire, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolRelease( FleetProvisioningSessionPool_t * pPool,
+                                                                uint32_t index )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = checkAcquired( pPool, index );
+
+    if( status == FleetProvisioningSuccess )
+    {
+        ( void ) FleetProvisioning_TimerWheelCancel( &( pPool->wheel ), index );
+
+        if( pPool->pQueues[ index ] != FP_SESSION_POOL_NOT_QUEUED )
+        {
+            removeDeferred( pPool, index );
+        }
+
+        if( pPool->pConcurrency != NULL )
+        {
+            ( void ) FleetProvisioning_ConcurrencyFinish( pPool->pConcurrency );
+        }
+
+        pPool->pStates[ index ] = FP_SESSION_STATE_FREE;
+        pPool->pNext[ index ] = pPool->freeHead;
+        pPool->freeHead = index;
+        pPool->inUseCount--;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolRelease, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolHandleEvent( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t index,
+                                                                    const FleetProvisioningEvent_t * pEvent,
+                                                                    FleetProvisioningAction_t * pOutAction )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = checkAcquired( pPool, index );
+    uint32_t startCycles = 0U;
+
+    if( status == FleetProvisioningSuccess )
+    {
+        if( pPool->pLatency != NULL )
+        {
+            startCycles = FP_PERF_READ_CYCLES();
+        }
+
+        status = FleetProvisioning_SessionHandleEvent( &( pPool->pSessions[ index ] ), pEvent, pOutAction );
+        pPool->pStates[ index ] = ( uint8_t ) pPool->pSessions[ index ].state;
+
+        if( ( status == FleetProvisioningSuccess ) && ( pPool->pLatency != NULL ) &&
+            ( pEvent->type == FleetProvisioningEventMessage ) )
+        {
+            recordResponse( pPool, index, pEvent->topic, startCycles );
+        }
+
+        if( ( status == FleetProvisioningSuccess ) && ( pPool->pConcurrency != NULL ) &&
+            ( pEvent->type == FleetProvisioningEventMessage ) )
+        {
+            ( void ) FleetProvisioning_ConcurrencyOnResponse( pPool->pConcurrency, pEvent->topic,
+                                                              pEvent->pPayload, pEvent->payloadLength );
+        }
+
+        if( status == FleetProvisioningSuccess )
+        {
+            gatePublish( pPool, index, pOutAction );
+            updateTimer( pPool, index, pOutAction );
+            recordPublish( pPool, index, pOutAction );
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolHandleEvent, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolTick( FleetProvisioningSessionPool_t * pPool,
+                                                             uint32_t now )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pPool == NULL )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p.", ( void * ) pPool ) );
+    }
+    else
+    {
+        status = FleetProvisioning_TimerWheelAdvance( &( pPool->wheel ), now );
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolTick, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolNextTimeout( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t * pOutIndex,
+                                                                    FleetProvisioningAction_t * pOutAction )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningEvent_t event = { FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U };
+    uint32_t index;
+
+    if( ( pPool == NULL ) || ( pOutIndex == NULL ) || ( pOutAction == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p, pOutIndex: %p, pOutAction: %p.",
+                    ( void * ) pPool,
+                    ( void * ) pOutIndex,
+                    ( void * ) pOutAction ) );
+    }
+    else
+    {
+        status = FleetProvisioning_TimerWheelPopExpired( &( pPool->wheel ), &index );
+    }
+
+    /* A timer is only armed while its session waits for a response, so the
+     * session always handles the timeout. */
+    if( status == FleetProvisioningSuccess )
+    {
+        status = FleetProvisioning_SessionPoolHandleEvent( pPool, index, &event, pOutAction );
+        *pOutIndex = index;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolNextTimeout, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetRateLimiter( FleetProvisioningSessionPool_t * pPool,
+                                                                       FleetProvisioningRateLimiter_t * pLimiter )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pPool == NULL )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p.", ( void * ) pPool ) );
+    }
+    else
+    {
+        pPool->pLimiter = pLimiter;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolSetRateLimiter, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetConcurrency( FleetProvisioningSessionPool_t * pPool,
+                                                                       FleetProvisioningConcurrency_t * pController )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pPool == NULL )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p.", ( void * ) pPool ) );
+    }
+    else if( pPool->inUseCount > 0U )
+    {
+        LogError( ( "The concurrency controller cannot change while %lu sessions are acquired.",
+                    ( unsigned long ) pPool->inUseCount ) );
+    }
+    else
+    {
+        pPool->pConcurrency = pController;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolSetConcurrency, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolNextPublish( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t * pOutIndex,
+                                                                    FleetProvisioningAction_t * pOutAction )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pPool == NULL ) || ( pOutIndex == NULL ) || ( pOutAction == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p, pOutIndex: %p, pOutAction: %p.",
+                    ( void * ) pPool,
+                    ( void * ) pOutIndex,
+                    ( void * ) pOutAction ) );
+    }
+    else
+    {
+        status = FleetProvisioningNoMatch;
+    }
+
+    /* Deferred RegisterThing requests go first. New flows start once none
+     * are left, or once they held new flows back for
+     * FP_SESSION_POOL_STARVATION_LIMIT requests; a RegisterThing request
+     * still goes when no new flow can. */
+    if( ( status == FleetProvisioningNoMatch ) &&
+        ( ( pPool->registerStreak >= FP_SESSION_POOL_STARVATION_LIMIT ) ||
+          ( pPool->queueHeads[ FleetProvisioningRegisterThingApi ] == FP_SESSION_POOL_INVALID_INDEX ) ) )
+    {
+        status = takeNewFlow( pPool, pOutIndex, pOutAction );
+    }
+
+    if( status == FleetProvisioningNoMatch )
+    {
+        status = takeRegister( pPool, pOutIndex, pOutAction );
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolNextPublish, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetLatency( FleetProvisioningSessionPool_t * pPool,
+                                                                   FleetProvisioningLatency_t * pLatency )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pPool == NULL )
+    {
+        LogError( ( "Invalid input parameter. pPool: %p.", ( void * ) pPool ) );
+    }
+    else
+    {
+        pPool->pLatency = pLatency;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfSessionPoolSetLatency, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,280 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_shard.c
+ * @brief Implementation of the shard queues for the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning shard include. */
+#include "fleet_provisioning_shard.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Largest difference between two queue positions that is taken as
+ * the second one being ahead. Positions wrap, so a larger difference means
+ * the second one is behind.
+ */
+#define POSITION_MAX_DISTANCE    ( 0x7FFFFFFFU )
+
+/* Without a mapping to the atomic operations of the target, shard queues
+ * compare and write plainly. */
+#ifndef FP_ATOMIC_COMPARE_AND_SWAP
+    #define PLAIN_COMPARE_AND_SWAP    ( 1 )
+    #define FP_ATOMIC_COMPARE_AND_SWAP( pValue, expected, desired )    compareAndSwap( ( pValue ), ( expected ), ( desired ) )
+#endif
+
+/*-----------------------------------------------------------*/
+
+#ifdef PLAIN_COMPARE_AND_SWAP
+
+/**
+ * @brief Replace a value if it equals an expected value, without atomic
+ * operations: the default of #FP_ATOMIC_COMPARE_AND_SWAP.
+ *
+ * @param[in,out] pValue The value.
+ * @param[in] expected The expected value.
+ * @param[in] desired The value to write if @p pValue holds @p expected.
+ *
+ * @return 1 if the value was replaced, 0 otherwise.
+ */
+    static uint8_t compareAndSwap( uint32_t * pValue,
+                                   uint32_t expected,
+                                   uint32_t desired );
+#endif
+
+/*-----------------------------------------------------------*/
+
+#ifdef PLAIN_COMPARE_AND_SWAP
+    static uint8_t compareAndSwap( uint32_t * pValue,
+                                   uint32_t expected,
+                                   uint32_t desired )
+    {
+        uint8_t swapped = 0U;
+
+        if( *pValue == expected )
+        {
+            *pValue = desired;
+            swapped = 1U;
+        }
+
+        return swapped;
+    }
+#endif
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_GetShard( const char * pKey,
+                                                      size_t keyLength,
+                                                      uint32_t shardCount,
+                                                      uint32_t * pOutShard )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t hash;
+
+    if( ( pKey == NULL ) || ( keyLength == 0U ) || ( shardCount == 0U ) || ( pOutShard == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pKey: %p, keyLength: %lu, shardCount: %u, pOutShard: %p.",
+                    ( const void * ) pKey,
+                    ( unsigned long ) keyLength,
+                    ( unsigned int ) shardCount,
+                    ( void * ) pOutShard ) );
+    }
+    else
+    {
+        /* FNV-1a, then a finalizer so that keys differing only in their
+         * last characters, such as serial numbers, differ in the high bits
+         * too. The shard is the high bits of the product with the shard
+         * count, which spreads the hashes evenly without a division. */
+        hash = FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, pKey, keyLength );
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6BU;
+        hash ^= hash >> 13;
+        hash *= 0xC2B2AE35U;
+        hash ^= hash >> 16;
+
+        *pOutShard = ( uint32_t ) ( ( ( uint64_t ) hash * shardCount ) >> 32 );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfGetShard, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ShardQueueInit( FleetProvisioningShardQueue_t * pQueue,
+                                                            FleetProvisioningShardSlot_t * pSlots,
+                                                            uint32_t slotCount )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    /* A single slot cannot tell a full queue from an empty one. */
+    if( ( pQueue == NULL ) || ( pSlots == NULL ) || ( slotCount < 2U ) ||
+        ( slotCount > FP_SHARD_QUEUE_MAX_SLOTS ) || ( ( slotCount & ( slotCount - 1U ) ) != 0U ) )
+    {
+        LogError( ( "Invalid input parameter. pQueue: %p, pSlots: %p, slotCount: %u.",
+                    ( void * ) pQueue,
+                    ( void * ) pSlots,
+                    ( unsigned int ) slotCount ) );
+    }
+    else
+    {
+        /* A slot is free for the push at the position equal to its
+         * sequence, and holds an event for the pop at the position one
+         * below its sequence. */
+        for( i = 0U; i < slotCount; i++ )
+        {
+            pSlots[ i ].sequence = i;
+        }
+
+        pQueue->pSlots = pSlots;
+        pQueue->mask = slotCount - 1U;
+        pQueue->popPosition = 0U;
+        pQueue->pushPosition = 0U;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfShardQueueInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ShardQueuePush( FleetProvisioningShardQueue_t * pQueue,
+                                                            uint32_t tag,
+                                                            const FleetProvisioningEvent_t * pEvent )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningShardSlot_t * pSlot;
+    uint32_t position;
+    uint32_t sequence;
+    uint8_t done = 0U;
+
+    if( ( pQueue == NULL ) || ( pEvent == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pQueue: %p, pEvent: %p.",
+                    ( void * ) pQueue,
+                    ( const void * ) pEvent ) );
+    }
+    else
+    {
+        position = FP_ATOMIC_LOAD_ACQUIRE( &( pQueue->pushPosition ) );
+
+        while( done == 0U )
+        {
+            pSlot = &( pQueue->pSlots[ position & pQueue->mask ] );
+            sequence = FP_ATOMIC_LOAD_ACQUIRE( &( pSlot->sequence ) );
+
+            if( sequence == position )
+            {
+                /* The slot is free. Claim the position, unless another
+                 * thread claimed it first. */
+                if( FP_ATOMIC_COMPARE_AND_SWAP( &( pQueue->pushPosition ), position, position + 1U ) )
+                {
+                    pSlot->tag = tag;
+                    pSlot->event = *pEvent;
+                    FP_ATOMIC_STORE_RELEASE( &( pSlot->sequence ), position + 1U );
+                    status = FleetProvisioningSuccess;
+                    done = 1U;
+                }
+                else
+                {
+                    position = FP_ATOMIC_LOAD_ACQUIRE( &( pQueue->pushPosition ) );
+                }
+            }
+            else if( ( position - sequence ) <= POSITION_MAX_DISTANCE )
+            {
+                /* The slot still holds the event pushed one lap earlier,
+                 * which the worker has not popped yet. */
+                status = FleetProvisioningBufferTooSmall;
+                done = 1U;
+            }
+            else
+            {
+                /* Another thread pushed onto the slot since the position
+                 * was read. */
+                position = FP_ATOMIC_LOAD_ACQUIRE( &( pQueue->pushPosition ) );
+            }
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfShardQueuePush, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_ShardQueuePop( FleetProvisioningShardQueue_t * pQueue,
+                                                           uint32_t * pOutTag,
+                                                           FleetProvisioningEvent_t * pOutEvent )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    FleetProvisioningShardSlot_t * pSlot;
+    uint32_t position;
+
+    if( ( pQueue == NULL ) || ( pOutTag == NULL ) || ( pOutEvent == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pQueue: %p, pOutTag: %p, pOutEvent: %p.",
+                    ( void * ) pQueue,
+                    ( void * ) pOutTag,
+                    ( void * ) pOutEvent ) );
+    }
+    else
+    {
+        position = pQueue->popPosition;
+        pSlot = &( pQueue->pSlots[ position & pQueue->mask ] );
+
+        if( FP_ATOMIC_LOAD_ACQUIRE( &( pSlot->sequence ) ) == ( position + 1U ) )
+        {
+            *pOutTag = pSlot->tag;
+            *pOutEvent = pSlot->event;
+
+            /* Free the slot for the push one lap later. */
+            FP_ATOMIC_STORE_RELEASE( &( pSlot->sequence ), position + pQueue->mask + 1U );
+            pQueue->popPosition = position + 1U;
+            status = FleetProvisioningSuccess;
+        }
+        else
+        {
+            status = FleetProvisioningNoMatch;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfShardQueuePop, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,460 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_timer_wheel.c
+ * @brief Implementation of the hierarchical timer wheel for the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning timer wheel include. */
+#include "fleet_provisioning_timer_wheel.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief List value of a timer that is not armed.
+ */
+#define LIST_NONE            ( 0xFFFFU )
+
+/**
+ * @brief Index of the expired list in the list heads.
+ */
+#define LIST_EXPIRED         ( FP_TIMER_WHEEL_LISTS - 1U )
+
+/**
+ * @brief Mask of the slot index within a level.
+ */
+#define SLOT_MASK            ( FP_TIMER_WHEEL_SLOTS - 1U )
+
+/**
+ * @brief Number of ticks the wheel holds without re-queuing.
+ */
+#define WHEEL_RANGE          ( 1UL << ( FP_TIMER_WHEEL_SLOT_BITS * FP_TIMER_WHEEL_LEVELS ) )
+
+/**
+ * @brief Largest delay that can be armed, so that tick comparisons are not
+ * confused by the wrap of the tick counter.
+ */
+#define MAX_DELAY_TICKS      ( 0x7FFFFFFFU )
+
+#if ( FP_TIMER_WHEEL_LEVELS < 1U ) || ( FP_TIMER_WHEEL_LEVELS > 5U )
+    #error "FP_TIMER_WHEEL_LEVELS must be from 1 to 5."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add a timer at the front of a list.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] list The list.
+ * @param[in] timer The index of the timer.
+ */
+static void pushFront( FleetProvisioningTimerWheel_t * pWheel,
+                       uint16_t list,
+                       uint32_t timer );
+
+/**
+ * @brief Add a timer at the end of the expired list.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] timer The index of the timer.
+ */
+static void appendExpired( FleetProvisioningTimerWheel_t * pWheel,
+                           uint32_t timer );
+
+/**
+ * @brief Remove a timer from its list.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] timer The index of the timer, which must be armed.
+ */
+static void unlinkTimer( FleetProvisioningTimerWheel_t * pWheel,
+                         uint32_t timer );
+
+/**
+ * @brief Place a pending timer in the slot for its expiry, relative to the
+ * current tick.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] timer The index of the timer.
+ */
+static void placeTimer( FleetProvisioningTimerWheel_t * pWheel,
+                        uint32_t timer );
+
+/**
+ * @brief Empty the slot of a level for the current tick, placing its timers
+ * again, or expiring them for level 0.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] level The level.
+ */
+static void processSlot( FleetProvisioningTimerWheel_t * pWheel,
+                         uint32_t level );
+
+/**
+ * @brief Move the wheel forward by one tick.
+ *
+ * @param[in] pWheel The timer wheel.
+ */
+static void processTick( FleetProvisioningTimerWheel_t * pWheel );
+
+/*-----------------------------------------------------------*/
+
+static void pushFront( FleetProvisioningTimerWheel_t * pWheel,
+                       uint16_t list,
+                       uint32_t timer )
+{
+    FleetProvisioningTimerNode_t * pNode = &( pWheel->pNodes[ timer ] );
+
+    pNode->list = list;
+    pNode->prev = FP_TIMER_WHEEL_INVALID_TIMER;
+    pNode->next = pWheel->heads[ list ];
+
+    if( pNode->next != FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        pWheel->pNodes[ pNode->next ].prev = timer;
+    }
+
+    pWheel->heads[ list ] = timer;
+}
+/*-----------------------------------------------------------*/
+
+static void appendExpired( FleetProvisioningTimerWheel_t * pWheel,
+                           uint32_t timer )
+{
+    FleetProvisioningTimerNode_t * pNode = &( pWheel->pNodes[ timer ] );
+
+    pNode->list = ( uint16_t ) LIST_EXPIRED;
+    pNode->next = FP_TIMER_WHEEL_INVALID_TIMER;
+    pNode->prev = pWheel->expiredTail;
+
+    if( pWheel->expiredTail != FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        pWheel->pNodes[ pWheel->expiredTail ].next = timer;
+    }
+    else
+    {
+        pWheel->heads[ LIST_EXPIRED ] = timer;
+    }
+
+    pWheel->expiredTail = timer;
+}
+/*-----------------------------------------------------------*/
+
+static void unlinkTimer( FleetProvisioningTimerWheel_t * pWheel,
+                         uint32_t timer )
+{
+    FleetProvisioningTimerNode_t * pNode = &( pWheel->pNodes[ timer ] );
+
+    assert( pNode->list != LIST_NONE );
+
+    if( pNode->prev != FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        pWheel->pNodes[ pNode->prev ].next = pNode->next;
+    }
+    else
+    {
+        pWheel->heads[ pNode->list ] = pNode->next;
+    }
+
+    if( pNode->next != FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        pWheel->pNodes[ pNode->next ].prev = pNode->prev;
+    }
+    else if( pNode->list == LIST_EXPIRED )
+    {
+        pWheel->expiredTail = pNode->prev;
+    }
+    else
+    {
+        /* Slot lists have no tail. */
+    }
+
+    if( pNode->list != LIST_EXPIRED )
+    {
+        pWheel->pendingCount--;
+    }
+
+    pNode->list = LIST_NONE;
+}
+/*-----------------------------------------------------------*/
+
+static void placeTimer( FleetProvisioningTimerWheel_t * pWheel,
+                        uint32_t timer )
+{
+    uint32_t expiry = pWheel->pNodes[ timer ].expiry;
+    uint32_t delta = expiry - pWheel->now;
+    uint32_t level = 0U;
+    uint32_t slot;
+
+    /* Timers beyond the range of the wheel wait in the top level, and are
+     * placed again when the wheel reaches them. */
+    if( delta >= WHEEL_RANGE )
+    {
+        expiry = pWheel->now + ( uint32_t ) ( WHEEL_RANGE - 1U );
+        delta = ( uint32_t ) ( WHEEL_RANGE - 1U );
+    }
+
+    while( ( ( level + 1U ) < FP_TIMER_WHEEL_LEVELS ) &&
+           ( ( delta >> ( FP_TIMER_WHEEL_SLOT_BITS * ( level + 1U ) ) ) != 0U ) )
+    {
+        level++;
+    }
+
+    slot = ( expiry >> ( FP_TIMER_WHEEL_SLOT_BITS * level ) ) & SLOT_MASK;
+    pushFront( pWheel, ( uint16_t ) ( ( level * FP_TIMER_WHEEL_SLOTS ) + slot ), timer );
+}
+/*-----------------------------------------------------------*/
+
+static void processSlot( FleetProvisioningTimerWheel_t * pWheel,
+                         uint32_t level )
+{
+    uint32_t list = ( level * FP_TIMER_WHEEL_SLOTS ) +
+                    ( ( pWheel->now >> ( FP_TIMER_WHEEL_SLOT_BITS * level ) ) & SLOT_MASK );
+    uint32_t timer = pWheel->heads[ list ];
+    uint32_t next;
+
+    pWheel->heads[ list ] = FP_TIMER_WHEEL_INVALID_TIMER;
+
+    while( timer != FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        next = pWheel->pNodes[ timer ].next;
+
+        /* A level 0 slot only holds timers expiring at this tick. */
+        if( level == 0U )
+        {
+            pWheel->pendingCount--;
+            appendExpired( pWheel, timer );
+        }
+        else
+        {
+            placeTimer( pWheel, timer );
+        }
+
+        timer = next;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void processTick( FleetProvisioningTimerWheel_t * pWheel )
+{
+    uint32_t level;
+
+    pWheel->now++;
+
+    /* Higher levels first, as their timers may move to the slot of a lower
+     * level for this tick. */
+    for( level = FP_TIMER_WHEEL_LEVELS - 1U; level > 0U; level-- )
+    {
+        if( ( pWheel->now & ( ( 1UL << ( FP_TIMER_WHEEL_SLOT_BITS * level ) ) - 1U ) ) == 0U )
+        {
+            processSlot( pWheel, level );
+        }
+    }
+
+    processSlot( pWheel, 0U );
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelInit( FleetProvisioningTimerWheel_t * pWheel,
+                                                            FleetProvisioningTimerNode_t * pNodes,
+                                                            size_t timerCount )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t i;
+
+    if( ( pWheel == NULL ) || ( pNodes == NULL ) || ( timerCount == 0U ) ||
+        ( timerCount >= FP_TIMER_WHEEL_INVALID_TIMER ) )
+    {
+        LogError( ( "Invalid input parameter. pWheel: %p, pNodes: %p, timerCount: %lu.",
+                    ( void * ) pWheel,
+                    ( void * ) pNodes,
+                    ( unsigned long ) timerCount ) );
+    }
+    else
+    {
+        pWheel->pNodes = pNodes;
+        pWheel->timerCount = ( uint32_t ) timerCount;
+        pWheel->now = 0U;
+        pWheel->pendingCount = 0U;
+        pWheel->expiredTail = FP_TIMER_WHEEL_INVALID_TIMER;
+
+        for( i = 0U; i < FP_TIMER_WHEEL_LISTS; i++ )
+        {
+            pWheel->heads[ i ] = FP_TIMER_WHEEL_INVALID_TIMER;
+        }
+
+        for( i = 0U; i < pWheel->timerCount; i++ )
+        {
+            pNodes[ i ].list = LIST_NONE;
+        }
+
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfTimerWheelInit, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelArm( FleetProvisioningTimerWheel_t * pWheel,
+                                                           uint32_t timer,
+                                                           uint32_t delayTicks )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pWheel == NULL ) || ( timer >= pWheel->timerCount ) ||
+        ( delayTicks == 0U ) || ( delayTicks > MAX_DELAY_TICKS ) )
+    {
+        LogError( ( "Invalid input parameter. pWheel: %p, timer: %lu, delayTicks: %lu.",
+                    ( void * ) pWheel,
+                    ( unsigned long ) timer,
+                    ( unsigned long ) delayTicks ) );
+    }
+    else
+    {
+        if( pWheel->pNodes[ timer ].list != LIST_NONE )
+        {
+            unlinkTimer( pWheel, timer );
+        }
+
+        pWheel->pNodes[ timer ].expiry = pWheel->now + delayTicks;
+        placeTimer( pWheel, timer );
+        pWheel->pendingCount++;
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfTimerWheelArm, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelCancel( FleetProvisioningTimerWheel_t * pWheel,
+                                                              uint32_t timer )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( ( pWheel == NULL ) || ( timer >= pWheel->timerCount ) )
+    {
+        LogError( ( "Invalid input parameter. pWheel: %p, timer: %lu.",
+                    ( void * ) pWheel,
+                    ( unsigned long ) timer ) );
+    }
+    else if( pWheel->pNodes[ timer ].list == LIST_NONE )
+    {
+        status = FleetProvisioningNoMatch;
+    }
+    else
+    {
+        unlinkTimer( pWheel, timer );
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfTimerWheelCancel, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelAdvance( FleetProvisioningTimerWheel_t * pWheel,
+                                                               uint32_t now )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+
+    if( pWheel == NULL )
+    {
+        LogError( ( "Invalid input parameter. pWheel: %p.", ( void * ) pWheel ) );
+    }
+    else
+    {
+        /* The unsigned difference is below 2^31 for ticks in the future. */
+        while( ( pWheel->pendingCount > 0U ) && ( pWheel->now != now ) &&
+               ( ( now - pWheel->now ) <= MAX_DELAY_TICKS ) )
+        {
+            processTick( pWheel );
+        }
+
+        /* With no pending timer there is nothing to process on the way. */
+        if( ( now - pWheel->now ) <= MAX_DELAY_TICKS )
+        {
+            pWheel->now = now;
+        }
+
+        status = FleetProvisioningSuccess;
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfTimerWheelAdvance, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelPopExpired( FleetProvisioningTimerWheel_t * pWheel,
+                                                                  uint32_t * pOutTimer )
+{
+    FP_PERF_START( perfStart )
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    uint32_t timer;
+
+    if( ( pWheel == NULL ) || ( pOutTimer == NULL ) )
+    {
+        LogError( ( "Invalid input parameter. pWheel: %p, pOutTimer: %p.",
+                    ( void * ) pWheel,
+                    ( void * ) pOutTimer ) );
+    }
+    else
+    {
+        timer = pWheel->heads[ LIST_EXPIRED ];
+
+        if( timer == FP_TIMER_WHEEL_INVALID_TIMER )
+        {
+            status = FleetProvisioningNoMatch;
+        }
+        else
+        {
+            unlinkTimer( pWheel, timer );
+            *pOutTimer = timer;
+            status = FleetProvisioningSuccess;
+        }
+    }
+
+    FP_PERF_RECORD( FleetProvisioningPerfTimerWheelPopExpired, status, perfStart );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
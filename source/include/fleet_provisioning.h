@@ -31,6 +31,7 @@
 #define FLEET_PROVISIONING_H_
 
 /* Standard includes. */
+#include <stddef.h>
 #include <stdint.h>
 
 /* *INDENT-OFF* */
@@ -111,6 +112,29 @@ typedef enum
     FleetProvisioningCbor
 } FleetProvisioningFormat_t;
 
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief Fleet Provisioning APIs, each with its own transaction rate limit.
+ */
+typedef enum
+{
+    FleetProvisioningCreateCertFromCsrApi = 0, /**< @brief CreateCertificateFromCsr. */
+    FleetProvisioningCreateKeysAndCertApi,     /**< @brief CreateKeysAndCertificate. */
+    FleetProvisioningRegisterThingApi          /**< @brief RegisterThing. */
+} FleetProvisioningApi_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief What a Fleet Provisioning topic is for, as returned by
+ * #FleetProvisioning_GetTopicInfo.
+ */
+typedef struct FleetProvisioningTopicInfo
+{
+    FleetProvisioningFormat_t format;  /**< @brief Message format of the topic. */
+    FleetProvisioningApi_t api;        /**< @brief API of the topic. */
+    FleetProvisioningApiTopics_t kind; /**< @brief Whether it is the publish, accepted or rejected topic of the API. */
+} FleetProvisioningTopicInfo_t;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -119,6 +143,12 @@ typedef enum
  */
 #define FP_TEMPLATENAME_MAX_LENGTH    36U
 
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of Fleet Provisioning APIs.
+ */
+#define FP_API_COUNT                  ( 3U )
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -150,6 +180,8 @@ typedef enum
 #define FP_API_REJECTED_SUFFIX              "/rejected"
 #define FP_API_LENGTH_REJECTED_SUFFIX       ( ( uint16_t ) ( sizeof( FP_API_REJECTED_SUFFIX ) - 1U ) )
 
+#define FP_FNV1A_OFFSET_BASIS               ( 2166136261U )
+
 /** @endcond */
 
 /*-----------------------------------------------------------*/
@@ -712,6 +744,56 @@ FleetProvisioningStatus_t FleetProvisioning_MatchTopic( const char * pTopic,
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Get the format, API and kind of a Fleet Provisioning topic.
+ *
+ * @param[in] topic The topic, as matched by #FleetProvisioning_MatchTopic.
+ * @param[out] pOutInfo The format, API and kind of the topic.
+ *
+ * @return FleetProvisioningSuccess if the information is returned;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to tell the rejected responses of any
+ * // API and format apart from the other topics.
+ *
+ * FleetProvisioningTopicInfo_t info;
+ *
+ * if( ( FleetProvisioning_GetTopicInfo( topic, &info ) == FleetProvisioningSuccess ) &&
+ *     ( info.kind == FleetProvisioningRejected ) )
+ * {
+ *      // info.format tells how to parse the error response.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_gettopicinfo] */
+FleetProvisioningStatus_t FleetProvisioning_GetTopicInfo( FleetProvisioningTopic_t topic,
+                                                          FleetProvisioningTopicInfo_t * pOutInfo );
+/* @[declare_fleet_provisioning_gettopicinfo] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Continue a 32-bit FNV-1a hash over some bytes. Called by the
+ * library.
+ *
+ * @param[in] hash The offset basis, to start a hash, or the hash of the
+ * bytes before @p pData.
+ * @param[in] pData The bytes to hash.
+ * @param[in] length The length of @p pData.
+ *
+ * @return The hash of all the bytes so far.
+ */
+/* @[declare_fleet_provisioning_hashfnv1a] */
+uint32_t FleetProvisioning_HashFnv1a( uint32_t hash,
+                                      const char * pData,
+                                      size_t length );
+/* @[declare_fleet_provisioning_hashfnv1a] */
+
+/*-----------------------------------------------------------*/
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     }
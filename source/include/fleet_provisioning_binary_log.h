@@ -0,0 +1,251 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_binary_log.h
+ * @brief Interface for the binary error log of the AWS IoT Fleet
+ * Provisioning Library.
+ */
+
+#ifndef FLEET_PROVISIONING_BINARY_LOG_H_
+#define FLEET_PROVISIONING_BINARY_LOG_H_
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Value of #FleetProvisioningBinaryLog_t.magic, "FPBL" in a little
+ * endian dump.
+ */
+#define FP_BINARY_LOG_MAGIC       ( 0x4C425046U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of arguments of a binary log record.
+ */
+#define FP_BINARY_LOG_MAX_ARGS    ( 6U )
+
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief The messages of the binary log.
+ *
+ * The text of each message is in #FP_BINARY_LOG_FORMATS. Values are never
+ * reused, so that logs of older builds can still be decoded.
+ */
+typedef enum
+{
+    FleetProvisioningLogNone = 0,                            /**< @brief No message. */
+    FleetProvisioningLogGetRegisterThingTopicBadParameter,   /**< @brief #FleetProvisioning_GetRegisterThingTopic was called with invalid parameters. */
+    FleetProvisioningLogGetRegisterThingTopicBufferTooSmall, /**< @brief #FleetProvisioning_GetRegisterThingTopic was called with a buffer too small. */
+    FleetProvisioningLogMatchTopicBadParameter,              /**< @brief #FleetProvisioning_MatchTopic was called with invalid parameters. */
+    FleetProvisioningLogMessageCount                         /**< @brief Number of messages. */
+} FleetProvisioningLogMessage_t;
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Initializer of an array of the text of each
+ * #FleetProvisioningLogMessage_t, for decoders.
+ *
+ * The text is a printf format using only `%p`, `%d` and `%u`, which take
+ * the arguments of the record in order.
+ */
+#define FP_BINARY_LOG_FORMATS                                                   \
+    {                                                                           \
+        "",                                                                     \
+        "Invalid input parameter. pTopicBuffer: %p, format: %d, topic: %d,"     \
+        " pTemplateName: %p, templateNameLength: %u, pOutLength: %p.",          \
+        "The buffer is too small to hold the topic string. "                    \
+        "Provided buffer size: %u, Required buffer size: %u.",                  \
+        "Invalid input parameter. pTopic: %p, pOutApi: %p."                     \
+    }
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A record of a binary log.
+ */
+typedef struct FleetProvisioningBinaryLogRecord
+{
+    /**
+     * @brief One more than the number of records written to the log before
+     * this one, or 0 while it is written.
+     */
+    uint32_t sequence;
+    uint32_t message;                        /**< @brief The #FleetProvisioningLogMessage_t. */
+    uint64_t args[ FP_BINARY_LOG_MAX_ARGS ]; /**< @brief The arguments of the message; pointers are stored as their address. */
+} FleetProvisioningBinaryLogRecord_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A binary log: a ring of the most recent records.
+ *
+ * The log is meant to be read offline, from a dump of this structure, on a
+ * host of the same byte order. While other threads may write to the log,
+ * dump a copy taken with #FleetProvisioning_BinaryLogCopy instead, as the
+ * records written while the dump is taken may be incomplete.
+ */
+typedef struct FleetProvisioningBinaryLog
+{
+    uint32_t magic; /**< @brief #FP_BINARY_LOG_MAGIC. */
+    uint32_t size;  /**< @brief #FP_BINARY_LOG_SIZE. */
+    uint32_t next;  /**< @brief Number of records written. */
+    uint32_t reserved; /**< @brief Unused; aligns the records to 8 bytes. */
+    FleetProvisioningBinaryLogRecord_t records[ FP_BINARY_LOG_SIZE ]; /**< @brief Record @p next modulo #FP_BINARY_LOG_SIZE is written next. */
+} FleetProvisioningBinaryLog_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore these macros as they are private.
+ */
+
+#if ( FP_ENABLE_BINARY_LOG != 0 )
+    #define FP_BINARY_LOG( message, arg0, arg1, arg2, arg3, arg4, arg5 ) \
+    FleetProvisioning_BinaryLogWrite( ( message ),                       \
+                                      ( uint64_t ) ( arg0 ),             \
+                                      ( uint64_t ) ( arg1 ),             \
+                                      ( uint64_t ) ( arg2 ),             \
+                                      ( uint64_t ) ( arg3 ),             \
+                                      ( uint64_t ) ( arg4 ),             \
+                                      ( uint64_t ) ( arg5 ) )
+    #define FP_BINARY_LOG_POINTER( pointer )    ( ( uintptr_t ) ( const void * ) ( pointer ) )
+#else
+    #define FP_BINARY_LOG( message, arg0, arg1, arg2, arg3, arg4, arg5 )
+#endif
+
+/** @endcond */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a binary log.
+ *
+ * @param[out] pLog The log to initialize.
+ *
+ * @return #FleetProvisioningSuccess if the log was initialized;
+ * #FleetProvisioningBadParameter if @p pLog is NULL.
+ */
+/* @[declare_fleet_provisioning_binaryloginit] */
+FleetProvisioningStatus_t FleetProvisioning_BinaryLogInit( FleetProvisioningBinaryLog_t * pLog );
+/* @[declare_fleet_provisioning_binaryloginit] */
+
+/**
+ * @brief Copy a binary log, to dump it while other threads write to it.
+ *
+ * Each record is copied between two reads of its sequence. A record written
+ * while it is copied is given a sequence of 0 in the copy, so that decoders
+ * skip it rather than show the arguments of two messages. This relies on
+ * #FP_ATOMIC_LOAD_ACQUIRE, #FP_ATOMIC_STORE_RELEASE and
+ * #FP_ATOMIC_THREAD_FENCE being defined for the target.
+ *
+ * @param[in] pLog The log, initialized with #FleetProvisioning_BinaryLogInit.
+ * @param[out] pCopy The copy.
+ *
+ * @return #FleetProvisioningSuccess if the log was copied;
+ * #FleetProvisioningBadParameter if @p pLog or @p pCopy is NULL, or they
+ * are the same log.
+ */
+/* @[declare_fleet_provisioning_binarylogcopy] */
+FleetProvisioningStatus_t FleetProvisioning_BinaryLogCopy( const FleetProvisioningBinaryLog_t * pLog,
+                                                           FleetProvisioningBinaryLog_t * pCopy );
+/* @[declare_fleet_provisioning_binarylogcopy] */
+
+#if ( FP_ENABLE_BINARY_LOG != 0 )
+
+/**
+ * @brief Set the binary log the library writes to.
+ *
+ * Logging stops when NULL is set. The log should be set before other threads
+ * call the library, or with an atomic store on targets where pointer stores
+ * are not atomic.
+ *
+ * @param[in] pLog The log, initialized with #FleetProvisioning_BinaryLogInit,
+ * or NULL.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to keep a binary log of the errors of
+ * // the library, for example in memory kept across resets.
+ *
+ * static FleetProvisioningBinaryLog_t log;
+ *
+ * ( void ) FleetProvisioning_BinaryLogInit( &log );
+ * FleetProvisioning_BinaryLogSet( &log );
+ *
+ * // Later, copy the log, dump the sizeof( copy ) bytes at &copy to a file,
+ * // and decode it on a host with fleet_provisioning_binary_log_decode.
+ * static FleetProvisioningBinaryLog_t copy;
+ *
+ * ( void ) FleetProvisioning_BinaryLogCopy( &log, &copy );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_binarylogset] */
+    void FleetProvisioning_BinaryLogSet( FleetProvisioningBinaryLog_t * pLog );
+/* @[declare_fleet_provisioning_binarylogset] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a record to the binary log. Called by the library.
+ *
+ * @param[in] message The message.
+ * @param[in] arg0 The first argument of the message.
+ * @param[in] arg1 The second argument of the message.
+ * @param[in] arg2 The third argument of the message.
+ * @param[in] arg3 The fourth argument of the message.
+ * @param[in] arg4 The fifth argument of the message.
+ * @param[in] arg5 The sixth argument of the message.
+ */
+/* @[declare_fleet_provisioning_binarylogwrite] */
+    void FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMessage_t message,
+                                           uint64_t arg0,
+                                           uint64_t arg1,
+                                           uint64_t arg2,
+                                           uint64_t arg3,
+                                           uint64_t arg4,
+                                           uint64_t arg5 );
+/* @[declare_fleet_provisioning_binarylogwrite] */
+
+#endif /* if ( FP_ENABLE_BINARY_LOG != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_BINARY_LOG_H_ */
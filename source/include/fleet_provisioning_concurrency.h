@@ -0,0 +1,185 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_concurrency.h
+ * @brief Interface for the adaptive concurrency limit of AWS IoT Fleet
+ * Provisioning sessions.
+ */
+
+#ifndef FLEET_PROVISIONING_CONCURRENCY_H_
+#define FLEET_PROVISIONING_CONCURRENCY_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Largest limit of a concurrency controller, so that cutting it by a
+ * percentage cannot overflow.
+ */
+#define FP_CONCURRENCY_MAX_LIMIT    ( UINT32_MAX / 100U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief The settings of a concurrency controller.
+ */
+typedef struct FleetProvisioningConcurrencyConfig
+{
+    uint32_t minLimit;        /**< @brief Smallest limit, at least 1. */
+    uint32_t initialLimit;    /**< @brief First limit, from @p minLimit to @p maxLimit. */
+    uint32_t maxLimit;        /**< @brief Largest limit, at most #FP_CONCURRENCY_MAX_LIMIT. */
+    uint32_t decreasePercent; /**< @brief Share of the limit cut on throttling, from 1 to 99. */
+} FleetProvisioningConcurrencyConfig_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief An additive-increase, multiplicative-decrease (AIMD) controller of
+ * the number of sessions in flight.
+ *
+ * The limit grows by one for each limit's worth of accepted responses, and
+ * is cut by @p decreasePercent when a rejected response reports throttling.
+ * After a cut, the throttled responses to requests sent under the old limit
+ * are not counted again.
+ *
+ * Initialized by #FleetProvisioning_ConcurrencyInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningConcurrency
+{
+    uint32_t limit;           /**< @brief Current number of sessions allowed in flight. */
+    uint32_t minLimit;        /**< @brief Smallest limit. */
+    uint32_t maxLimit;        /**< @brief Largest limit. */
+    uint32_t decreasePercent; /**< @brief Share of the limit cut on throttling. */
+    uint32_t inFlight;        /**< @brief Number of sessions in flight. */
+    uint32_t acceptedCount;   /**< @brief Accepted responses since the limit last changed. */
+    uint32_t holdoff;         /**< @brief Responses left before throttling cuts the limit again. */
+} FleetProvisioningConcurrency_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a concurrency controller with no sessions in flight.
+ *
+ * @param[out] pController The controller to initialize.
+ * @param[in] pConfig The settings of the controller.
+ *
+ * @return FleetProvisioningSuccess if the controller is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to start with 4 sessions in flight,
+ * // probe up to 64, and halve the limit when the service throttles.
+ *
+ * static const FleetProvisioningConcurrencyConfig_t config = { 1U, 4U, 64U, 50U };
+ * FleetProvisioningConcurrency_t controller;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_ConcurrencyInit( &controller, &config );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_concurrencyinit] */
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyInit( FleetProvisioningConcurrency_t * pController,
+                                                             const FleetProvisioningConcurrencyConfig_t * pConfig );
+/* @[declare_fleet_provisioning_concurrencyinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start a session, if the limit allows one more in flight.
+ *
+ * @param[in] pController The controller.
+ *
+ * @return FleetProvisioningSuccess if the session may start;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the limit is reached.
+ */
+/* @[declare_fleet_provisioning_concurrencytrystart] */
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyTryStart( FleetProvisioningConcurrency_t * pController );
+/* @[declare_fleet_provisioning_concurrencytrystart] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Finish a session started by #FleetProvisioning_ConcurrencyTryStart.
+ *
+ * @param[in] pController The controller.
+ *
+ * @return FleetProvisioningSuccess if the session is finished;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_concurrencyfinish] */
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyFinish( FleetProvisioningConcurrency_t * pController );
+/* @[declare_fleet_provisioning_concurrencyfinish] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Adjust the limit for a response.
+ *
+ * Accepted responses raise the limit. Rejected responses whose
+ * #FP_API_STATUS_CODE_KEY is 429 (throttling) or 503 (service unavailable)
+ * cut it; other rejections leave it as is.
+ *
+ * @param[in] pController The controller.
+ * @param[in] topic The topic of the response, as matched by
+ * #FleetProvisioning_MatchTopic.
+ * @param[in] pPayload The payload of the response. Only read for rejected
+ * responses.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return FleetProvisioningSuccess if the response is counted;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the topic is not a response topic.
+ */
+/* @[declare_fleet_provisioning_concurrencyonresponse] */
+FleetProvisioningStatus_t FleetProvisioning_ConcurrencyOnResponse( FleetProvisioningConcurrency_t * pController,
+                                                                   FleetProvisioningTopic_t topic,
+                                                                   const char * pPayload,
+                                                                   size_t payloadLength );
+/* @[declare_fleet_provisioning_concurrencyonresponse] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_CONCURRENCY_H_ */
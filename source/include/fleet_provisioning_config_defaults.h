@@ -132,4 +132,419 @@
     #define LogDebug( message )
 #endif
 
+/**
+ * @brief The maximum number of device configuration entries indexed when
+ * parsing a RegisterThing accepted response.
+ *
+ * The device configuration is defined by the provisioning template, so this
+ * should be set to at least the number of entries in the template used by the
+ * application. Each entry adds 22 bytes to
+ * #FleetProvisioningRegisterThingResponse_t.
+ *
+ * <b>Possible values:</b> Any positive integer up to 127. <br>
+ * <b>Default value:</b> `16`
+ */
+#ifndef FP_DEVICE_CONFIG_MAX_ENTRIES
+    #define FP_DEVICE_CONFIG_MAX_ENTRIES    ( 16U )
+#endif
+
+/**
+ * @brief Set to 1 to use SIMD instructions for base64 coding of PEM data.
+ *
+ * When enabled, PEM data is decoded 16 characters at a time with SSSE3 on x86
+ * targets, or 64 characters at a time with NEON on Arm targets, and encoded
+ * in blocks of the same size. The compiler must be configured for the
+ * instruction set (for example with `-mssse3`), as the library does not
+ * detect CPU features at run time. On other targets, or when disabled, the
+ * portable implementation is used.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef FP_ENABLE_SIMD_BASE64
+    #define FP_ENABLE_SIMD_BASE64    ( 0 )
+#endif
+
+/**
+ * @brief The maximum number of variable slots in a RegisterThing payload
+ * template.
+ *
+ * Each slot adds 8 bytes to
+ * #FleetProvisioningRegisterThingTemplate_t.
+ *
+ * <b>Possible values:</b> Any positive integer. <br>
+ * <b>Default value:</b> `8`
+ */
+#ifndef FP_TEMPLATE_MAX_SLOTS
+    #define FP_TEMPLATE_MAX_SLOTS    ( 8U )
+#endif
+
+/**
+ * @brief The largest certificate ownership token a pooled session can
+ * register.
+ *
+ * Together with #FP_SESSION_MAX_CSR_LENGTH and
+ * #FP_SESSION_MAX_PARAMETERS_LENGTH, this sets the length of the payload
+ * buffer of each session in a #FleetProvisioningSessionPool_t. A session
+ * that receives a longer token fails.
+ *
+ * <b>Possible values:</b> Any positive integer. <br>
+ * <b>Default value:</b> `1024`
+ */
+#ifndef FP_SESSION_MAX_TOKEN_LENGTH
+    #define FP_SESSION_MAX_TOKEN_LENGTH    ( 1024U )
+#endif
+
+/**
+ * @brief The largest DER certificate signing request a pooled session can
+ * send.
+ *
+ * <b>Possible values:</b> Any positive integer. <br>
+ * <b>Default value:</b> `1024`
+ */
+#ifndef FP_SESSION_MAX_CSR_LENGTH
+    #define FP_SESSION_MAX_CSR_LENGTH    ( 1024U )
+#endif
+
+/**
+ * @brief The largest RegisterThing parameters a pooled session can send,
+ * as the total length of the parameter names and values plus 6 bytes for
+ * each parameter.
+ *
+ * <b>Possible values:</b> Any positive integer. <br>
+ * <b>Default value:</b> `256`
+ */
+#ifndef FP_SESSION_MAX_PARAMETERS_LENGTH
+    #define FP_SESSION_MAX_PARAMETERS_LENGTH    ( 256U )
+#endif
+
+/**
+ * @brief The number of levels of a provisioning timer wheel.
+ *
+ * Each level has 64 slots and multiplies the range of delays the wheel holds
+ * without re-queuing by 64: with the default 4 levels, delays up to 2^24
+ * ticks, about 46 hours with 10 ms ticks. Longer delays still work, but are
+ * moved back to the top level each time they reach its slot. Each level adds
+ * 256 bytes to #FleetProvisioningTimerWheel_t.
+ *
+ * <b>Possible values:</b> Any integer from 1 to 5. <br>
+ * <b>Default value:</b> `4`
+ */
+#ifndef FP_TIMER_WHEEL_LEVELS
+    #define FP_TIMER_WHEEL_LEVELS    ( 4U )
+#endif
+
+/**
+ * @brief The most RegisterThing requests a session pool sends in a row while
+ * a new provisioning flow waits to start.
+ *
+ * Deferred RegisterThing requests go out before the first request of new
+ * flows, so that sessions already holding a certificate finish first. After
+ * this many of them, one new flow is let through, so that new flows are not
+ * starved under sustained load.
+ *
+ * <b>Possible values:</b> Any positive integer. <br>
+ * <b>Default value:</b> `8`
+ */
+#ifndef FP_SESSION_POOL_STARVATION_LIMIT
+    #define FP_SESSION_POOL_STARVATION_LIMIT    ( 8U )
+#endif
+
+/**
+ * @brief The number of requests a response correlator can track at once,
+ * over all APIs.
+ *
+ * Each pending request takes 12 bytes on 32-bit targets, and 16 bytes on
+ * 64-bit targets, in #FleetProvisioningCorrelator_t.
+ *
+ * <b>Possible values:</b> Any integer from 1 to 65534. <br>
+ * <b>Default value:</b> `32`
+ */
+#ifndef FP_CORRELATOR_MAX_PENDING
+    #define FP_CORRELATOR_MAX_PENDING    ( 32U )
+#endif
+
+/**
+ * @brief The number of recent accepted responses a deduplication window
+ * remembers.
+ *
+ * Accepted responses delivered again by the broker after a reconnect are
+ * dropped if they are among this many most recent accepted responses. Each
+ * response takes 8 bytes in #FleetProvisioningDedupWindow_t.
+ *
+ * <b>Possible values:</b> Any integer from 1 to 65535. <br>
+ * <b>Default value:</b> `16`
+ */
+#ifndef FP_DEDUP_WINDOW_SIZE
+    #define FP_DEDUP_WINDOW_SIZE    ( 16U )
+#endif
+
+/**
+ * @brief The number of bits of a value kept by the buckets of a latency
+ * histogram, after its leading one.
+ *
+ * A #FleetProvisioningHistogram_t splits each power of two into
+ * 2^FP_HISTOGRAM_SUB_BUCKET_BITS buckets, so a value is recorded with a
+ * relative error below 2^-FP_HISTOGRAM_SUB_BUCKET_BITS. Each histogram takes
+ * ( 33 - FP_HISTOGRAM_SUB_BUCKET_BITS ) * 2^FP_HISTOGRAM_SUB_BUCKET_BITS * 4
+ * + 8 bytes, 504 bytes by default.
+ *
+ * <b>Possible values:</b> Any integer from 0 to 8. <br>
+ * <b>Default value:</b> `2`
+ */
+#ifndef FP_HISTOGRAM_SUB_BUCKET_BITS
+    #define FP_HISTOGRAM_SUB_BUCKET_BITS    ( 2U )
+#endif
+
+/**
+ * @brief How far through the validity period of a certificate its rotation
+ * window starts, in percent.
+ *
+ * See #FleetProvisioning_GetRotationTime.
+ *
+ * <b>Possible values:</b> Any integer below
+ * #FP_ROTATION_WINDOW_END_PERCENT. <br>
+ * <b>Default value:</b> `50`
+ */
+#ifndef FP_ROTATION_WINDOW_START_PERCENT
+    #define FP_ROTATION_WINDOW_START_PERCENT    ( 50U )
+#endif
+
+/**
+ * @brief How far through the validity period of a certificate its rotation
+ * window ends, in percent.
+ *
+ * The rest of the validity period leaves time to retry a failed rotation
+ * before the certificate expires.
+ *
+ * <b>Possible values:</b> Any integer above
+ * #FP_ROTATION_WINDOW_START_PERCENT, up to 100. <br>
+ * <b>Default value:</b> `80`
+ */
+#ifndef FP_ROTATION_WINDOW_END_PERCENT
+    #define FP_ROTATION_WINDOW_END_PERCENT    ( 80U )
+#endif
+
+/**
+ * @brief Load a 32-bit value of a shard queue or a binary log with acquire
+ * ordering.
+ *
+ * The positions and slot sequence numbers of shard queues, and the sequence
+ * numbers of binary log records, are shared between threads. They are
+ * accessed through this macro, #FP_ATOMIC_STORE_RELEASE and
+ * #FP_ATOMIC_COMPARE_AND_SWAP, so that they can be mapped to the atomic
+ * operations of the target. For example, with the GCC builtins:
+ * @code{c}
+ * #define FP_ATOMIC_LOAD_ACQUIRE( pValue )    __atomic_load_n( ( pValue ), __ATOMIC_ACQUIRE )
+ * #define FP_ATOMIC_STORE_RELEASE( pValue, value )    __atomic_store_n( ( pValue ), ( value ), __ATOMIC_RELEASE )
+ * #define FP_ATOMIC_COMPARE_AND_SWAP( pValue, expected, desired )    __sync_bool_compare_and_swap( ( pValue ), ( expected ), ( desired ) )
+ * @endcode
+ *
+ * <b>Default value</b>: A plain read, which is only correct when a shard
+ * queue or a binary log is used by a single thread.
+ */
+#ifndef FP_ATOMIC_LOAD_ACQUIRE
+    #define FP_ATOMIC_LOAD_ACQUIRE( pValue )    ( *( pValue ) )
+#endif
+
+/**
+ * @brief Store a 32-bit value of a shard queue or a binary log with release
+ * ordering.
+ *
+ * See #FP_ATOMIC_LOAD_ACQUIRE.
+ *
+ * <b>Default value</b>: A plain write, which is only correct when a shard
+ * queue or a binary log is used by a single thread.
+ */
+#ifndef FP_ATOMIC_STORE_RELEASE
+    #define FP_ATOMIC_STORE_RELEASE( pValue, value )    ( *( pValue ) = ( value ) )
+#endif
+
+/**
+ * @brief Atomically replace a 32-bit value of a shard queue if it equals an
+ * expected value. Evaluates to nonzero if the value was replaced, and zero
+ * otherwise.
+ *
+ * See #FP_ATOMIC_LOAD_ACQUIRE.
+ *
+ * <b>Default value</b>: A plain compare and write, defined in
+ * fleet_provisioning_shard.c, which is only correct when a shard queue is
+ * used by a single thread.
+ */
+#ifdef DOXYGEN
+    #define FP_ATOMIC_COMPARE_AND_SWAP( pValue, expected, desired )
+#endif
+
+/**
+ * @brief Set to 1 to count the calls of the public functions of the library,
+ * by returned status, in a #FleetProvisioningPerfCounters_t set with
+ * #FleetProvisioning_PerfSetCounters.
+ *
+ * When disabled, the counting code is not compiled.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef FP_ENABLE_PERF_COUNTERS
+    #define FP_ENABLE_PERF_COUNTERS    ( 0 )
+#endif
+
+/**
+ * @brief Set to 1 to also count the calls of the public functions by the
+ * log2 of the cycles they took, as read by #FP_PERF_READ_CYCLES.
+ *
+ * Only used when #FP_ENABLE_PERF_COUNTERS is 1. Adds 128 bytes per function
+ * to #FleetProvisioningPerfCounters_t.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef FP_ENABLE_PERF_HISTOGRAMS
+    #define FP_ENABLE_PERF_HISTOGRAMS    ( 0 )
+#endif
+
+/**
+ * @brief Read a free running 32-bit cycle counter, for
+ * #FP_ENABLE_PERF_HISTOGRAMS.
+ *
+ * For example, on a Cortex-M target with a DWT unit:
+ *
+ * @code{c}
+ * #define FP_PERF_READ_CYCLES()    ( DWT->CYCCNT )
+ * @endcode
+ *
+ * <b>Default value</b>: `0`, which counts every call in the first bucket.
+ */
+#ifndef FP_PERF_READ_CYCLES
+    #define FP_PERF_READ_CYCLES()    ( 0U )
+#endif
+
+/**
+ * @brief Add to a 32-bit performance counter, for #FP_ENABLE_PERF_COUNTERS,
+ * or to a 32-bit or 64-bit counter of a #FleetProvisioningHistogram_t.
+ *
+ * No ordering is needed, so when the library is called from several threads
+ * this can be a relaxed atomic add. With GCC or Clang:
+ *
+ * @code{c}
+ * #define FP_ATOMIC_ADD_RELAXED( pValue, value ) \
+ *     ( ( void ) __atomic_fetch_add( ( pValue ), ( value ), __ATOMIC_RELAXED ) )
+ * @endcode
+ *
+ * <b>Default value</b>: A plain add, which may lose counts when the library
+ * is called from several threads.
+ */
+#ifndef FP_ATOMIC_ADD_RELAXED
+    #define FP_ATOMIC_ADD_RELAXED( pValue, value )    ( *( pValue ) += ( value ) )
+#endif
+
+/**
+ * @brief Set to 1 to record errors on the hot paths of the library in a
+ * binary log (fleet_provisioning_binary_log.h) set with
+ * #FleetProvisioning_BinaryLogSet.
+ *
+ * A binary log record holds a message identifier and the raw arguments of
+ * the message, and is written without formatting or locks. The records are
+ * rendered to text offline. This is independent of #LogError, which can be
+ * left empty in production while the binary log is enabled.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef FP_ENABLE_BINARY_LOG
+    #define FP_ENABLE_BINARY_LOG    ( 0 )
+#endif
+
+/**
+ * @brief The number of records a binary log holds.
+ *
+ * When the log is full, the oldest record is overwritten. Each record takes
+ * 56 bytes in #FleetProvisioningBinaryLog_t.
+ *
+ * <b>Possible values:</b> Any power of two from 1 to 65536. <br>
+ * <b>Default value:</b> `32`
+ */
+#ifndef FP_BINARY_LOG_SIZE
+    #define FP_BINARY_LOG_SIZE    ( 32U )
+#endif
+
+/**
+ * @brief Atomically add to a 32-bit value, and evaluate to the value before
+ * the addition, for #FP_ENABLE_BINARY_LOG.
+ *
+ * No ordering is needed. With GCC or Clang:
+ *
+ * @code{c}
+ * #define FP_ATOMIC_FETCH_ADD( pValue, value ) \
+ *     __atomic_fetch_add( ( pValue ), ( value ), __ATOMIC_RELAXED )
+ * @endcode
+ *
+ * <b>Default value</b>: A plain add, which is only correct when the library
+ * is called from a single thread.
+ */
+#ifndef FP_ATOMIC_FETCH_ADD
+    #define FP_ATOMIC_FETCH_ADD( pValue, value )    ( ( *( pValue ) += ( value ) ) - ( value ) )
+#endif
+
+/**
+ * @brief A fence ordering the loads and stores before it with the loads and
+ * stores after it, for #FP_ENABLE_BINARY_LOG.
+ *
+ * A binary log record is written, and read by
+ * #FleetProvisioning_BinaryLogCopy, as a sequence lock: the fence keeps its
+ * arguments between the stores, or the loads, of its sequence. With GCC or
+ * Clang:
+ *
+ * @code{c}
+ * #define FP_ATOMIC_THREAD_FENCE()    __atomic_thread_fence( __ATOMIC_ACQ_REL )
+ * @endcode
+ *
+ * <b>Default value</b>: Nothing, which is only correct when the log is
+ * written and copied by a single thread.
+ */
+#ifndef FP_ATOMIC_THREAD_FENCE
+    #define FP_ATOMIC_THREAD_FENCE()    ( ( void ) 0 )
+#endif
+
+/**
+ * @brief Set to 1 to compile USDT probes, which tracers such as bpftrace,
+ * perf and SystemTap can attach to, into the topic functions on Linux.
+ *
+ * The probes are at the entry and return of #FleetProvisioning_MatchTopic
+ * and #FleetProvisioning_GetRegisterThingTopic, and at each of their results.
+ * A probe that no tracer is attached to costs a `nop` instruction. The
+ * `<sys/sdt.h>` header, from the SystemTap SDT development package, must be
+ * available. Ignored if #FP_TRACE_PROBE is defined.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef FP_ENABLE_USDT_PROBES
+    #define FP_ENABLE_USDT_PROBES    ( 0 )
+#endif
+
+/**
+ * @brief Fire a static probe of the Fleet Provisioning library.
+ *
+ * @p name is the probe name, and @p arg0 and @p arg1 are integer or pointer
+ * arguments, 0 when unused. This can be defined to map the probes to another
+ * tracer. For example, to an LTTng tracepoint provider:
+ *
+ * @code{c}
+ * #define FP_TRACE_PROBE( name, arg0, arg1 ) \
+ *     tracepoint( fleet_provisioning, name, ( uint64_t ) ( uintptr_t ) ( arg0 ), ( uint64_t ) ( uintptr_t ) ( arg1 ) )
+ * @endcode
+ *
+ * <b>Default value</b>: A USDT probe of the `fleet_provisioning` provider
+ * when #FP_ENABLE_USDT_PROBES is 1; nothing otherwise.
+ */
+#ifndef FP_TRACE_PROBE
+    #if ( FP_ENABLE_USDT_PROBES != 0 )
+        #include <sys/sdt.h>
+        #define FP_TRACE_PROBE( name, arg0, arg1 )    DTRACE_PROBE2( fleet_provisioning, name, arg0, arg1 )
+    #else
+        #define FP_TRACE_PROBE( name, arg0, arg1 )
+    #endif
+#endif
+
 #endif /* FLEET_PROVISIONING_CONFIG_DEFAULTS_H_ */
@@ -0,0 +1,224 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_correlator.h
+ * @brief Interface for matching AWS IoT Fleet Provisioning responses to
+ * pending requests.
+ */
+
+#ifndef FLEET_PROVISIONING_CORRELATOR_H_
+#define FLEET_PROVISIONING_CORRELATOR_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of request queues of a correlator: one for each API in each
+ * payload format.
+ */
+#define FP_CORRELATOR_QUEUE_COUNT      ( 2U * FP_API_COUNT )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Index marking the end of a list of pending requests.
+ */
+#define FP_CORRELATOR_INVALID_INDEX    ( 0xFFFFU )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A request waiting for its response.
+ */
+typedef struct FleetProvisioningPendingRequest
+{
+    /**
+     * @brief For RegisterThing, the template name of the request. It is
+     * not copied.
+     */
+    const char * pTemplateName;
+    uint32_t tag;                /**< @brief Application value identifying the request, such as a session index. */
+    uint16_t templateNameLength; /**< @brief Length of the template name. */
+    uint16_t next;               /**< @brief Next request of the queue or of the free list. */
+} FleetProvisioningPendingRequest_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A response correlator.
+ *
+ * Fleet Provisioning responses carry no client token, but the service
+ * answers the requests of an API in order. The correlator keeps the pending
+ * requests of each API and payload format in a FIFO queue, and matches each
+ * response to the oldest pending request of its API; for RegisterThing, the
+ * oldest one for the template name in the topic.
+ *
+ * Initialized by #FleetProvisioning_CorrelatorInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningCorrelator
+{
+    FleetProvisioningPendingRequest_t requests[ FP_CORRELATOR_MAX_PENDING ]; /**< @brief Request entries. */
+    uint16_t heads[ FP_CORRELATOR_QUEUE_COUNT ];                             /**< @brief Oldest request of each queue. */
+    uint16_t tails[ FP_CORRELATOR_QUEUE_COUNT ];                             /**< @brief Newest request of each queue. */
+    uint16_t counts[ FP_CORRELATOR_QUEUE_COUNT ];                            /**< @brief Number of requests in each queue. */
+    uint16_t freeHead;                                                       /**< @brief First unused entry. */
+    uint16_t pipelineDepth;                                                  /**< @brief Most requests pending in each queue. */
+} FleetProvisioningCorrelator_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a correlator with no pending requests.
+ *
+ * @param[out] pCorrelator The correlator to initialize.
+ * @param[in] pipelineDepth The most requests of one API and format that may
+ * be pending at once, from 1 to #FP_CORRELATOR_MAX_PENDING.
+ *
+ * @return FleetProvisioningSuccess if the correlator is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_correlatorinit] */
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorInit( FleetProvisioningCorrelator_t * pCorrelator,
+                                                            uint16_t pipelineDepth );
+/* @[declare_fleet_provisioning_correlatorinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record a request as it is published.
+ *
+ * Requests must be recorded in the order they are published. The template
+ * name of a RegisterThing request is kept by reference, and must stay valid
+ * until the request is matched or cancelled.
+ *
+ * @param[in] pCorrelator The correlator.
+ * @param[in] request The publish topic of the request.
+ * @param[in] pTemplateName For RegisterThing, the template name of the
+ * request; ignored otherwise.
+ * @param[in] templateNameLength The length of @p pTemplateName.
+ * @param[in] tag Application value returned with the response.
+ *
+ * @return FleetProvisioningSuccess if the request is recorded;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the pipeline of the API is full, in which
+ * case the request should be published later;
+ * FleetProvisioningBufferTooSmall if #FP_CORRELATOR_MAX_PENDING requests
+ * are pending.
+ */
+/* @[declare_fleet_provisioning_correlatorpush] */
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorPush( FleetProvisioningCorrelator_t * pCorrelator,
+                                                            FleetProvisioningTopic_t request,
+                                                            const char * pTemplateName,
+                                                            uint16_t templateNameLength,
+                                                            uint32_t tag );
+/* @[declare_fleet_provisioning_correlatorpush] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Match a response to the oldest pending request of its API, and
+ * remove that request.
+ *
+ * @param[in] pCorrelator The correlator.
+ * @param[in] pTopic The topic of the response.
+ * @param[in] topicLength The length of @p pTopic.
+ * @param[out] pOutTopic The topic of the response, as matched by
+ * #FleetProvisioning_MatchTopic.
+ * @param[out] pOutTag The tag of the request.
+ *
+ * @return FleetProvisioningSuccess if the response is matched;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the topic is not a Fleet Provisioning response
+ * topic, or no request is pending for it.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to route an incoming message to the
+ * // pooled session whose request it answers.
+ *
+ * FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvisioningInvalidTopic, NULL, 0U };
+ * FleetProvisioningAction_t action;
+ * uint32_t index;
+ *
+ * if( FleetProvisioning_CorrelatorMatch( &correlator, pTopic, topicLength,
+ *                                        &event.topic, &index ) == FleetProvisioningSuccess )
+ * {
+ *      event.pPayload = pPayload;
+ *      event.payloadLength = payloadLength;
+ *      ( void ) FleetProvisioning_SessionPoolHandleEvent( &pool, index, &event, &action );
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_correlatormatch] */
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorMatch( FleetProvisioningCorrelator_t * pCorrelator,
+                                                             const char * pTopic,
+                                                             uint16_t topicLength,
+                                                             FleetProvisioningTopic_t * pOutTopic,
+                                                             uint32_t * pOutTag );
+/* @[declare_fleet_provisioning_correlatormatch] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Remove the pending requests with a tag, such as those of a session
+ * that timed out.
+ *
+ * A response to a removed request that still arrives is matched to the
+ * next pending request of its API, so requests should only be cancelled
+ * once their responses are not expected anymore.
+ *
+ * @param[in] pCorrelator The correlator.
+ * @param[in] tag The tag of the requests.
+ *
+ * @return FleetProvisioningSuccess if requests are removed;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if no request has the tag.
+ */
+/* @[declare_fleet_provisioning_correlatorcancel] */
+FleetProvisioningStatus_t FleetProvisioning_CorrelatorCancel( FleetProvisioningCorrelator_t * pCorrelator,
+                                                              uint32_t tag );
+/* @[declare_fleet_provisioning_correlatorcancel] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_CORRELATOR_H_ */
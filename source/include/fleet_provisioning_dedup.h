@@ -0,0 +1,154 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_dedup.h
+ * @brief Interface for dropping AWS IoT Fleet Provisioning responses that
+ * the broker delivers again.
+ */
+
+#ifndef FLEET_PROVISIONING_DEDUP_H_
+#define FLEET_PROVISIONING_DEDUP_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief An accepted response seen by a deduplication window.
+ */
+typedef struct FleetProvisioningDedupEntry
+{
+    uint32_t fingerprint;   /**< @brief Hash of the topic and payload. */
+    uint32_t payloadLength; /**< @brief Length of the payload. */
+} FleetProvisioningDedupEntry_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A window of the most recent accepted responses, used to drop
+ * accepted responses delivered again.
+ *
+ * At QoS 1, the broker may deliver a response again after a reconnect.
+ * Matched to a pending request, such a response would be taken as the
+ * response to another request, and parsing it again costs as much as the
+ * first time. The window remembers a fingerprint of the last
+ * #FP_DEDUP_WINDOW_SIZE accepted responses, so that repeated ones are
+ * dropped before they are parsed or correlated.
+ *
+ * Rejected responses are not deduplicated: they carry nothing of their
+ * request, so the rejections of two requests, such as two throttled ones,
+ * can be identical.
+ *
+ * Initialized by #FleetProvisioning_DedupInit. The members should not be
+ * modified by the application.
+ */
+typedef struct FleetProvisioningDedupWindow
+{
+    FleetProvisioningDedupEntry_t entries[ FP_DEDUP_WINDOW_SIZE ]; /**< @brief Recent responses. */
+    uint16_t count;                                                /**< @brief Number of entries in use. */
+    uint16_t next;                                                 /**< @brief Entry the next response replaces. */
+} FleetProvisioningDedupWindow_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize an empty deduplication window.
+ *
+ * @param[out] pWindow The window to initialize.
+ *
+ * @return FleetProvisioningSuccess if the window is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_dedupinit] */
+FleetProvisioningStatus_t FleetProvisioning_DedupInit( FleetProvisioningDedupWindow_t * pWindow );
+/* @[declare_fleet_provisioning_dedupinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check whether an accepted response was seen recently, and remember
+ * it if not.
+ *
+ * An accepted response is identified by its topic and a hash of its
+ * payload, which is cheaper to compute than parsing the payload. Its
+ * payload holds a certificate ID, an ownership token or a thing name that
+ * no other request gets, so two accepted responses can only be confused if
+ * both their lengths and 32-bit hashes are equal.
+ *
+ * Rejected responses are always new, and are not remembered, as the
+ * rejections of different requests can be identical.
+ *
+ * @param[in] pWindow The window.
+ * @param[in] topic The topic of the response, as matched by
+ * #FleetProvisioning_MatchTopic.
+ * @param[in] pPayload The payload of the response.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return FleetProvisioningSuccess if the response is new;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the response is a repeat of one of the last
+ * #FP_DEDUP_WINDOW_SIZE accepted responses, and should be dropped.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to drop repeated responses before
+ * // they are matched to a pending request.
+ *
+ * FleetProvisioningTopic_t topic;
+ *
+ * if( ( FleetProvisioning_MatchTopic( pTopic, topicLength, &topic ) == FleetProvisioningSuccess ) &&
+ *     ( FleetProvisioning_DedupCheck( &window, topic, pPayload,
+ *                                     payloadLength ) == FleetProvisioningSuccess ) )
+ * {
+ *      // Correlate and handle the response.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_dedupcheck] */
+FleetProvisioningStatus_t FleetProvisioning_DedupCheck( FleetProvisioningDedupWindow_t * pWindow,
+                                                        FleetProvisioningTopic_t topic,
+                                                        const char * pPayload,
+                                                        size_t payloadLength );
+/* @[declare_fleet_provisioning_dedupcheck] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_DEDUP_H_ */
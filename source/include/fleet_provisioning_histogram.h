@@ -0,0 +1,296 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file fleet_provisioning_histogram.h
+ * @brief Interface for the latency histograms of AWS IoT Fleet Provisioning
+ * requests.
+ */
+
+#ifndef FLEET_PROVISIONING_HISTOGRAM_H_
+#define FLEET_PROVISIONING_HISTOGRAM_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of buckets of a #FleetProvisioningHistogram_t.
+ *
+ * Values below 2^#FP_HISTOGRAM_SUB_BUCKET_BITS have a bucket each. Each
+ * higher power of two is split into 2^#FP_HISTOGRAM_SUB_BUCKET_BITS buckets
+ * of equal width.
+ */
+#define FP_HISTOGRAM_BUCKETS \
+    ( ( 33U - FP_HISTOGRAM_SUB_BUCKET_BITS ) * ( 1U << FP_HISTOGRAM_SUB_BUCKET_BITS ) )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of values of #FleetProvisioningTopic_t.
+ */
+#define FP_LATENCY_TOPIC_COUNT    ( 19U )
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A log-linear histogram of 32-bit values, such as latencies.
+ *
+ * The memory of a histogram is fixed, and a value is recorded with a
+ * relative error below 2^-#FP_HISTOGRAM_SUB_BUCKET_BITS, whatever its
+ * magnitude. Values are recorded with #FP_ATOMIC_ADD_RELAXED, so that
+ * several threads can record in the same histogram; threads can also record
+ * in histograms of their own, merged with #FleetProvisioning_HistogramMerge
+ * when exported.
+ *
+ * A histogram is initialized by setting it to zero. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningHistogram
+{
+    uint64_t sum;                             /**< @brief Sum of the recorded values. */
+    uint32_t counts[ FP_HISTOGRAM_BUCKETS ]; /**< @brief Number of values recorded in each bucket. */
+} FleetProvisioningHistogram_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Latency histograms of the requests of a session pool, set with
+ * #FleetProvisioning_SessionPoolSetLatency.
+ *
+ * The histograms are indexed by the #FleetProvisioningTopic_t of the
+ * response, so each phase of provisioning has its own: the CreateKeys or
+ * CreateCertificateFromCsr request, and the RegisterThing request, each
+ * accepted or rejected, in JSON or CBOR. The histograms of the request
+ * topics are not used by the session pool.
+ *
+ * Initialized by #FleetProvisioning_LatencyInit. The members should not be
+ * modified by the application.
+ */
+typedef struct FleetProvisioningLatency
+{
+    /**
+     * @brief Ticks from the publish of each request to its response, in the
+     * ticks passed to #FleetProvisioning_SessionPoolTick.
+     */
+    FleetProvisioningHistogram_t responseTicks[ FP_LATENCY_TOPIC_COUNT ];
+
+    /**
+     * @brief Cycles taken to handle each response, as read by
+     * #FP_PERF_READ_CYCLES. For an accepted CreateKeys or
+     * CreateCertificateFromCsr response, this is the time taken to parse the
+     * certificate and build the RegisterThing request.
+     */
+    FleetProvisioningHistogram_t handleCycles[ FP_LATENCY_TOPIC_COUNT ];
+} FleetProvisioningLatency_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record a value in a histogram.
+ *
+ * @param[in] pHistogram The histogram.
+ * @param[in] value The value.
+ *
+ * @return FleetProvisioningSuccess if the value is recorded;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_histogramrecord] */
+FleetProvisioningStatus_t FleetProvisioning_HistogramRecord( FleetProvisioningHistogram_t * pHistogram,
+                                                             uint32_t value );
+/* @[declare_fleet_provisioning_histogramrecord] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the values of a histogram to another.
+ *
+ * @param[in] pDestination The histogram the values are added to.
+ * @param[in] pSource The histogram the values are taken from. It is not
+ * changed.
+ *
+ * @return FleetProvisioningSuccess if the histograms are merged;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_histogrammerge] */
+FleetProvisioningStatus_t FleetProvisioning_HistogramMerge( FleetProvisioningHistogram_t * pDestination,
+                                                            const FleetProvisioningHistogram_t * pSource );
+/* @[declare_fleet_provisioning_histogrammerge] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a histogram in the Prometheus text exposition format.
+ *
+ * The `_bucket`, `_sum` and `_count` samples of the histogram are written,
+ * without the `# HELP` and `# TYPE` lines, so that histograms with different
+ * labels can be written one after the other under the same metric name. The
+ * `le` label of a bucket is the highest value it counts. Only the buckets
+ * holding values are written, along with the `+Inf` bucket; as the counts
+ * only grow, a bucket written once is written in every later export.
+ *
+ * @param[in] pHistogram The histogram.
+ * @param[in] pName The metric name.
+ * @param[in] nameLength The length of @p pName.
+ * @param[in] pLabels The labels of the histogram, such as
+ * `template="Gateway"`, or NULL for none.
+ * @param[in] labelsLength The length of @p pLabels.
+ * @param[out] pBuffer The buffer to write to.
+ * @param[in] bufferLength The length of @p pBuffer.
+ * @param[out] pOutLength The length written.
+ *
+ * @return FleetProvisioningSuccess if the histogram is written;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the buffer cannot hold the histogram.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to export the end-to-end provisioning
+ * // time of the devices of each template, recorded by the application.
+ *
+ * #define METRIC    "fleet_provisioning_seconds"
+ * #define LABELS    "template=\"Gateway\""
+ *
+ * static FleetProvisioningHistogram_t gatewaySeconds;
+ * char buffer[ 4096 ];
+ * size_t length;
+ * FleetProvisioningStatus_t status;
+ *
+ * ( void ) FleetProvisioning_HistogramRecord( &gatewaySeconds, doneTime - startTime );
+ *
+ * // Later, when scraped:
+ * status = FleetProvisioning_HistogramExportPrometheus( &gatewaySeconds,
+ *                                                       METRIC, sizeof( METRIC ) - 1U,
+ *                                                       LABELS, sizeof( LABELS ) - 1U,
+ *                                                       buffer, sizeof( buffer ),
+ *                                                       &length );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_histogramexportprometheus] */
+FleetProvisioningStatus_t FleetProvisioning_HistogramExportPrometheus( const FleetProvisioningHistogram_t * pHistogram,
+                                                                       const char * pName,
+                                                                       size_t nameLength,
+                                                                       const char * pLabels,
+                                                                       size_t labelsLength,
+                                                                       char * pBuffer,
+                                                                       size_t bufferLength,
+                                                                       size_t * pOutLength );
+/* @[declare_fleet_provisioning_histogramexportprometheus] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize empty latency histograms.
+ *
+ * @param[out] pLatency The histograms to initialize.
+ *
+ * @return FleetProvisioningSuccess if the histograms are initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_latencyinit] */
+FleetProvisioningStatus_t FleetProvisioning_LatencyInit( FleetProvisioningLatency_t * pLatency );
+/* @[declare_fleet_provisioning_latencyinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the values of latency histograms to others, for example those
+ * of the session pools of several threads.
+ *
+ * @param[in] pDestination The histograms the values are added to.
+ * @param[in] pSource The histograms the values are taken from. They are not
+ * changed.
+ *
+ * @return FleetProvisioningSuccess if the histograms are merged;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_latencymerge] */
+FleetProvisioningStatus_t FleetProvisioning_LatencyMerge( FleetProvisioningLatency_t * pDestination,
+                                                          const FleetProvisioningLatency_t * pSource );
+/* @[declare_fleet_provisioning_latencymerge] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write latency histograms in the Prometheus text exposition format.
+ *
+ * Two histogram metrics are written, `fleet_provisioning_response_ticks` and
+ * `fleet_provisioning_handle_cycles`, with a `format`, `api` and `response`
+ * label for each response topic. Topics without values are left out.
+ *
+ * @param[in] pLatency The histograms.
+ * @param[out] pBuffer The buffer to write to.
+ * @param[in] bufferLength The length of @p pBuffer.
+ * @param[out] pOutLength The length written.
+ *
+ * @return FleetProvisioningSuccess if the histograms are written;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the buffer cannot hold the histograms.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to export the latencies of the
+ * // session pools of two threads.
+ *
+ * static FleetProvisioningLatency_t latency[ 2 ];
+ * static FleetProvisioningLatency_t total;
+ * static char buffer[ 16384 ];
+ * size_t length;
+ * FleetProvisioningStatus_t status;
+ *
+ * ( void ) FleetProvisioning_SessionPoolSetLatency( &pool[ 0 ], &latency[ 0 ] );
+ * ( void ) FleetProvisioning_SessionPoolSetLatency( &pool[ 1 ], &latency[ 1 ] );
+ *
+ * // Later, when scraped:
+ * ( void ) FleetProvisioning_LatencyInit( &total );
+ * ( void ) FleetProvisioning_LatencyMerge( &total, &latency[ 0 ] );
+ * ( void ) FleetProvisioning_LatencyMerge( &total, &latency[ 1 ] );
+ * status = FleetProvisioning_LatencyExportPrometheus( &total, buffer,
+ *                                                     sizeof( buffer ), &length );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_latencyexportprometheus] */
+FleetProvisioningStatus_t FleetProvisioning_LatencyExportPrometheus( const FleetProvisioningLatency_t * pLatency,
+                                                                     char * pBuffer,
+                                                                     size_t bufferLength,
+                                                                     size_t * pOutLength );
+/* @[declare_fleet_provisioning_latencyexportprometheus] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_HISTOGRAM_H_ */
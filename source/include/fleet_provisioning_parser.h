@@ -0,0 +1,295 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_parser.h
+ * @brief Interface for parsing AWS IoT Fleet Provisioning response payloads.
+ */
+
+#ifndef FLEET_PROVISIONING_PARSER_H_
+#define FLEET_PROVISIONING_PARSER_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of hash slots in the device configuration index.
+ *
+ * Twice the number of entries, so that the load factor of the open addressing
+ * table never exceeds one half.
+ */
+#define FP_DEVICE_CONFIG_INDEX_SLOTS    ( 2U * FP_DEVICE_CONFIG_MAX_ENTRIES )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A read-only view of a region of a payload buffer.
+ */
+typedef struct FleetProvisioningSpan
+{
+    const char * pData; /**< @brief Start of the region. */
+    size_t length;      /**< @brief Length of the region in bytes. */
+} FleetProvisioningSpan_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief An entry in the device configuration index.
+ *
+ * Offsets are relative to the start of the parsed payload.
+ */
+typedef struct FleetProvisioningDeviceConfigEntry
+{
+    uint32_t keyHash;     /**< @brief FNV-1a hash of the key bytes. */
+    uint32_t keyOffset;   /**< @brief Offset of the key bytes. */
+    uint32_t valueOffset; /**< @brief Offset of the value bytes. */
+    uint32_t valueLength; /**< @brief Length of the value bytes. */
+    uint16_t keyLength;   /**< @brief Length of the key bytes. */
+} FleetProvisioningDeviceConfigEntry_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Parsed RegisterThing accepted response.
+ *
+ * All spans point into the payload passed to
+ * #FleetProvisioning_ParseRegisterThingAccepted, which must therefore outlive
+ * this structure. The members are private to the parser and should only be
+ * accessed through #FleetProvisioning_GetDeviceConfigValue and
+ * #FleetProvisioning_GetDeviceConfigEntry, except for @p thingName.
+ */
+typedef struct FleetProvisioningRegisterThingResponse
+{
+    FleetProvisioningSpan_t thingName; /**< @brief Name of the created thing. */
+
+    /**
+     * @brief Payload the index refers to.
+     */
+    const char * pPayload;
+
+    /**
+     * @brief Number of entries in the device configuration.
+     */
+    uint16_t entryCount;
+
+    /**
+     * @brief Device configuration entries in payload order.
+     */
+    FleetProvisioningDeviceConfigEntry_t entries[ FP_DEVICE_CONFIG_MAX_ENTRIES ];
+
+    /**
+     * @brief Hash slots holding one plus the index of an entry, or zero if the
+     * slot is free.
+     */
+    uint8_t slots[ FP_DEVICE_CONFIG_INDEX_SLOTS ];
+} FleetProvisioningRegisterThingResponse_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Parse a RegisterThing accepted response payload.
+ *
+ * Extracts the thing name and builds an index over the members of the
+ * device configuration, so that configuration values can be looked up
+ * without scanning the payload again. The payload is not modified and no
+ * values are copied; JSON escape sequences in keys and values are left as
+ * they appear in the payload.
+ *
+ * String values are returned without their JSON quotes or CBOR header. Values
+ * of any other type are returned as their complete encoded representation.
+ *
+ * @param[in] pPayload The payload received on a RegisterThing accepted topic.
+ * @param[in] payloadLength The length of @p pPayload.
+ * @param[in] format The format of the payload.
+ * @param[out] pOutResponse The parsed response.
+ *
+ * @return FleetProvisioningSuccess if the payload is parsed;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the device configuration has more than
+ * #FP_DEVICE_CONFIG_MAX_ENTRIES entries;
+ * FleetProvisioningError if the payload is malformed or has no thing name.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to read the thing name and a device
+ * // configuration value from a JSON RegisterThing accepted response.
+ *
+ * FleetProvisioningRegisterThingResponse_t response;
+ * FleetProvisioningSpan_t value;
+ * FleetProvisioningStatus_t status;
+ *
+ * // pPayload and payloadLength are the payload received on the
+ * // FP_JSON_REGISTER_ACCEPTED_TOPIC topic.
+ * status = FleetProvisioning_ParseRegisterThingAccepted( pPayload,
+ *                                                        payloadLength,
+ *                                                        FleetProvisioningJson,
+ *                                                        &response );
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      // response.thingName holds the name of the provisioned thing.
+ *      status = FleetProvisioning_GetDeviceConfigValue( &response,
+ *                                                       "serverUrl",
+ *                                                       9U,
+ *                                                       &value );
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_parseregisterthingaccepted] */
+FleetProvisioningStatus_t FleetProvisioning_ParseRegisterThingAccepted( const char * pPayload,
+                                                                        size_t payloadLength,
+                                                                        FleetProvisioningFormat_t format,
+                                                                        FleetProvisioningRegisterThingResponse_t * pOutResponse );
+/* @[declare_fleet_provisioning_parseregisterthingaccepted] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Look up a device configuration value by key.
+ *
+ * @param[in] pResponse A response parsed by
+ * #FleetProvisioning_ParseRegisterThingAccepted.
+ * @param[in] pKey The key to look up, as it appears in the payload.
+ * @param[in] keyLength The length of @p pKey.
+ * @param[out] pOutValue The value of the first entry with the given key.
+ *
+ * @return FleetProvisioningSuccess if the key is found;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the device configuration has no such key.
+ */
+/* @[declare_fleet_provisioning_getdeviceconfigvalue] */
+FleetProvisioningStatus_t FleetProvisioning_GetDeviceConfigValue( const FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                                  const char * pKey,
+                                                                  size_t keyLength,
+                                                                  FleetProvisioningSpan_t * pOutValue );
+/* @[declare_fleet_provisioning_getdeviceconfigvalue] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Iterate over the device configuration entries.
+ *
+ * Entries are returned in the order they appear in the payload. Start with an
+ * @p index of zero and increment it until FleetProvisioningNoMatch is
+ * returned.
+ *
+ * @param[in] pResponse A response parsed by
+ * #FleetProvisioning_ParseRegisterThingAccepted.
+ * @param[in] index The position of the entry to return.
+ * @param[out] pOutKey The key of the entry.
+ * @param[out] pOutValue The value of the entry.
+ *
+ * @return FleetProvisioningSuccess if the entry is returned;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if @p index is past the last entry.
+ */
+/* @[declare_fleet_provisioning_getdeviceconfigentry] */
+FleetProvisioningStatus_t FleetProvisioning_GetDeviceConfigEntry( const FleetProvisioningRegisterThingResponse_t * pResponse,
+                                                                  size_t index,
+                                                                  FleetProvisioningSpan_t * pOutKey,
+                                                                  FleetProvisioningSpan_t * pOutValue );
+/* @[declare_fleet_provisioning_getdeviceconfigentry] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Locate a string member of a response payload, without copying it.
+ *
+ * Only the top level of the payload is searched. The returned span points
+ * into @p pPayload: for JSON payloads it holds the string as it appears
+ * between the quotes, with any escape sequences left in place; for CBOR
+ * payloads it holds the text string bytes. This can be used to pass the
+ * #FP_API_OWNERSHIP_TOKEN_KEY of a CreateKeysAndCertificate or
+ * CreateCertificateFromCSR accepted response straight to
+ * #FleetProvisioning_GatherRegisterThingTemplate, or to find the
+ * #FP_API_CERTIFICATE_PEM_KEY to decode with #FleetProvisioning_PemToDer.
+ *
+ * @param[in] pPayload The response payload.
+ * @param[in] payloadLength The length of @p pPayload.
+ * @param[in] format The format of the payload.
+ * @param[in] pKey The key to look up.
+ * @param[in] keyLength The length of @p pKey.
+ * @param[out] pOutValue The value of the first member with the given key.
+ *
+ * @return FleetProvisioningSuccess if the key is found;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the payload has no such key;
+ * FleetProvisioningError if the payload is malformed or the value is not a
+ * string.
+ */
+/* @[declare_fleet_provisioning_getresponsestring] */
+FleetProvisioningStatus_t FleetProvisioning_GetResponseString( const char * pPayload,
+                                                               size_t payloadLength,
+                                                               FleetProvisioningFormat_t format,
+                                                               const char * pKey,
+                                                               size_t keyLength,
+                                                               FleetProvisioningSpan_t * pOutValue );
+/* @[declare_fleet_provisioning_getresponsestring] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the #FP_API_STATUS_CODE_KEY member of a rejected response.
+ *
+ * The value must be an unsigned integer: plain decimal digits in JSON, or
+ * major type 0 in CBOR. Only the top level of the payload is searched.
+ *
+ * @param[in] pPayload The response payload.
+ * @param[in] payloadLength The length of @p pPayload.
+ * @param[in] format The format of the payload.
+ * @param[out] pOutStatusCode The status code.
+ *
+ * @return FleetProvisioningSuccess if the status code is read;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the payload has no status code;
+ * FleetProvisioningError if the payload is malformed or the status code is
+ * not an unsigned integer that fits in 32 bits.
+ */
+/* @[declare_fleet_provisioning_getresponsestatuscode] */
+FleetProvisioningStatus_t FleetProvisioning_GetResponseStatusCode( const char * pPayload,
+                                                                   size_t payloadLength,
+                                                                   FleetProvisioningFormat_t format,
+                                                                   uint32_t * pOutStatusCode );
+/* @[declare_fleet_provisioning_getresponsestatuscode] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_PARSER_H_ */
@@ -0,0 +1,162 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_pem.h
+ * @brief Interface for converting certificates and keys between the PEM form
+ * used by AWS IoT Fleet Provisioning payloads and DER.
+ */
+
+#ifndef FLEET_PROVISIONING_PEM_H_
+#define FLEET_PROVISIONING_PEM_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Decode a PEM certificate or key into DER, in place.
+ *
+ * The input is the value of a PEM field, such as #FP_API_CERTIFICATE_PEM_KEY
+ * or #FP_API_PRIVATE_KEY_KEY, exactly as it appears in the received payload:
+ * for JSON payloads, line breaks are the two character escape sequence `\n`
+ * and slashes may be escaped as `\/`; for CBOR payloads, line breaks are
+ * literal newlines. The armor lines are removed, the line breaks are dropped,
+ * and the base64 body is decoded. The DER bytes are written to the start of
+ * @p pPem, so no additional buffer is needed. Only the first PEM block is
+ * decoded.
+ *
+ * The contents of @p pPem past the returned DER length are unspecified after
+ * the call, as is the whole buffer if the call fails.
+ *
+ * @param[in,out] pPem The PEM data, which is overwritten with the DER data.
+ * @param[in] pemLength The length of @p pPem.
+ * @param[out] pOutDerLength The length of the DER data.
+ *
+ * @return FleetProvisioningSuccess if the PEM data is decoded;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningError if the PEM data is malformed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to convert the certificate in a
+ * // CreateKeysAndCertificate accepted response to DER in the receive buffer.
+ *
+ * size_t derLength = 0;
+ * FleetProvisioningStatus_t status;
+ *
+ * // pCertificate and certificateLength locate the value of the
+ * // certificatePem key within the receive buffer, as found by a JSON or
+ * // CBOR parser.
+ * status = FleetProvisioning_PemToDer( pCertificate,
+ *                                      certificateLength,
+ *                                      &derLength );
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      // pCertificate now holds derLength bytes of DER, ready to be stored
+ *      // or passed to the TLS stack.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_pemtoder] */
+FleetProvisioningStatus_t FleetProvisioning_PemToDer( char * pPem,
+                                                      size_t pemLength,
+                                                      size_t * pOutDerLength );
+/* @[declare_fleet_provisioning_pemtoder] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Encode DER data as PEM, as it must appear in a payload of the given
+ * format.
+ *
+ * The base64 body, line breaks and armor lines are written to @p pBuffer in
+ * a single pass. For JSON payloads, line breaks are written as the two
+ * character escape sequence `\n`, so the output can be placed directly
+ * between the quotes of a JSON string; for CBOR payloads, they are literal
+ * newlines. Body lines are 64 characters long. The length of buffer needed
+ * is given by #FleetProvisioning_GetPemLength.
+ *
+ * @param[in] pDer The DER data to encode.
+ * @param[in] derLength The length of @p pDer.
+ * @param[in] pLabel The PEM label, such as `CERTIFICATE REQUEST`.
+ * @param[in] labelLength The length of @p pLabel.
+ * @param[in] format The format of the payload the PEM data is placed in.
+ * @param[out] pBuffer The buffer to write the PEM data to.
+ * @param[in] bufferLength The length of @p pBuffer.
+ * @param[out] pOutLength The length of the PEM data.
+ *
+ * @return FleetProvisioningSuccess if the PEM data is written;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the buffer cannot hold the PEM data.
+ */
+/* @[declare_fleet_provisioning_dertopem] */
+FleetProvisioningStatus_t FleetProvisioning_DerToPem( const uint8_t * pDer,
+                                                      size_t derLength,
+                                                      const char * pLabel,
+                                                      size_t labelLength,
+                                                      FleetProvisioningFormat_t format,
+                                                      char * pBuffer,
+                                                      size_t bufferLength,
+                                                      size_t * pOutLength );
+/* @[declare_fleet_provisioning_dertopem] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the length of the PEM data written by
+ * #FleetProvisioning_DerToPem.
+ *
+ * @param[in] derLength The length of the DER data.
+ * @param[in] labelLength The length of the PEM label.
+ * @param[in] format The format of the payload the PEM data is placed in.
+ *
+ * @return The length of the PEM data, or 0 if the parameters are invalid.
+ */
+/* @[declare_fleet_provisioning_getpemlength] */
+size_t FleetProvisioning_GetPemLength( size_t derLength,
+                                       size_t labelLength,
+                                       FleetProvisioningFormat_t format );
+/* @[declare_fleet_provisioning_getpemlength] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_PEM_H_ */
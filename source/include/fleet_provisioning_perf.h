@@ -0,0 +1,264 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_perf.h
+ * @brief Interface for the optional performance counters of the AWS IoT
+ * Fleet Provisioning Library.
+ */
+
+#ifndef FLEET_PROVISIONING_PERF_H_
+#define FLEET_PROVISIONING_PERF_H_
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of values of #FleetProvisioningStatus_t.
+ */
+#define FP_PERF_STATUS_COUNT        ( 5U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of values of #FleetProvisioningTopic_t.
+ */
+#define FP_PERF_TOPIC_COUNT         ( 19U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of buckets of the cycle count histograms. Bucket `i` counts
+ * the calls that took from 2^i to 2^(i+1) - 1 cycles; bucket 0 also counts
+ * calls of 0 cycles.
+ */
+#define FP_PERF_HISTOGRAM_BUCKETS   ( 32U )
+
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief The public functions counted by #FleetProvisioningPerfCounters_t.
+ */
+typedef enum
+{
+    FleetProvisioningPerfGetRegisterThingTopic = 0,         /**< @brief #FleetProvisioning_GetRegisterThingTopic. */
+    FleetProvisioningPerfMatchTopic,                        /**< @brief #FleetProvisioning_MatchTopic. */
+    FleetProvisioningPerfParseRegisterThingAccepted,        /**< @brief #FleetProvisioning_ParseRegisterThingAccepted. */
+    FleetProvisioningPerfGetDeviceConfigValue,              /**< @brief #FleetProvisioning_GetDeviceConfigValue. */
+    FleetProvisioningPerfGetDeviceConfigEntry,              /**< @brief #FleetProvisioning_GetDeviceConfigEntry. */
+    FleetProvisioningPerfGetResponseString,                 /**< @brief #FleetProvisioning_GetResponseString. */
+    FleetProvisioningPerfGetResponseStatusCode,             /**< @brief #FleetProvisioning_GetResponseStatusCode. */
+    FleetProvisioningPerfPemToDer,                          /**< @brief #FleetProvisioning_PemToDer. */
+    FleetProvisioningPerfDerToPem,                          /**< @brief #FleetProvisioning_DerToPem. */
+    FleetProvisioningPerfSerializeCreateCertFromCsrRequest, /**< @brief #FleetProvisioning_SerializeCreateCertFromCsrRequest. */
+    FleetProvisioningPerfInitRegisterThingTemplate,         /**< @brief #FleetProvisioning_InitRegisterThingTemplate. */
+    FleetProvisioningPerfSetTemplateSlot,                   /**< @brief #FleetProvisioning_SetTemplateSlot. */
+    FleetProvisioningPerfCompleteRegisterThingTemplate,     /**< @brief #FleetProvisioning_CompleteRegisterThingTemplate. */
+    FleetProvisioningPerfGatherRegisterThingTemplate,       /**< @brief #FleetProvisioning_GatherRegisterThingTemplate. */
+    FleetProvisioningPerfSessionInit,                       /**< @brief #FleetProvisioning_SessionInit. */
+    FleetProvisioningPerfSessionHandleEvent,                /**< @brief #FleetProvisioning_SessionHandleEvent. */
+    FleetProvisioningPerfSessionGetRequest,                 /**< @brief #FleetProvisioning_SessionGetRequest. */
+    FleetProvisioningPerfSessionPoolInit,                   /**< @brief #FleetProvisioning_SessionPoolInit. */
+    FleetProvisioningPerfSessionPoolAcquire,                /**< @brief #FleetProvisioning_SessionPoolAcquire. */
+    FleetProvisioningPerfSessionPoolRelease,                /**< @brief #FleetProvisioning_SessionPoolRelease. */
+    FleetProvisioningPerfSessionPoolHandleEvent,            /**< @brief #FleetProvisioning_SessionPoolHandleEvent. */
+    FleetProvisioningPerfSessionPoolTick,                   /**< @brief #FleetProvisioning_SessionPoolTick. */
+    FleetProvisioningPerfSessionPoolNextTimeout,            /**< @brief #FleetProvisioning_SessionPoolNextTimeout. */
+    FleetProvisioningPerfSessionPoolSetRateLimiter,         /**< @brief #FleetProvisioning_SessionPoolSetRateLimiter. */
+    FleetProvisioningPerfSessionPoolSetConcurrency,         /**< @brief #FleetProvisioning_SessionPoolSetConcurrency. */
+    FleetProvisioningPerfSessionPoolNextPublish,            /**< @brief #FleetProvisioning_SessionPoolNextPublish. */
+    FleetProvisioningPerfTimerWheelInit,                    /**< @brief #FleetProvisioning_TimerWheelInit. */
+    FleetProvisioningPerfTimerWheelArm,                     /**< @brief #FleetProvisioning_TimerWheelArm. */
+    FleetProvisioningPerfTimerWheelCancel,                  /**< @brief #FleetProvisioning_TimerWheelCancel. */
+    FleetProvisioningPerfTimerWheelAdvance,                 /**< @brief #FleetProvisioning_TimerWheelAdvance. */
+    FleetProvisioningPerfTimerWheelPopExpired,              /**< @brief #FleetProvisioning_TimerWheelPopExpired. */
+    FleetProvisioningPerfGetTopicInfo,                      /**< @brief #FleetProvisioning_GetTopicInfo. */
+    FleetProvisioningPerfRateLimiterInit,                   /**< @brief #FleetProvisioning_RateLimiterInit. */
+    FleetProvisioningPerfRateLimiterTryAcquire,             /**< @brief #FleetProvisioning_RateLimiterTryAcquire. */
+    FleetProvisioningPerfConcurrencyInit,                   /**< @brief #FleetProvisioning_ConcurrencyInit. */
+    FleetProvisioningPerfConcurrencyTryStart,               /**< @brief #FleetProvisioning_ConcurrencyTryStart. */
+    FleetProvisioningPerfConcurrencyFinish,                 /**< @brief #FleetProvisioning_ConcurrencyFinish. */
+    FleetProvisioningPerfConcurrencyOnResponse,             /**< @brief #FleetProvisioning_ConcurrencyOnResponse. */
+    FleetProvisioningPerfCorrelatorInit,                    /**< @brief #FleetProvisioning_CorrelatorInit. */
+    FleetProvisioningPerfCorrelatorPush,                    /**< @brief #FleetProvisioning_CorrelatorPush. */
+    FleetProvisioningPerfCorrelatorMatch,                   /**< @brief #FleetProvisioning_CorrelatorMatch. */
+    FleetProvisioningPerfCorrelatorCancel,                  /**< @brief #FleetProvisioning_CorrelatorCancel. */
+    FleetProvisioningPerfGetShard,                          /**< @brief #FleetProvisioning_GetShard. */
+    FleetProvisioningPerfShardQueueInit,                    /**< @brief #FleetProvisioning_ShardQueueInit. */
+    FleetProvisioningPerfShardQueuePush,                    /**< @brief #FleetProvisioning_ShardQueuePush. */
+    FleetProvisioningPerfShardQueuePop,                     /**< @brief #FleetProvisioning_ShardQueuePop. */
+    FleetProvisioningPerfGetStartDelay,                     /**< @brief #FleetProvisioning_GetStartDelay. */
+    FleetProvisioningPerfGetRotationTime,                   /**< @brief #FleetProvisioning_GetRotationTime. */
+    FleetProvisioningPerfDedupInit,                         /**< @brief #FleetProvisioning_DedupInit. */
+    FleetProvisioningPerfDedupCheck,                        /**< @brief #FleetProvisioning_DedupCheck. */
+    FleetProvisioningPerfBinaryLogInit,                     /**< @brief #FleetProvisioning_BinaryLogInit. */
+    FleetProvisioningPerfBinaryLogCopy,                     /**< @brief #FleetProvisioning_BinaryLogCopy. */
+    FleetProvisioningPerfHistogramRecord,                   /**< @brief #FleetProvisioning_HistogramRecord. */
+    FleetProvisioningPerfHistogramMerge,                    /**< @brief #FleetProvisioning_HistogramMerge. */
+    FleetProvisioningPerfHistogramExportPrometheus,         /**< @brief #FleetProvisioning_HistogramExportPrometheus. */
+    FleetProvisioningPerfLatencyInit,                       /**< @brief #FleetProvisioning_LatencyInit. */
+    FleetProvisioningPerfLatencyMerge,                      /**< @brief #FleetProvisioning_LatencyMerge. */
+    FleetProvisioningPerfLatencyExportPrometheus,           /**< @brief #FleetProvisioning_LatencyExportPrometheus. */
+    FleetProvisioningPerfSessionPoolSetLatency,             /**< @brief #FleetProvisioning_SessionPoolSetLatency. */
+    FleetProvisioningPerfApiCount                           /**< @brief Number of functions counted. */
+} FleetProvisioningPerfApi_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Performance counters of the library.
+ *
+ * Only present when #FP_ENABLE_PERF_COUNTERS is 1. The counters are updated
+ * with #FP_ATOMIC_ADD_RELAXED, and wrap around; readers should take the
+ * difference between two reads modulo 2^32. Calls the library makes to its
+ * own public functions, such as a session pool calling
+ * #FleetProvisioning_SessionHandleEvent, are counted too.
+ */
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+    typedef struct FleetProvisioningPerfCounters
+    {
+        /**
+         * @brief Number of calls of each function, by returned status.
+         */
+        uint32_t calls[ FleetProvisioningPerfApiCount ][ FP_PERF_STATUS_COUNT ];
+
+        /**
+         * @brief Number of calls of #FleetProvisioning_MatchTopic with valid
+         * parameters, by topic; #FleetProvisioningInvalidTopic counts the
+         * topics that did not match.
+         */
+        uint32_t topics[ FP_PERF_TOPIC_COUNT ];
+
+        #if ( FP_ENABLE_PERF_HISTOGRAMS != 0 )
+
+            /**
+             * @brief Number of calls of each function, by the log2 of the
+             * cycles they took, as read by #FP_PERF_READ_CYCLES.
+             */
+            uint32_t cycles[ FleetProvisioningPerfApiCount ][ FP_PERF_HISTOGRAM_BUCKETS ];
+        #endif
+    } FleetProvisioningPerfCounters_t;
+#endif /* if ( FP_ENABLE_PERF_COUNTERS != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore these macros as they are private.
+ */
+
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+    #if ( FP_ENABLE_PERF_HISTOGRAMS != 0 )
+        #define FP_PERF_START( startCycles )    uint32_t startCycles = FP_PERF_READ_CYCLES();
+    #else
+        #define FP_PERF_START( startCycles )    uint32_t startCycles = 0U;
+    #endif
+    #define FP_PERF_RECORD( api, status, startCycles )    FleetProvisioning_PerfRecord( ( api ), ( status ), ( startCycles ) )
+    #define FP_PERF_RECORD_TOPIC( topic )                 FleetProvisioning_PerfRecordTopic( topic )
+#else
+    #define FP_PERF_START( startCycles )
+    #define FP_PERF_RECORD( api, status, startCycles )
+    #define FP_PERF_RECORD_TOPIC( topic )
+#endif
+
+/** @endcond */
+
+/*-----------------------------------------------------------*/
+
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+
+/**
+ * @brief Set the counters the library updates.
+ *
+ * The counters are provided by the application, which reads them at any
+ * time, for example to export them. They are not cleared. Counting stops
+ * when NULL is set. The counters should be set before other threads call the
+ * library, or with an atomic store on targets where pointer stores are not
+ * atomic.
+ *
+ * @param[in] pCounters The counters, or NULL.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to count the topics matched on a
+ * // gateway.
+ *
+ * static FleetProvisioningPerfCounters_t counters;
+ *
+ * FleetProvisioning_PerfSetCounters( &counters );
+ *
+ * // Later, on another thread:
+ * uint32_t noMatch = counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningNoMatch ];
+ * uint32_t registerAccepted = counters.topics[ FleetProvJsonRegisterThingAccepted ];
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_perfsetcounters] */
+    void FleetProvisioning_PerfSetCounters( FleetProvisioningPerfCounters_t * pCounters );
+/* @[declare_fleet_provisioning_perfsetcounters] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a call of a public function. Called by the library.
+ *
+ * @param[in] api The function.
+ * @param[in] status The status it returned.
+ * @param[in] startCycles The cycle count when it was called.
+ */
+/* @[declare_fleet_provisioning_perfrecord] */
+    void FleetProvisioning_PerfRecord( FleetProvisioningPerfApi_t api,
+                                       FleetProvisioningStatus_t status,
+                                       uint32_t startCycles );
+/* @[declare_fleet_provisioning_perfrecord] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count a topic matched by #FleetProvisioning_MatchTopic. Called by
+ * the library.
+ *
+ * @param[in] topic The topic.
+ */
+/* @[declare_fleet_provisioning_perfrecordtopic] */
+    void FleetProvisioning_PerfRecordTopic( FleetProvisioningTopic_t topic );
+/* @[declare_fleet_provisioning_perfrecordtopic] */
+
+#endif /* if ( FP_ENABLE_PERF_COUNTERS != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_PERF_H_ */
@@ -0,0 +1,160 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_rate_limiter.h
+ * @brief Interface for the token-bucket rate limiter of AWS IoT Fleet
+ * Provisioning requests.
+ */
+
+#ifndef FLEET_PROVISIONING_RATE_LIMITER_H_
+#define FLEET_PROVISIONING_RATE_LIMITER_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief The rate limit of an API.
+ *
+ * Requests are allowed at @p requestsPerPeriod every @p periodTicks ticks
+ * on average, with bursts of up to @p burst requests after a quiet period.
+ */
+typedef struct FleetProvisioningRateLimit
+{
+    uint32_t requestsPerPeriod; /**< @brief Sustained rate, or 0 for no limit. */
+    uint32_t periodTicks;       /**< @brief Period of the rate, in ticks. */
+    uint32_t burst;             /**< @brief Largest burst of requests, at least 1. */
+} FleetProvisioningRateLimit_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A token bucket.
+ *
+ * Tokens are counted in credits of 1 / @p periodTicks of a request, so that
+ * refilling is exact in integer arithmetic.
+ */
+typedef struct FleetProvisioningTokenBucket
+{
+    uint32_t credits;        /**< @brief Credits in the bucket. */
+    uint32_t capacity;       /**< @brief Credits of a full bucket. */
+    uint32_t creditsPerTick; /**< @brief Credits added each tick, or 0 for no limit. */
+    uint32_t cost;           /**< @brief Credits taken by a request. */
+    uint32_t lastTick;       /**< @brief Tick of the last refill. */
+} FleetProvisioningTokenBucket_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A rate limiter with one token bucket for each API.
+ *
+ * Initialized by #FleetProvisioning_RateLimiterInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningRateLimiter
+{
+    FleetProvisioningTokenBucket_t buckets[ FP_API_COUNT ]; /**< @brief Buckets, indexed by #FleetProvisioningApi_t. */
+} FleetProvisioningRateLimiter_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a rate limiter with full buckets, so that the first
+ * bursts go out at once.
+ *
+ * @param[out] pLimiter The rate limiter to initialize.
+ * @param[in] pLimits The limit of each API, indexed by
+ * #FleetProvisioningApi_t.
+ * @param[in] now The current tick.
+ *
+ * @return FleetProvisioningSuccess if the rate limiter is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed, including
+ * limits whose @p burst times @p periodTicks does not fit 32 bits.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to set up a rate limiter for 10 ms
+ * // ticks, allowing each API 10 requests per second, in bursts of 20.
+ *
+ * static const FleetProvisioningRateLimit_t limits[ FP_API_COUNT ] =
+ * {
+ *      { 10U, 100U, 20U },
+ *      { 10U, 100U, 20U },
+ *      { 10U, 100U, 20U }
+ * };
+ * FleetProvisioningRateLimiter_t limiter;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_RateLimiterInit( &limiter, limits, 0U );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_ratelimiterinit] */
+FleetProvisioningStatus_t FleetProvisioning_RateLimiterInit( FleetProvisioningRateLimiter_t * pLimiter,
+                                                             const FleetProvisioningRateLimit_t * pLimits,
+                                                             uint32_t now );
+/* @[declare_fleet_provisioning_ratelimiterinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Take a token for a request, if one is available.
+ *
+ * @param[in] pLimiter The rate limiter.
+ * @param[in] request The publish topic of the request.
+ * @param[in] now The current tick. A tick 2^31 or more ticks after the last
+ * one seen, as when the tick counter wrapped while the API was idle, fills
+ * the bucket of the API.
+ * @param[out] pOutWaitTicks Optional, may be NULL. When no token is
+ * available, the number of ticks until one is.
+ *
+ * @return FleetProvisioningSuccess if a token is taken;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the request must wait.
+ */
+/* @[declare_fleet_provisioning_ratelimitertryacquire] */
+FleetProvisioningStatus_t FleetProvisioning_RateLimiterTryAcquire( FleetProvisioningRateLimiter_t * pLimiter,
+                                                                   FleetProvisioningTopic_t request,
+                                                                   uint32_t now,
+                                                                   uint32_t * pOutWaitTicks );
+/* @[declare_fleet_provisioning_ratelimitertryacquire] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_RATE_LIMITER_H_ */
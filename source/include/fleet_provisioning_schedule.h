@@ -0,0 +1,125 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_schedule.h
+ * @brief Interface for spreading the AWS IoT Fleet Provisioning requests of
+ * a fleet over time.
+ */
+
+#ifndef FLEET_PROVISIONING_SCHEDULE_H_
+#define FLEET_PROVISIONING_SCHEDULE_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Get how long a device should wait before starting a provisioning
+ * flow, so that the devices of a fleet that start together, such as after
+ * a firmware release or a power restore, spread their flows over a window.
+ *
+ * The delay is derived from the device ID, so a device gets the same delay
+ * every time, and the delays of a fleet are spread evenly over the window.
+ *
+ * @param[in] pDeviceId A unique ID of the device, such as its serial number.
+ * @param[in] deviceIdLength The length of @p pDeviceId.
+ * @param[in] windowTicks The length of the window, in the ticks of the
+ * application. A window of 0 gives no delay.
+ * @param[out] pOutDelayTicks The delay, below @p windowTicks.
+ *
+ * @return FleetProvisioningSuccess if the delay is computed;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to start a flow after the delay of the
+ * // device, with a window of 10 minutes in millisecond ticks.
+ *
+ * uint32_t delay;
+ *
+ * if( FleetProvisioning_GetStartDelay( pSerial, serialLength, 600000U, &delay ) == FleetProvisioningSuccess )
+ * {
+ *      // Start the session once the tick count reaches bootTicks + delay.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_getstartdelay] */
+FleetProvisioningStatus_t FleetProvisioning_GetStartDelay( const char * pDeviceId,
+                                                           size_t deviceIdLength,
+                                                           uint32_t windowTicks,
+                                                           uint32_t * pOutDelayTicks );
+/* @[declare_fleet_provisioning_getstartdelay] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get when a device should rotate its certificate with
+ * CreateCertificateFromCsr.
+ *
+ * The rotation falls in a window of the certificate's validity period, from
+ * #FP_ROTATION_WINDOW_START_PERCENT to #FP_ROTATION_WINDOW_END_PERCENT of the
+ * way through it, well before expiry. The time within the window is derived
+ * from the device ID, so that the rotations of a fleet whose certificates
+ * were issued together are spread evenly over the window.
+ *
+ * @param[in] pDeviceId A unique ID of the device, such as its serial number.
+ * @param[in] deviceIdLength The length of @p pDeviceId.
+ * @param[in] notBefore The start of the validity period of the certificate,
+ * in seconds.
+ * @param[in] notAfter The end of the validity period of the certificate, in
+ * seconds of the same epoch, after @p notBefore.
+ * @param[out] pOutRotationTime The time to rotate the certificate, in
+ * seconds of the same epoch.
+ *
+ * @return FleetProvisioningSuccess if the time is computed;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_getrotationtime] */
+FleetProvisioningStatus_t FleetProvisioning_GetRotationTime( const char * pDeviceId,
+                                                             size_t deviceIdLength,
+                                                             uint32_t notBefore,
+                                                             uint32_t notAfter,
+                                                             uint32_t * pOutRotationTime );
+/* @[declare_fleet_provisioning_getrotationtime] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_SCHEDULE_H_ */
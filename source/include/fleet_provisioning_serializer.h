@@ -0,0 +1,430 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_serializer.h
+ * @brief Interface for serializing AWS IoT Fleet Provisioning request
+ * payloads.
+ */
+
+#ifndef FLEET_PROVISIONING_SERIALIZER_H_
+#define FLEET_PROVISIONING_SERIALIZER_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* Fleet Provisioning parser include, for FleetProvisioningSpan_t. */
+#include "fleet_provisioning_parser.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief PEM label of a certificate signing request.
+ */
+#define FP_CSR_PEM_LABEL           "CERTIFICATE REQUEST"
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Length of #FP_CSR_PEM_LABEL.
+ */
+#define FP_CSR_PEM_LABEL_LENGTH    ( ( uint16_t ) ( sizeof( FP_CSR_PEM_LABEL ) - 1U ) )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Largest number of segments in a gathered payload.
+ */
+#define FP_GATHER_MAX_SEGMENTS     ( 3U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Upper bound on the length of a CreateCertificateFromCSR request
+ * payload, in either format, for a CSR of the given DER length.
+ *
+ * @param csrDerLength The length of the DER certificate signing request.
+ */
+#define FP_CSR_REQUEST_MAX_LENGTH( csrDerLength )       \
+    ( ( 4U * ( ( ( csrDerLength ) + 2U ) / 3U ) ) +     \
+      ( 2U * ( ( ( csrDerLength ) + 47U ) / 48U ) ) +   \
+      ( 2U * FP_CSR_PEM_LABEL_LENGTH ) + 67U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Upper bound on the length of a RegisterThing request payload, in
+ * either format.
+ *
+ * @param parametersLength The total length of the parameter names and
+ * values, plus 6 bytes for each parameter.
+ * @param tokenLength The length of the certificate ownership token.
+ */
+#define FP_REGISTER_REQUEST_MAX_LENGTH( parametersLength, tokenLength ) \
+    ( ( parametersLength ) + ( tokenLength ) + 49U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A RegisterThing parameter given to
+ * #FleetProvisioning_InitRegisterThingTemplate.
+ *
+ * A parameter with a NULL value is a variable slot, @p valueLength bytes
+ * wide, which is filled for each device with
+ * #FleetProvisioning_SetTemplateSlot.
+ */
+typedef struct FleetProvisioningTemplateParameter
+{
+    const char * pKey;   /**< @brief Parameter name. */
+    size_t keyLength;    /**< @brief Length of the parameter name. */
+    const char * pValue; /**< @brief Fixed value, or NULL for a slot. */
+    size_t valueLength;  /**< @brief Length of the value, or width of the slot. */
+} FleetProvisioningTemplateParameter_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Location of a variable slot in a payload template.
+ */
+typedef struct FleetProvisioningTemplateSlot
+{
+    uint32_t offset; /**< @brief Offset of the slot in the template buffer. */
+    uint32_t length; /**< @brief Width of the slot in bytes. */
+} FleetProvisioningTemplateSlot_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief RegisterThing request payload template.
+ *
+ * Initialized by #FleetProvisioning_InitRegisterThingTemplate. The members
+ * should not be modified by the application.
+ */
+typedef struct FleetProvisioningRegisterThingTemplate
+{
+    char * pBuffer;                   /**< @brief Buffer holding the payload. */
+    size_t bufferLength;              /**< @brief Length of the buffer. */
+    size_t prefixLength;              /**< @brief Length of the payload before the ownership token. */
+    FleetProvisioningFormat_t format; /**< @brief Format of the payload. */
+    size_t slotCount;                 /**< @brief Number of variable slots. */
+
+    /**
+     * @brief Variable slots, in the order of their parameters.
+     */
+    FleetProvisioningTemplateSlot_t slots[ FP_TEMPLATE_MAX_SLOTS ];
+} FleetProvisioningRegisterThingTemplate_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A payload made of segments in different buffers, to be sent in
+ * order with a gather write.
+ */
+typedef struct FleetProvisioningPayloadGather
+{
+    FleetProvisioningSpan_t segments[ FP_GATHER_MAX_SEGMENTS ]; /**< @brief Segments of the payload, in order. */
+    size_t segmentCount;                                       /**< @brief Number of segments used. */
+    size_t payloadLength;                                      /**< @brief Total length of the segments. */
+} FleetProvisioningPayloadGather_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Serialize a CreateCertificateFromCSR request payload from a DER
+ * certificate signing request.
+ *
+ * The payload is a map holding the PEM form of the CSR under
+ * #FP_API_CSR_KEY: a JSON object with the line breaks escaped, or a CBOR map
+ * with a text string value. The CSR is encoded directly into @p pBuffer, so
+ * no intermediate PEM buffer is needed.
+ *
+ * @param[in] pCsrDer The DER certificate signing request.
+ * @param[in] csrDerLength The length of @p pCsrDer.
+ * @param[in] format The format of the payload.
+ * @param[out] pBuffer The buffer to write the payload to.
+ * @param[in] bufferLength The length of @p pBuffer.
+ * @param[out] pOutLength The length of the payload.
+ *
+ * @return FleetProvisioningSuccess if the payload is written;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the buffer cannot hold the payload.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to build the payload of a JSON
+ * // CreateCertificateFromCSR request from a CSR generated by the crypto
+ * // library.
+ *
+ * char payload[ 1024 ];
+ * size_t payloadLength = 0;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_SerializeCreateCertFromCsrRequest( pCsrDer,
+ *                                                               csrDerLength,
+ *                                                               FleetProvisioningJson,
+ *                                                               payload,
+ *                                                               sizeof( payload ),
+ *                                                               &payloadLength );
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      // Publish payloadLength bytes of payload to
+ *      // FP_JSON_CREATE_CERT_PUBLISH_TOPIC.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_serializecreatecertfromcsrrequest] */
+FleetProvisioningStatus_t FleetProvisioning_SerializeCreateCertFromCsrRequest( const uint8_t * pCsrDer,
+                                                                               size_t csrDerLength,
+                                                                               FleetProvisioningFormat_t format,
+                                                                               char * pBuffer,
+                                                                               size_t bufferLength,
+                                                                               size_t * pOutLength );
+/* @[declare_fleet_provisioning_serializecreatecertfromcsrrequest] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Serialize the fixed part of a RegisterThing request payload into
+ * a template.
+ *
+ * Devices provisioned with the same template usually send parameters of the
+ * same shape, where only a few values, such as the serial number, change.
+ * This serializes the #FP_API_PARAMETERS_KEY map once, with the fixed values
+ * in place and a fixed-width slot for each variable value, so that building
+ * the request for each device only needs the slots to be filled with
+ * #FleetProvisioning_SetTemplateSlot and the ownership token to be appended
+ * with #FleetProvisioning_CompleteRegisterThingTemplate.
+ *
+ * The template buffer is also the buffer the request is built and published
+ * from. The ownership token is placed after the parameters, so the buffer
+ * must have room for the longest token expected.
+ *
+ * For JSON payloads, parameter names and fixed values are written as given,
+ * and must not contain characters that need to be escaped.
+ *
+ * @param[out] pTemplate The template to initialize.
+ * @param[in] format The format of the payload.
+ * @param[in] pParameters The RegisterThing parameters. May be NULL if
+ * @p parameterCount is 0.
+ * @param[in] parameterCount The number of parameters.
+ * @param[in] pBuffer The buffer holding the payload.
+ * @param[in] bufferLength The length of @p pBuffer.
+ *
+ * @return FleetProvisioningSuccess if the template is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the buffer cannot hold the template, or
+ * the parameters have more than #FP_TEMPLATE_MAX_SLOTS slots.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to build RegisterThing requests for
+ * // each device on a production line, where only the serial number changes.
+ *
+ * static char payload[ 1024 ];
+ * static FleetProvisioningRegisterThingTemplate_t registerTemplate;
+ * FleetProvisioningTemplateParameter_t parameters[] =
+ * {
+ *     { "DeviceLocation", 14, "Line3", 5 },
+ *     { "SerialNumber", 12, NULL, 10 }
+ * };
+ * size_t payloadLength = 0;
+ * FleetProvisioningStatus_t status;
+ *
+ * // Once, at start up.
+ * status = FleetProvisioning_InitRegisterThingTemplate( &registerTemplate,
+ *                                                       FleetProvisioningJson,
+ *                                                       parameters,
+ *                                                       2,
+ *                                                       payload,
+ *                                                       sizeof( payload ) );
+ *
+ * // For each device.
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      status = FleetProvisioning_SetTemplateSlot( &registerTemplate,
+ *                                                  0,
+ *                                                  pSerialNumber,
+ *                                                  10 );
+ * }
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      status = FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate,
+ *                                                                pToken,
+ *                                                                tokenLength,
+ *                                                                &payloadLength );
+ * }
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      // Publish payloadLength bytes of payload to the RegisterThing topic.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_initregisterthingtemplate] */
+FleetProvisioningStatus_t FleetProvisioning_InitRegisterThingTemplate( FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                       FleetProvisioningFormat_t format,
+                                                                       const FleetProvisioningTemplateParameter_t * pParameters,
+                                                                       size_t parameterCount,
+                                                                       char * pBuffer,
+                                                                       size_t bufferLength );
+/* @[declare_fleet_provisioning_initregisterthingtemplate] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Fill a variable slot of a RegisterThing payload template.
+ *
+ * The value is copied into the template buffer, where it stays for the
+ * following requests until the slot is set again.
+ *
+ * @param[in] pTemplate The template.
+ * @param[in] slotIndex The index of the slot, counting only the parameters
+ * that are slots.
+ * @param[in] pValue The value.
+ * @param[in] valueLength The length of @p pValue, which must equal the width
+ * of the slot.
+ *
+ * @return FleetProvisioningSuccess if the slot is filled;
+ * FleetProvisioningBadParameter if invalid parameters are passed, including a
+ * value of the wrong length or, for JSON payloads, one that needs escaping.
+ */
+/* @[declare_fleet_provisioning_settemplateslot] */
+FleetProvisioningStatus_t FleetProvisioning_SetTemplateSlot( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                             size_t slotIndex,
+                                                             const char * pValue,
+                                                             size_t valueLength );
+/* @[declare_fleet_provisioning_settemplateslot] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Complete a RegisterThing request payload by appending the
+ * certificate ownership token to the template.
+ *
+ * The token is written exactly as given, so for JSON payloads it should be
+ * the value as it appears in a JSON CreateKeysAndCertificate or
+ * CreateCertificateFromCSR accepted response. The complete payload starts at
+ * the start of the template buffer.
+ *
+ * @param[in] pTemplate The template, with its slots filled.
+ * @param[in] pToken The certificate ownership token.
+ * @param[in] tokenLength The length of @p pToken.
+ * @param[out] pOutLength The length of the payload.
+ *
+ * @return FleetProvisioningSuccess if the payload is complete;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the template buffer cannot hold the
+ * token.
+ */
+/* @[declare_fleet_provisioning_completeregisterthingtemplate] */
+FleetProvisioningStatus_t FleetProvisioning_CompleteRegisterThingTemplate( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                           const char * pToken,
+                                                                           size_t tokenLength,
+                                                                           size_t * pOutLength );
+/* @[declare_fleet_provisioning_completeregisterthingtemplate] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Describe a RegisterThing request payload as segments around the
+ * certificate ownership token, without copying the token.
+ *
+ * This is an alternative to #FleetProvisioning_CompleteRegisterThingTemplate
+ * for transports that can publish a payload from several buffers. The token
+ * stays where it is, typically in the receive buffer of the
+ * CreateKeysAndCertificate or CreateCertificateFromCSR accepted response,
+ * located with #FleetProvisioning_GetResponseString. The segments are the
+ * template buffer up to the token, the token, and for JSON payloads the
+ * closing characters. For CBOR payloads the length header of the token is
+ * written to the template buffer.
+ *
+ * The token must stay valid and unchanged until the payload is sent, and
+ * must come from a response of the same format as the template.
+ *
+ * @param[in] pTemplate The template, with its slots filled.
+ * @param[in] pToken The certificate ownership token.
+ * @param[in] tokenLength The length of @p pToken.
+ * @param[out] pOutGather The segments of the payload.
+ *
+ * @return FleetProvisioningSuccess if the payload is described;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the template buffer cannot hold the CBOR
+ * token header.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to send a RegisterThing request using
+ * // the ownership token in a CreateKeysAndCertificate accepted response,
+ * // still in the MQTT receive buffer.
+ *
+ * FleetProvisioningSpan_t token;
+ * FleetProvisioningPayloadGather_t gather;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_GetResponseString( pReceived,
+ *                                               receivedLength,
+ *                                               FleetProvisioningJson,
+ *                                               FP_API_OWNERSHIP_TOKEN_KEY,
+ *                                               sizeof( FP_API_OWNERSHIP_TOKEN_KEY ) - 1U,
+ *                                               &token );
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      status = FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate,
+ *                                                              token.pData,
+ *                                                              token.length,
+ *                                                              &gather );
+ * }
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      // Send gather.segmentCount segments, gather.payloadLength bytes in
+ *      // total, as the payload of one publish.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_gatherregisterthingtemplate] */
+FleetProvisioningStatus_t FleetProvisioning_GatherRegisterThingTemplate( const FleetProvisioningRegisterThingTemplate_t * pTemplate,
+                                                                         const char * pToken,
+                                                                         size_t tokenLength,
+                                                                         FleetProvisioningPayloadGather_t * pOutGather );
+/* @[declare_fleet_provisioning_gatherregisterthingtemplate] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_SERIALIZER_H_ */
@@ -0,0 +1,380 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session.h
+ * @brief Interface for the event-driven AWS IoT Fleet Provisioning session
+ * state machine.
+ */
+
+#ifndef FLEET_PROVISIONING_SESSION_H_
+#define FLEET_PROVISIONING_SESSION_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* Fleet Provisioning serializer include. */
+#include "fleet_provisioning_serializer.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Length of a session topic buffer large enough for any template
+ * name.
+ *
+ * The buffer holds the RegisterThing accepted and rejected topics, which
+ * have the same length in both formats.
+ */
+#define FP_SESSION_TOPIC_BUFFER_LENGTH                                \
+    ( FP_JSON_REGISTER_ACCEPTED_LENGTH( FP_TEMPLATENAME_MAX_LENGTH ) + \
+      FP_JSON_REGISTER_REJECTED_LENGTH( FP_TEMPLATENAME_MAX_LENGTH ) )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Length of a session payload buffer large enough for requests
+ * within #FP_SESSION_MAX_CSR_LENGTH, #FP_SESSION_MAX_PARAMETERS_LENGTH and
+ * #FP_SESSION_MAX_TOKEN_LENGTH.
+ */
+#define FP_SESSION_PAYLOAD_BUFFER_LENGTH                                          \
+    ( ( FP_CSR_REQUEST_MAX_LENGTH( FP_SESSION_MAX_CSR_LENGTH ) >                  \
+        FP_REGISTER_REQUEST_MAX_LENGTH( FP_SESSION_MAX_PARAMETERS_LENGTH,         \
+                                        FP_SESSION_MAX_TOKEN_LENGTH ) ) ?         \
+      FP_CSR_REQUEST_MAX_LENGTH( FP_SESSION_MAX_CSR_LENGTH ) :                    \
+      FP_REGISTER_REQUEST_MAX_LENGTH( FP_SESSION_MAX_PARAMETERS_LENGTH,           \
+                                      FP_SESSION_MAX_TOKEN_LENGTH ) )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief States of a provisioning session.
+ */
+typedef enum
+{
+    FleetProvisioningSessionIdle = 0,              /**< @brief Initialized, waiting for the start event. */
+    FleetProvisioningSessionSubscribingCredentials, /**< @brief Waiting for the credentials topics subscription. */
+    FleetProvisioningSessionSubscribingRegister,   /**< @brief Waiting for the RegisterThing topics subscription. */
+    FleetProvisioningSessionAwaitingCredentials,   /**< @brief Waiting for the credentials response. */
+    FleetProvisioningSessionAwaitingRegister,      /**< @brief Waiting for the RegisterThing response. */
+    FleetProvisioningSessionDone,                  /**< @brief The device is provisioned. */
+    FleetProvisioningSessionFailed                 /**< @brief Provisioning failed. */
+} FleetProvisioningSessionState_t;
+
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief Events fed to a provisioning session.
+ */
+typedef enum
+{
+    FleetProvisioningEventStart = 0,  /**< @brief Start provisioning. */
+    FleetProvisioningEventSubscribed, /**< @brief The last subscribe action is acknowledged. */
+    FleetProvisioningEventMessage,    /**< @brief A Fleet Provisioning response is received. */
+    FleetProvisioningEventTimeout     /**< @brief The timer of the last action expired. */
+} FleetProvisioningEventType_t;
+
+/**
+ * @ingroup fleet_provisioning_enum_types
+ * @brief Actions requested by a provisioning session.
+ */
+typedef enum
+{
+    FleetProvisioningActionNone = 0,  /**< @brief Nothing to do until the next event. */
+    FleetProvisioningActionSubscribe, /**< @brief Subscribe to the action topics. */
+    FleetProvisioningActionPublish,   /**< @brief Publish the action payload to the action topic. */
+    FleetProvisioningActionDone,      /**< @brief The device is provisioned. */
+    FleetProvisioningActionFailed,    /**< @brief Provisioning failed. */
+
+    /**
+     * @brief The request is held back by the rate limiter of a session pool,
+     * to be published later; the credentials of a RegisterThing request are
+     * set as for #FleetProvisioningActionPublish. Only returned by
+     * #FleetProvisioning_SessionPoolHandleEvent.
+     */
+    FleetProvisioningActionDeferred
+} FleetProvisioningActionType_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Configuration of a provisioning session.
+ *
+ * The template name, CSR and parameters are not copied, and must outlive the
+ * session.
+ */
+typedef struct FleetProvisioningSessionConfig
+{
+    FleetProvisioningFormat_t format; /**< @brief Format of the requests and responses. */
+    const char * pTemplateName;       /**< @brief Name of the provisioning template. */
+    uint16_t templateNameLength;      /**< @brief Length of the template name. */
+
+    /**
+     * @brief DER certificate signing request, to use CreateCertificateFromCSR,
+     * or NULL to use CreateKeysAndCertificate.
+     */
+    const uint8_t * pCsrDer;
+    size_t csrDerLength; /**< @brief Length of the CSR. */
+
+    /**
+     * @brief RegisterThing parameters, which must all have values.
+     */
+    const FleetProvisioningTemplateParameter_t * pParameters;
+    size_t parameterCount; /**< @brief Number of parameters. */
+
+    /**
+     * @brief Non-zero if the application subscribes to the response topics
+     * itself, once for all sessions, so the session requests no
+     * subscriptions.
+     */
+    uint8_t sharedSubscriptions;
+} FleetProvisioningSessionConfig_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A provisioning session.
+ *
+ * Initialized by #FleetProvisioning_SessionInit. The members should not be
+ * modified by the application.
+ */
+typedef struct FleetProvisioningSession
+{
+    FleetProvisioningSessionState_t state; /**< @brief Current state. */
+    FleetProvisioningFormat_t format;      /**< @brief Format of the requests and responses. */
+    const uint8_t * pCsrDer;               /**< @brief CSR, or NULL for CreateKeysAndCertificate. */
+    size_t csrDerLength;                   /**< @brief Length of the CSR. */
+
+    /**
+     * @brief RegisterThing parameters.
+     */
+    const FleetProvisioningTemplateParameter_t * pParameters;
+    size_t parameterCount;        /**< @brief Number of parameters. */
+    const char * pTopicBuffer;    /**< @brief RegisterThing accepted topic, followed by the rejected topic. */
+    uint16_t acceptedTopicLength; /**< @brief Length of the RegisterThing accepted topic. */
+    uint16_t rejectedTopicLength; /**< @brief Length of the RegisterThing rejected topic. */
+    char * pPayloadBuffer;        /**< @brief Buffer the requests are built in. */
+    size_t payloadBufferLength;   /**< @brief Length of the payload buffer. */
+    size_t requestLength;         /**< @brief Length of the last request built in the payload buffer. */
+    uint8_t sharedSubscriptions;  /**< @brief Non-zero if the session requests no subscriptions. */
+} FleetProvisioningSession_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief An event fed to a provisioning session.
+ */
+typedef struct FleetProvisioningEvent
+{
+    FleetProvisioningEventType_t type; /**< @brief Type of the event. */
+
+    /**
+     * @brief For #FleetProvisioningEventMessage, the topic of the message as
+     * matched by #FleetProvisioning_MatchTopic.
+     */
+    FleetProvisioningTopic_t topic;
+    const char * pPayload; /**< @brief For #FleetProvisioningEventMessage, the message payload. */
+    size_t payloadLength;  /**< @brief Length of the payload. */
+} FleetProvisioningEvent_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief Credentials received in a CreateKeysAndCertificate or
+ * CreateCertificateFromCSR accepted response.
+ *
+ * The spans point into the payload of the event, and are empty if the
+ * response does not hold the member.
+ */
+typedef struct FleetProvisioningCredentials
+{
+    FleetProvisioningSpan_t certificateId;  /**< @brief ID of the certificate. */
+    FleetProvisioningSpan_t certificatePem; /**< @brief PEM certificate, as in the payload. */
+    FleetProvisioningSpan_t privateKey;     /**< @brief PEM private key, for CreateKeysAndCertificate. */
+} FleetProvisioningCredentials_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief An action requested by a provisioning session.
+ */
+typedef struct FleetProvisioningAction
+{
+    FleetProvisioningActionType_t type; /**< @brief Type of the action. */
+
+    /**
+     * @brief For #FleetProvisioningActionSubscribe, the accepted and rejected
+     * topics; for #FleetProvisioningActionPublish, the request topic.
+     */
+    FleetProvisioningSpan_t topics[ 2 ];
+    size_t topicCount; /**< @brief Number of topics used. */
+
+    /**
+     * @brief For #FleetProvisioningActionPublish, the request, as the
+     * publish topic value of #FleetProvisioningTopic_t.
+     */
+    FleetProvisioningTopic_t request;
+    FleetProvisioningSpan_t payload; /**< @brief For #FleetProvisioningActionPublish, the request payload. */
+
+    /**
+     * @brief For the RegisterThing #FleetProvisioningActionPublish, the
+     * credentials of the response that led to it.
+     */
+    FleetProvisioningCredentials_t credentials;
+    FleetProvisioningSpan_t thingName; /**< @brief For #FleetProvisioningActionDone, the name of the thing. */
+} FleetProvisioningAction_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a provisioning session.
+ *
+ * The session provisions one device: it requests credentials with
+ * CreateKeysAndCertificate or CreateCertificateFromCSR, then registers them
+ * with RegisterThing. It does no I/O of its own. The application feeds it
+ * events with #FleetProvisioning_SessionHandleEvent and carries out the
+ * actions it returns, so one thread can drive any number of sessions.
+ *
+ * The RegisterThing topics are written to @p pTopicBuffer once, here. The
+ * requests are built in @p pPayloadBuffer, which must have room for the
+ * CreateCertificateFromCSR request, if any, and for the RegisterThing
+ * request with the longest ownership token expected.
+ *
+ * @param[out] pSession The session to initialize.
+ * @param[in] pConfig The configuration of the session.
+ * @param[in] pTopicBuffer The topic buffer of the session.
+ * @param[in] topicBufferLength The length of @p pTopicBuffer; at most
+ * #FP_SESSION_TOPIC_BUFFER_LENGTH bytes are used.
+ * @param[in] pPayloadBuffer The payload buffer of the session.
+ * @param[in] payloadBufferLength The length of @p pPayloadBuffer.
+ *
+ * @return FleetProvisioningSuccess if the session is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the topic buffer cannot hold the
+ * RegisterThing topics.
+ */
+/* @[declare_fleet_provisioning_sessioninit] */
+FleetProvisioningStatus_t FleetProvisioning_SessionInit( FleetProvisioningSession_t * pSession,
+                                                         const FleetProvisioningSessionConfig_t * pConfig,
+                                                         char * pTopicBuffer,
+                                                         size_t topicBufferLength,
+                                                         char * pPayloadBuffer,
+                                                         size_t payloadBufferLength );
+/* @[declare_fleet_provisioning_sessioninit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Feed an event to a provisioning session, and get the action it
+ * requests in return.
+ *
+ * The function never blocks. A session that is started asks for its
+ * subscriptions, then publishes its requests; the application acknowledges
+ * each subscribe action with #FleetProvisioningEventSubscribed, and arms a
+ * timer for each subscribe or publish action, reporting its expiry with
+ * #FleetProvisioningEventTimeout. An event that does not apply to the
+ * session in its current state, such as a response for another session or a
+ * timeout after the response, yields #FleetProvisioningActionNone.
+ *
+ * The topics and payload of an action point into the session buffers and
+ * stay valid until the next event. The credentials and thing name point into
+ * the payload of the event, so should be stored before the receive buffer is
+ * reused.
+ *
+ * @param[in] pSession The session.
+ * @param[in] pEvent The event.
+ * @param[out] pOutAction The action requested by the session.
+ *
+ * @return FleetProvisioningSuccess if the event is handled;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the event does not apply to the session.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to forward an incoming MQTT publish to
+ * // a provisioning session.
+ *
+ * FleetProvisioningEvent_t event = { 0 };
+ * FleetProvisioningAction_t action;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_MatchTopic( pTopic, topicLength, &( event.topic ) );
+ *
+ * if( status == FleetProvisioningSuccess )
+ * {
+ *      event.type = FleetProvisioningEventMessage;
+ *      event.pPayload = pPayload;
+ *      event.payloadLength = payloadLength;
+ *      status = FleetProvisioning_SessionHandleEvent( &session, &event, &action );
+ * }
+ *
+ * if( ( status == FleetProvisioningSuccess ) &&
+ *     ( action.type == FleetProvisioningActionPublish ) )
+ * {
+ *      // Store action.credentials if not empty, then publish
+ *      // action.payload to action.topics[ 0 ] and arm the response timer.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_sessionhandleevent] */
+FleetProvisioningStatus_t FleetProvisioning_SessionHandleEvent( FleetProvisioningSession_t * pSession,
+                                                                const FleetProvisioningEvent_t * pEvent,
+                                                                FleetProvisioningAction_t * pOutAction );
+/* @[declare_fleet_provisioning_sessionhandleevent] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the publish action of the request a session is waiting a
+ * response for, to publish it again or later.
+ *
+ * The credentials of the response the RegisterThing request was built from
+ * are not included.
+ *
+ * @param[in] pSession The session.
+ * @param[out] pOutAction The publish action.
+ *
+ * @return FleetProvisioningSuccess if the action is returned;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the session is not waiting for a response.
+ */
+/* @[declare_fleet_provisioning_sessiongetrequest] */
+FleetProvisioningStatus_t FleetProvisioning_SessionGetRequest( const FleetProvisioningSession_t * pSession,
+                                                               FleetProvisioningAction_t * pOutAction );
+/* @[declare_fleet_provisioning_sessiongetrequest] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_SESSION_H_ */
@@ -0,0 +1,473 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session_pool.h
+ * @brief Interface for a fixed-capacity pool of AWS IoT Fleet Provisioning
+ * sessions.
+ */
+
+#ifndef FLEET_PROVISIONING_SESSION_POOL_H_
+#define FLEET_PROVISIONING_SESSION_POOL_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning session include. */
+#include "fleet_provisioning_session.h"
+
+/* Fleet Provisioning timer wheel include. */
+#include "fleet_provisioning_timer_wheel.h"
+
+/* Fleet Provisioning rate limiter include. */
+#include "fleet_provisioning_rate_limiter.h"
+
+/* Fleet Provisioning concurrency include. */
+#include "fleet_provisioning_concurrency.h"
+
+/* Fleet Provisioning histogram include. */
+#include "fleet_provisioning_histogram.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief State recorded in #FleetProvisioningSessionPool_t::pStates for a
+ * free session.
+ */
+#define FP_SESSION_STATE_FREE            ( 0xFFU )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Index marking the end of the free list.
+ */
+#define FP_SESSION_POOL_INVALID_INDEX    ( 0xFFFFFFFFU )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Value of #FleetProvisioningSessionPool_t::pQueues for a session
+ * whose request is not deferred.
+ */
+#define FP_SESSION_POOL_NOT_QUEUED       ( 0xFFU )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Arena bytes used by each session of a pool.
+ */
+#define FP_SESSION_POOL_SLOT_LENGTH                                   \
+    ( sizeof( FleetProvisioningSession_t ) +                          \
+      sizeof( FleetProvisioningTimerNode_t ) +                        \
+      ( 2U * sizeof( uint32_t ) ) + 2U +                              \
+      FP_SESSION_TOPIC_BUFFER_LENGTH + FP_SESSION_PAYLOAD_BUFFER_LENGTH )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Length of the arena needed for a pool of the given capacity.
+ *
+ * @param capacity The number of sessions in the pool.
+ */
+#define FP_SESSION_POOL_ARENA_LENGTH( capacity )    ( ( capacity ) * FP_SESSION_POOL_SLOT_LENGTH )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A fixed-capacity pool of provisioning sessions.
+ *
+ * All the memory of the pool is carved from one arena at initialization, as
+ * separate arrays: the sessions, their timeout timers, the free and deferred
+ * lists, the publish ticks of their requests, the session states, the
+ * deferred queues of the sessions and the session buffers. Sweeping all
+ * sessions for their state only touches the one byte per session array
+ * @p pStates.
+ *
+ * Initialized by #FleetProvisioning_SessionPoolInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningSessionPool
+{
+    FleetProvisioningSession_t * pSessions; /**< @brief The sessions. */
+
+    /**
+     * @brief State of each session, as a #FleetProvisioningSessionState_t,
+     * or #FP_SESSION_STATE_FREE.
+     */
+    uint8_t * pStates;
+    uint32_t * pNext;       /**< @brief Next session in the free list or in a deferred queue. */
+    uint32_t * pSentTicks;  /**< @brief Tick of the last request published by each session. */
+
+    /**
+     * @brief Deferred queue holding each session, as a
+     * #FleetProvisioningApi_t, or #FP_SESSION_POOL_NOT_QUEUED.
+     */
+    uint8_t * pQueues;
+    char * pTopicBuffers;   /**< @brief Topic buffers, #FP_SESSION_TOPIC_BUFFER_LENGTH bytes each. */
+    char * pPayloadBuffers; /**< @brief Payload buffers, #FP_SESSION_PAYLOAD_BUFFER_LENGTH bytes each. */
+    uint32_t capacity;      /**< @brief Number of sessions. */
+    uint32_t freeHead;      /**< @brief First free session, or #FP_SESSION_POOL_INVALID_INDEX. */
+    uint32_t inUseCount;    /**< @brief Number of acquired sessions. */
+    uint32_t timeoutTicks;  /**< @brief Response timeout of the sessions, or 0 for none. */
+
+    /**
+     * @brief Timeout timers of the sessions, with the same indexes as the
+     * sessions.
+     */
+    FleetProvisioningTimerWheel_t wheel;
+
+    /**
+     * @brief Rate limiter of the publishes, or NULL for none.
+     */
+    FleetProvisioningRateLimiter_t * pLimiter;
+    uint32_t queueHeads[ FP_API_COUNT ]; /**< @brief First session of each deferred queue. */
+    uint32_t queueTails[ FP_API_COUNT ]; /**< @brief Last session of each deferred queue. */
+    uint32_t nextQueue;                  /**< @brief New flow queue served first by the next new flow. */
+
+    /**
+     * @brief RegisterThing requests sent in a row while a new flow waited.
+     */
+    uint32_t registerStreak;
+
+    /**
+     * @brief Concurrency controller of the acquired sessions, or NULL for
+     * none.
+     */
+    FleetProvisioningConcurrency_t * pConcurrency;
+
+    /**
+     * @brief Latency histograms of the requests, or NULL for none.
+     */
+    FleetProvisioningLatency_t * pLatency;
+} FleetProvisioningSessionPool_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a session pool in an arena.
+ *
+ * No other memory is used by the pool. The arena must be aligned as for a
+ * pointer, for example by declaring it as an array of `uint64_t`.
+ *
+ * With a timeout, each session is given @p timeoutTicks ticks to get the
+ * response to each of its subscriptions and requests, counted in the ticks
+ * passed to #FleetProvisioning_SessionPoolTick.
+ *
+ * @param[out] pPool The pool to initialize.
+ * @param[in] pArena The arena.
+ * @param[in] arenaLength The length of @p pArena.
+ * @param[in] capacity The number of sessions.
+ * @param[in] timeoutTicks The response timeout, below 2^31, or 0 for none.
+ *
+ * @return FleetProvisioningSuccess if the pool is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the arena is shorter than
+ * #FP_SESSION_POOL_ARENA_LENGTH.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to set up a pool for a gateway that
+ * // provisions up to 1000 devices at once.
+ *
+ * // With 10 ms ticks, each response is given 5 seconds.
+ *
+ * #define MAX_SESSIONS     1000U
+ * #define TIMEOUT_TICKS    500U
+ *
+ * static uint64_t arena[ ( FP_SESSION_POOL_ARENA_LENGTH( MAX_SESSIONS ) + 7U ) / 8U ];
+ * static FleetProvisioningSessionPool_t pool;
+ * FleetProvisioningStatus_t status;
+ *
+ * status = FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ),
+ *                                             MAX_SESSIONS, TIMEOUT_TICKS );
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_sessionpoolinit] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolInit( FleetProvisioningSessionPool_t * pPool,
+                                                             void * pArena,
+                                                             size_t arenaLength,
+                                                             size_t capacity,
+                                                             uint32_t timeoutTicks );
+/* @[declare_fleet_provisioning_sessionpoolinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Take a free session from a pool and initialize it.
+ *
+ * The session gets the buffers of its slot in the arena, so its CSR and
+ * parameters must be within #FP_SESSION_MAX_CSR_LENGTH and
+ * #FP_SESSION_MAX_PARAMETERS_LENGTH. It is then driven with
+ * #FleetProvisioning_SessionPoolHandleEvent.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] pConfig The configuration of the session.
+ * @param[out] pOutIndex The index of the session.
+ *
+ * @return FleetProvisioningSuccess if a session is acquired;
+ * FleetProvisioningBadParameter if invalid parameters are passed, including
+ * a configuration beyond the session limits;
+ * FleetProvisioningBufferTooSmall if no session is free;
+ * FleetProvisioningNoMatch if the concurrency controller of the pool allows
+ * no more sessions in flight.
+ */
+/* @[declare_fleet_provisioning_sessionpoolacquire] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolAcquire( FleetProvisioningSessionPool_t * pPool,
+                                                                const FleetProvisioningSessionConfig_t * pConfig,
+                                                                uint32_t * pOutIndex );
+/* @[declare_fleet_provisioning_sessionpoolacquire] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Return a session to its pool.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ *
+ * @return FleetProvisioningSuccess if the session is released;
+ * FleetProvisioningBadParameter if invalid parameters are passed, including
+ * a session that is not acquired.
+ */
+/* @[declare_fleet_provisioning_sessionpoolrelease] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolRelease( FleetProvisioningSessionPool_t * pPool,
+                                                                uint32_t index );
+/* @[declare_fleet_provisioning_sessionpoolrelease] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Feed an event to a session of a pool.
+ *
+ * This is #FleetProvisioning_SessionHandleEvent for pooled sessions, which
+ * also keeps @p pStates up to date. With a timeout, the timer of the session
+ * is armed by each subscribe or publish action, and cancelled when the
+ * session ends.
+ *
+ * With a rate limiter, a publish action is only returned if the API of the
+ * request has a token, and no older request of that API is deferred. The
+ * first request of a flow also waits while RegisterThing requests are
+ * deferred.
+ * Otherwise #FleetProvisioningActionDeferred is returned, and the publish
+ * is returned later by #FleetProvisioning_SessionPoolNextPublish.
+ *
+ * With a concurrency controller, each response handled by the session is
+ * passed to #FleetProvisioning_ConcurrencyOnResponse.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] index The index of the session.
+ * @param[in] pEvent The event.
+ * @param[out] pOutAction The action requested by the session.
+ *
+ * @return The status of #FleetProvisioning_SessionHandleEvent;
+ * FleetProvisioningBadParameter if the session is not acquired.
+ */
+/* @[declare_fleet_provisioning_sessionpoolhandleevent] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolHandleEvent( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t index,
+                                                                    const FleetProvisioningEvent_t * pEvent,
+                                                                    FleetProvisioningAction_t * pOutAction );
+/* @[declare_fleet_provisioning_sessionpoolhandleevent] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Advance the timeout timers of a pool to the given tick.
+ *
+ * The sessions that time out are then returned by
+ * #FleetProvisioning_SessionPoolNextTimeout. The cost does not depend on the
+ * number of pending timeouts.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] now The current tick, counted from the initialization of the
+ * pool.
+ *
+ * @return FleetProvisioningSuccess if the timers are advanced;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_sessionpooltick] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolTick( FleetProvisioningSessionPool_t * pPool,
+                                                             uint32_t now );
+/* @[declare_fleet_provisioning_sessionpooltick] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Feed #FleetProvisioningEventTimeout to the next session that timed
+ * out.
+ *
+ * @param[in] pPool The pool.
+ * @param[out] pOutIndex The index of the session.
+ * @param[out] pOutAction The action requested by the session.
+ *
+ * @return FleetProvisioningSuccess if a session timed out;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if no more sessions timed out.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to handle the timeouts of a pool
+ * // from a periodic task.
+ *
+ * FleetProvisioningAction_t action;
+ * uint32_t index;
+ *
+ * ( void ) FleetProvisioning_SessionPoolTick( &pool, ticksSinceStart );
+ *
+ * while( FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) == FleetProvisioningSuccess )
+ * {
+ *      // action.type is FleetProvisioningActionFailed: report the device
+ *      // of session index, and release the session.
+ *      ( void ) FleetProvisioning_SessionPoolRelease( &pool, index );
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_sessionpoolnexttimeout] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolNextTimeout( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t * pOutIndex,
+                                                                    FleetProvisioningAction_t * pOutAction );
+/* @[declare_fleet_provisioning_sessionpoolnexttimeout] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Set the rate limiter gating the publishes of a pool.
+ *
+ * The rate limiter works in the ticks of the pool, counted from the
+ * initialization of the pool and passed to
+ * #FleetProvisioning_SessionPoolTick.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] pLimiter The rate limiter, or NULL to publish without limit.
+ *
+ * @return FleetProvisioningSuccess if the rate limiter is set;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_sessionpoolsetratelimiter] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetRateLimiter( FleetProvisioningSessionPool_t * pPool,
+                                                                       FleetProvisioningRateLimiter_t * pLimiter );
+/* @[declare_fleet_provisioning_sessionpoolsetratelimiter] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Set the concurrency controller limiting the sessions in flight in
+ * a pool.
+ *
+ * Each acquired session is counted as in flight until it is released, and
+ * the responses of the sessions adjust the limit.
+ *
+ * @param[in] pPool The pool, with no session acquired.
+ * @param[in] pController The controller, or NULL to only be limited by the
+ * capacity of the pool.
+ *
+ * @return FleetProvisioningSuccess if the controller is set;
+ * FleetProvisioningBadParameter if invalid parameters are passed, including
+ * a pool with sessions acquired.
+ */
+/* @[declare_fleet_provisioning_sessionpoolsetconcurrency] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetConcurrency( FleetProvisioningSessionPool_t * pPool,
+                                                                       FleetProvisioningConcurrency_t * pController );
+/* @[declare_fleet_provisioning_sessionpoolsetconcurrency] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Take the next deferred publish whose API has a token.
+ *
+ * Each API keeps its deferred requests in order. Deferred RegisterThing
+ * requests go first, so that sessions holding a certificate complete before
+ * new flows start; after #FP_SESSION_POOL_STARVATION_LIMIT of them in a row,
+ * a waiting new flow gets a turn. The CreateCertificateFromCSR and
+ * CreateKeysAndCertificate requests that start new flows take turns. The
+ * timeout of the session starts with the publish.
+ *
+ * @param[in] pPool The pool.
+ * @param[out] pOutIndex The index of the session.
+ * @param[out] pOutAction The publish action, without credentials.
+ *
+ * @return FleetProvisioningSuccess if a publish is returned;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if no deferred publish can go out yet.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to send the deferred publishes of a
+ * // pool from a periodic task.
+ *
+ * FleetProvisioningAction_t action;
+ * uint32_t index;
+ *
+ * ( void ) FleetProvisioning_SessionPoolTick( &pool, ticksSinceStart );
+ *
+ * while( FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) == FleetProvisioningSuccess )
+ * {
+ *      // Publish action.payload to action.topics[ 0 ].
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_sessionpoolnextpublish] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolNextPublish( FleetProvisioningSessionPool_t * pPool,
+                                                                    uint32_t * pOutIndex,
+                                                                    FleetProvisioningAction_t * pOutAction );
+/* @[declare_fleet_provisioning_sessionpoolnextpublish] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Set the latency histograms the pool records its requests in.
+ *
+ * For each response handled by a session, the pool records the ticks since
+ * the session published its request, in the histogram of the response topic
+ * in #FleetProvisioningLatency_t::responseTicks. Requests held back by the
+ * rate limiter are counted from their publish, so the time spent deferred
+ * is not included. The cycles taken by the session to handle the response
+ * are recorded in #FleetProvisioningLatency_t::handleCycles.
+ *
+ * @param[in] pPool The pool.
+ * @param[in] pLatency The histograms, or NULL to record nothing.
+ *
+ * @return FleetProvisioningSuccess if the histograms are set;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_sessionpoolsetlatency] */
+FleetProvisioningStatus_t FleetProvisioning_SessionPoolSetLatency( FleetProvisioningSessionPool_t * pPool,
+                                                                   FleetProvisioningLatency_t * pLatency );
+/* @[declare_fleet_provisioning_sessionpoolsetlatency] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_SESSION_POOL_H_ */
@@ -0,0 +1,211 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_shard.h
+ * @brief Interface for spreading AWS IoT Fleet Provisioning sessions over
+ * worker threads.
+ */
+
+#ifndef FLEET_PROVISIONING_SHARD_H_
+#define FLEET_PROVISIONING_SHARD_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning session include. */
+#include "fleet_provisioning_session.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief The most slots of a shard queue.
+ */
+#define FP_SHARD_QUEUE_MAX_SLOTS    ( 0x80000000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A slot of a shard queue.
+ */
+typedef struct FleetProvisioningShardSlot
+{
+    uint32_t sequence;              /**< @brief Queue position the slot is ready for. */
+    uint32_t tag;                   /**< @brief Application value identifying the session of the event. */
+    FleetProvisioningEvent_t event; /**< @brief The queued event. Its payload is not copied. */
+} FleetProvisioningShardSlot_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A bounded queue handing session events to the worker thread that
+ * owns a shard of the sessions.
+ *
+ * Each worker owns a shard: a session pool and a timer wheel that only it
+ * uses, so that sessions are driven without locks. The I/O thread matches
+ * each incoming message to its session, for example with a correlator, and
+ * pushes it onto the queue of the session's shard. Any number of threads may
+ * push onto a queue; only its worker may pop from it.
+ *
+ * The queue takes no lock. Its shared state is accessed through
+ * #FP_ATOMIC_LOAD_ACQUIRE, #FP_ATOMIC_STORE_RELEASE and
+ * #FP_ATOMIC_COMPARE_AND_SWAP, which must be defined for the target when
+ * the queue is used by more than one thread.
+ *
+ * Initialized by #FleetProvisioning_ShardQueueInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningShardQueue
+{
+    FleetProvisioningShardSlot_t * pSlots; /**< @brief Slots, provided by the application. */
+    uint32_t mask;                         /**< @brief Number of slots minus one. */
+    uint32_t popPosition;                  /**< @brief Position of the next event to pop, used by the worker only. */
+    uint32_t pushPosition;                 /**< @brief Position of the next event to push, shared by the pushing threads. */
+} FleetProvisioningShardQueue_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Choose the shard of a session from a key that identifies its
+ * device, such as a serial number.
+ *
+ * The same key always gives the same shard for a given shard count, and
+ * keys are spread evenly over the shards.
+ *
+ * @param[in] pKey The key.
+ * @param[in] keyLength The length of @p pKey.
+ * @param[in] shardCount The number of shards.
+ * @param[out] pOutShard The shard of the key, below @p shardCount.
+ *
+ * @return FleetProvisioningSuccess if the shard is chosen;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_getshard] */
+FleetProvisioningStatus_t FleetProvisioning_GetShard( const char * pKey,
+                                                      size_t keyLength,
+                                                      uint32_t shardCount,
+                                                      uint32_t * pOutShard );
+/* @[declare_fleet_provisioning_getshard] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize an empty shard queue.
+ *
+ * Must be called before any thread uses the queue.
+ *
+ * @param[out] pQueue The queue to initialize.
+ * @param[in] pSlots The slots of the queue, which must stay valid for as
+ * long as the queue is used.
+ * @param[in] slotCount The number of slots, a power of two from 2 to
+ * #FP_SHARD_QUEUE_MAX_SLOTS. The queue holds up to this many events.
+ *
+ * @return FleetProvisioningSuccess if the queue is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_shardqueueinit] */
+FleetProvisioningStatus_t FleetProvisioning_ShardQueueInit( FleetProvisioningShardQueue_t * pQueue,
+                                                            FleetProvisioningShardSlot_t * pSlots,
+                                                            uint32_t slotCount );
+/* @[declare_fleet_provisioning_shardqueueinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Push an event for a session onto a shard queue.
+ *
+ * May be called from any thread. The payload of the event is not copied,
+ * and must stay valid until the worker has handled the event.
+ *
+ * @param[in] pQueue The queue.
+ * @param[in] tag Application value identifying the session, such as its
+ * index in the session pool of the shard.
+ * @param[in] pEvent The event.
+ *
+ * @return FleetProvisioningSuccess if the event is queued;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningBufferTooSmall if the queue is full.
+ */
+/* @[declare_fleet_provisioning_shardqueuepush] */
+FleetProvisioningStatus_t FleetProvisioning_ShardQueuePush( FleetProvisioningShardQueue_t * pQueue,
+                                                            uint32_t tag,
+                                                            const FleetProvisioningEvent_t * pEvent );
+/* @[declare_fleet_provisioning_shardqueuepush] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Pop the oldest event of a shard queue.
+ *
+ * Must only be called by the worker thread of the shard.
+ *
+ * @param[in] pQueue The queue.
+ * @param[out] pOutTag The tag the event was pushed with.
+ * @param[out] pOutEvent The event.
+ *
+ * @return FleetProvisioningSuccess if an event is popped;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the queue is empty, or the oldest event is
+ * still being pushed.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows the loop of a worker thread, which drives
+ * // the sessions of its shard.
+ *
+ * FleetProvisioningEvent_t event;
+ * FleetProvisioningAction_t action;
+ * uint32_t index;
+ *
+ * while( FleetProvisioning_ShardQueuePop( &shard->queue, &index, &event ) == FleetProvisioningSuccess )
+ * {
+ *      if( FleetProvisioning_SessionPoolHandleEvent( &shard->pool, index, &event, &action ) == FleetProvisioningSuccess )
+ *      {
+ *          // Carry out the action.
+ *      }
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_shardqueuepop] */
+FleetProvisioningStatus_t FleetProvisioning_ShardQueuePop( FleetProvisioningShardQueue_t * pQueue,
+                                                           uint32_t * pOutTag,
+                                                           FleetProvisioningEvent_t * pOutEvent );
+/* @[declare_fleet_provisioning_shardqueuepop] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_SHARD_H_ */
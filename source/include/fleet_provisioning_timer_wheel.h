@@ -0,0 +1,232 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_timer_wheel.h
+ * @brief Interface for the hierarchical timer wheel used for AWS IoT Fleet
+ * Provisioning request timeouts.
+ */
+
+#ifndef FLEET_PROVISIONING_TIMER_WHEEL_H_
+#define FLEET_PROVISIONING_TIMER_WHEEL_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of bits of a tick count handled by each level of a timer
+ * wheel.
+ */
+#define FP_TIMER_WHEEL_SLOT_BITS        ( 6U )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of slots in each level of a timer wheel.
+ */
+#define FP_TIMER_WHEEL_SLOTS            ( 1U << FP_TIMER_WHEEL_SLOT_BITS )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Index of no timer.
+ */
+#define FP_TIMER_WHEEL_INVALID_TIMER    ( 0xFFFFFFFFU )
+
+/**
+ * @ingroup fleet_provisioning_constants
+ * @brief Number of timer lists of a timer wheel: one for each slot, and one
+ * for the expired timers.
+ */
+#define FP_TIMER_WHEEL_LISTS            ( ( FP_TIMER_WHEEL_LEVELS * FP_TIMER_WHEEL_SLOTS ) + 1U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A timer of a timer wheel.
+ *
+ * The members are private to the timer wheel.
+ */
+typedef struct FleetProvisioningTimerNode
+{
+    uint32_t next;   /**< @brief Next timer in the same list. */
+    uint32_t prev;   /**< @brief Previous timer in the same list. */
+    uint32_t expiry; /**< @brief Tick the timer expires at. */
+    uint16_t list;   /**< @brief List holding the timer, if armed. */
+} FleetProvisioningTimerNode_t;
+
+/**
+ * @ingroup fleet_provisioning_struct_types
+ * @brief A hashed hierarchical timer wheel.
+ *
+ * Each level has #FP_TIMER_WHEEL_SLOTS slots, and each slot of a level spans
+ * as many ticks as a whole turn of the level below. A timer is placed in the
+ * slot of the lowest level that can hold its expiry; it moves down a level
+ * when the wheel reaches its slot, and is expired when it reaches level 0.
+ * Arming and cancelling are O(1), and each tick visits one slot per level.
+ *
+ * Initialized by #FleetProvisioning_TimerWheelInit. The members should not
+ * be modified by the application.
+ */
+typedef struct FleetProvisioningTimerWheel
+{
+    FleetProvisioningTimerNode_t * pNodes;   /**< @brief The timers. */
+    uint32_t timerCount;                     /**< @brief Number of timers. */
+    uint32_t now;                            /**< @brief Last tick processed. */
+    uint32_t pendingCount;                   /**< @brief Number of timers armed and not expired. */
+    uint32_t expiredTail;                    /**< @brief Last timer of the expired list. */
+    uint32_t heads[ FP_TIMER_WHEEL_LISTS ];  /**< @brief First timer of each list. */
+} FleetProvisioningTimerWheel_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize a timer wheel.
+ *
+ * The wheel starts at tick 0, so ticks passed to
+ * #FleetProvisioning_TimerWheelAdvance count from initialization.
+ *
+ * @param[out] pWheel The timer wheel to initialize.
+ * @param[in] pNodes The timers, one for each object that can time out.
+ * @param[in] timerCount The number of timers in @p pNodes.
+ *
+ * @return FleetProvisioningSuccess if the wheel is initialized;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_timerwheelinit] */
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelInit( FleetProvisioningTimerWheel_t * pWheel,
+                                                            FleetProvisioningTimerNode_t * pNodes,
+                                                            size_t timerCount );
+/* @[declare_fleet_provisioning_timerwheelinit] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Arm a timer, or re-arm it if already armed.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] timer The index of the timer.
+ * @param[in] delayTicks The number of ticks from the current tick to the
+ * expiry, at least 1 and below 2^31.
+ *
+ * @return FleetProvisioningSuccess if the timer is armed;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_timerwheelarm] */
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelArm( FleetProvisioningTimerWheel_t * pWheel,
+                                                           uint32_t timer,
+                                                           uint32_t delayTicks );
+/* @[declare_fleet_provisioning_timerwheelarm] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Cancel a timer, whether pending or expired and not yet popped.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] timer The index of the timer.
+ *
+ * @return FleetProvisioningSuccess if the timer is cancelled;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if the timer is not armed.
+ */
+/* @[declare_fleet_provisioning_timerwheelcancel] */
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelCancel( FleetProvisioningTimerWheel_t * pWheel,
+                                                              uint32_t timer );
+/* @[declare_fleet_provisioning_timerwheelcancel] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Advance a timer wheel to the given tick, moving the timers that
+ * expire on the way to the expired list.
+ *
+ * The cost is one slot per level for each tick advanced, plus each timer
+ * moved, whatever the number of pending timers. When no timer is pending,
+ * the wheel jumps straight to @p now.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[in] now The current tick, counted from initialization. Ticks from
+ * the past are ignored.
+ *
+ * @return FleetProvisioningSuccess if the wheel is advanced;
+ * FleetProvisioningBadParameter if invalid parameters are passed.
+ */
+/* @[declare_fleet_provisioning_timerwheeladvance] */
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelAdvance( FleetProvisioningTimerWheel_t * pWheel,
+                                                               uint32_t now );
+/* @[declare_fleet_provisioning_timerwheeladvance] */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Take the next expired timer, in expiry order.
+ *
+ * @param[in] pWheel The timer wheel.
+ * @param[out] pOutTimer The index of the timer.
+ *
+ * @return FleetProvisioningSuccess if a timer is returned;
+ * FleetProvisioningBadParameter if invalid parameters are passed;
+ * FleetProvisioningNoMatch if no timer has expired.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The following example shows how to handle the timeouts of each tick
+ * // as one batch.
+ *
+ * uint32_t timer;
+ *
+ * ( void ) FleetProvisioning_TimerWheelAdvance( &wheel, ticksSinceStart );
+ *
+ * while( FleetProvisioning_TimerWheelPopExpired( &wheel, &timer ) == FleetProvisioningSuccess )
+ * {
+ *      // Handle the timeout of the object with index timer.
+ * }
+ * @endcode
+ */
+/* @[declare_fleet_provisioning_timerwheelpopexpired] */
+FleetProvisioningStatus_t FleetProvisioning_TimerWheelPopExpired( FleetProvisioningTimerWheel_t * pWheel,
+                                                                  uint32_t * pOutTimer );
+/* @[declare_fleet_provisioning_timerwheelpopexpired] */
+
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* FLEET_PROVISIONING_TIMER_WHEEL_H_ */
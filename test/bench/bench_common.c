@@ -0,0 +1,367 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file bench_common.c
+ * @brief Implementation of the helpers shared by the AWS IoT Fleet
+ * Provisioning benchmarks.
+ */
+
+/* For clock_gettime and nanosleep. */
+#define _POSIX_C_SOURCE    199309L
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    #include <x86intrin.h>
+#endif
+
+#include "bench_common.h"
+
+/**
+ * @brief Size of the buffer written to evict the caches. Larger than the
+ * last-level cache of current server CPUs.
+ */
+#define EVICTION_BUFFER_SIZE    ( 64U * 1024U * 1024U )
+
+/**
+ * @brief Stride of the eviction writes: one cache line.
+ */
+#define CACHE_LINE_SIZE         ( 64U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Buffer written to evict the caches, allocated on first use.
+ */
+static volatile uint8_t * pEvictionBuffer = NULL;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Order doubles for qsort.
+ */
+static int compareDoubles( const void * pLeft,
+                           const void * pRight );
+
+/**
+ * @brief Time one call of an operation.
+ *
+ * @param[in] function The operation.
+ * @param[in] pContext Passed to @p function.
+ * @param[out] pNs The time taken.
+ * @param[out] pCycles The cycles taken.
+ */
+static void timeOnce( BenchFunction_t function,
+                      void * pContext,
+                      double * pNs,
+                      double * pCycles );
+
+/**
+ * @brief An operation that does nothing, timed to remove the cost of the
+ * timing itself.
+ */
+static void emptyOperation( void * pContext );
+
+/*-----------------------------------------------------------*/
+
+static int compareDoubles( const void * pLeft,
+                           const void * pRight )
+{
+    double left = *( const double * ) pLeft;
+    double right = *( const double * ) pRight;
+
+    return ( left > right ) - ( left < right );
+}
+/*-----------------------------------------------------------*/
+
+static void timeOnce( BenchFunction_t function,
+                      void * pContext,
+                      double * pNs,
+                      double * pCycles )
+{
+    uint64_t startNs = Bench_NowNs();
+    uint64_t startCycles = Bench_ReadCycles();
+
+    function( pContext );
+
+    *pCycles = ( double ) ( Bench_ReadCycles() - startCycles );
+    *pNs = ( double ) ( Bench_NowNs() - startNs );
+}
+/*-----------------------------------------------------------*/
+
+static void emptyOperation( void * pContext )
+{
+    ( void ) pContext;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t Bench_NowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+void Bench_SleepUntilNs( uint64_t targetNs )
+{
+    struct timespec delay;
+    uint64_t nowNs = Bench_NowNs();
+
+    while( nowNs < targetNs )
+    {
+        delay.tv_sec = ( time_t ) ( ( targetNs - nowNs ) / 1000000000U );
+        delay.tv_nsec = ( long ) ( ( targetNs - nowNs ) % 1000000000U );
+        ( void ) nanosleep( &delay, NULL );
+        nowNs = Bench_NowNs();
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint64_t Bench_ReadCycles( void )
+{
+    #if defined( __x86_64__ ) || defined( __i386__ )
+        return ( uint64_t ) __rdtsc();
+    #else
+        return 0U;
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+int Bench_HasCycleCounter( void )
+{
+    #if defined( __x86_64__ ) || defined( __i386__ )
+        return 1;
+    #else
+        return 0;
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+void Bench_EvictCaches( void )
+{
+    size_t i;
+
+    if( pEvictionBuffer == NULL )
+    {
+        pEvictionBuffer = malloc( EVICTION_BUFFER_SIZE );
+
+        if( pEvictionBuffer == NULL )
+        {
+            fprintf( stderr, "Cannot allocate the cache eviction buffer.\n" );
+            exit( EXIT_FAILURE );
+        }
+    }
+
+    for( i = 0U; i < EVICTION_BUFFER_SIZE; i += CACHE_LINE_SIZE )
+    {
+        pEvictionBuffer[ i ] = ( uint8_t ) ( pEvictionBuffer[ i ] + 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void Bench_Run( const BenchSettings_t * pSettings,
+                const char * pName,
+                BenchFunction_t function,
+                void * pContext,
+                BenchResult_t * pResult )
+{
+    double * pNs = malloc( pSettings->coldSamples * sizeof( double ) );
+    double * pCycles = malloc( pSettings->coldSamples * sizeof( double ) );
+    double overheadNs;
+    double overheadCycles;
+    uint64_t startNs;
+    uint64_t startCycles;
+    uint32_t i;
+
+    if( ( pNs == NULL ) || ( pCycles == NULL ) || ( pSettings->coldSamples == 0U ) ||
+        ( pSettings->warmIterations == 0U ) )
+    {
+        fprintf( stderr, "Invalid benchmark settings.\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    ( void ) memset( pResult, 0, sizeof( BenchResult_t ) );
+    ( void ) strncpy( pResult->name, pName, BENCH_MAX_NAME_LENGTH - 1U );
+
+    /* Warm: one call to load the caches, then many calls back to back. */
+    function( pContext );
+    startNs = Bench_NowNs();
+    startCycles = Bench_ReadCycles();
+
+    for( i = 0U; i < pSettings->warmIterations; i++ )
+    {
+        function( pContext );
+    }
+
+    pResult->warmCyclesPerOp = ( double ) ( Bench_ReadCycles() - startCycles ) / pSettings->warmIterations;
+    pResult->warmNsPerOp = ( double ) ( Bench_NowNs() - startNs ) / pSettings->warmIterations;
+
+    /* Cold: the median of single calls after evicting the caches, less the
+     * median cost of timing an empty call the same way. */
+    for( i = 0U; i < pSettings->coldSamples; i++ )
+    {
+        Bench_EvictCaches();
+        timeOnce( emptyOperation, NULL, &( pNs[ i ] ), &( pCycles[ i ] ) );
+    }
+
+    qsort( pNs, pSettings->coldSamples, sizeof( double ), compareDoubles );
+    qsort( pCycles, pSettings->coldSamples, sizeof( double ), compareDoubles );
+    overheadNs = pNs[ pSettings->coldSamples / 2U ];
+    overheadCycles = pCycles[ pSettings->coldSamples / 2U ];
+
+    for( i = 0U; i < pSettings->coldSamples; i++ )
+    {
+        Bench_EvictCaches();
+        timeOnce( function, pContext, &( pNs[ i ] ), &( pCycles[ i ] ) );
+    }
+
+    qsort( pNs, pSettings->coldSamples, sizeof( double ), compareDoubles );
+    qsort( pCycles, pSettings->coldSamples, sizeof( double ), compareDoubles );
+    pResult->coldNsPerOp = pNs[ pSettings->coldSamples / 2U ] - overheadNs;
+    pResult->coldCyclesPerOp = pCycles[ pSettings->coldSamples / 2U ] - overheadCycles;
+
+    if( pResult->coldNsPerOp < 0.0 )
+    {
+        pResult->coldNsPerOp = 0.0;
+    }
+
+    if( pResult->coldCyclesPerOp < 0.0 )
+    {
+        pResult->coldCyclesPerOp = 0.0;
+    }
+
+    if( Bench_HasCycleCounter() == 0 )
+    {
+        pResult->warmCyclesPerOp = -1.0;
+        pResult->coldCyclesPerOp = -1.0;
+    }
+
+    free( pNs );
+    free( pCycles );
+}
+/*-----------------------------------------------------------*/
+
+double Bench_Percentile( double * pValues,
+                         size_t count,
+                         double percent )
+{
+    double rank = ( percent / 100.0 ) * ( double ) count;
+    size_t index = ( size_t ) rank;
+    double value = 0.0;
+
+    if( count > 0U )
+    {
+        qsort( pValues, count, sizeof( double ), compareDoubles );
+
+        /* Nearest rank: the sample at the rounded up rank, counted from 1. */
+        if( ( ( double ) index == rank ) && ( index > 0U ) )
+        {
+            index--;
+        }
+
+        value = pValues[ ( index < count ) ? index : ( count - 1U ) ];
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+void Bench_WriteJson( FILE * pFile,
+                      const BenchResult_t * pResults,
+                      size_t resultCount )
+{
+    size_t i;
+
+    fprintf( pFile, "{\n  \"benchmarks\": [\n" );
+
+    for( i = 0U; i < resultCount; i++ )
+    {
+        fprintf( pFile,
+                 "    { \"name\": \"%s\", \"warm_ns_per_op\": %.2f, \"warm_cycles_per_op\": %.1f, "
+                 "\"cold_ns_per_op\": %.2f, \"cold_cycles_per_op\": %.1f }%s\n",
+                 pResults[ i ].name,
+                 pResults[ i ].warmNsPerOp,
+                 pResults[ i ].warmCyclesPerOp,
+                 pResults[ i ].coldNsPerOp,
+                 pResults[ i ].coldCyclesPerOp,
+                 ( ( i + 1U ) < resultCount ) ? "," : "" );
+    }
+
+    fprintf( pFile, "  ]\n}\n" );
+}
+/*-----------------------------------------------------------*/
+
+int Bench_CheckBaseline( const char * pBaselinePath,
+                         const BenchResult_t * pResults,
+                         size_t resultCount,
+                         double tolerancePercent )
+{
+    FILE * pFile = fopen( pBaselinePath, "r" );
+    char line[ 512 ];
+    char name[ BENCH_MAX_NAME_LENGTH ];
+    double baselineNs;
+    int regressions = 0;
+    size_t i;
+
+    if( pFile == NULL )
+    {
+        fprintf( stderr, "Cannot open the baseline %s.\n", pBaselinePath );
+        regressions = -1;
+    }
+
+    while( ( pFile != NULL ) && ( fgets( line, sizeof( line ), pFile ) != NULL ) )
+    {
+        /* Lines other than benchmarks do not match. */
+        if( sscanf( line, " { \"name\": \"%95[^\"]\", \"warm_ns_per_op\": %lf", name, &baselineNs ) != 2 )
+        {
+            continue;
+        }
+
+        for( i = 0U; i < resultCount; i++ )
+        {
+            if( ( strcmp( name, pResults[ i ].name ) == 0 ) &&
+                ( pResults[ i ].warmNsPerOp > ( baselineNs * ( 1.0 + ( tolerancePercent / 100.0 ) ) ) ) )
+            {
+                fprintf( stderr, "%s: %.2f ns/op, baseline %.2f ns/op.\n",
+                         name, pResults[ i ].warmNsPerOp, baselineNs );
+                regressions++;
+            }
+        }
+    }
+
+    if( pFile != NULL )
+    {
+        ( void ) fclose( pFile );
+    }
+
+    return regressions;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,170 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file bench_common.h
+ * @brief Timing, cache eviction and reporting helpers shared by the AWS IoT
+ * Fleet Provisioning benchmarks.
+ */
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Longest benchmark name, including the terminating null character.
+ */
+#define BENCH_MAX_NAME_LENGTH    ( 96U )
+
+/**
+ * @brief An operation to measure.
+ *
+ * @param[in] pContext The context the benchmark was registered with.
+ */
+typedef void ( * BenchFunction_t )( void * pContext );
+
+/**
+ * @brief Measurements of one benchmark.
+ *
+ * Cycle counts are only measured on targets with a cycle counter; elsewhere
+ * they are negative.
+ */
+typedef struct BenchResult
+{
+    char name[ BENCH_MAX_NAME_LENGTH ]; /**< @brief Name of the benchmark. */
+    double warmNsPerOp;                 /**< @brief Mean time per operation, with the operation in cache. */
+    double warmCyclesPerOp;             /**< @brief Mean cycles per operation, with the operation in cache. */
+    double coldNsPerOp;                 /**< @brief Median time of one operation, after evicting the caches. */
+    double coldCyclesPerOp;             /**< @brief Median cycles of one operation, after evicting the caches. */
+} BenchResult_t;
+
+/**
+ * @brief Settings of a benchmark run.
+ */
+typedef struct BenchSettings
+{
+    uint32_t warmIterations; /**< @brief Operations timed together for the warm measurement. */
+    uint32_t coldSamples;    /**< @brief Operations timed one by one for the cold measurement. */
+} BenchSettings_t;
+
+/**
+ * @brief Read a monotonic clock.
+ *
+ * @return The time in nanoseconds.
+ */
+uint64_t Bench_NowNs( void );
+
+/**
+ * @brief Sleep until the monotonic clock reaches a time.
+ *
+ * @param[in] targetNs The time, as read by #Bench_NowNs.
+ */
+void Bench_SleepUntilNs( uint64_t targetNs );
+
+/**
+ * @brief Read the cycle counter of the CPU.
+ *
+ * @return The cycle count, or 0 if the target has no cycle counter.
+ */
+uint64_t Bench_ReadCycles( void );
+
+/**
+ * @brief Check whether #Bench_ReadCycles counts cycles on this target.
+ *
+ * @return 1 if it does; 0 otherwise.
+ */
+int Bench_HasCycleCounter( void );
+
+/**
+ * @brief Push the data and code of previous operations out of the CPU
+ * caches, by writing a buffer larger than the last-level cache.
+ */
+void Bench_EvictCaches( void );
+
+/**
+ * @brief Measure an operation.
+ *
+ * @param[in] pSettings The settings of the run.
+ * @param[in] pName The name of the benchmark.
+ * @param[in] function The operation.
+ * @param[in] pContext Passed to @p function.
+ * @param[out] pResult The measurements.
+ */
+void Bench_Run( const BenchSettings_t * pSettings,
+                const char * pName,
+                BenchFunction_t function,
+                void * pContext,
+                BenchResult_t * pResult );
+
+/**
+ * @brief Get a percentile of samples.
+ *
+ * @param[in,out] pValues The samples, which are sorted in place.
+ * @param[in] count The number of samples.
+ * @param[in] percent The percentile, from 0 to 100.
+ *
+ * @return The smallest sample that is greater than or equal to @p percent of
+ * the samples, or 0 if there are none.
+ */
+double Bench_Percentile( double * pValues,
+                         size_t count,
+                         double percent );
+
+/**
+ * @brief Write results as JSON, one benchmark per line.
+ *
+ * @param[in] pFile The file to write to.
+ * @param[in] pResults The results.
+ * @param[in] resultCount The number of results.
+ */
+void Bench_WriteJson( FILE * pFile,
+                      const BenchResult_t * pResults,
+                      size_t resultCount );
+
+/**
+ * @brief Compare results against a baseline written by #Bench_WriteJson,
+ * and print the benchmarks that got slower.
+ *
+ * Only warm times are compared, as cold times vary too much between runs.
+ * Benchmarks missing from the baseline are skipped.
+ *
+ * @param[in] pBaselinePath The path of the baseline.
+ * @param[in] pResults The results.
+ * @param[in] resultCount The number of results.
+ * @param[in] tolerancePercent How much slower than the baseline a benchmark
+ * may be.
+ *
+ * @return The number of benchmarks slower than the tolerance allows, or -1
+ * if the baseline cannot be read.
+ */
+int Bench_CheckBaseline( const char * pBaselinePath,
+                         const BenchResult_t * pResults,
+                         size_t resultCount,
+                         double tolerancePercent );
+
+#endif /* BENCH_COMMON_H_ */
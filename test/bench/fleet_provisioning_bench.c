@@ -0,0 +1,684 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_bench.c
+ * @brief Microbenchmarks of the topic functions and the timer wheel of the
+ * AWS IoT Fleet Provisioning Library.
+ *
+ * Usage: fleet_provisioning_bench [--iterations N] [--cold-samples N]
+ * [--output FILE] [--baseline FILE] [--tolerance PERCENT] [--corpus FILE]
+ * [--binary-log FILE]
+ *
+ * Results are written as JSON to standard output, or to the output file.
+ * With a baseline, the exit status is non-zero if any benchmark is slower
+ * than the baseline by more than the tolerance, 10% by default.
+ *
+ * With a corpus written by fleet_provisioning_corpus, MatchTopic is also
+ * timed on each category of the corpus, cycling through its topics.
+ *
+ * The timer wheel is timed with 1000 to 100000 timers pending, each
+ * operation advancing it by a tick and re-arming the timer that expires, to
+ * show that the cost does not grow with the number of pending timeouts.
+ *
+ * Calls with invalid parameters are timed with the binary log set, to show
+ * the cost of logging errors. With --binary-log, the log is dumped to the
+ * file at the end, for fleet_provisioning_binary_log_decode.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_binary_log.h"
+#include "fleet_provisioning_timer_wheel.h"
+
+#include "bench_common.h"
+
+/**
+ * @brief Template name used in the topic benchmarks.
+ */
+#define TEMPLATE_NAME             "FleetTemplate"
+
+/**
+ * @brief Length of the buffer RegisterThing topics are built in, enough for
+ * the longest template name.
+ */
+#define TOPIC_BUFFER_LENGTH       ( 128U )
+
+/**
+ * @brief Most benchmarks in a run.
+ */
+#define MAX_BENCHMARKS            ( 64U )
+
+/**
+ * @brief Default number of operations of the warm measurements.
+ */
+#define DEFAULT_ITERATIONS        ( 1000000U )
+
+/**
+ * @brief Default number of operations of the cold measurements.
+ */
+#define DEFAULT_COLD_SAMPLES      ( 31U )
+
+/**
+ * @brief Longest line of a corpus, with its category.
+ */
+#define CORPUS_LINE_LENGTH        ( 1024U )
+
+/**
+ * @brief Categories of corpus topics.
+ */
+#define CORPUS_CATEGORIES         ( 3U )
+
+/**
+ * @brief Timers pending in the timer wheel benchmarks.
+ */
+#define TIMER_WHEEL_SIZES         ( 3U )
+
+/**
+ * @brief Default tolerance of the baseline check, in percent.
+ */
+#define DEFAULT_TOLERANCE         ( 10.0 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A topic to match, with the name of its benchmark.
+ */
+typedef struct MatchCase
+{
+    const char * pName;  /**< @brief Name of the benchmark. */
+    const char * pTopic; /**< @brief The topic. */
+} MatchCase_t;
+
+/**
+ * @brief Context of a MatchTopic benchmark.
+ */
+typedef struct MatchContext
+{
+    const char * pTopic;  /**< @brief The topic to match. */
+    uint16_t topicLength; /**< @brief Length of the topic. */
+} MatchContext_t;
+
+/**
+ * @brief Context of a GetRegisterThingTopic benchmark.
+ */
+typedef struct RegisterTopicContext
+{
+    char buffer[ TOPIC_BUFFER_LENGTH ];   /**< @brief Buffer the topic is written to. */
+    FleetProvisioningFormat_t format;    /**< @brief Format of the topic. */
+    FleetProvisioningApiTopics_t topic;  /**< @brief Publish, accepted or rejected topic. */
+    const char * pTemplateName;          /**< @brief The template name. */
+    uint16_t templateNameLength;         /**< @brief Length of the template name. */
+} RegisterTopicContext_t;
+
+/**
+ * @brief Context of a corpus benchmark: the topics of one category.
+ */
+typedef struct CorpusContext
+{
+    MatchContext_t * pTopics; /**< @brief The topics. */
+    size_t topicCount;        /**< @brief Number of topics. */
+    size_t topicSize;         /**< @brief Size of the topics array. */
+    size_t next;              /**< @brief Topic matched by the next call. */
+} CorpusContext_t;
+
+/**
+ * @brief Context of a timer wheel benchmark.
+ */
+typedef struct TimerWheelContext
+{
+    FleetProvisioningTimerWheel_t wheel; /**< @brief The timer wheel. */
+    uint32_t timerCount;                 /**< @brief Number of timers, all pending. */
+} TimerWheelContext_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Every Fleet Provisioning topic, in #FleetProvisioningTopic_t order.
+ */
+static const MatchCase_t topicCases[] =
+{
+    { "MatchTopic/JsonCreateCertFromCsrPublish",  FP_JSON_CREATE_CERT_PUBLISH_TOPIC                   },
+    { "MatchTopic/JsonCreateCertFromCsrAccepted", FP_JSON_CREATE_CERT_ACCEPTED_TOPIC                  },
+    { "MatchTopic/JsonCreateCertFromCsrRejected", FP_JSON_CREATE_CERT_REJECTED_TOPIC                  },
+    { "MatchTopic/JsonCreateKeysAndCertPublish",  FP_JSON_CREATE_KEYS_PUBLISH_TOPIC                   },
+    { "MatchTopic/JsonCreateKeysAndCertAccepted", FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC                  },
+    { "MatchTopic/JsonCreateKeysAndCertRejected", FP_JSON_CREATE_KEYS_REJECTED_TOPIC                  },
+    { "MatchTopic/JsonRegisterThingPublish",      FP_JSON_REGISTER_PUBLISH_TOPIC( TEMPLATE_NAME )     },
+    { "MatchTopic/JsonRegisterThingAccepted",     FP_JSON_REGISTER_ACCEPTED_TOPIC( TEMPLATE_NAME )    },
+    { "MatchTopic/JsonRegisterThingRejected",     FP_JSON_REGISTER_REJECTED_TOPIC( TEMPLATE_NAME )    },
+    { "MatchTopic/CborCreateCertFromCsrPublish",  FP_CBOR_CREATE_CERT_PUBLISH_TOPIC                   },
+    { "MatchTopic/CborCreateCertFromCsrAccepted", FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC                  },
+    { "MatchTopic/CborCreateCertFromCsrRejected", FP_CBOR_CREATE_CERT_REJECTED_TOPIC                  },
+    { "MatchTopic/CborCreateKeysAndCertPublish",  FP_CBOR_CREATE_KEYS_PUBLISH_TOPIC                   },
+    { "MatchTopic/CborCreateKeysAndCertAccepted", FP_CBOR_CREATE_KEYS_ACCEPTED_TOPIC                  },
+    { "MatchTopic/CborCreateKeysAndCertRejected", FP_CBOR_CREATE_KEYS_REJECTED_TOPIC                  },
+    { "MatchTopic/CborRegisterThingPublish",      FP_CBOR_REGISTER_PUBLISH_TOPIC( TEMPLATE_NAME )     },
+    { "MatchTopic/CborRegisterThingAccepted",     FP_CBOR_REGISTER_ACCEPTED_TOPIC( TEMPLATE_NAME )    },
+    { "MatchTopic/CborRegisterThingRejected",     FP_CBOR_REGISTER_REJECTED_TOPIC( TEMPLATE_NAME )    },
+
+    /* Topics that differ from a Fleet Provisioning topic in one place, which
+     * are rejected only after most of the topic is compared. */
+    { "MatchTopic/NearMiss/TruncatedSuffix",      "$aws/certificates/create/json/accepte"             },
+    { "MatchTopic/NearMiss/WrongFormat",          "$aws/certificates/create/jsox/accepted"            },
+    { "MatchTopic/NearMiss/ExtraSuffix",          "$aws/certificates/create-from-csr/cbor/rejected/x" },
+    { "MatchTopic/NearMiss/WrongBridge",          "$aws/provisioning-templates/" TEMPLATE_NAME "/provisiom/json/accepted" },
+    { "MatchTopic/NearMiss/EmptyTemplateName",    "$aws/provisioning-templates//provision/json/accepted" },
+    { "MatchTopic/NearMiss/TemplateNameTooLong",
+      "$aws/provisioning-templates/abcdefghijklmnopqrstuvwxyz0123456789a/provision/json" },
+
+    /* Topics of other services and of the application, which should be
+     * rejected early. */
+    { "MatchTopic/Foreign/Shadow",                "$aws/things/thing-0001/shadow/update/accepted"     },
+    { "MatchTopic/Foreign/Jobs",                  "$aws/things/thing-0001/jobs/notify-next"           },
+    { "MatchTopic/Foreign/Telemetry",             "plant/line-4/sensors/temperature"                  },
+    { "MatchTopic/Foreign/Short",                 "a"                                                 }
+};
+
+/**
+ * @brief Template names of the GetRegisterThingTopic benchmarks, from the
+ * shortest to the longest valid one.
+ */
+static const char * const templateNames[] =
+{
+    "t",
+    "template",
+    "FleetTemplate-0001",
+    "abcdefghijklmnopqrstuvwxyz0123456789"
+};
+
+/**
+ * @brief Categories of corpus topics, as written by the corpus generator.
+ */
+static const char * const corpusCategories[ CORPUS_CATEGORIES ] = { "valid", "near-miss", "foreign" };
+
+/**
+ * @brief Names of the corpus benchmarks, by category.
+ */
+static const char * const corpusNames[ CORPUS_CATEGORIES ] =
+{
+    "MatchTopic/Corpus/Valid",
+    "MatchTopic/Corpus/NearMiss",
+    "MatchTopic/Corpus/Foreign"
+};
+
+/**
+ * @brief Numbers of timers pending in the timer wheel benchmarks.
+ */
+static const uint32_t timerWheelSizes[ TIMER_WHEEL_SIZES ] = { 1000U, 10000U, 100000U };
+
+/**
+ * @brief Written by the benchmarks, so that their work is not optimized
+ * away.
+ */
+static volatile uint32_t sink;
+
+/**
+ * @brief The binary log the library writes errors to.
+ */
+static FleetProvisioningBinaryLog_t binaryLog;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Match a topic.
+ */
+static void benchMatchTopic( void * pContext );
+
+/**
+ * @brief Build a RegisterThing topic.
+ */
+static void benchGetRegisterThingTopic( void * pContext );
+
+/**
+ * @brief Match a topic without an output parameter, which is logged as an
+ * error.
+ */
+static void benchMatchTopicBadParameter( void * pContext );
+
+/**
+ * @brief Build a RegisterThing topic in a buffer too small, which is logged
+ * as an error.
+ */
+static void benchGetRegisterThingTopicTooSmall( void * pContext );
+
+/**
+ * @brief Match the next topic of a corpus category.
+ */
+static void benchMatchCorpus( void * pContext );
+
+/**
+ * @brief Advance a timer wheel by a tick, and re-arm the timer that expires.
+ */
+static void benchTimerWheelTick( void * pContext );
+
+/**
+ * @brief Fill a timer wheel with timers expiring one per tick, or exit.
+ */
+static void initTimerWheel( TimerWheelContext_t * pTimers,
+                            uint32_t timerCount );
+
+/**
+ * @brief Load a corpus, or exit.
+ */
+static void loadCorpus( const char * pPath,
+                        CorpusContext_t * pCorpus );
+
+/**
+ * @brief Parse an unsigned command line value, or exit.
+ */
+static unsigned long parseNumber( const char * pArgument );
+
+/*-----------------------------------------------------------*/
+
+static void benchMatchTopic( void * pContext )
+{
+    const MatchContext_t * pMatch = pContext;
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+    ( void ) FleetProvisioning_MatchTopic( pMatch->pTopic, pMatch->topicLength, &topic );
+    sink = ( uint32_t ) topic;
+}
+/*-----------------------------------------------------------*/
+
+static void benchGetRegisterThingTopic( void * pContext )
+{
+    RegisterTopicContext_t * pRegister = pContext;
+    uint16_t length = 0U;
+
+    ( void ) FleetProvisioning_GetRegisterThingTopic( pRegister->buffer,
+                                                      ( uint16_t ) sizeof( pRegister->buffer ),
+                                                      pRegister->format,
+                                                      pRegister->topic,
+                                                      pRegister->pTemplateName,
+                                                      pRegister->templateNameLength,
+                                                      &length );
+    sink = length;
+}
+/*-----------------------------------------------------------*/
+
+static void benchMatchTopicBadParameter( void * pContext )
+{
+    const MatchContext_t * pMatch = pContext;
+
+    sink = ( uint32_t ) FleetProvisioning_MatchTopic( pMatch->pTopic, pMatch->topicLength, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void benchGetRegisterThingTopicTooSmall( void * pContext )
+{
+    RegisterTopicContext_t * pRegister = pContext;
+    uint16_t length = 0U;
+
+    sink = ( uint32_t ) FleetProvisioning_GetRegisterThingTopic( pRegister->buffer,
+                                                                 1U,
+                                                                 pRegister->format,
+                                                                 pRegister->topic,
+                                                                 pRegister->pTemplateName,
+                                                                 pRegister->templateNameLength,
+                                                                 &length );
+}
+/*-----------------------------------------------------------*/
+
+static void benchMatchCorpus( void * pContext )
+{
+    CorpusContext_t * pCorpus = pContext;
+
+    benchMatchTopic( &( pCorpus->pTopics[ pCorpus->next ] ) );
+    pCorpus->next = ( pCorpus->next + 1U ) % pCorpus->topicCount;
+}
+/*-----------------------------------------------------------*/
+
+static void benchTimerWheelTick( void * pContext )
+{
+    TimerWheelContext_t * pTimers = pContext;
+    uint32_t timer = FP_TIMER_WHEEL_INVALID_TIMER;
+
+    ( void ) FleetProvisioning_TimerWheelAdvance( &( pTimers->wheel ), pTimers->wheel.now + 1U );
+
+    /* The timer expires again after all the others, so that one timer
+     * expires at each tick and all the others stay pending. */
+    while( FleetProvisioning_TimerWheelPopExpired( &( pTimers->wheel ), &timer ) == FleetProvisioningSuccess )
+    {
+        ( void ) FleetProvisioning_TimerWheelArm( &( pTimers->wheel ), timer, pTimers->timerCount );
+    }
+
+    sink = timer;
+}
+/*-----------------------------------------------------------*/
+
+static void initTimerWheel( TimerWheelContext_t * pTimers,
+                            uint32_t timerCount )
+{
+    FleetProvisioningTimerNode_t * pNodes = malloc( timerCount * sizeof( FleetProvisioningTimerNode_t ) );
+    uint32_t timer;
+
+    if( pNodes == NULL )
+    {
+        fprintf( stderr, "Out of memory.\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    ( void ) FleetProvisioning_TimerWheelInit( &( pTimers->wheel ), pNodes, timerCount );
+    pTimers->timerCount = timerCount;
+
+    for( timer = 0U; timer < timerCount; timer++ )
+    {
+        ( void ) FleetProvisioning_TimerWheelArm( &( pTimers->wheel ), timer, timer + 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void loadCorpus( const char * pPath,
+                        CorpusContext_t * pCorpus )
+{
+    char line[ CORPUS_LINE_LENGTH ];
+    FILE * pFile = fopen( pPath, "r" );
+    CorpusContext_t * pCategory;
+    MatchContext_t * pGrown;
+    char * pTopic;
+    char * pEnd;
+    size_t i;
+
+    if( pFile == NULL )
+    {
+        fprintf( stderr, "Cannot open the corpus %s.\n", pPath );
+        exit( EXIT_FAILURE );
+    }
+
+    while( fgets( line, sizeof( line ), pFile ) != NULL )
+    {
+        pTopic = strchr( line, '\t' );
+        pEnd = strchr( line, '\n' );
+        pCategory = NULL;
+
+        if( ( pTopic != NULL ) && ( pEnd != NULL ) )
+        {
+            *pTopic = '\0';
+            pTopic++;
+            *pEnd = '\0';
+
+            for( i = 0U; i < CORPUS_CATEGORIES; i++ )
+            {
+                pCategory = ( strcmp( line, corpusCategories[ i ] ) == 0 ) ? &( pCorpus[ i ] ) : pCategory;
+            }
+        }
+
+        if( pCategory == NULL )
+        {
+            fprintf( stderr, "Invalid line in the corpus %s.\n", pPath );
+            exit( EXIT_FAILURE );
+        }
+
+        /* Grow the topics of the category by doubling. */
+        if( pCategory->topicCount == pCategory->topicSize )
+        {
+            pCategory->topicSize = ( pCategory->topicSize == 0U ) ? 1024U : ( 2U * pCategory->topicSize );
+            pGrown = realloc( pCategory->pTopics, pCategory->topicSize * sizeof( MatchContext_t ) );
+
+            if( pGrown == NULL )
+            {
+                fprintf( stderr, "Out of memory.\n" );
+                exit( EXIT_FAILURE );
+            }
+
+            pCategory->pTopics = pGrown;
+        }
+
+        pCategory->pTopics[ pCategory->topicCount ].topicLength = ( uint16_t ) strlen( pTopic );
+        pCategory->pTopics[ pCategory->topicCount ].pTopic = malloc( ( size_t ) pCategory->pTopics[ pCategory->topicCount ].topicLength + 1U );
+
+        if( pCategory->pTopics[ pCategory->topicCount ].pTopic == NULL )
+        {
+            fprintf( stderr, "Out of memory.\n" );
+            exit( EXIT_FAILURE );
+        }
+
+        ( void ) strcpy( ( char * ) pCategory->pTopics[ pCategory->topicCount ].pTopic, pTopic );
+        pCategory->topicCount++;
+    }
+
+    ( void ) fclose( pFile );
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value == 0UL ) )
+    {
+        fprintf( stderr, "Expected a positive number.\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static BenchResult_t results[ MAX_BENCHMARKS ];
+    static const char * const formatNames[] = { "Json", "Cbor" };
+    static const char * const topicNames[] = { "Publish", "Accepted", "Rejected" };
+    BenchSettings_t settings = { DEFAULT_ITERATIONS, DEFAULT_COLD_SAMPLES };
+    MatchContext_t match;
+    RegisterTopicContext_t registerTopic;
+    TimerWheelContext_t timers;
+    CorpusContext_t corpus[ CORPUS_CATEGORIES ];
+    const char * pCorpusPath = NULL;
+    const char * pBinaryLogPath = NULL;
+    const char * pOutputPath = NULL;
+    const char * pBaselinePath = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    char name[ BENCH_MAX_NAME_LENGTH ];
+    FILE * pOutput = stdout;
+    size_t resultCount = 0U;
+    size_t i;
+    int format;
+    int topic;
+    int regressions = 0;
+    int arg;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--iterations" ) == 0 )
+        {
+            settings.warmIterations = ( uint32_t ) parseNumber( pValue );
+        }
+        else if( strcmp( argv[ arg ], "--cold-samples" ) == 0 )
+        {
+            settings.coldSamples = ( uint32_t ) parseNumber( pValue );
+        }
+        else if( strcmp( argv[ arg ], "--output" ) == 0 )
+        {
+            pOutputPath = pValue;
+        }
+        else if( strcmp( argv[ arg ], "--baseline" ) == 0 )
+        {
+            pBaselinePath = pValue;
+        }
+        else if( strcmp( argv[ arg ], "--tolerance" ) == 0 )
+        {
+            tolerance = ( double ) parseNumber( pValue );
+        }
+        else if( strcmp( argv[ arg ], "--corpus" ) == 0 )
+        {
+            pCorpusPath = pValue;
+        }
+        else if( strcmp( argv[ arg ], "--binary-log" ) == 0 )
+        {
+            pBinaryLogPath = pValue;
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s [--iterations N] [--cold-samples N] [--output FILE] "
+                     "[--baseline FILE] [--tolerance PERCENT] [--corpus FILE] [--binary-log FILE]\n",
+                     argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            fprintf( stderr, "Missing value for %s.\n", argv[ arg ] );
+            return EXIT_FAILURE;
+        }
+
+        arg++;
+    }
+
+    for( i = 0U; i < ( sizeof( topicCases ) / sizeof( topicCases[ 0 ] ) ); i++ )
+    {
+        match.pTopic = topicCases[ i ].pTopic;
+        match.topicLength = ( uint16_t ) strlen( topicCases[ i ].pTopic );
+        Bench_Run( &settings, topicCases[ i ].pName, benchMatchTopic, &match, &( results[ resultCount ] ) );
+        resultCount++;
+    }
+
+    for( format = 0; format < 2; format++ )
+    {
+        for( topic = 0; topic < 3; topic++ )
+        {
+            for( i = 0U; i < ( sizeof( templateNames ) / sizeof( templateNames[ 0 ] ) ); i++ )
+            {
+                registerTopic.format = ( format == 0 ) ? FleetProvisioningJson : FleetProvisioningCbor;
+                registerTopic.topic = ( FleetProvisioningApiTopics_t ) ( ( int ) FleetProvisioningPublish + topic );
+                registerTopic.pTemplateName = templateNames[ i ];
+                registerTopic.templateNameLength = ( uint16_t ) strlen( templateNames[ i ] );
+                ( void ) sprintf( name, "GetRegisterThingTopic/%s%s/NameLength%u",
+                                  formatNames[ format ], topicNames[ topic ],
+                                  ( unsigned int ) registerTopic.templateNameLength );
+                Bench_Run( &settings, name, benchGetRegisterThingTopic, &registerTopic,
+                           &( results[ resultCount ] ) );
+                resultCount++;
+            }
+        }
+    }
+
+    for( i = 0U; i < TIMER_WHEEL_SIZES; i++ )
+    {
+        initTimerWheel( &timers, timerWheelSizes[ i ] );
+        ( void ) sprintf( name, "TimerWheel/Tick/Pending%lu", ( unsigned long ) timerWheelSizes[ i ] );
+        Bench_Run( &settings, name, benchTimerWheelTick, &timers, &( results[ resultCount ] ) );
+        resultCount++;
+        free( timers.wheel.pNodes );
+    }
+
+    ( void ) FleetProvisioning_BinaryLogInit( &binaryLog );
+    FleetProvisioning_BinaryLogSet( &binaryLog );
+
+    match.pTopic = topicCases[ 0 ].pTopic;
+    match.topicLength = ( uint16_t ) strlen( topicCases[ 0 ].pTopic );
+    Bench_Run( &settings, "MatchTopic/BadParameter", benchMatchTopicBadParameter, &match,
+               &( results[ resultCount ] ) );
+    resultCount++;
+
+    registerTopic.format = FleetProvisioningJson;
+    registerTopic.topic = FleetProvisioningAccepted;
+    registerTopic.pTemplateName = TEMPLATE_NAME;
+    registerTopic.templateNameLength = ( uint16_t ) strlen( TEMPLATE_NAME );
+    Bench_Run( &settings, "GetRegisterThingTopic/BufferTooSmall", benchGetRegisterThingTopicTooSmall,
+               &registerTopic, &( results[ resultCount ] ) );
+    resultCount++;
+
+    FleetProvisioning_BinaryLogSet( NULL );
+
+    if( pBinaryLogPath != NULL )
+    {
+        pOutput = fopen( pBinaryLogPath, "wb" );
+
+        if( ( pOutput == NULL ) || ( fwrite( &binaryLog, sizeof( binaryLog ), 1U, pOutput ) != 1U ) )
+        {
+            fprintf( stderr, "Cannot write %s.\n", pBinaryLogPath );
+            return EXIT_FAILURE;
+        }
+
+        ( void ) fclose( pOutput );
+        pOutput = stdout;
+    }
+
+    if( pCorpusPath != NULL )
+    {
+        ( void ) memset( corpus, 0, sizeof( corpus ) );
+        loadCorpus( pCorpusPath, corpus );
+
+        for( i = 0U; i < CORPUS_CATEGORIES; i++ )
+        {
+            if( corpus[ i ].topicCount > 0U )
+            {
+                Bench_Run( &settings, corpusNames[ i ], benchMatchCorpus, &( corpus[ i ] ), &( results[ resultCount ] ) );
+                resultCount++;
+            }
+
+            while( corpus[ i ].topicCount > 0U )
+            {
+                corpus[ i ].topicCount--;
+                free( ( char * ) corpus[ i ].pTopics[ corpus[ i ].topicCount ].pTopic );
+            }
+
+            free( corpus[ i ].pTopics );
+        }
+    }
+
+    if( pOutputPath != NULL )
+    {
+        pOutput = fopen( pOutputPath, "w" );
+
+        if( pOutput == NULL )
+        {
+            fprintf( stderr, "Cannot open %s.\n", pOutputPath );
+            return EXIT_FAILURE;
+        }
+    }
+
+    Bench_WriteJson( pOutput, results, resultCount );
+
+    if( pOutput != stdout )
+    {
+        ( void ) fclose( pOutput );
+    }
+
+    if( pBaselinePath != NULL )
+    {
+        regressions = Bench_CheckBaseline( pBaselinePath, results, resultCount, tolerance );
+    }
+
+    return ( regressions == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
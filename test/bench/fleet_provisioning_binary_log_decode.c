@@ -0,0 +1,251 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_binary_log_decode.c
+ * @brief Decoder of the binary log of the AWS IoT Fleet Provisioning
+ * Library.
+ *
+ * Usage: fleet_provisioning_binary_log_decode FILE
+ *
+ * The file is a dump of a #FleetProvisioningBinaryLog_t, taken on a target
+ * of the same byte order as the host. Its records are written to standard
+ * output from the oldest to the newest, one per line, as their sequence
+ * number and the text of their message. Records that were being written
+ * when the dump was taken are skipped. The exit status is non-zero if the
+ * file is not a binary log.
+ */
+
+/* Standard includes. */
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning binary log include. */
+#include "fleet_provisioning_binary_log.h"
+
+/**
+ * @brief Size of the fields of #FleetProvisioningBinaryLog_t before the
+ * records.
+ */
+#define HEADER_SIZE    ( offsetof( FleetProvisioningBinaryLog_t, records ) )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The text of each message.
+ */
+static const char * const messageFormats[ FleetProvisioningLogMessageCount ] = FP_BINARY_LOG_FORMATS;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the text of a record.
+ *
+ * @param[in] pRecord The record.
+ */
+static void printRecord( const FleetProvisioningBinaryLogRecord_t * pRecord );
+
+/**
+ * @brief Read a file into memory.
+ *
+ * @param[in] pPath The file.
+ * @param[out] pLength The length of the file.
+ *
+ * @return The contents of the file, to free, or NULL if it cannot be read.
+ */
+static uint8_t * readFile( const char * pPath,
+                           size_t * pLength );
+
+/*-----------------------------------------------------------*/
+
+static void printRecord( const FleetProvisioningBinaryLogRecord_t * pRecord )
+{
+    const char * pFormat;
+    uint32_t arg = 0U;
+
+    printf( "%10lu ", ( unsigned long ) pRecord->sequence );
+
+    if( ( pRecord->message == ( uint32_t ) FleetProvisioningLogNone ) ||
+        ( pRecord->message >= ( uint32_t ) FleetProvisioningLogMessageCount ) )
+    {
+        /* A log of a newer build: show the raw record. */
+        printf( "Unknown message %lu:", ( unsigned long ) pRecord->message );
+
+        for( arg = 0U; arg < FP_BINARY_LOG_MAX_ARGS; arg++ )
+        {
+            printf( " 0x%" PRIx64, pRecord->args[ arg ] );
+        }
+    }
+    else
+    {
+        for( pFormat = messageFormats[ pRecord->message ]; *pFormat != '\0'; pFormat++ )
+        {
+            if( ( pFormat[ 0 ] != '%' ) || ( pFormat[ 1 ] == '\0' ) )
+            {
+                putchar( *pFormat );
+            }
+            else
+            {
+                pFormat++;
+
+                if( ( *pFormat != '%' ) && ( arg >= FP_BINARY_LOG_MAX_ARGS ) )
+                {
+                    printf( "?" );
+                }
+                else if( *pFormat == 'p' )
+                {
+                    printf( "0x%" PRIx64, pRecord->args[ arg ] );
+                    arg++;
+                }
+                else if( *pFormat == 'd' )
+                {
+                    printf( "%" PRId64, ( int64_t ) pRecord->args[ arg ] );
+                    arg++;
+                }
+                else if( *pFormat == 'u' )
+                {
+                    printf( "%" PRIu64, pRecord->args[ arg ] );
+                    arg++;
+                }
+                else
+                {
+                    putchar( *pFormat );
+                }
+            }
+        }
+    }
+
+    putchar( '\n' );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t * readFile( const char * pPath,
+                           size_t * pLength )
+{
+    FILE * pFile = fopen( pPath, "rb" );
+    uint8_t * pContents = NULL;
+    size_t capacity = 0U;
+    size_t length = 0U;
+    uint8_t * pGrown;
+
+    if( pFile != NULL )
+    {
+        do
+        {
+            if( length == capacity )
+            {
+                capacity = ( capacity == 0U ) ? 4096U : ( capacity * 2U );
+                pGrown = realloc( pContents, capacity );
+
+                if( pGrown == NULL )
+                {
+                    free( pContents );
+                    pContents = NULL;
+                    break;
+                }
+
+                pContents = pGrown;
+            }
+
+            length += fread( &( pContents[ length ] ), 1U, capacity - length, pFile );
+        } while( length == capacity );
+
+        ( void ) fclose( pFile );
+    }
+
+    *pLength = length;
+
+    return pContents;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    FleetProvisioningBinaryLogRecord_t record;
+    uint8_t * pContents;
+    size_t length = 0U;
+    uint32_t magic = 0U;
+    uint32_t size = 0U;
+    uint32_t next = 0U;
+    uint32_t i;
+    int status = EXIT_FAILURE;
+
+    if( argc != 2 )
+    {
+        fprintf( stderr, "Usage: %s FILE\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    pContents = readFile( argv[ 1 ], &length );
+
+    if( pContents == NULL )
+    {
+        fprintf( stderr, "Cannot read %s.\n", argv[ 1 ] );
+        return EXIT_FAILURE;
+    }
+
+    if( length >= HEADER_SIZE )
+    {
+        ( void ) memcpy( &magic, &( pContents[ offsetof( FleetProvisioningBinaryLog_t, magic ) ] ), sizeof( magic ) );
+        ( void ) memcpy( &size, &( pContents[ offsetof( FleetProvisioningBinaryLog_t, size ) ] ), sizeof( size ) );
+        ( void ) memcpy( &next, &( pContents[ offsetof( FleetProvisioningBinaryLog_t, next ) ] ), sizeof( next ) );
+    }
+
+    if( ( length < HEADER_SIZE ) || ( magic != FP_BINARY_LOG_MAGIC ) )
+    {
+        fprintf( stderr, "%s is not a binary log, or is from a target of another byte order.\n", argv[ 1 ] );
+    }
+    else if( ( size == 0U ) || ( ( size & ( size - 1U ) ) != 0U ) ||
+             ( ( ( length - HEADER_SIZE ) / sizeof( record ) ) < size ) )
+    {
+        fprintf( stderr, "%s is truncated, or has an invalid size of %lu records.\n",
+                 argv[ 1 ], ( unsigned long ) size );
+    }
+    else
+    {
+        /* The record written next is the oldest one. */
+        for( i = 0U; i < size; i++ )
+        {
+            ( void ) memcpy( &record,
+                             &( pContents[ HEADER_SIZE + ( ( ( next + i ) % size ) * sizeof( record ) ) ] ),
+                             sizeof( record ) );
+
+            if( record.sequence != 0U )
+            {
+                printRecord( &record );
+            }
+        }
+
+        status = EXIT_SUCCESS;
+    }
+
+    free( pContents );
+
+    return status;
+}
+/*-----------------------------------------------------------*/
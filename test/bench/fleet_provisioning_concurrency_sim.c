@@ -0,0 +1,381 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_concurrency_sim.c
+ * @brief Simulation of the concurrency controller of
+ * fleet_provisioning_concurrency.h against the mock service, showing its
+ * throughput converge to the capacity of the service.
+ *
+ * Usage: fleet_provisioning_concurrency_sim [--seconds N] [--rate N]
+ * [--rate-after N] [--change-second N] [--min-latency-ms N]
+ * [--max-latency-ms N] [--initial-limit N] [--max-limit N]
+ * [--decrease-percent P] [--seed N]
+ *
+ * A gateway keeps as many CreateKeysAndCertificate requests in flight as the
+ * controller allows, starting one as soon as another is answered. The mock
+ * accepts --rate requests per second and throttles the rest, and from
+ * --change-second on accepts --rate-after per second instead, so that the
+ * controller has to find a new capacity. Each response is matched with
+ * #FleetProvisioning_MatchTopic and fed to the controller.
+ *
+ * The run is on a simulated clock. The report gives, for each simulated
+ * second, the limit at its end and the requests accepted and throttled in
+ * it, then, for the second half of each capacity, the accepted rate as a
+ * share of the capacity and the share of requests throttled. The exit status
+ * is non-zero if the run stalls, or if the accepted rate of the second half
+ * of either capacity is below #MIN_UTILIZATION_PERCENT of the capacity.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_concurrency.h"
+
+#include "mock_service.h"
+
+/**
+ * @brief Nanoseconds in a millisecond.
+ */
+#define NS_PER_MS                  ( 1000000U )
+
+/**
+ * @brief Nanoseconds in a second.
+ */
+#define NS_PER_SECOND              ( 1000000000U )
+
+/**
+ * @brief Longest run, in simulated seconds.
+ */
+#define MAX_SECONDS                ( 3600U )
+
+/**
+ * @brief Smallest accepted rate, as a share of the capacity, for the run to
+ * count as converged.
+ */
+#define MIN_UTILIZATION_PERCENT    ( 80U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Counts of one simulated second.
+ */
+typedef struct SimSecond
+{
+    uint32_t limit;     /**< @brief Limit of the controller at the end of the second. */
+    uint32_t accepted;  /**< @brief Requests accepted in the second. */
+    uint32_t throttled; /**< @brief Requests throttled in the second. */
+} SimSecond_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Parse a number of a command line option, or exit.
+ *
+ * @param[in] pArgument The option value, or NULL if missing.
+ * @param[in] minimum The smallest value allowed.
+ * @param[in] maximum The largest value allowed.
+ *
+ * @return The number.
+ */
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum );
+
+/**
+ * @brief Print the accepted rate and the throttled share of a span of
+ * seconds run at one capacity.
+ *
+ * @param[in] pSeconds The counts of the seconds.
+ * @param[in] first The first second of the span.
+ * @param[in] end The second after the span.
+ * @param[in] rate The capacity of the service over the span.
+ *
+ * @return 0 if the accepted rate is at least #MIN_UTILIZATION_PERCENT of
+ * the capacity, 1 if not.
+ */
+static int reportSpan( const SimSecond_t * pSeconds,
+                       unsigned long first,
+                       unsigned long end,
+                       unsigned long rate );
+
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value < minimum ) || ( value > maximum ) )
+    {
+        fprintf( stderr, "Expected a number from %lu to %lu.\n", minimum, maximum );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+static int reportSpan( const SimSecond_t * pSeconds,
+                       unsigned long first,
+                       unsigned long end,
+                       unsigned long rate )
+{
+    unsigned long accepted = 0UL;
+    unsigned long throttled = 0UL;
+    unsigned long second;
+    double utilization;
+
+    for( second = first; second < end; second++ )
+    {
+        accepted += pSeconds[ second ].accepted;
+        throttled += pSeconds[ second ].throttled;
+    }
+
+    utilization = ( ( double ) accepted * 100.0 ) / ( ( double ) rate * ( double ) ( end - first ) );
+
+    printf( "seconds %lu to %lu: %.1f requests/s accepted of %lu, %.1f%% of capacity, %.2f%% throttled\n",
+            first, end, ( double ) accepted / ( double ) ( end - first ), rate, utilization,
+            ( ( accepted + throttled ) > 0UL ) ? ( ( double ) throttled * 100.0 / ( double ) ( accepted + throttled ) ) : 0.0 );
+
+    return ( utilization < ( double ) MIN_UTILIZATION_PERCENT ) ? 1 : 0;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static char topic[ MOCK_MAX_TOPIC_LENGTH ];
+    static char payload[ MOCK_MAX_PAYLOAD_LENGTH ];
+    FleetProvisioningConcurrencyConfig_t config = { 1U, 1U, 10000U, 30U };
+    FleetProvisioningConcurrency_t controller;
+    MockServiceConfig_t serviceConfig;
+    MockService_t service;
+    FleetProvisioningTopic_t responseTopic = FleetProvisioningInvalidTopic;
+    SimSecond_t * pSeconds;
+    unsigned long seconds = 60UL;
+    unsigned long rate = 1000UL;
+    unsigned long rateAfter = 500UL;
+    unsigned long changeSecond = 30UL;
+    unsigned long second;
+    uint64_t nowNs = 0U;
+    uint64_t dueNs = 0U;
+    uint64_t endNs;
+    uint32_t clientId = 0U;
+    uint32_t responseClientId = 0U;
+    uint16_t topicLength = 0U;
+    size_t payloadLength = 0U;
+    int error = 0;
+    int arg;
+
+    ( void ) memset( &serviceConfig, 0, sizeof( serviceConfig ) );
+    serviceConfig.minLatencyNs = 50U * ( uint64_t ) NS_PER_MS;
+    serviceConfig.maxLatencyNs = 150U * ( uint64_t ) NS_PER_MS;
+    serviceConfig.seed = 1U;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--seconds" ) == 0 )
+        {
+            seconds = parseNumber( pValue, 2UL, MAX_SECONDS );
+        }
+        else if( strcmp( argv[ arg ], "--rate" ) == 0 )
+        {
+            rate = parseNumber( pValue, 1UL, 1000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--rate-after" ) == 0 )
+        {
+            rateAfter = parseNumber( pValue, 1UL, 1000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--change-second" ) == 0 )
+        {
+            changeSecond = parseNumber( pValue, 0UL, MAX_SECONDS );
+        }
+        else if( strcmp( argv[ arg ], "--min-latency-ms" ) == 0 )
+        {
+            serviceConfig.minLatencyNs = parseNumber( pValue, 1UL, 3600000UL ) * ( uint64_t ) NS_PER_MS;
+        }
+        else if( strcmp( argv[ arg ], "--max-latency-ms" ) == 0 )
+        {
+            serviceConfig.maxLatencyNs = parseNumber( pValue, 1UL, 3600000UL ) * ( uint64_t ) NS_PER_MS;
+        }
+        else if( strcmp( argv[ arg ], "--initial-limit" ) == 0 )
+        {
+            config.initialLimit = ( uint32_t ) parseNumber( pValue, 1UL, FP_CONCURRENCY_MAX_LIMIT );
+        }
+        else if( strcmp( argv[ arg ], "--max-limit" ) == 0 )
+        {
+            config.maxLimit = ( uint32_t ) parseNumber( pValue, 1UL, 1000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--decrease-percent" ) == 0 )
+        {
+            config.decreasePercent = ( uint32_t ) parseNumber( pValue, 1UL, 99UL );
+        }
+        else if( strcmp( argv[ arg ], "--seed" ) == 0 )
+        {
+            serviceConfig.seed = ( uint32_t ) parseNumber( pValue, 1UL, 0xFFFFFFFFUL );
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s [--seconds N] [--rate N] [--rate-after N] [--change-second N] "
+                     "[--min-latency-ms N] [--max-latency-ms N] [--initial-limit N] [--max-limit N] "
+                     "[--decrease-percent P] [--seed N]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            fprintf( stderr, "Missing value for %s.\n", argv[ arg ] );
+            return EXIT_FAILURE;
+        }
+
+        arg++;
+    }
+
+    /* Without a change, the whole run is at the first capacity. */
+    if( changeSecond > seconds )
+    {
+        changeSecond = seconds;
+    }
+
+    /* Each request in flight waits for its response at the mock. */
+    serviceConfig.ratePerSecond = ( uint32_t ) rate;
+    serviceConfig.maxPending = config.maxLimit;
+    endNs = ( uint64_t ) seconds * NS_PER_SECOND;
+    pSeconds = calloc( seconds, sizeof( SimSecond_t ) );
+
+    if( ( pSeconds == NULL ) ||
+        ( FleetProvisioning_ConcurrencyInit( &controller, &config ) != FleetProvisioningSuccess ) ||
+        ( MockService_Init( &service, &serviceConfig ) != FleetProvisioningSuccess ) )
+    {
+        fprintf( stderr, "Invalid settings, or out of memory.\n" );
+        return EXIT_FAILURE;
+    }
+
+    /* Run the events in time order: requests start as soon as the limit
+     * allows, and responses are delivered once due. */
+    while( ( error == 0 ) && ( nowNs < endNs ) )
+    {
+        while( ( error == 0 ) && ( FleetProvisioning_ConcurrencyTryStart( &controller ) == FleetProvisioningSuccess ) )
+        {
+            error = ( MockService_Publish( &service, nowNs, clientId, FP_JSON_CREATE_KEYS_PUBLISH_TOPIC,
+                                           FP_JSON_CREATE_KEYS_PUBLISH_LENGTH, "{}", 2U ) == FleetProvisioningSuccess ) ? 0 : 1;
+            clientId++;
+        }
+
+        if( ( error == 0 ) && ( MockService_NextDue( &service, &dueNs ) == FleetProvisioningSuccess ) )
+        {
+            nowNs = dueNs;
+            second = ( unsigned long ) ( nowNs / NS_PER_SECOND );
+
+            /* The capacity of the mock changes between requests. */
+            if( second >= changeSecond )
+            {
+                service.config.ratePerSecond = ( uint32_t ) rateAfter;
+            }
+
+            while( ( error == 0 ) && ( second < seconds ) &&
+                   ( MockService_Poll( &service, nowNs, &responseClientId, topic, &topicLength,
+                                       payload, &payloadLength ) == FleetProvisioningSuccess ) )
+            {
+                error = ( ( FleetProvisioning_MatchTopic( topic, topicLength, &responseTopic ) == FleetProvisioningSuccess ) &&
+                          ( FleetProvisioning_ConcurrencyOnResponse( &controller, responseTopic,
+                                                                     payload, payloadLength ) == FleetProvisioningSuccess ) &&
+                          ( FleetProvisioning_ConcurrencyFinish( &controller ) == FleetProvisioningSuccess ) ) ? 0 : 1;
+
+                if( responseTopic == FleetProvJsonCreateKeysAndCertAccepted )
+                {
+                    pSeconds[ second ].accepted++;
+                }
+                else
+                {
+                    pSeconds[ second ].throttled++;
+                }
+
+                pSeconds[ second ].limit = controller.limit;
+            }
+        }
+        else
+        {
+            /* Nothing is in flight, and no request can start. */
+            error = 1;
+        }
+    }
+
+    printf( "%8s %8s %10s %10s\n", "second", "limit", "accepted", "throttled" );
+
+    for( second = 0UL; second < seconds; second++ )
+    {
+        /* Carry the limit over seconds without a response. */
+        if( ( second > 0UL ) && ( ( pSeconds[ second ].accepted + pSeconds[ second ].throttled ) == 0U ) )
+        {
+            pSeconds[ second ].limit = pSeconds[ second - 1UL ].limit;
+        }
+
+        printf( "%8lu %8lu %10lu %10lu\n", second, ( unsigned long ) pSeconds[ second ].limit,
+                ( unsigned long ) pSeconds[ second ].accepted, ( unsigned long ) pSeconds[ second ].throttled );
+    }
+
+    if( error != 0 )
+    {
+        fprintf( stderr, "The run stalled.\n" );
+    }
+    else
+    {
+        /* The first half of each capacity is left for the limit to settle. */
+        if( changeSecond >= 2UL )
+        {
+            error |= reportSpan( pSeconds, changeSecond / 2UL, changeSecond, rate );
+        }
+
+        if( ( seconds - changeSecond ) >= 2UL )
+        {
+            error |= reportSpan( pSeconds, changeSecond + ( ( seconds - changeSecond ) / 2UL ), seconds, rateAfter );
+        }
+
+        if( error != 0 )
+        {
+            fprintf( stderr, "The throughput did not converge to the capacity.\n" );
+        }
+    }
+
+    MockService_Cleanup( &service );
+    free( pSeconds );
+
+    return ( error == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
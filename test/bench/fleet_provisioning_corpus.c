@@ -0,0 +1,583 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_corpus.c
+ * @brief Generator of synthetic topic corpora for the AWS IoT Fleet
+ * Provisioning topic matcher.
+ *
+ * Usage: fleet_provisioning_corpus [--count N] [--seed N]
+ * [--valid-percent P] [--near-miss-percent P] [--register-percent P]
+ * [--max-name-percent P] [--output FILE]
+ *
+ * Each line of the corpus is a category, a tab and a topic:
+ *
+ * - "valid": Fleet Provisioning topics of every API, format and suffix.
+ *   RegisterThing topics make up --register-percent of them, and use
+ *   template names of random length. --max-name-percent of those names are
+ *   the longest allowed, FP_TEMPLATENAME_MAX_LENGTH characters.
+ * - "near-miss": Fleet Provisioning topics changed in one place:
+ *   - truncated;
+ *   - with a look-alike format, suffix or prefix;
+ *   - with a template name that is too long, empty, or holds a character
+ *     not allowed.
+ * - "foreign": topics of other services and of applications, such as long
+ *   shadow and jobs topics.
+ *
+ * The rest of the topics after the valid and near-miss shares are foreign.
+ * Topics are built from the fragment macros of fleet_provisioning.h, so the
+ * corpus follows changes to the topic grammar. Near misses that happen to
+ * match are drawn again, so every category is exact. The same seed gives the
+ * same corpus. fleet_provisioning_bench --corpus times the matcher on each
+ * category.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/**
+ * @brief Longest topic generated.
+ */
+#define MAX_TOPIC_LENGTH          ( 512U )
+
+/**
+ * @brief Longest thing name allowed by AWS IoT Core.
+ */
+#define THING_NAME_MAX_LENGTH     ( 128U )
+
+/**
+ * @brief Longest named shadow or job ID allowed by AWS IoT Core.
+ */
+#define SHADOW_NAME_MAX_LENGTH    ( 64U )
+
+/**
+ * @brief Number of kinds of near misses.
+ */
+#define NEAR_MISS_KINDS           ( 8U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A topic being built.
+ */
+typedef struct Topic
+{
+    char text[ MAX_TOPIC_LENGTH ]; /**< @brief The topic. */
+    size_t length;                 /**< @brief Its length. */
+    size_t formatOffset;           /**< @brief For a Fleet Provisioning topic, offset of the format. */
+    size_t nameOffset;             /**< @brief For a RegisterThing topic, offset of the template name. */
+    size_t nameLength;             /**< @brief For a RegisterThing topic, length of the template name. */
+} Topic_t;
+
+/**
+ * @brief Settings of a corpus.
+ */
+typedef struct CorpusSettings
+{
+    unsigned long count;           /**< @brief Number of topics. */
+    unsigned long validPercent;    /**< @brief Share of valid topics. */
+    unsigned long nearMissPercent; /**< @brief Share of near misses. */
+    unsigned long registerPercent; /**< @brief Share of RegisterThing topics among valid ones. */
+    unsigned long maxNamePercent;  /**< @brief Share of template names of the longest length. */
+} CorpusSettings_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Characters allowed in template names.
+ */
+static const char nameCharacters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-";
+
+/**
+ * @brief Prefixes of the APIs, in #FleetProvisioningTopic_t order.
+ */
+static const char * const apiPrefixes[ 3 ] =
+{
+    FP_CREATE_CERT_API_PREFIX,
+    FP_CREATE_KEYS_API_PREFIX,
+    FP_REGISTER_API_PREFIX
+};
+
+/**
+ * @brief Formats, in #FleetProvisioningFormat_t order.
+ */
+static const char * const formats[ 2 ] = { FP_API_JSON_FORMAT, FP_API_CBOR_FORMAT };
+
+/**
+ * @brief Suffixes, in #FleetProvisioningApiTopics_t order.
+ */
+static const char * const suffixes[ 3 ] = { "", FP_API_ACCEPTED_SUFFIX, FP_API_REJECTED_SUFFIX };
+
+/**
+ * @brief State of the random generator.
+ */
+static uint32_t randomState = 1U;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Draw a random number below a bound.
+ */
+static uint32_t randomBelow( uint32_t bound );
+
+/**
+ * @brief Append text to a topic.
+ */
+static void append( Topic_t * pTopic,
+                    const char * pText,
+                    size_t length );
+
+/**
+ * @brief Append a random name of characters allowed in template names.
+ */
+static void appendName( Topic_t * pTopic,
+                        size_t length );
+
+/**
+ * @brief Draw a character allowed in template names, other than a given
+ * one.
+ */
+static char otherCharacter( char character );
+
+/**
+ * @brief Build a Fleet Provisioning topic.
+ *
+ * @param[out] pTopic The topic.
+ * @param[in] api The API, in #FleetProvisioningTopic_t order.
+ * @param[in] format The format.
+ * @param[in] suffix The suffix, in #FleetProvisioningApiTopics_t order.
+ * @param[in] nameLength For RegisterThing, the length of the template name.
+ */
+static void buildValid( Topic_t * pTopic,
+                        uint32_t api,
+                        uint32_t format,
+                        uint32_t suffix,
+                        size_t nameLength );
+
+/**
+ * @brief Build a random Fleet Provisioning topic.
+ */
+static void randomValid( const CorpusSettings_t * pSettings,
+                         Topic_t * pTopic );
+
+/**
+ * @brief Build a random near miss.
+ */
+static void randomNearMiss( const CorpusSettings_t * pSettings,
+                            Topic_t * pTopic );
+
+/**
+ * @brief Build a random topic of another service or of an application.
+ */
+static void randomForeign( Topic_t * pTopic );
+
+/**
+ * @brief Parse a numeric option, or exit.
+ */
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t randomBelow( uint32_t bound )
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    return ( uint32_t ) ( ( ( uint64_t ) randomState * bound ) >> 32 );
+}
+/*-----------------------------------------------------------*/
+
+static void append( Topic_t * pTopic,
+                    const char * pText,
+                    size_t length )
+{
+    ( void ) memcpy( &( pTopic->text[ pTopic->length ] ), pText, length );
+    pTopic->length += length;
+}
+/*-----------------------------------------------------------*/
+
+static void appendName( Topic_t * pTopic,
+                        size_t length )
+{
+    size_t i;
+
+    for( i = 0U; i < length; i++ )
+    {
+        pTopic->text[ pTopic->length ] = nameCharacters[ randomBelow( sizeof( nameCharacters ) - 1U ) ];
+        pTopic->length++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static char otherCharacter( char character )
+{
+    char other;
+
+    do
+    {
+        other = nameCharacters[ randomBelow( sizeof( nameCharacters ) - 1U ) ];
+    } while( other == character );
+
+    return other;
+}
+/*-----------------------------------------------------------*/
+
+static void buildValid( Topic_t * pTopic,
+                        uint32_t api,
+                        uint32_t format,
+                        uint32_t suffix,
+                        size_t nameLength )
+{
+    pTopic->length = 0U;
+    append( pTopic, apiPrefixes[ api ], strlen( apiPrefixes[ api ] ) );
+    pTopic->nameOffset = pTopic->length;
+    pTopic->nameLength = 0U;
+
+    if( api == 2U )
+    {
+        appendName( pTopic, nameLength );
+        pTopic->nameLength = nameLength;
+        append( pTopic, FP_REGISTER_API_BRIDGE, FP_REGISTER_API_LENGTH_BRIDGE );
+    }
+
+    pTopic->formatOffset = pTopic->length;
+    append( pTopic, formats[ format ], strlen( formats[ format ] ) );
+    append( pTopic, suffixes[ suffix ], strlen( suffixes[ suffix ] ) );
+}
+/*-----------------------------------------------------------*/
+
+static void randomValid( const CorpusSettings_t * pSettings,
+                         Topic_t * pTopic )
+{
+    uint32_t api = ( randomBelow( 100U ) < pSettings->registerPercent ) ? 2U : randomBelow( 2U );
+    size_t nameLength = ( randomBelow( 100U ) < pSettings->maxNamePercent ) ?
+                        FP_TEMPLATENAME_MAX_LENGTH : ( 1U + randomBelow( FP_TEMPLATENAME_MAX_LENGTH ) );
+
+    buildValid( pTopic, api, randomBelow( 2U ), randomBelow( 3U ), nameLength );
+}
+/*-----------------------------------------------------------*/
+
+static void randomNearMiss( const CorpusSettings_t * pSettings,
+                            Topic_t * pTopic )
+{
+    static const char invalidNameCharacters[] = "./+#$ ";
+    FleetProvisioningTopic_t match = FleetProvisioningInvalidTopic;
+    size_t offset;
+    size_t cut;
+
+    do
+    {
+        randomValid( pSettings, pTopic );
+
+        switch( randomBelow( NEAR_MISS_KINDS ) )
+        {
+            case 0:
+                /* Truncated anywhere past the start of the format. */
+                cut = 1U + randomBelow( ( uint32_t ) ( pTopic->length - pTopic->formatOffset ) );
+                pTopic->length -= cut;
+                break;
+
+            case 1:
+                /* A look-alike format, with one character changed. */
+                offset = pTopic->formatOffset + randomBelow( FP_API_LENGTH_JSON_FORMAT );
+                pTopic->text[ offset ] = otherCharacter( pTopic->text[ offset ] );
+                break;
+
+            case 2:
+                /* A look-alike suffix, with one character changed or added. */
+                offset = pTopic->length - 1U;
+
+                if( randomBelow( 2U ) == 0U )
+                {
+                    pTopic->text[ offset ] = otherCharacter( pTopic->text[ offset ] );
+                }
+                else
+                {
+                    append( pTopic, "/", 1U );
+                    appendName( pTopic, 1U + randomBelow( 8U ) );
+                }
+
+                break;
+
+            case 3:
+                /* A look-alike prefix, with one character changed. */
+                offset = randomBelow( ( uint32_t ) pTopic->nameOffset );
+                pTopic->text[ offset ] = otherCharacter( pTopic->text[ offset ] );
+                break;
+
+            case 4:
+                /* A template name one to four characters too long. */
+                buildValid( pTopic, 2U, randomBelow( 2U ), randomBelow( 3U ),
+                            FP_TEMPLATENAME_MAX_LENGTH + 1U + randomBelow( 4U ) );
+                break;
+
+            case 5:
+                /* An empty template name. */
+                buildValid( pTopic, 2U, randomBelow( 2U ), randomBelow( 3U ), 0U );
+                break;
+
+            case 6:
+                /* A template name holding a character not allowed. */
+                buildValid( pTopic, 2U, randomBelow( 2U ), randomBelow( 3U ),
+                            1U + randomBelow( FP_TEMPLATENAME_MAX_LENGTH ) );
+                pTopic->text[ pTopic->nameOffset + randomBelow( ( uint32_t ) pTopic->nameLength ) ] =
+                    invalidNameCharacters[ randomBelow( sizeof( invalidNameCharacters ) - 1U ) ];
+                break;
+
+            default:
+                /* The bridge of a RegisterThing topic with one character
+                 * changed, or a request prefix without its trailing slash. */
+                if( pTopic->nameLength > 0U )
+                {
+                    offset = pTopic->nameOffset + pTopic->nameLength + 1U + randomBelow( FP_REGISTER_API_LENGTH_BRIDGE - 2U );
+                    pTopic->text[ offset ] = otherCharacter( pTopic->text[ offset ] );
+                }
+                else
+                {
+                    pTopic->length = pTopic->nameOffset - 1U;
+                }
+
+                break;
+        }
+    } while( FleetProvisioning_MatchTopic( pTopic->text, ( uint16_t ) pTopic->length, &match ) == FleetProvisioningSuccess );
+}
+/*-----------------------------------------------------------*/
+
+static void randomForeign( Topic_t * pTopic )
+{
+    static const char * const shadowActions[] = { "get", "update", "delete" };
+    static const char * const shadowSuffixes[] = { "", "/accepted", "/rejected", "/delta", "/documents" };
+    static const char * const jobActions[] = { "notify", "notify-next", "get", "start-next" };
+    static const char * const jobSuffixes[] = { "/get", "/update", "/get/accepted", "/update/rejected" };
+    uint32_t kind = randomBelow( 4U );
+    uint32_t choice;
+
+    pTopic->length = 0U;
+
+    if( kind < 2U )
+    {
+        /* Thing names are often long serial numbers or ARNs. */
+        append( pTopic, "$aws/things/", 12U );
+        appendName( pTopic, ( randomBelow( 2U ) == 0U ) ? THING_NAME_MAX_LENGTH : ( 1U + randomBelow( THING_NAME_MAX_LENGTH ) ) );
+    }
+
+    if( kind == 0U )
+    {
+        append( pTopic, "/shadow/", 8U );
+
+        if( randomBelow( 2U ) == 0U )
+        {
+            append( pTopic, "name/", 5U );
+            appendName( pTopic, 1U + randomBelow( SHADOW_NAME_MAX_LENGTH ) );
+            append( pTopic, "/", 1U );
+        }
+
+        choice = randomBelow( 3U );
+        append( pTopic, shadowActions[ choice ], strlen( shadowActions[ choice ] ) );
+        choice = randomBelow( 5U );
+        append( pTopic, shadowSuffixes[ choice ], strlen( shadowSuffixes[ choice ] ) );
+    }
+    else if( kind == 1U )
+    {
+        append( pTopic, "/jobs/", 6U );
+
+        if( randomBelow( 2U ) == 0U )
+        {
+            choice = randomBelow( 4U );
+            append( pTopic, jobActions[ choice ], strlen( jobActions[ choice ] ) );
+        }
+        else
+        {
+            appendName( pTopic, 1U + randomBelow( SHADOW_NAME_MAX_LENGTH ) );
+            choice = randomBelow( 4U );
+            append( pTopic, jobSuffixes[ choice ], strlen( jobSuffixes[ choice ] ) );
+        }
+    }
+    else if( kind == 2U )
+    {
+        /* Other reserved topics, some sharing the start of the
+         * certificates prefix. */
+        choice = randomBelow( 3U );
+
+        if( choice == 0U )
+        {
+            append( pTopic, "$aws/events/presence/connected/", 31U );
+            appendName( pTopic, 1U + randomBelow( THING_NAME_MAX_LENGTH ) );
+        }
+        else if( choice == 1U )
+        {
+            append( pTopic, "$aws/rules/", 11U );
+            appendName( pTopic, 1U + randomBelow( SHADOW_NAME_MAX_LENGTH ) );
+        }
+        else
+        {
+            append( pTopic, "$aws/certificates/", 18U );
+            appendName( pTopic, 1U + randomBelow( 16U ) );
+        }
+    }
+    else
+    {
+        /* Application telemetry. */
+        append( pTopic, "devices/", 8U );
+        appendName( pTopic, 1U + randomBelow( 32U ) );
+        append( pTopic, "/telemetry/", 11U );
+        appendName( pTopic, 1U + randomBelow( 16U ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value < minimum ) || ( value > maximum ) )
+    {
+        fprintf( stderr, "Expected a number from %lu to %lu.\n", minimum, maximum );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static Topic_t topic;
+    CorpusSettings_t settings = { 10000UL, 40UL, 30UL, 34UL, 25UL };
+    const char * pOutputPath = NULL;
+    const char * pCategory;
+    FILE * pOutput = stdout;
+    uint32_t draw;
+    unsigned long i;
+    int arg;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--count" ) == 0 )
+        {
+            settings.count = parseNumber( pValue, 1UL, 100000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--seed" ) == 0 )
+        {
+            randomState = ( uint32_t ) parseNumber( pValue, 1UL, 0xFFFFFFFFUL );
+        }
+        else if( strcmp( argv[ arg ], "--valid-percent" ) == 0 )
+        {
+            settings.validPercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--near-miss-percent" ) == 0 )
+        {
+            settings.nearMissPercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--register-percent" ) == 0 )
+        {
+            settings.registerPercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--max-name-percent" ) == 0 )
+        {
+            settings.maxNamePercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--output" ) == 0 )
+        {
+            pOutputPath = pValue;
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s [--count N] [--seed N] [--valid-percent P] [--near-miss-percent P] "
+                     "[--register-percent P] [--max-name-percent P] [--output FILE]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            fprintf( stderr, "Missing value for %s.\n", argv[ arg ] );
+            return EXIT_FAILURE;
+        }
+
+        arg++;
+    }
+
+    if( ( settings.validPercent + settings.nearMissPercent ) > 100UL )
+    {
+        fprintf( stderr, "The valid and near-miss shares add up to more than 100%%.\n" );
+        return EXIT_FAILURE;
+    }
+
+    if( pOutputPath != NULL )
+    {
+        pOutput = fopen( pOutputPath, "w" );
+
+        if( pOutput == NULL )
+        {
+            fprintf( stderr, "Cannot open %s.\n", pOutputPath );
+            return EXIT_FAILURE;
+        }
+    }
+
+    for( i = 0UL; i < settings.count; i++ )
+    {
+        draw = randomBelow( 100U );
+
+        if( draw < settings.validPercent )
+        {
+            pCategory = "valid";
+            randomValid( &settings, &topic );
+        }
+        else if( draw < ( settings.validPercent + settings.nearMissPercent ) )
+        {
+            pCategory = "near-miss";
+            randomNearMiss( &settings, &topic );
+        }
+        else
+        {
+            pCategory = "foreign";
+            randomForeign( &topic );
+        }
+
+        fprintf( pOutput, "%s\t%.*s\n", pCategory, ( int ) topic.length, topic.text );
+    }
+
+    return ( fclose( pOutput ) == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,356 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_e2e.c
+ * @brief End-to-end check of provisioning sessions against the mock Fleet
+ * Provisioning service.
+ *
+ * Each scenario drives one or more sessions through their whole flow, with
+ * the mock answering on a simulated clock, and checks how they end. The exit
+ * status is non-zero if any scenario fails.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_session.h"
+
+#include "mock_service.h"
+
+/**
+ * @brief Template name used by the sessions.
+ */
+#define TEMPLATE_NAME             "FleetTemplate"
+
+/**
+ * @brief Length of the payload buffer of a session.
+ */
+#define PAYLOAD_BUFFER_LENGTH     ( 2048U )
+
+/**
+ * @brief Latencies of the mock.
+ */
+#define MIN_LATENCY_NS            ( 20000000U )
+#define MAX_LATENCY_NS            ( 200000000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A session with its buffers.
+ */
+typedef struct Device
+{
+    FleetProvisioningSession_t session;            /**< @brief The session. */
+    uint32_t clientId;                             /**< @brief ID of the device with the mock. */
+    FleetProvisioningActionType_t result;          /**< @brief Done or Failed once finished, None before. */
+    char topicBuffer[ FP_SESSION_TOPIC_BUFFER_LENGTH ]; /**< @brief Topic buffer of the session. */
+    char payloadBuffer[ PAYLOAD_BUFFER_LENGTH ];   /**< @brief Payload buffer of the session. */
+} Device_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Stand-in for a DER certificate signing request; the mock only
+ * checks that a CSR is sent.
+ */
+static const uint8_t csrDer[] = { 0x30U, 0x82U, 0x01U, 0x0AU, 0x02U, 0x01U, 0x00U, 0x30U };
+
+/**
+ * @brief The template parameters sent by the sessions.
+ */
+static const FleetProvisioningTemplateParameter_t parameters[] =
+{
+    { "SerialNumber", 12U, "e2e-0001", 8U }
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Carry out an action of a session.
+ *
+ * @param[in] pService The mock service.
+ * @param[in] nowNs The current time.
+ * @param[in] pDevice The device of the session.
+ * @param[in] pAction The action.
+ *
+ * @return 0 if the action is carried out, or 1 on an error.
+ */
+static int carryOut( MockService_t * pService,
+                     uint64_t nowNs,
+                     Device_t * pDevice,
+                     const FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Run sessions until they all finish.
+ *
+ * @param[in] pService The mock service.
+ * @param[in] pDevices The devices, initialized.
+ * @param[in] deviceCount The number of devices.
+ *
+ * @return 0 if the sessions ran, or 1 on an error.
+ */
+static int runSessions( MockService_t * pService,
+                        Device_t * pDevices,
+                        size_t deviceCount );
+
+/**
+ * @brief Run one scenario.
+ *
+ * @param[in] pName The name of the scenario.
+ * @param[in] pServiceConfig The behavior of the mock.
+ * @param[in] format The format of the sessions.
+ * @param[in] useCsr Non-zero to use CreateCertificateFromCSR.
+ * @param[in] deviceCount The number of sessions, at most 4.
+ * @param[in] expectedDone The number of sessions expected to succeed; the
+ * others are expected to fail.
+ *
+ * @return 0 if the scenario passes, or 1 otherwise.
+ */
+static int runScenario( const char * pName,
+                        const MockServiceConfig_t * pServiceConfig,
+                        FleetProvisioningFormat_t format,
+                        uint8_t useCsr,
+                        size_t deviceCount,
+                        size_t expectedDone );
+
+/*-----------------------------------------------------------*/
+
+static int carryOut( MockService_t * pService,
+                     uint64_t nowNs,
+                     Device_t * pDevice,
+                     const FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningEvent_t event;
+    FleetProvisioningAction_t next;
+    FleetProvisioningStatus_t status;
+    int error = 0;
+
+    if( pAction->type == FleetProvisioningActionSubscribe )
+    {
+        /* Subscriptions are acknowledged at once. */
+        ( void ) memset( &event, 0, sizeof( event ) );
+        event.type = FleetProvisioningEventSubscribed;
+
+        if( FleetProvisioning_SessionHandleEvent( &( pDevice->session ), &event, &next ) != FleetProvisioningSuccess )
+        {
+            error = 1;
+        }
+        else
+        {
+            error = carryOut( pService, nowNs, pDevice, &next );
+        }
+    }
+    else if( pAction->type == FleetProvisioningActionPublish )
+    {
+        status = MockService_Publish( pService, nowNs, pDevice->clientId,
+                                      pAction->topics[ 0 ].pData, ( uint16_t ) pAction->topics[ 0 ].length,
+                                      pAction->payload.pData, pAction->payload.length );
+        error = ( status == FleetProvisioningSuccess ) ? 0 : 1;
+    }
+    else if( ( pAction->type == FleetProvisioningActionDone ) || ( pAction->type == FleetProvisioningActionFailed ) )
+    {
+        pDevice->result = pAction->type;
+    }
+    else
+    {
+        /* Nothing to do. */
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static int runSessions( MockService_t * pService,
+                        Device_t * pDevices,
+                        size_t deviceCount )
+{
+    static char topic[ MOCK_MAX_TOPIC_LENGTH ];
+    static char payload[ MOCK_MAX_PAYLOAD_LENGTH ];
+    FleetProvisioningEvent_t event;
+    FleetProvisioningAction_t action;
+    uint64_t nowNs = 0U;
+    uint32_t clientId;
+    uint16_t topicLength;
+    size_t payloadLength;
+    size_t i;
+    int error = 0;
+
+    ( void ) memset( &event, 0, sizeof( event ) );
+    event.type = FleetProvisioningEventStart;
+
+    for( i = 0U; ( i < deviceCount ) && ( error == 0 ); i++ )
+    {
+        if( FleetProvisioning_SessionHandleEvent( &( pDevices[ i ].session ), &event, &action ) != FleetProvisioningSuccess )
+        {
+            error = 1;
+        }
+        else
+        {
+            error = carryOut( pService, nowNs, &( pDevices[ i ] ), &action );
+        }
+    }
+
+    while( ( error == 0 ) && ( MockService_NextDue( pService, &nowNs ) == FleetProvisioningSuccess ) )
+    {
+        ( void ) MockService_Poll( pService, nowNs, &clientId, topic, &topicLength, payload, &payloadLength );
+        event.type = FleetProvisioningEventMessage;
+        event.pPayload = payload;
+        event.payloadLength = payloadLength;
+
+        if( ( clientId >= deviceCount ) ||
+            ( FleetProvisioning_MatchTopic( topic, topicLength, &( event.topic ) ) != FleetProvisioningSuccess ) ||
+            ( FleetProvisioning_SessionHandleEvent( &( pDevices[ clientId ].session ), &event, &action ) != FleetProvisioningSuccess ) )
+        {
+            error = 1;
+        }
+        else
+        {
+            error = carryOut( pService, nowNs, &( pDevices[ clientId ] ), &action );
+        }
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static int runScenario( const char * pName,
+                        const MockServiceConfig_t * pServiceConfig,
+                        FleetProvisioningFormat_t format,
+                        uint8_t useCsr,
+                        size_t deviceCount,
+                        size_t expectedDone )
+{
+    static Device_t devices[ 4 ];
+    MockService_t service;
+    FleetProvisioningSessionConfig_t config;
+    size_t done = 0U;
+    size_t failed = 0U;
+    size_t i;
+    int error = 0;
+
+    ( void ) memset( &config, 0, sizeof( config ) );
+    config.format = format;
+    config.pTemplateName = TEMPLATE_NAME;
+    config.templateNameLength = ( uint16_t ) ( sizeof( TEMPLATE_NAME ) - 1U );
+    config.pCsrDer = ( useCsr != 0U ) ? csrDer : NULL;
+    config.csrDerLength = ( useCsr != 0U ) ? sizeof( csrDer ) : 0U;
+    config.pParameters = parameters;
+    config.parameterCount = sizeof( parameters ) / sizeof( parameters[ 0 ] );
+
+    if( MockService_Init( &service, pServiceConfig ) != FleetProvisioningSuccess )
+    {
+        error = 1;
+    }
+    else
+    {
+        for( i = 0U; ( i < deviceCount ) && ( error == 0 ); i++ )
+        {
+            devices[ i ].clientId = ( uint32_t ) i;
+            devices[ i ].result = FleetProvisioningActionNone;
+
+            /* Cover both the subscribing and the shared subscriptions
+             * flows. */
+            config.sharedSubscriptions = ( uint8_t ) ( i % 2U );
+
+            if( FleetProvisioning_SessionInit( &( devices[ i ].session ), &config,
+                                               devices[ i ].topicBuffer, sizeof( devices[ i ].topicBuffer ),
+                                               devices[ i ].payloadBuffer, sizeof( devices[ i ].payloadBuffer ) ) != FleetProvisioningSuccess )
+            {
+                error = 1;
+            }
+        }
+
+        if( error == 0 )
+        {
+            error = runSessions( &service, devices, deviceCount );
+        }
+
+        for( i = 0U; i < deviceCount; i++ )
+        {
+            if( devices[ i ].result == FleetProvisioningActionDone )
+            {
+                done++;
+            }
+            else if( devices[ i ].result == FleetProvisioningActionFailed )
+            {
+                failed++;
+            }
+            else
+            {
+                /* Unfinished. */
+            }
+        }
+
+        if( ( done != expectedDone ) || ( ( done + failed ) != deviceCount ) )
+        {
+            error = 1;
+        }
+
+        MockService_Cleanup( &service );
+    }
+
+    printf( "%s %s: %lu done, %lu failed\n", ( error == 0 ) ? "PASS" : "FAIL", pName,
+            ( unsigned long ) done, ( unsigned long ) failed );
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    MockServiceConfig_t serviceConfig;
+    int failures = 0;
+
+    ( void ) memset( &serviceConfig, 0, sizeof( serviceConfig ) );
+    serviceConfig.minLatencyNs = MIN_LATENCY_NS;
+    serviceConfig.maxLatencyNs = MAX_LATENCY_NS;
+    serviceConfig.maxPending = 16U;
+    serviceConfig.seed = 1U;
+
+    failures += runScenario( "JsonCreateKeys", &serviceConfig, FleetProvisioningJson, 0U, 1U, 1U );
+    failures += runScenario( "JsonCreateCert", &serviceConfig, FleetProvisioningJson, 1U, 1U, 1U );
+    failures += runScenario( "CborCreateKeys", &serviceConfig, FleetProvisioningCbor, 0U, 1U, 1U );
+    failures += runScenario( "CborCreateCert", &serviceConfig, FleetProvisioningCbor, 1U, 1U, 1U );
+    failures += runScenario( "Concurrent", &serviceConfig, FleetProvisioningJson, 0U, 4U, 4U );
+
+    /* Two requests per second for each API: of four sessions starting
+     * together, two get credentials and the others are throttled. */
+    serviceConfig.ratePerSecond = 2U;
+    failures += runScenario( "RateLimited", &serviceConfig, FleetProvisioningCbor, 0U, 4U, 2U );
+    serviceConfig.ratePerSecond = 0U;
+
+    serviceConfig.throttlePercent = 100U;
+    failures += runScenario( "Throttled", &serviceConfig, FleetProvisioningJson, 0U, 2U, 0U );
+    serviceConfig.throttlePercent = 0U;
+
+    serviceConfig.errorPercent = 100U;
+    failures += runScenario( "Errors", &serviceConfig, FleetProvisioningCbor, 1U, 2U, 0U );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,731 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_load.c
+ * @brief Load generator provisioning a simulated fleet of devices through
+ * the AWS IoT Fleet Provisioning Library, against the mock service.
+ *
+ * Usage: fleet_provisioning_load [--devices N] [--concurrency N]
+ * [--templates N] [--cbor-percent P] [--csr-percent P]
+ * [--throttle-percent P] [--error-percent P] [--rate N]
+ * [--min-latency-ms N] [--max-latency-ms N] [--start-window-ms N] [--seed N]
+ * [--record FILE]
+ *
+ * Devices are scheduled to start over the start window, spread with
+ * #FleetProvisioning_GetStartDelay, and provisioned by a gateway running at
+ * most --concurrency sessions at once; the others queue for a free session.
+ * Each session requests credentials with CreateKeysAndCertificate, or with
+ * CreateCertificateFromCSR for --csr-percent of the devices, then registers
+ * the device with one of --templates templates. The mock answers with
+ * latencies in the given range, throttling and failing at the given rates,
+ * and limiting each API to --rate requests per second if set.
+ *
+ * The fleet runs on a simulated clock, so the latencies reported are those
+ * the service and the queueing would give, while the wall clock time of the
+ * run is the cost of the library and the mock. The report gives the
+ * simulated and measured throughput, and the p50, p99 and p999 latencies of
+ * each phase. With --record, the requests and responses are written to a
+ * trace for fleet_provisioning_replay, as seen by the gateway. The exit
+ * status is non-zero if the run stalls or the trace cannot be written.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_schedule.h"
+#include "fleet_provisioning_session.h"
+
+#include "bench_common.h"
+#include "mock_service.h"
+#include "trace.h"
+
+/**
+ * @brief Length of the payload buffer of a session.
+ */
+#define PAYLOAD_BUFFER_LENGTH     ( 2048U )
+
+/**
+ * @brief Length of the device serial numbers, "device-" and eight digits.
+ */
+#define SERIAL_LENGTH             ( 15U )
+
+/**
+ * @brief Most templates in the mix.
+ */
+#define MAX_TEMPLATES             ( 16U )
+
+/**
+ * @brief Nanoseconds in a millisecond.
+ */
+#define NS_PER_MS                 ( 1000000U )
+
+/**
+ * @brief Phases of the flow of a device.
+ */
+#define PHASE_QUEUED              ( 0U )
+#define PHASE_CREDENTIALS         ( 1U )
+#define PHASE_REGISTER            ( 2U )
+#define PHASE_TOTAL               ( 3U )
+#define PHASE_COUNT               ( 4U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Settings of a run.
+ */
+typedef struct LoadSettings
+{
+    unsigned long devices;       /**< @brief Devices to provision. */
+    unsigned long concurrency;   /**< @brief Most sessions at once. */
+    unsigned long templates;     /**< @brief Templates in the mix. */
+    unsigned long cborPercent;   /**< @brief Share of devices using CBOR. */
+    unsigned long csrPercent;    /**< @brief Share of devices using CreateCertificateFromCSR. */
+    unsigned long startWindowMs; /**< @brief Window the devices start over. */
+    MockServiceConfig_t service; /**< @brief Behavior of the mock. */
+} LoadSettings_t;
+
+/**
+ * @brief A device scheduled to start.
+ */
+typedef struct Arrival
+{
+    uint64_t startNs; /**< @brief When the device is scheduled to start. */
+    uint32_t device;  /**< @brief Number of the device. */
+} Arrival_t;
+
+/**
+ * @brief A session of the gateway, with its buffers.
+ */
+typedef struct Slot
+{
+    FleetProvisioningSession_t session;                 /**< @brief The session. */
+    FleetProvisioningTemplateParameter_t parameter;     /**< @brief The serial number parameter. */
+    uint64_t scheduledNs;                               /**< @brief When the device was scheduled to start. */
+    uint64_t phaseStartNs;                              /**< @brief When the current phase started. */
+    uint32_t phase;                                     /**< @brief The current phase. */
+    char serial[ SERIAL_LENGTH + 1U ];                  /**< @brief Serial number of the device. */
+    char topicBuffer[ FP_SESSION_TOPIC_BUFFER_LENGTH ]; /**< @brief Topic buffer of the session. */
+    char payloadBuffer[ PAYLOAD_BUFFER_LENGTH ];        /**< @brief Payload buffer of the session. */
+} Slot_t;
+
+/**
+ * @brief State of a run.
+ */
+typedef struct Load
+{
+    const LoadSettings_t * pSettings;      /**< @brief Settings of the run. */
+    MockService_t service;                 /**< @brief The mock service. */
+    Slot_t * pSlots;                       /**< @brief Sessions of the gateway. */
+    uint32_t * pFreeSlots;                 /**< @brief Stack of the free sessions. */
+    size_t freeCount;                      /**< @brief Number of free sessions. */
+    double * pLatencies[ PHASE_COUNT ];    /**< @brief Latencies of each phase, in milliseconds. */
+    size_t latencyCounts[ PHASE_COUNT ];   /**< @brief Number of latencies of each phase. */
+    unsigned long done;                    /**< @brief Devices provisioned. */
+    unsigned long failed[ PHASE_COUNT ];   /**< @brief Devices failed in each phase. */
+    uint64_t nowNs;                        /**< @brief Simulated time. */
+    TraceWriter_t * pRecorder;             /**< @brief Trace of the messages, or NULL. */
+} Load_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Template names of the mix.
+ */
+static char templateNames[ MAX_TEMPLATES ][ 16 ];
+
+/**
+ * @brief Stand-in for a DER certificate signing request; the mock only
+ * checks that a CSR is sent.
+ */
+static const uint8_t csrDer[] = { 0x30U, 0x82U, 0x01U, 0x0AU, 0x02U, 0x01U, 0x00U, 0x30U };
+
+/**
+ * @brief Names of the phases in the report.
+ */
+static const char * const phaseNames[ PHASE_COUNT ] = { "queued", "credentials", "register", "total" };
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Parse a numeric option.
+ *
+ * @param[in] pArgument The value of the option.
+ * @param[in] minimum The smallest value allowed.
+ * @param[in] maximum The largest value allowed.
+ *
+ * @return The value; the program exits if it is invalid.
+ */
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum );
+
+/**
+ * @brief Write the serial number of a device.
+ *
+ * @param[out] pSerial Buffer of #SERIAL_LENGTH characters and a null.
+ * @param[in] device The number of the device, below 100000000.
+ */
+static void formatSerial( char * pSerial,
+                          uint32_t device );
+
+/**
+ * @brief Order arrivals by start time for qsort.
+ */
+static int compareArrivals( const void * pLeft,
+                            const void * pRight );
+
+/**
+ * @brief Record the latency of a phase.
+ *
+ * @param[in] pLoad The run.
+ * @param[in] phase The phase.
+ * @param[in] startNs When the phase started.
+ */
+static void recordLatency( Load_t * pLoad,
+                           uint32_t phase,
+                           uint64_t startNs );
+
+/**
+ * @brief Carry out an action of a session.
+ *
+ * @param[in] pLoad The run.
+ * @param[in] slotIndex The session.
+ * @param[in] pAction The action.
+ *
+ * @return 0 if the action is carried out, or 1 on an error.
+ */
+static int carryOut( Load_t * pLoad,
+                     uint32_t slotIndex,
+                     const FleetProvisioningAction_t * pAction );
+
+/**
+ * @brief Start the flow of a device in a free session.
+ *
+ * @param[in] pLoad The run.
+ * @param[in] pArrival The device.
+ *
+ * @return 0 if the flow is started, or 1 on an error.
+ */
+static int startDevice( Load_t * pLoad,
+                        const Arrival_t * pArrival );
+
+/**
+ * @brief Deliver the next response of the mock to its session.
+ *
+ * @param[in] pLoad The run.
+ *
+ * @return 0 if the response is delivered, or 1 on an error.
+ */
+static int deliverResponse( Load_t * pLoad );
+
+/**
+ * @brief Print the report of a run.
+ *
+ * @param[in] pLoad The run.
+ * @param[in] wallNs The wall clock time of the run.
+ */
+static void printReport( Load_t * pLoad,
+                         uint64_t wallNs );
+
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value < minimum ) || ( value > maximum ) )
+    {
+        fprintf( stderr, "Expected a number from %lu to %lu.\n", minimum, maximum );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+static void formatSerial( char * pSerial,
+                          uint32_t device )
+{
+    uint32_t value = device;
+    size_t i;
+
+    ( void ) memcpy( pSerial, "device-", 7U );
+
+    for( i = SERIAL_LENGTH; i > 7U; i-- )
+    {
+        pSerial[ i - 1U ] = ( char ) ( '0' + ( value % 10U ) );
+        value /= 10U;
+    }
+
+    pSerial[ SERIAL_LENGTH ] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+static int compareArrivals( const void * pLeft,
+                            const void * pRight )
+{
+    const Arrival_t * pLeftArrival = pLeft;
+    const Arrival_t * pRightArrival = pRight;
+    int order = ( pLeftArrival->startNs > pRightArrival->startNs ) - ( pLeftArrival->startNs < pRightArrival->startNs );
+
+    if( order == 0 )
+    {
+        order = ( pLeftArrival->device > pRightArrival->device ) - ( pLeftArrival->device < pRightArrival->device );
+    }
+
+    return order;
+}
+/*-----------------------------------------------------------*/
+
+static void recordLatency( Load_t * pLoad,
+                           uint32_t phase,
+                           uint64_t startNs )
+{
+    pLoad->pLatencies[ phase ][ pLoad->latencyCounts[ phase ] ] = ( double ) ( pLoad->nowNs - startNs ) / ( double ) NS_PER_MS;
+    pLoad->latencyCounts[ phase ]++;
+}
+/*-----------------------------------------------------------*/
+
+static int carryOut( Load_t * pLoad,
+                     uint32_t slotIndex,
+                     const FleetProvisioningAction_t * pAction )
+{
+    Slot_t * pSlot = &( pLoad->pSlots[ slotIndex ] );
+    int error = 0;
+
+    if( pAction->type == FleetProvisioningActionPublish )
+    {
+        /* A RegisterThing request ends the credentials phase. */
+        if( pAction->credentials.certificatePem.length > 0U )
+        {
+            recordLatency( pLoad, PHASE_CREDENTIALS, pSlot->phaseStartNs );
+            pSlot->phaseStartNs = pLoad->nowNs;
+            pSlot->phase = PHASE_REGISTER;
+        }
+
+        if( pLoad->pRecorder != NULL )
+        {
+            error = Trace_Write( pLoad->pRecorder, pLoad->nowNs, TRACE_OUTBOUND,
+                                 pAction->topics[ 0 ].pData, ( uint16_t ) pAction->topics[ 0 ].length,
+                                 pAction->payload.pData, pAction->payload.length );
+        }
+
+        error |= ( MockService_Publish( &( pLoad->service ), pLoad->nowNs, slotIndex,
+                                       pAction->topics[ 0 ].pData, ( uint16_t ) pAction->topics[ 0 ].length,
+                                       pAction->payload.pData, pAction->payload.length ) == FleetProvisioningSuccess ) ? 0 : 1;
+    }
+    else if( ( pAction->type == FleetProvisioningActionDone ) || ( pAction->type == FleetProvisioningActionFailed ) )
+    {
+        if( pAction->type == FleetProvisioningActionDone )
+        {
+            recordLatency( pLoad, PHASE_REGISTER, pSlot->phaseStartNs );
+            recordLatency( pLoad, PHASE_TOTAL, pSlot->scheduledNs );
+            pLoad->done++;
+        }
+        else
+        {
+            pLoad->failed[ pSlot->phase ]++;
+        }
+
+        pLoad->pFreeSlots[ pLoad->freeCount ] = slotIndex;
+        pLoad->freeCount++;
+    }
+    else
+    {
+        /* The sessions share the subscriptions of the gateway, so request
+         * none. */
+        error = ( pAction->type == FleetProvisioningActionNone ) ? 0 : 1;
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static int startDevice( Load_t * pLoad,
+                        const Arrival_t * pArrival )
+{
+    const LoadSettings_t * pSettings = pLoad->pSettings;
+    FleetProvisioningSessionConfig_t config;
+    FleetProvisioningEvent_t event;
+    FleetProvisioningAction_t action;
+    uint32_t slotIndex;
+    Slot_t * pSlot;
+    uint32_t mix = pArrival->device * 2654435761U;
+    int error = 1;
+
+    pLoad->freeCount--;
+    slotIndex = pLoad->pFreeSlots[ pLoad->freeCount ];
+    pSlot = &( pLoad->pSlots[ slotIndex ] );
+    pSlot->scheduledNs = pArrival->startNs;
+    pSlot->phaseStartNs = pLoad->nowNs;
+    pSlot->phase = PHASE_CREDENTIALS;
+    recordLatency( pLoad, PHASE_QUEUED, pArrival->startNs );
+    formatSerial( pSlot->serial, pArrival->device );
+
+    pSlot->parameter.pKey = "SerialNumber";
+    pSlot->parameter.keyLength = 12U;
+    pSlot->parameter.pValue = pSlot->serial;
+    pSlot->parameter.valueLength = SERIAL_LENGTH;
+
+    /* Pick the template, format and API of the device from its number. */
+    ( void ) memset( &config, 0, sizeof( config ) );
+    config.format = ( ( ( mix >> 8 ) % 100U ) < pSettings->cborPercent ) ? FleetProvisioningCbor : FleetProvisioningJson;
+    config.pTemplateName = templateNames[ pArrival->device % pSettings->templates ];
+    config.templateNameLength = ( uint16_t ) strlen( config.pTemplateName );
+    config.pCsrDer = ( ( ( mix >> 20 ) % 100U ) < pSettings->csrPercent ) ? csrDer : NULL;
+    config.csrDerLength = ( config.pCsrDer != NULL ) ? sizeof( csrDer ) : 0U;
+    config.pParameters = &( pSlot->parameter );
+    config.parameterCount = 1U;
+    config.sharedSubscriptions = 1U;
+
+    ( void ) memset( &event, 0, sizeof( event ) );
+    event.type = FleetProvisioningEventStart;
+
+    if( ( FleetProvisioning_SessionInit( &( pSlot->session ), &config,
+                                         pSlot->topicBuffer, sizeof( pSlot->topicBuffer ),
+                                         pSlot->payloadBuffer, sizeof( pSlot->payloadBuffer ) ) == FleetProvisioningSuccess ) &&
+        ( FleetProvisioning_SessionHandleEvent( &( pSlot->session ), &event, &action ) == FleetProvisioningSuccess ) )
+    {
+        error = carryOut( pLoad, slotIndex, &action );
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static int deliverResponse( Load_t * pLoad )
+{
+    static char topic[ MOCK_MAX_TOPIC_LENGTH ];
+    static char payload[ MOCK_MAX_PAYLOAD_LENGTH ];
+    FleetProvisioningEvent_t event;
+    FleetProvisioningAction_t action;
+    uint32_t slotIndex = 0U;
+    uint16_t topicLength = 0U;
+    size_t payloadLength = 0U;
+    int error = 1;
+
+    ( void ) memset( &event, 0, sizeof( event ) );
+    event.type = FleetProvisioningEventMessage;
+    event.pPayload = payload;
+
+    if( ( MockService_Poll( &( pLoad->service ), pLoad->nowNs, &slotIndex, topic, &topicLength,
+                            payload, &payloadLength ) == FleetProvisioningSuccess ) &&
+        ( FleetProvisioning_MatchTopic( topic, topicLength, &( event.topic ) ) == FleetProvisioningSuccess ) )
+    {
+        event.payloadLength = payloadLength;
+        error = 0;
+
+        if( pLoad->pRecorder != NULL )
+        {
+            error = Trace_Write( pLoad->pRecorder, pLoad->nowNs, TRACE_INBOUND,
+                                 topic, topicLength, payload, payloadLength );
+        }
+
+        if( ( error == 0 ) &&
+            ( FleetProvisioning_SessionHandleEvent( &( pLoad->pSlots[ slotIndex ].session ), &event, &action ) == FleetProvisioningSuccess ) )
+        {
+            error = carryOut( pLoad, slotIndex, &action );
+        }
+        else
+        {
+            error = 1;
+        }
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static void printReport( Load_t * pLoad,
+                         uint64_t wallNs )
+{
+    static const char * const apiNames[ MOCK_API_COUNT ] = { "CreateCertificateFromCsr", "CreateKeysAndCertificate", "RegisterThing" };
+    const MockServiceStats_t * pStats = &( pLoad->service.stats );
+    unsigned long failed = 0UL;
+    uint32_t phase;
+    uint32_t api;
+
+    for( phase = 0U; phase < PHASE_COUNT; phase++ )
+    {
+        failed += pLoad->failed[ phase ];
+    }
+
+    printf( "devices: %lu provisioned, %lu failed getting credentials, %lu failed registering\n",
+            pLoad->done, pLoad->failed[ PHASE_CREDENTIALS ], pLoad->failed[ PHASE_REGISTER ] );
+    printf( "simulated: %.3f s, %.1f devices/s\n", ( double ) pLoad->nowNs / 1e9,
+            ( pLoad->nowNs > 0U ) ? ( ( double ) ( pLoad->done + failed ) * 1e9 / ( double ) pLoad->nowNs ) : 0.0 );
+    printf( "wall clock: %.3f s, %.1f devices/s\n", ( double ) wallNs / 1e9,
+            ( wallNs > 0U ) ? ( ( double ) ( pLoad->done + failed ) * 1e9 / ( double ) wallNs ) : 0.0 );
+    printf( "%-12s %10s %12s %12s %12s\n", "phase (ms)", "count", "p50", "p99", "p999" );
+
+    for( phase = 0U; phase < PHASE_COUNT; phase++ )
+    {
+        printf( "%-12s %10lu %12.3f %12.3f %12.3f\n", phaseNames[ phase ],
+                ( unsigned long ) pLoad->latencyCounts[ phase ],
+                Bench_Percentile( pLoad->pLatencies[ phase ], pLoad->latencyCounts[ phase ], 50.0 ),
+                Bench_Percentile( pLoad->pLatencies[ phase ], pLoad->latencyCounts[ phase ], 99.0 ),
+                Bench_Percentile( pLoad->pLatencies[ phase ], pLoad->latencyCounts[ phase ], 99.9 ) );
+    }
+
+    printf( "%-26s %10s %10s %10s %10s\n", "service", "requests", "accepted", "throttled", "failed" );
+
+    for( api = 0U; api < MOCK_API_COUNT; api++ )
+    {
+        printf( "%-26s %10lu %10lu %10lu %10lu\n", apiNames[ api ],
+                ( unsigned long ) pStats->requests[ api ], ( unsigned long ) pStats->accepted[ api ],
+                ( unsigned long ) pStats->throttled[ api ], ( unsigned long ) pStats->failed[ api ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static Load_t load;
+    static TraceWriter_t recorder;
+    const char * pRecordPath = NULL;
+    LoadSettings_t settings;
+    Arrival_t * pArrivals;
+    uint64_t dueNs = 0U;
+    uint64_t wallStartNs;
+    uint32_t delayMs = 0U;
+    unsigned long next = 0UL;
+    unsigned long i;
+    uint32_t phase;
+    int haveDue;
+    int error = 0;
+    int arg;
+
+    ( void ) memset( &settings, 0, sizeof( settings ) );
+    settings.devices = 100000UL;
+    settings.concurrency = 1000UL;
+    settings.templates = 4UL;
+    settings.cborPercent = 50UL;
+    settings.csrPercent = 50UL;
+    settings.service.minLatencyNs = 20U * ( uint64_t ) NS_PER_MS;
+    settings.service.maxLatencyNs = 200U * ( uint64_t ) NS_PER_MS;
+    settings.service.seed = 1U;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--devices" ) == 0 )
+        {
+            settings.devices = parseNumber( pValue, 1UL, 100000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--concurrency" ) == 0 )
+        {
+            settings.concurrency = parseNumber( pValue, 1UL, 1000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--templates" ) == 0 )
+        {
+            settings.templates = parseNumber( pValue, 1UL, MAX_TEMPLATES );
+        }
+        else if( strcmp( argv[ arg ], "--cbor-percent" ) == 0 )
+        {
+            settings.cborPercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--csr-percent" ) == 0 )
+        {
+            settings.csrPercent = parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--throttle-percent" ) == 0 )
+        {
+            settings.service.throttlePercent = ( uint32_t ) parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--error-percent" ) == 0 )
+        {
+            settings.service.errorPercent = ( uint32_t ) parseNumber( pValue, 0UL, 100UL );
+        }
+        else if( strcmp( argv[ arg ], "--rate" ) == 0 )
+        {
+            settings.service.ratePerSecond = ( uint32_t ) parseNumber( pValue, 0UL, 1000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--min-latency-ms" ) == 0 )
+        {
+            settings.service.minLatencyNs = parseNumber( pValue, 0UL, 3600000UL ) * ( uint64_t ) NS_PER_MS;
+        }
+        else if( strcmp( argv[ arg ], "--max-latency-ms" ) == 0 )
+        {
+            settings.service.maxLatencyNs = parseNumber( pValue, 0UL, 3600000UL ) * ( uint64_t ) NS_PER_MS;
+        }
+        else if( strcmp( argv[ arg ], "--start-window-ms" ) == 0 )
+        {
+            settings.startWindowMs = parseNumber( pValue, 0UL, 0xFFFFFFFFUL );
+        }
+        else if( strcmp( argv[ arg ], "--seed" ) == 0 )
+        {
+            settings.service.seed = ( uint32_t ) parseNumber( pValue, 1UL, 0xFFFFFFFFUL );
+        }
+        else if( strcmp( argv[ arg ], "--record" ) == 0 )
+        {
+            pRecordPath = pValue;
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s [--devices N] [--concurrency N] [--templates N] "
+                     "[--cbor-percent P] [--csr-percent P] [--throttle-percent P] [--error-percent P] "
+                     "[--rate N] [--min-latency-ms N] [--max-latency-ms N] [--start-window-ms N] "
+                     "[--seed N] [--record FILE]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            fprintf( stderr, "Missing value for %s.\n", argv[ arg ] );
+            return EXIT_FAILURE;
+        }
+
+        arg++;
+    }
+
+    /* Each session has at most one request waiting for its response. */
+    settings.service.maxPending = ( uint32_t ) settings.concurrency;
+    load.pSettings = &settings;
+
+    for( i = 0UL; i < settings.templates; i++ )
+    {
+        ( void ) sprintf( templateNames[ i ], "LoadTemplate%02lu", i );
+    }
+
+    pArrivals = malloc( settings.devices * sizeof( Arrival_t ) );
+    load.pSlots = malloc( settings.concurrency * sizeof( Slot_t ) );
+    load.pFreeSlots = malloc( settings.concurrency * sizeof( uint32_t ) );
+
+    for( phase = 0U; phase < PHASE_COUNT; phase++ )
+    {
+        load.pLatencies[ phase ] = malloc( settings.devices * sizeof( double ) );
+        error |= ( load.pLatencies[ phase ] == NULL ) ? 1 : 0;
+    }
+
+    if( ( error != 0 ) || ( pArrivals == NULL ) || ( load.pSlots == NULL ) || ( load.pFreeSlots == NULL ) ||
+        ( MockService_Init( &( load.service ), &( settings.service ) ) != FleetProvisioningSuccess ) )
+    {
+        fprintf( stderr, "Invalid settings, or out of memory.\n" );
+        return EXIT_FAILURE;
+    }
+
+    /* Schedule the devices over the start window. */
+    for( i = 0UL; i < settings.devices; i++ )
+    {
+        formatSerial( load.pSlots[ 0 ].serial, ( uint32_t ) i );
+        ( void ) FleetProvisioning_GetStartDelay( load.pSlots[ 0 ].serial, SERIAL_LENGTH,
+                                                  ( uint32_t ) settings.startWindowMs, &delayMs );
+        pArrivals[ i ].startNs = ( uint64_t ) delayMs * NS_PER_MS;
+        pArrivals[ i ].device = ( uint32_t ) i;
+    }
+
+    qsort( pArrivals, settings.devices, sizeof( Arrival_t ), compareArrivals );
+
+    for( i = 0UL; i < settings.concurrency; i++ )
+    {
+        load.pFreeSlots[ i ] = ( uint32_t ) ( settings.concurrency - 1UL - i );
+    }
+
+    load.freeCount = settings.concurrency;
+
+    if( pRecordPath != NULL )
+    {
+        if( Trace_OpenWriter( &recorder, pRecordPath ) != 0 )
+        {
+            fprintf( stderr, "Cannot create %s.\n", pRecordPath );
+            return EXIT_FAILURE;
+        }
+
+        load.pRecorder = &recorder;
+    }
+
+    wallStartNs = Bench_NowNs();
+
+    /* Run the events in time order: a device starts once it is due and a
+     * session is free, and responses are delivered once due. */
+    while( ( error == 0 ) && ( ( next < settings.devices ) || ( load.freeCount < settings.concurrency ) ) )
+    {
+        haveDue = ( MockService_NextDue( &( load.service ), &dueNs ) == FleetProvisioningSuccess ) ? 1 : 0;
+
+        if( ( next < settings.devices ) && ( load.freeCount > 0U ) &&
+            ( ( haveDue == 0 ) || ( pArrivals[ next ].startNs <= dueNs ) ) )
+        {
+            if( pArrivals[ next ].startNs > load.nowNs )
+            {
+                load.nowNs = pArrivals[ next ].startNs;
+            }
+
+            error = startDevice( &load, &( pArrivals[ next ] ) );
+            next++;
+        }
+        else if( haveDue != 0 )
+        {
+            load.nowNs = dueNs;
+            error = deliverResponse( &load );
+        }
+        else
+        {
+            /* Sessions are waiting with nothing due. */
+            error = 1;
+        }
+    }
+
+    printReport( &load, Bench_NowNs() - wallStartNs );
+
+    if( ( load.pRecorder != NULL ) && ( Trace_CloseWriter( load.pRecorder ) != 0 ) )
+    {
+        fprintf( stderr, "Cannot write %s.\n", pRecordPath );
+        error = 1;
+    }
+
+    if( error != 0 )
+    {
+        fprintf( stderr, "The run failed.\n" );
+    }
+
+    MockService_Cleanup( &( load.service ) );
+
+    for( phase = 0U; phase < PHASE_COUNT; phase++ )
+    {
+        free( load.pLatencies[ phase ] );
+    }
+
+    free( pArrivals );
+    free( load.pSlots );
+    free( load.pFreeSlots );
+
+    return ( error == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
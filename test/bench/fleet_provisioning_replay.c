@@ -0,0 +1,413 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_replay.c
+ * @brief Replay of recorded Fleet Provisioning traffic through the topic
+ * matching and response parsing of the AWS IoT Fleet Provisioning Library.
+ *
+ * Usage: fleet_provisioning_replay --trace FILE [--pace fast|original]
+ * [--repeat N]
+ *
+ * The trace, written with trace.h, is loaded into memory. Then each inbound
+ * message is matched with #FleetProvisioning_MatchTopic and parsed as a
+ * device would: the credentials, ownership token, thing name and device
+ * configuration of accepted responses, and the status and error of rejected
+ * ones. Outbound messages are skipped. Messages are replayed as fast as
+ * possible, --repeat times, or once at the pace they were recorded at.
+ *
+ * The report gives the throughput and the p50, p99 and p999 handling time
+ * of each kind of message, and at original pace how late the messages were
+ * handled. The exit status is non-zero if the trace cannot be read or a
+ * response fails to parse.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_parser.h"
+
+#include "bench_common.h"
+#include "trace.h"
+
+/**
+ * @brief Number of topics of each API in #FleetProvisioningTopic_t.
+ */
+#define TOPICS_PER_API              ( 3U )
+
+/**
+ * @brief Index of the RegisterThing API among the topics of a format.
+ */
+#define REGISTER_API                ( 2U )
+
+/**
+ * @brief Kinds of inbound messages in the report.
+ */
+#define KIND_CREDENTIALS_ACCEPTED   ( 0U )
+#define KIND_REGISTER_ACCEPTED      ( 1U )
+#define KIND_REJECTED               ( 2U )
+#define KIND_OTHER                  ( 3U )
+#define KIND_COUNT                  ( 4U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief An inbound message of the trace, loaded in memory.
+ */
+typedef struct Message
+{
+    uint64_t timestampNs; /**< @brief Time of the message, from the start of the trace. */
+    size_t topicOffset;   /**< @brief Offset of the topic in the data. */
+    uint16_t topicLength; /**< @brief Length of the topic. */
+    size_t payloadLength; /**< @brief Length of the payload, which follows the topic. */
+} Message_t;
+
+/**
+ * @brief The inbound messages of a trace.
+ */
+typedef struct Replay
+{
+    Message_t * pMessages;   /**< @brief The messages. */
+    size_t messageCount;     /**< @brief Number of messages. */
+    size_t outboundCount;    /**< @brief Number of outbound messages skipped. */
+    char * pData;            /**< @brief Topics and payloads of the messages. */
+    size_t dataLength;       /**< @brief Bytes used in the data. */
+    size_t dataSize;         /**< @brief Size of the data. */
+} Replay_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Names of the kinds of messages in the report.
+ */
+static const char * const kindNames[ KIND_COUNT ] = { "credentials accepted", "register accepted", "rejected", "other" };
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Load the inbound messages of a trace.
+ *
+ * @param[in] pPath The path of the trace.
+ * @param[out] pReplay The messages.
+ *
+ * @return 0 on success, or 1 if the trace cannot be read.
+ */
+static int loadTrace( const char * pPath,
+                      Replay_t * pReplay );
+
+/**
+ * @brief Match and parse a message as a device would.
+ *
+ * @param[in] pTopic The topic.
+ * @param[in] topicLength The length of @p pTopic.
+ * @param[in] pPayload The payload.
+ * @param[in] payloadLength The length of @p pPayload.
+ * @param[out] pKind The kind of the message.
+ *
+ * @return 0 if the message is handled, or 1 if a response fails to parse.
+ */
+static int handleMessage( const char * pTopic,
+                          uint16_t topicLength,
+                          const char * pPayload,
+                          size_t payloadLength,
+                          uint32_t * pKind );
+
+/*-----------------------------------------------------------*/
+
+static int loadTrace( const char * pPath,
+                      Replay_t * pReplay )
+{
+    TraceReader_t reader;
+    TraceRecord_t record;
+    size_t messageSize = 0U;
+    size_t length;
+    void * pGrown;
+    int status;
+    int error = 0;
+
+    ( void ) memset( pReplay, 0, sizeof( Replay_t ) );
+
+    if( Trace_OpenReader( &reader, pPath ) != 0 )
+    {
+        fprintf( stderr, "Cannot read the trace %s.\n", pPath );
+        return 1;
+    }
+
+    for( status = Trace_Read( &reader, &record ); ( status == 1 ) && ( error == 0 ); status = Trace_Read( &reader, &record ) )
+    {
+        if( record.direction == TRACE_OUTBOUND )
+        {
+            pReplay->outboundCount++;
+            continue;
+        }
+
+        length = record.topicLength + record.payloadLength;
+
+        /* Grow the arrays by doubling. */
+        if( pReplay->messageCount == messageSize )
+        {
+            messageSize = ( messageSize == 0U ) ? 1024U : ( 2U * messageSize );
+            pGrown = realloc( pReplay->pMessages, messageSize * sizeof( Message_t ) );
+            error = ( pGrown == NULL ) ? 1 : 0;
+            pReplay->pMessages = ( pGrown != NULL ) ? pGrown : pReplay->pMessages;
+        }
+
+        while( ( error == 0 ) && ( ( pReplay->dataSize - pReplay->dataLength ) < length ) )
+        {
+            pReplay->dataSize = ( pReplay->dataSize == 0U ) ? 65536U : ( 2U * pReplay->dataSize );
+            pGrown = realloc( pReplay->pData, pReplay->dataSize );
+            error = ( pGrown == NULL ) ? 1 : 0;
+            pReplay->pData = ( pGrown != NULL ) ? pGrown : pReplay->pData;
+        }
+
+        if( error == 0 )
+        {
+            pReplay->pMessages[ pReplay->messageCount ].timestampNs = record.timestampNs;
+            pReplay->pMessages[ pReplay->messageCount ].topicOffset = pReplay->dataLength;
+            pReplay->pMessages[ pReplay->messageCount ].topicLength = record.topicLength;
+            pReplay->pMessages[ pReplay->messageCount ].payloadLength = record.payloadLength;
+            ( void ) memcpy( &( pReplay->pData[ pReplay->dataLength ] ), record.pTopic, record.topicLength );
+            ( void ) memcpy( &( pReplay->pData[ pReplay->dataLength + record.topicLength ] ),
+                             record.pPayload, record.payloadLength );
+            pReplay->dataLength += length;
+            pReplay->messageCount++;
+        }
+    }
+
+    if( ( status == -1 ) || ( error != 0 ) )
+    {
+        fprintf( stderr, "The trace %s is corrupt, or memory ran out.\n", pPath );
+        error = 1;
+    }
+
+    Trace_CloseReader( &reader );
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+static int handleMessage( const char * pTopic,
+                          uint16_t topicLength,
+                          const char * pPayload,
+                          size_t payloadLength,
+                          uint32_t * pKind )
+{
+    static FleetProvisioningRegisterThingResponse_t response;
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    FleetProvisioningFormat_t format;
+    FleetProvisioningSpan_t value;
+    uint32_t statusCode = 0U;
+    uint32_t index;
+    int error = 0;
+
+    *pKind = KIND_OTHER;
+
+    if( FleetProvisioning_MatchTopic( pTopic, topicLength, &topic ) == FleetProvisioningSuccess )
+    {
+        index = ( uint32_t ) topic - 1U;
+        format = ( index < ( TOPICS_PER_API * 3U ) ) ? FleetProvisioningJson : FleetProvisioningCbor;
+
+        if( ( index % TOPICS_PER_API ) == 2U )
+        {
+            *pKind = KIND_REJECTED;
+            error = ( ( FleetProvisioning_GetResponseStatusCode( pPayload, payloadLength, format, &statusCode ) != FleetProvisioningSuccess ) ||
+                      ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, FP_API_ERROR_CODE_KEY,
+                                                             sizeof( FP_API_ERROR_CODE_KEY ) - 1U, &value ) != FleetProvisioningSuccess ) ) ? 1 : 0;
+        }
+        else if( ( ( index % TOPICS_PER_API ) == 1U ) && ( ( ( index / TOPICS_PER_API ) % 3U ) == REGISTER_API ) )
+        {
+            *pKind = KIND_REGISTER_ACCEPTED;
+            error = ( FleetProvisioning_ParseRegisterThingAccepted( pPayload, payloadLength, format, &response ) != FleetProvisioningSuccess ) ? 1 : 0;
+        }
+        else if( ( index % TOPICS_PER_API ) == 1U )
+        {
+            *pKind = KIND_CREDENTIALS_ACCEPTED;
+            error = ( ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, FP_API_CERTIFICATE_ID_KEY,
+                                                             sizeof( FP_API_CERTIFICATE_ID_KEY ) - 1U, &value ) != FleetProvisioningSuccess ) ||
+                      ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, FP_API_CERTIFICATE_PEM_KEY,
+                                                             sizeof( FP_API_CERTIFICATE_PEM_KEY ) - 1U, &value ) != FleetProvisioningSuccess ) ||
+                      ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, FP_API_OWNERSHIP_TOKEN_KEY,
+                                                             sizeof( FP_API_OWNERSHIP_TOKEN_KEY ) - 1U, &value ) != FleetProvisioningSuccess ) ) ? 1 : 0;
+
+            /* Only CreateKeysAndCertificate responses hold a private key. */
+            if( ( error == 0 ) && ( ( index / TOPICS_PER_API ) % 3U ) == 1U )
+            {
+                error = ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, FP_API_PRIVATE_KEY_KEY,
+                                                               sizeof( FP_API_PRIVATE_KEY_KEY ) - 1U, &value ) != FleetProvisioningSuccess ) ? 1 : 0;
+            }
+        }
+        else
+        {
+            /* A request, echoed back to the device. */
+        }
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static Replay_t replay;
+    double * pTimes[ KIND_COUNT ] = { NULL };
+    size_t timeCounts[ KIND_COUNT ] = { 0U };
+    const char * pTracePath = NULL;
+    const Message_t * pMessage;
+    unsigned long repeat = 1UL;
+    unsigned long round;
+    uint64_t startNs;
+    uint64_t beforeNs;
+    uint64_t wallNs;
+    uint64_t lateNs;
+    uint64_t maxLateNs = 0U;
+    uint64_t bytes = 0U;
+    int originalPace = 0;
+    uint32_t kind;
+    size_t i;
+    int errors = 0;
+    int usage = 0;
+    int arg;
+    char * pEnd = NULL;
+
+    for( arg = 1; ( arg < argc ) && ( usage == 0 ); arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            usage = 1;
+        }
+        else if( strcmp( argv[ arg ], "--trace" ) == 0 )
+        {
+            pTracePath = pValue;
+        }
+        else if( strcmp( argv[ arg ], "--pace" ) == 0 )
+        {
+            originalPace = ( strcmp( pValue, "original" ) == 0 ) ? 1 : 0;
+            usage = ( ( originalPace == 0 ) && ( strcmp( pValue, "fast" ) != 0 ) ) ? 1 : 0;
+        }
+        else if( strcmp( argv[ arg ], "--repeat" ) == 0 )
+        {
+            repeat = strtoul( pValue, &pEnd, 10 );
+            usage = ( ( *pEnd != '\0' ) || ( repeat == 0UL ) ) ? 1 : 0;
+        }
+        else
+        {
+            usage = 1;
+        }
+
+        arg++;
+    }
+
+    if( ( usage != 0 ) || ( pTracePath == NULL ) )
+    {
+        fprintf( stderr, "Usage: %s --trace FILE [--pace fast|original] [--repeat N]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    if( loadTrace( pTracePath, &replay ) != 0 )
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* The original pace is only replayed once. */
+    repeat = ( originalPace != 0 ) ? 1UL : repeat;
+
+    for( kind = 0U; kind < KIND_COUNT; kind++ )
+    {
+        pTimes[ kind ] = malloc( ( ( replay.messageCount * repeat ) + 1U ) * sizeof( double ) );
+
+        if( pTimes[ kind ] == NULL )
+        {
+            fprintf( stderr, "Out of memory.\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    startNs = Bench_NowNs();
+
+    for( round = 0UL; round < repeat; round++ )
+    {
+        for( i = 0U; i < replay.messageCount; i++ )
+        {
+            pMessage = &( replay.pMessages[ i ] );
+
+            if( originalPace != 0 )
+            {
+                Bench_SleepUntilNs( startNs + ( pMessage->timestampNs - replay.pMessages[ 0 ].timestampNs ) );
+            }
+
+            beforeNs = Bench_NowNs();
+            errors += handleMessage( &( replay.pData[ pMessage->topicOffset ] ), pMessage->topicLength,
+                                     &( replay.pData[ pMessage->topicOffset + pMessage->topicLength ] ),
+                                     pMessage->payloadLength, &kind );
+            wallNs = Bench_NowNs();
+            pTimes[ kind ][ timeCounts[ kind ] ] = ( double ) ( wallNs - beforeNs );
+            timeCounts[ kind ]++;
+            bytes += pMessage->topicLength + pMessage->payloadLength;
+
+            if( originalPace != 0 )
+            {
+                lateNs = wallNs - ( startNs + ( pMessage->timestampNs - replay.pMessages[ 0 ].timestampNs ) );
+                maxLateNs = ( lateNs > maxLateNs ) ? lateNs : maxLateNs;
+            }
+        }
+    }
+
+    wallNs = Bench_NowNs() - startNs;
+
+    printf( "trace: %lu inbound messages replayed %lu times, %lu outbound skipped, %d parse errors\n",
+            ( unsigned long ) replay.messageCount, repeat, ( unsigned long ) replay.outboundCount, errors );
+    printf( "wall clock: %.3f s, %.1f messages/s, %.1f MB/s\n", ( double ) wallNs / 1e9,
+            ( wallNs > 0U ) ? ( ( double ) ( replay.messageCount * repeat ) * 1e9 / ( double ) wallNs ) : 0.0,
+            ( wallNs > 0U ) ? ( ( double ) bytes * 1e3 / ( double ) wallNs ) : 0.0 );
+
+    if( originalPace != 0 )
+    {
+        printf( "latest message: %.3f ms late\n", ( double ) maxLateNs / 1e6 );
+    }
+
+    printf( "%-22s %10s %12s %12s %12s\n", "message (ns)", "count", "p50", "p99", "p999" );
+
+    for( kind = 0U; kind < KIND_COUNT; kind++ )
+    {
+        printf( "%-22s %10lu %12.0f %12.0f %12.0f\n", kindNames[ kind ], ( unsigned long ) timeCounts[ kind ],
+                Bench_Percentile( pTimes[ kind ], timeCounts[ kind ], 50.0 ),
+                Bench_Percentile( pTimes[ kind ], timeCounts[ kind ], 99.0 ),
+                Bench_Percentile( pTimes[ kind ], timeCounts[ kind ], 99.9 ) );
+        free( pTimes[ kind ] );
+    }
+
+    free( replay.pMessages );
+    free( replay.pData );
+
+    return ( errors == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
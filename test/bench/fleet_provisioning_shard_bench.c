@@ -0,0 +1,496 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_shard_bench.c
+ * @brief Scaling benchmark of the shard queues of fleet_provisioning_shard.h,
+ * from 1 to 16 worker threads.
+ *
+ * Usage: fleet_provisioning_shard_bench [--threads N] [--producers N]
+ * [--events N] [--slots N]
+ *
+ * Producer threads stand for the I/O threads: each matches the topic of a
+ * CreateKeysAndCertificate accepted response with
+ * #FleetProvisioning_MatchTopic, chooses the shard of its device with
+ * #FleetProvisioning_GetShard and pushes it onto the queue of the shard.
+ * Each worker thread pops the events of its queue and reads the certificate
+ * ID, certificate, private key and ownership token of the response, which is
+ * the JSON work of a worker. The response comes from the mock service, so it
+ * has a realistic size.
+ *
+ * The same events are run with 1, 2, 4, 8 and 16 workers, up to --threads.
+ * The library is built with the shard queue atomics mapped to the GCC
+ * builtins. The report gives, for each worker count, the events handled per
+ * second, the speedup over one worker and the efficiency, which is the
+ * speedup divided by the worker count. Scaling needs as many cores as
+ * producers and workers. The exit status is non-zero if an event is lost or
+ * handled twice.
+ */
+
+/* For pthreads and sched_yield. */
+#define _POSIX_C_SOURCE    200112L
+
+/* Standard includes. */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_parser.h"
+#include "fleet_provisioning_shard.h"
+
+#include "bench_common.h"
+#include "mock_service.h"
+
+/**
+ * @brief Most worker threads.
+ */
+#define MAX_WORKERS          ( 16U )
+
+/**
+ * @brief Most producer threads.
+ */
+#define MAX_PRODUCERS        ( 16U )
+
+/**
+ * @brief Number of devices the events are spread over.
+ */
+#define DEVICE_COUNT         ( 4096U )
+
+/**
+ * @brief Length of the device serial numbers, "device-" and eight digits.
+ */
+#define SERIAL_LENGTH        ( 15U )
+
+/**
+ * @brief Size of a cache line, to keep the state of each thread apart.
+ */
+#define CACHE_LINE_LENGTH    ( 64U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A worker thread, with the queue of its shard.
+ */
+typedef struct Worker
+{
+    FleetProvisioningShardQueue_t queue;    /**< @brief Queue of the shard. */
+    FleetProvisioningShardSlot_t * pSlots;  /**< @brief Slots of the queue. */
+    struct Run * pRun;                      /**< @brief The run the worker is part of. */
+    pthread_t thread;                       /**< @brief The thread. */
+    unsigned long handled;                  /**< @brief Events handled. */
+    uint64_t checksum;                      /**< @brief Sum of the tags and lengths read, so the work is kept. */
+    char padding[ CACHE_LINE_LENGTH ];      /**< @brief Keeps the next worker off the cache lines of this one. */
+} Worker_t;
+
+/**
+ * @brief A producer thread.
+ */
+typedef struct Producer
+{
+    struct Run * pRun;                 /**< @brief The run the producer is part of. */
+    pthread_t thread;                  /**< @brief The thread. */
+    uint32_t index;                    /**< @brief Number of the producer. */
+    char padding[ CACHE_LINE_LENGTH ]; /**< @brief Keeps the next producer off the cache lines of this one. */
+} Producer_t;
+
+/**
+ * @brief State of a run with one worker count.
+ */
+typedef struct Run
+{
+    Worker_t * pWorkers;      /**< @brief The workers. */
+    uint32_t workerCount;     /**< @brief Number of workers. */
+    uint32_t producerCount;   /**< @brief Number of producers. */
+    unsigned long events;     /**< @brief Events to push, over all producers. */
+    uint32_t producersDone;   /**< @brief Producers that pushed all their events, read and written atomically. */
+    const char * pTopic;      /**< @brief Topic of the response. */
+    uint16_t topicLength;     /**< @brief Length of the topic. */
+    const char * pPayload;    /**< @brief Payload of the response. */
+    size_t payloadLength;     /**< @brief Length of the payload. */
+} Run_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Serial numbers of the devices.
+ */
+static char serials[ DEVICE_COUNT ][ SERIAL_LENGTH + 1U ];
+
+/**
+ * @brief Keys the workers read from each response.
+ */
+static const char * const responseKeys[] =
+{
+    FP_API_CERTIFICATE_ID_KEY,
+    FP_API_CERTIFICATE_PEM_KEY,
+    FP_API_PRIVATE_KEY_KEY,
+    FP_API_OWNERSHIP_TOKEN_KEY
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Parse a number of a command line option, or exit.
+ *
+ * @param[in] pArgument The option value, or NULL if missing.
+ * @param[in] minimum The smallest value allowed.
+ * @param[in] maximum The largest value allowed.
+ *
+ * @return The number.
+ */
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum );
+
+/**
+ * @brief Push the events of a producer.
+ *
+ * @param[in] pArgument The producer.
+ *
+ * @return NULL.
+ */
+static void * runProducer( void * pArgument );
+
+/**
+ * @brief Handle the events of a worker until the producers are done and its
+ * queue is empty.
+ *
+ * @param[in] pArgument The worker.
+ *
+ * @return NULL.
+ */
+static void * runWorker( void * pArgument );
+
+/**
+ * @brief Run the events with a number of workers.
+ *
+ * @param[in] pRun The run, with its workers and their queues initialized.
+ * @param[out] pElapsedNs The time the run took.
+ *
+ * @return 0 if every event was handled once, 1 otherwise.
+ */
+static int runEvents( Run_t * pRun,
+                      uint64_t * pElapsedNs );
+
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument,
+                                  unsigned long minimum,
+                                  unsigned long maximum )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value < minimum ) || ( value > maximum ) )
+    {
+        fprintf( stderr, "Expected a number from %lu to %lu.\n", minimum, maximum );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+static void * runProducer( void * pArgument )
+{
+    Producer_t * pProducer = ( Producer_t * ) pArgument;
+    Run_t * pRun = pProducer->pRun;
+    FleetProvisioningEvent_t event;
+    uint32_t shard = 0U;
+    unsigned long i;
+
+    ( void ) memset( &event, 0, sizeof( event ) );
+    event.type = FleetProvisioningEventMessage;
+    event.pPayload = pRun->pPayload;
+    event.payloadLength = pRun->payloadLength;
+
+    for( i = pProducer->index; i < pRun->events; i += pRun->producerCount )
+    {
+        /* Classify the message, then hand it to the shard of its device. */
+        ( void ) FleetProvisioning_MatchTopic( pRun->pTopic, pRun->topicLength, &( event.topic ) );
+        ( void ) FleetProvisioning_GetShard( serials[ i % DEVICE_COUNT ], SERIAL_LENGTH,
+                                             pRun->workerCount, &shard );
+
+        while( FleetProvisioning_ShardQueuePush( &( pRun->pWorkers[ shard ].queue ), ( uint32_t ) i,
+                                                 &event ) != FleetProvisioningSuccess )
+        {
+            /* The worker is behind; let it run. */
+            ( void ) sched_yield();
+        }
+    }
+
+    ( void ) __atomic_fetch_add( &( pRun->producersDone ), 1U, __ATOMIC_RELEASE );
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void * runWorker( void * pArgument )
+{
+    Worker_t * pWorker = ( Worker_t * ) pArgument;
+    Run_t * pRun = pWorker->pRun;
+    FleetProvisioningEvent_t event;
+    FleetProvisioningSpan_t value;
+    uint32_t tag = 0U;
+    uint32_t done = 0U;
+    size_t key;
+
+    while( done == 0U )
+    {
+        /* Every event is pushed before its producer counts as done, so once
+         * all are done, an empty queue stays empty. */
+        done = ( __atomic_load_n( &( pRun->producersDone ), __ATOMIC_ACQUIRE ) == pRun->producerCount ) ? 1U : 0U;
+
+        while( FleetProvisioning_ShardQueuePop( &( pWorker->queue ), &tag, &event ) == FleetProvisioningSuccess )
+        {
+            for( key = 0U; key < ( sizeof( responseKeys ) / sizeof( responseKeys[ 0 ] ) ); key++ )
+            {
+                if( FleetProvisioning_GetResponseString( event.pPayload, event.payloadLength, FleetProvisioningJson,
+                                                         responseKeys[ key ], strlen( responseKeys[ key ] ),
+                                                         &value ) == FleetProvisioningSuccess )
+                {
+                    pWorker->checksum += value.length;
+                }
+            }
+
+            pWorker->checksum += tag;
+            pWorker->handled++;
+        }
+
+        if( done == 0U )
+        {
+            ( void ) sched_yield();
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static int runEvents( Run_t * pRun,
+                      uint64_t * pElapsedNs )
+{
+    static Producer_t producers[ MAX_PRODUCERS ];
+    FleetProvisioningSpan_t value;
+    unsigned long handled = 0UL;
+    uint64_t checksum = 0U;
+    uint64_t expected = 0U;
+    uint64_t startNs;
+    uint32_t i;
+    int error = 0;
+
+    pRun->producersDone = 0U;
+    startNs = Bench_NowNs();
+
+    for( i = 0U; i < pRun->workerCount; i++ )
+    {
+        pRun->pWorkers[ i ].pRun = pRun;
+        pRun->pWorkers[ i ].handled = 0UL;
+        pRun->pWorkers[ i ].checksum = 0U;
+        error |= ( pthread_create( &( pRun->pWorkers[ i ].thread ), NULL, runWorker, &( pRun->pWorkers[ i ] ) ) != 0 ) ? 1 : 0;
+    }
+
+    for( i = 0U; i < pRun->producerCount; i++ )
+    {
+        producers[ i ].pRun = pRun;
+        producers[ i ].index = i;
+        error |= ( pthread_create( &( producers[ i ].thread ), NULL, runProducer, &( producers[ i ] ) ) != 0 ) ? 1 : 0;
+    }
+
+    if( error != 0 )
+    {
+        fprintf( stderr, "Cannot start the threads.\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    for( i = 0U; i < pRun->producerCount; i++ )
+    {
+        ( void ) pthread_join( producers[ i ].thread, NULL );
+    }
+
+    for( i = 0U; i < pRun->workerCount; i++ )
+    {
+        ( void ) pthread_join( pRun->pWorkers[ i ].thread, NULL );
+        handled += pRun->pWorkers[ i ].handled;
+        checksum += pRun->pWorkers[ i ].checksum;
+    }
+
+    *pElapsedNs = Bench_NowNs() - startNs;
+
+    /* Each event adds its tag and the lengths read from the payload, so an
+     * event lost or handled twice changes the sum. */
+    for( i = 0U; i < ( sizeof( responseKeys ) / sizeof( responseKeys[ 0 ] ) ); i++ )
+    {
+        if( FleetProvisioning_GetResponseString( pRun->pPayload, pRun->payloadLength, FleetProvisioningJson,
+                                                 responseKeys[ i ], strlen( responseKeys[ i ] ),
+                                                 &value ) == FleetProvisioningSuccess )
+        {
+            expected += value.length;
+        }
+    }
+
+    expected = ( expected * pRun->events ) + ( ( ( uint64_t ) pRun->events * ( pRun->events - 1UL ) ) / 2U );
+
+    if( ( handled != pRun->events ) || ( checksum != expected ) )
+    {
+        fprintf( stderr, "%lu workers handled %lu events of %lu.\n",
+                 ( unsigned long ) pRun->workerCount, handled, pRun->events );
+        error = 1;
+    }
+
+    return error;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static char topic[ MOCK_MAX_TOPIC_LENGTH ];
+    static char payload[ MOCK_MAX_PAYLOAD_LENGTH ];
+    static Worker_t workers[ MAX_WORKERS ];
+    MockServiceConfig_t serviceConfig;
+    MockService_t service;
+    Run_t run;
+    unsigned long threads = MAX_WORKERS;
+    unsigned long slots = 1024UL;
+    uint64_t elapsedNs = 0U;
+    double baseline = 0.0;
+    double rate;
+    uint32_t clientId = 0U;
+    uint32_t i;
+    int error = 0;
+    int arg;
+
+    ( void ) memset( &run, 0, sizeof( run ) );
+    run.producerCount = 1U;
+    run.events = 200000UL;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--threads" ) == 0 )
+        {
+            threads = parseNumber( pValue, 1UL, MAX_WORKERS );
+        }
+        else if( strcmp( argv[ arg ], "--producers" ) == 0 )
+        {
+            run.producerCount = ( uint32_t ) parseNumber( pValue, 1UL, MAX_PRODUCERS );
+        }
+        else if( strcmp( argv[ arg ], "--events" ) == 0 )
+        {
+            run.events = parseNumber( pValue, 1UL, 100000000UL );
+        }
+        else if( strcmp( argv[ arg ], "--slots" ) == 0 )
+        {
+            slots = parseNumber( pValue, 2UL, 1048576UL );
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s [--threads N] [--producers N] [--events N] [--slots N]\n", argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+
+        /* Every option takes a value. */
+        if( pValue == NULL )
+        {
+            fprintf( stderr, "Missing value for %s.\n", argv[ arg ] );
+            return EXIT_FAILURE;
+        }
+
+        arg++;
+    }
+
+    for( i = 0U; i < DEVICE_COUNT; i++ )
+    {
+        ( void ) sprintf( serials[ i ], "device-%08lu", ( unsigned long ) i );
+    }
+
+    /* Take one accepted response from the mock. */
+    ( void ) memset( &serviceConfig, 0, sizeof( serviceConfig ) );
+    serviceConfig.maxPending = 1U;
+    serviceConfig.seed = 1U;
+    run.pTopic = topic;
+    run.pPayload = payload;
+
+    if( ( MockService_Init( &service, &serviceConfig ) != FleetProvisioningSuccess ) ||
+        ( MockService_Publish( &service, 0U, clientId, FP_JSON_CREATE_KEYS_PUBLISH_TOPIC,
+                               FP_JSON_CREATE_KEYS_PUBLISH_LENGTH, "{}", 2U ) != FleetProvisioningSuccess ) ||
+        ( MockService_Poll( &service, 0U, &clientId, topic, &( run.topicLength ),
+                            payload, &( run.payloadLength ) ) != FleetProvisioningSuccess ) )
+    {
+        fprintf( stderr, "Cannot get a response from the mock.\n" );
+        return EXIT_FAILURE;
+    }
+
+    MockService_Cleanup( &service );
+    run.pWorkers = workers;
+
+    for( i = 0U; i < MAX_WORKERS; i++ )
+    {
+        workers[ i ].pSlots = malloc( slots * sizeof( FleetProvisioningShardSlot_t ) );
+
+        if( ( workers[ i ].pSlots == NULL ) ||
+            ( FleetProvisioning_ShardQueueInit( &( workers[ i ].queue ), workers[ i ].pSlots,
+                                                ( uint32_t ) slots ) != FleetProvisioningSuccess ) )
+        {
+            fprintf( stderr, "Invalid settings, or out of memory.\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf( "%u producers, %lu events of %lu bytes, %lu slots per queue\n",
+            ( unsigned ) run.producerCount, run.events, ( unsigned long ) run.payloadLength, slots );
+    printf( "%8s %14s %10s %12s\n", "workers", "events/s", "speedup", "efficiency" );
+
+    for( run.workerCount = 1U; ( error == 0 ) && ( run.workerCount <= threads ); run.workerCount *= 2U )
+    {
+        error = runEvents( &run, &elapsedNs );
+        rate = ( ( double ) run.events * 1e9 ) / ( double ) ( ( elapsedNs > 0U ) ? elapsedNs : 1U );
+
+        if( run.workerCount == 1U )
+        {
+            baseline = rate;
+        }
+
+        printf( "%8u %14.0f %9.2fx %11.1f%%\n", ( unsigned ) run.workerCount, rate, rate / baseline,
+                ( rate * 100.0 ) / ( baseline * ( double ) run.workerCount ) );
+    }
+
+    for( i = 0U; i < MAX_WORKERS; i++ )
+    {
+        free( workers[ i ].pSlots );
+    }
+
+    return ( error == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
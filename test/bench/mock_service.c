@@ -0,0 +1,853 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file mock_service.c
+ * @brief Implementation of the local stand-in for the AWS IoT Fleet
+ * Provisioning service.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning parser include. */
+#include "fleet_provisioning_parser.h"
+
+#include "mock_service.h"
+
+/**
+ * @brief Index of each API in #MockServiceStats_t.
+ */
+#define API_CREATE_CERT         ( 0U )
+#define API_CREATE_KEYS         ( 1U )
+#define API_REGISTER            ( 2U )
+
+/**
+ * @brief Number of topics of each API in #FleetProvisioningTopic_t.
+ */
+#define TOPICS_PER_API          ( 3U )
+
+/**
+ * @brief Deepest nesting of maps in a response.
+ */
+#define MAX_MAP_DEPTH           ( 4U )
+
+/**
+ * @brief Length of the shared part of the ownership tokens, which follows
+ * the eight characters of the response number.
+ */
+#define OWNERSHIP_TOKEN_LENGTH  ( 448U )
+
+/**
+ * @brief Rate limit tokens of one request.
+ */
+#define TOKENS_PER_REQUEST      ( 1000U )
+
+/**
+ * @brief CBOR major types used in responses.
+ */
+#define CBOR_MAJOR_UNSIGNED     ( 0U )
+#define CBOR_MAJOR_TEXT         ( 3U )
+#define CBOR_MAJOR_MAP          ( 5U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A response being written.
+ */
+typedef struct Writer
+{
+    char * pBuffer;                         /**< @brief The payload buffer. */
+    size_t length;                          /**< @brief Bytes written. */
+    size_t capacity;                        /**< @brief Size of the buffer. */
+    uint8_t format;                         /**< @brief Format of the response. */
+    uint8_t depth;                          /**< @brief Number of open maps. */
+    uint8_t needComma[ MAX_MAP_DEPTH + 1U ]; /**< @brief For JSON, whether each open map has members. */
+} Writer_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Response topics of the APIs other than RegisterThing, indexed by
+ * format, API and accepted or rejected.
+ */
+static const char * const responseTopics[ 2 ][ 2 ][ 2 ] =
+{
+    {
+        { FP_JSON_CREATE_CERT_ACCEPTED_TOPIC, FP_JSON_CREATE_CERT_REJECTED_TOPIC },
+        { FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FP_JSON_CREATE_KEYS_REJECTED_TOPIC }
+    },
+    {
+        { FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC, FP_CBOR_CREATE_CERT_REJECTED_TOPIC },
+        { FP_CBOR_CREATE_KEYS_ACCEPTED_TOPIC, FP_CBOR_CREATE_KEYS_REJECTED_TOPIC }
+    }
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Draw a random number.
+ */
+static uint32_t nextRandom( MockService_t * pService );
+
+/**
+ * @brief Write random base64 characters.
+ */
+static void fillBase64( MockService_t * pService,
+                        char * pOut,
+                        size_t count );
+
+/**
+ * @brief Build a PEM block of random base64 lines.
+ */
+static char * makePem( MockService_t * pService,
+                       const char * pLabel,
+                       uint32_t lineCount );
+
+/**
+ * @brief Check whether a pending request is due before another.
+ */
+static int isEarlier( const MockPending_t * pLeft,
+                      const MockPending_t * pRight );
+
+/**
+ * @brief Add a pending request to the heap.
+ */
+static void pushPending( MockService_t * pService,
+                         const MockPending_t * pPending );
+
+/**
+ * @brief Remove the earliest pending request from the heap.
+ */
+static void popPending( MockService_t * pService,
+                        MockPending_t * pPending );
+
+/**
+ * @brief Choose the status of a response to a request.
+ */
+static uint16_t chooseStatus( MockService_t * pService,
+                              uint64_t nowNs,
+                              uint32_t api,
+                              FleetProvisioningFormat_t format,
+                              const char * pPayload,
+                              size_t payloadLength );
+
+/**
+ * @brief Write raw bytes of a response.
+ */
+static void putBytes( Writer_t * pWriter,
+                      const char * pData,
+                      size_t length );
+
+/**
+ * @brief Write the head of a CBOR data item.
+ */
+static void putCborHead( Writer_t * pWriter,
+                         uint8_t majorType,
+                         uint32_t value );
+
+/**
+ * @brief Open a map of a response.
+ */
+static void beginMap( Writer_t * pWriter,
+                      uint32_t memberCount );
+
+/**
+ * @brief Close the innermost map of a response.
+ */
+static void endMap( Writer_t * pWriter );
+
+/**
+ * @brief Write the key of a member of the innermost map.
+ */
+static void putKey( Writer_t * pWriter,
+                    const char * pKey );
+
+/**
+ * @brief Write a string value.
+ */
+static void putString( Writer_t * pWriter,
+                       const char * pValue,
+                       size_t length );
+
+/**
+ * @brief Write an unsigned integer value.
+ */
+static void putUnsigned( Writer_t * pWriter,
+                         uint32_t value );
+
+/**
+ * @brief Write the payload of a response.
+ */
+static void writeResponse( const MockService_t * pService,
+                           const MockPending_t * pPending,
+                           Writer_t * pWriter );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t nextRandom( MockService_t * pService )
+{
+    uint32_t x = pService->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pService->random = x;
+
+    return x;
+}
+/*-----------------------------------------------------------*/
+
+static void fillBase64( MockService_t * pService,
+                        char * pOut,
+                        size_t count )
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+
+    for( i = 0U; i < count; i++ )
+    {
+        pOut[ i ] = alphabet[ nextRandom( pService ) % 64U ];
+    }
+}
+/*-----------------------------------------------------------*/
+
+static char * makePem( MockService_t * pService,
+                       const char * pLabel,
+                       uint32_t lineCount )
+{
+    size_t labelLength = strlen( pLabel );
+    size_t length = ( 2U * ( labelLength + 17U ) ) + ( lineCount * 65U );
+    char * pPem = malloc( length + 1U );
+    char * pCursor = pPem;
+    uint32_t line;
+
+    if( pPem != NULL )
+    {
+        ( void ) memcpy( pCursor, "-----BEGIN ", 11U );
+        ( void ) memcpy( pCursor + 11U, pLabel, labelLength );
+        ( void ) memcpy( pCursor + 11U + labelLength, "-----\n", 6U );
+        pCursor += 17U + labelLength;
+
+        for( line = 0U; line < lineCount; line++ )
+        {
+            fillBase64( pService, pCursor, 64U );
+            pCursor[ 64 ] = '\n';
+            pCursor += 65U;
+        }
+
+        ( void ) memcpy( pCursor, "-----END ", 9U );
+        ( void ) memcpy( pCursor + 9U, pLabel, labelLength );
+        ( void ) memcpy( pCursor + 9U + labelLength, "-----\n", 6U );
+        pCursor += 15U + labelLength;
+        *pCursor = '\0';
+    }
+
+    return pPem;
+}
+/*-----------------------------------------------------------*/
+
+static int isEarlier( const MockPending_t * pLeft,
+                      const MockPending_t * pRight )
+{
+    return ( pLeft->dueNs < pRight->dueNs ) ||
+           ( ( pLeft->dueNs == pRight->dueNs ) && ( pLeft->sequence < pRight->sequence ) );
+}
+/*-----------------------------------------------------------*/
+
+static void pushPending( MockService_t * pService,
+                         const MockPending_t * pPending )
+{
+    uint32_t index = pService->pendingCount;
+    uint32_t parent;
+
+    pService->pendingCount++;
+
+    while( index > 0U )
+    {
+        parent = ( index - 1U ) / 2U;
+
+        if( isEarlier( pPending, &( pService->pPending[ parent ] ) ) == 0 )
+        {
+            break;
+        }
+
+        pService->pPending[ index ] = pService->pPending[ parent ];
+        index = parent;
+    }
+
+    pService->pPending[ index ] = *pPending;
+}
+/*-----------------------------------------------------------*/
+
+static void popPending( MockService_t * pService,
+                        MockPending_t * pPending )
+{
+    MockPending_t last;
+    uint32_t index = 0U;
+    uint32_t child;
+
+    *pPending = pService->pPending[ 0 ];
+    pService->pendingCount--;
+    last = pService->pPending[ pService->pendingCount ];
+
+    for( child = 1U; child < pService->pendingCount; child = ( 2U * index ) + 1U )
+    {
+        if( ( ( child + 1U ) < pService->pendingCount ) &&
+            ( isEarlier( &( pService->pPending[ child + 1U ] ), &( pService->pPending[ child ] ) ) != 0 ) )
+        {
+            child++;
+        }
+
+        if( isEarlier( &( pService->pPending[ child ] ), &last ) == 0 )
+        {
+            break;
+        }
+
+        pService->pPending[ index ] = pService->pPending[ child ];
+        index = child;
+    }
+
+    pService->pPending[ index ] = last;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t chooseStatus( MockService_t * pService,
+                              uint64_t nowNs,
+                              uint32_t api,
+                              FleetProvisioningFormat_t format,
+                              const char * pPayload,
+                              size_t payloadLength )
+{
+    FleetProvisioningSpan_t value;
+    const char * pKey = ( api == API_REGISTER ) ? FP_API_OWNERSHIP_TOKEN_KEY : FP_API_CSR_KEY;
+    uint64_t capacity = ( uint64_t ) pService->config.ratePerSecond * TOKENS_PER_REQUEST;
+    uint16_t status = 200U;
+    uint32_t draw;
+    uint32_t i;
+
+    /* Refill the rate limits, in thousandths of a request. */
+    if( nowNs > pService->refillNs )
+    {
+        for( i = 0U; i < MOCK_API_COUNT; i++ )
+        {
+            pService->tokens[ i ] += ( ( nowNs - pService->refillNs ) * pService->config.ratePerSecond ) / 1000000U;
+
+            if( pService->tokens[ i ] > capacity )
+            {
+                pService->tokens[ i ] = capacity;
+            }
+        }
+
+        pService->refillNs = nowNs;
+    }
+
+    /* CreateKeysAndCertificate takes any payload. */
+    if( ( api != API_CREATE_KEYS ) &&
+        ( FleetProvisioning_GetResponseString( pPayload, payloadLength, format, pKey,
+                                               strlen( pKey ), &value ) != FleetProvisioningSuccess ) )
+    {
+        status = 400U;
+    }
+    else if( ( pService->config.ratePerSecond > 0U ) && ( pService->tokens[ api ] < TOKENS_PER_REQUEST ) )
+    {
+        status = 429U;
+    }
+    else
+    {
+        if( pService->config.ratePerSecond > 0U )
+        {
+            pService->tokens[ api ] -= TOKENS_PER_REQUEST;
+        }
+
+        draw = nextRandom( pService ) % 100U;
+
+        if( draw < pService->config.throttlePercent )
+        {
+            status = 429U;
+        }
+        else if( draw < ( pService->config.throttlePercent + pService->config.errorPercent ) )
+        {
+            status = 500U;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+static void putBytes( Writer_t * pWriter,
+                      const char * pData,
+                      size_t length )
+{
+    if( ( pWriter->capacity - pWriter->length ) < length )
+    {
+        /* Responses are sized to fit; anything else is a bug. */
+        abort();
+    }
+
+    ( void ) memcpy( &( pWriter->pBuffer[ pWriter->length ] ), pData, length );
+    pWriter->length += length;
+}
+/*-----------------------------------------------------------*/
+
+static void putCborHead( Writer_t * pWriter,
+                         uint8_t majorType,
+                         uint32_t value )
+{
+    char head[ 5 ];
+    size_t length;
+
+    if( value < 24U )
+    {
+        head[ 0 ] = ( char ) ( ( majorType << 5 ) | value );
+        length = 1U;
+    }
+    else if( value <= 0xFFU )
+    {
+        head[ 0 ] = ( char ) ( ( majorType << 5 ) | 24U );
+        head[ 1 ] = ( char ) value;
+        length = 2U;
+    }
+    else if( value <= 0xFFFFU )
+    {
+        head[ 0 ] = ( char ) ( ( majorType << 5 ) | 25U );
+        head[ 1 ] = ( char ) ( value >> 8 );
+        head[ 2 ] = ( char ) value;
+        length = 3U;
+    }
+    else
+    {
+        head[ 0 ] = ( char ) ( ( majorType << 5 ) | 26U );
+        head[ 1 ] = ( char ) ( value >> 24 );
+        head[ 2 ] = ( char ) ( value >> 16 );
+        head[ 3 ] = ( char ) ( value >> 8 );
+        head[ 4 ] = ( char ) value;
+        length = 5U;
+    }
+
+    putBytes( pWriter, head, length );
+}
+/*-----------------------------------------------------------*/
+
+static void beginMap( Writer_t * pWriter,
+                      uint32_t memberCount )
+{
+    if( pWriter->format == ( uint8_t ) FleetProvisioningCbor )
+    {
+        putCborHead( pWriter, CBOR_MAJOR_MAP, memberCount );
+    }
+    else
+    {
+        putBytes( pWriter, "{", 1U );
+    }
+
+    pWriter->depth++;
+    pWriter->needComma[ pWriter->depth ] = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void endMap( Writer_t * pWriter )
+{
+    if( pWriter->format == ( uint8_t ) FleetProvisioningJson )
+    {
+        putBytes( pWriter, "}", 1U );
+    }
+
+    pWriter->depth--;
+}
+/*-----------------------------------------------------------*/
+
+static void putKey( Writer_t * pWriter,
+                    const char * pKey )
+{
+    if( ( pWriter->format == ( uint8_t ) FleetProvisioningJson ) && ( pWriter->needComma[ pWriter->depth ] != 0U ) )
+    {
+        putBytes( pWriter, ",", 1U );
+    }
+
+    pWriter->needComma[ pWriter->depth ] = 1U;
+    putString( pWriter, pKey, strlen( pKey ) );
+
+    if( pWriter->format == ( uint8_t ) FleetProvisioningJson )
+    {
+        putBytes( pWriter, ":", 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void putString( Writer_t * pWriter,
+                       const char * pValue,
+                       size_t length )
+{
+    size_t start = 0U;
+    size_t i;
+
+    if( pWriter->format == ( uint8_t ) FleetProvisioningCbor )
+    {
+        putCborHead( pWriter, CBOR_MAJOR_TEXT, ( uint32_t ) length );
+        putBytes( pWriter, pValue, length );
+    }
+    else
+    {
+        /* PEM line breaks are the only characters that need escaping. */
+        putBytes( pWriter, "\"", 1U );
+
+        for( i = 0U; i < length; i++ )
+        {
+            if( pValue[ i ] == '\n' )
+            {
+                putBytes( pWriter, &( pValue[ start ] ), i - start );
+                putBytes( pWriter, "\\n", 2U );
+                start = i + 1U;
+            }
+        }
+
+        putBytes( pWriter, &( pValue[ start ] ), length - start );
+        putBytes( pWriter, "\"", 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void putUnsigned( Writer_t * pWriter,
+                         uint32_t value )
+{
+    char digits[ 10 ];
+    size_t count = 0U;
+
+    if( pWriter->format == ( uint8_t ) FleetProvisioningCbor )
+    {
+        putCborHead( pWriter, CBOR_MAJOR_UNSIGNED, value );
+    }
+    else
+    {
+        do
+        {
+            digits[ sizeof( digits ) - 1U - count ] = ( char ) ( '0' + ( value % 10U ) );
+            value /= 10U;
+            count++;
+        } while( value > 0U );
+
+        putBytes( pWriter, &( digits[ sizeof( digits ) - count ] ), count );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void writeResponse( const MockService_t * pService,
+                           const MockPending_t * pPending,
+                           Writer_t * pWriter )
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    char certificateId[ 64 ];
+    char thingName[ 16 ];
+    char number[ 8 ];
+    uint32_t i;
+
+    /* Derive the ID, thing name and token prefix from the number, so each
+     * response differs. */
+    for( i = 0U; i < 8U; i++ )
+    {
+        number[ i ] = hexDigits[ ( pPending->number >> ( 28U - ( 4U * i ) ) ) & 0xFU ];
+    }
+
+    for( i = 0U; i < sizeof( certificateId ); i++ )
+    {
+        certificateId[ i ] = hexDigits[ ( ( pPending->number * 2654435761U ) >> ( i % 29U ) ) & 0xFU ];
+    }
+
+    ( void ) memcpy( certificateId, number, sizeof( number ) );
+    ( void ) memcpy( thingName, "thing-", 6U );
+    ( void ) memcpy( &( thingName[ 6 ] ), number, sizeof( number ) );
+
+    if( pPending->statusCode != 200U )
+    {
+        beginMap( pWriter, 3U );
+        putKey( pWriter, FP_API_STATUS_CODE_KEY );
+        putUnsigned( pWriter, pPending->statusCode );
+        putKey( pWriter, FP_API_ERROR_CODE_KEY );
+
+        if( pPending->statusCode == 429U )
+        {
+            putString( pWriter, "ThrottlingException", 19U );
+            putKey( pWriter, FP_API_ERROR_MESSAGE_KEY );
+            putString( pWriter, "Rate exceeded", 13U );
+        }
+        else if( pPending->statusCode == 400U )
+        {
+            putString( pWriter, "InvalidPayload", 14U );
+            putKey( pWriter, FP_API_ERROR_MESSAGE_KEY );
+            putString( pWriter, "The request payload is invalid", 30U );
+        }
+        else
+        {
+            putString( pWriter, "InternalFailure", 15U );
+            putKey( pWriter, FP_API_ERROR_MESSAGE_KEY );
+            putString( pWriter, "Internal failure", 16U );
+        }
+
+        endMap( pWriter );
+    }
+    else if( pPending->api == API_REGISTER )
+    {
+        beginMap( pWriter, 2U );
+        putKey( pWriter, FP_API_DEVICE_CONFIG_KEY );
+        beginMap( pWriter, 2U );
+        putKey( pWriter, "fallbackUrl" );
+        putString( pWriter, "https://www.example.com/test-site", 33U );
+        putKey( pWriter, "locationUrl" );
+        putString( pWriter, "https://www.example.com/location", 32U );
+        endMap( pWriter );
+        putKey( pWriter, FP_API_THING_NAME_KEY );
+        putString( pWriter, thingName, 14U );
+        endMap( pWriter );
+    }
+    else
+    {
+        beginMap( pWriter, ( pPending->api == API_CREATE_KEYS ) ? 4U : 3U );
+        putKey( pWriter, FP_API_CERTIFICATE_ID_KEY );
+        putString( pWriter, certificateId, sizeof( certificateId ) );
+        putKey( pWriter, FP_API_CERTIFICATE_PEM_KEY );
+        putString( pWriter, pService->pCertificatePem, strlen( pService->pCertificatePem ) );
+
+        if( pPending->api == API_CREATE_KEYS )
+        {
+            putKey( pWriter, FP_API_PRIVATE_KEY_KEY );
+            putString( pWriter, pService->pPrivateKey, strlen( pService->pPrivateKey ) );
+        }
+
+        /* The token starts with the number, so that it differs too. */
+        putKey( pWriter, FP_API_OWNERSHIP_TOKEN_KEY );
+
+        if( pWriter->format == ( uint8_t ) FleetProvisioningCbor )
+        {
+            putCborHead( pWriter, CBOR_MAJOR_TEXT, ( uint32_t ) ( sizeof( number ) + strlen( pService->pOwnershipToken ) ) );
+            putBytes( pWriter, number, sizeof( number ) );
+            putBytes( pWriter, pService->pOwnershipToken, strlen( pService->pOwnershipToken ) );
+        }
+        else
+        {
+            putBytes( pWriter, "\"", 1U );
+            putBytes( pWriter, number, sizeof( number ) );
+            putBytes( pWriter, pService->pOwnershipToken, strlen( pService->pOwnershipToken ) );
+            putBytes( pWriter, "\"", 1U );
+        }
+
+        endMap( pWriter );
+    }
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t MockService_Init( MockService_t * pService,
+                                            const MockServiceConfig_t * pConfig )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningBadParameter;
+    size_t i;
+
+    if( ( pService != NULL ) && ( pConfig != NULL ) && ( pConfig->minLatencyNs <= pConfig->maxLatencyNs ) &&
+        ( ( pConfig->throttlePercent + pConfig->errorPercent ) <= 100U ) && ( pConfig->maxPending > 0U ) )
+    {
+        ( void ) memset( pService, 0, sizeof( MockService_t ) );
+        pService->config = *pConfig;
+        pService->random = ( pConfig->seed == 0U ) ? 1U : pConfig->seed;
+
+        for( i = 0U; i < MOCK_API_COUNT; i++ )
+        {
+            pService->tokens[ i ] = ( uint64_t ) pConfig->ratePerSecond * TOKENS_PER_REQUEST;
+        }
+
+        /* Sizes of a 2048-bit RSA certificate and private key, and of a
+         * service ownership token. */
+        pService->pPending = malloc( pConfig->maxPending * sizeof( MockPending_t ) );
+        pService->pCertificatePem = makePem( pService, "CERTIFICATE", 19U );
+        pService->pPrivateKey = makePem( pService, "RSA PRIVATE KEY", 25U );
+        pService->pOwnershipToken = malloc( OWNERSHIP_TOKEN_LENGTH + 1U );
+
+        if( ( pService->pPending != NULL ) && ( pService->pCertificatePem != NULL ) &&
+            ( pService->pPrivateKey != NULL ) && ( pService->pOwnershipToken != NULL ) )
+        {
+            fillBase64( pService, pService->pOwnershipToken, OWNERSHIP_TOKEN_LENGTH );
+            pService->pOwnershipToken[ OWNERSHIP_TOKEN_LENGTH ] = '\0';
+            status = FleetProvisioningSuccess;
+        }
+        else
+        {
+            MockService_Cleanup( pService );
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+void MockService_Cleanup( MockService_t * pService )
+{
+    free( pService->pPending );
+    free( pService->pCertificatePem );
+    free( pService->pPrivateKey );
+    free( pService->pOwnershipToken );
+    pService->pPending = NULL;
+    pService->pCertificatePem = NULL;
+    pService->pPrivateKey = NULL;
+    pService->pOwnershipToken = NULL;
+    pService->pendingCount = 0U;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t MockService_Publish( MockService_t * pService,
+                                               uint64_t nowNs,
+                                               uint32_t clientId,
+                                               const char * pTopic,
+                                               uint16_t topicLength,
+                                               const char * pPayload,
+                                               size_t payloadLength )
+{
+    FleetProvisioningStatus_t status;
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    MockPending_t pending;
+    uint64_t latencySpan = pService->config.maxLatencyNs - pService->config.minLatencyNs;
+    const char * pName;
+    const char * pEnd;
+
+    status = FleetProvisioning_MatchTopic( pTopic, topicLength, &topic );
+
+    if( ( status == FleetProvisioningSuccess ) && ( ( ( ( uint32_t ) topic - 1U ) % TOPICS_PER_API ) != 0U ) )
+    {
+        /* Responses are published by the service, not to it. */
+        status = FleetProvisioningNoMatch;
+    }
+
+    if( ( status == FleetProvisioningSuccess ) && ( pService->pendingCount == pService->config.maxPending ) )
+    {
+        status = FleetProvisioningBufferTooSmall;
+    }
+
+    if( status == FleetProvisioningSuccess )
+    {
+        ( void ) memset( &pending, 0, sizeof( pending ) );
+        pending.api = ( uint8_t ) ( ( ( ( uint32_t ) topic - 1U ) % ( TOPICS_PER_API * MOCK_API_COUNT ) ) / TOPICS_PER_API );
+        pending.format = ( uint8_t ) ( ( ( uint32_t ) topic - 1U ) / ( TOPICS_PER_API * MOCK_API_COUNT ) );
+        pending.sequence = pService->sequence;
+        pending.number = pService->nextNumber;
+        pending.clientId = clientId;
+        pending.statusCode = chooseStatus( pService, nowNs, pending.api, ( FleetProvisioningFormat_t ) pending.format,
+                                           pPayload, payloadLength );
+        pending.dueNs = nowNs + pService->config.minLatencyNs +
+                        ( ( latencySpan == 0U ) ? 0U : ( ( ( ( uint64_t ) nextRandom( pService ) << 32 ) | nextRandom( pService ) ) % ( latencySpan + 1U ) ) );
+
+        if( pending.api == API_REGISTER )
+        {
+            /* MatchTopic checked the template name is between the prefix
+             * and the next slash, and at most 36 characters long. */
+            pName = &( pTopic[ FP_REGISTER_API_LENGTH_PREFIX ] );
+            pEnd = memchr( pName, '/', topicLength - FP_REGISTER_API_LENGTH_PREFIX );
+            pending.templateNameLength = ( uint8_t ) ( pEnd - pName );
+            ( void ) memcpy( pending.templateName, pName, pending.templateNameLength );
+        }
+
+        pService->sequence++;
+        pService->nextNumber++;
+        pService->stats.requests[ pending.api ]++;
+        pushPending( pService, &pending );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t MockService_NextDue( const MockService_t * pService,
+                                               uint64_t * pOutDueNs )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+
+    if( pService->pendingCount > 0U )
+    {
+        *pOutDueNs = pService->pPending[ 0 ].dueNs;
+        status = FleetProvisioningSuccess;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+FleetProvisioningStatus_t MockService_Poll( MockService_t * pService,
+                                            uint64_t nowNs,
+                                            uint32_t * pClientId,
+                                            char * pTopic,
+                                            uint16_t * pTopicLength,
+                                            char * pPayload,
+                                            size_t * pPayloadLength )
+{
+    FleetProvisioningStatus_t status = FleetProvisioningNoMatch;
+    MockPending_t pending;
+    Writer_t writer;
+    const char * pResponseTopic;
+    uint32_t rejected;
+
+    if( ( pService->pendingCount > 0U ) && ( pService->pPending[ 0 ].dueNs <= nowNs ) )
+    {
+        popPending( pService, &pending );
+        rejected = ( pending.statusCode == 200U ) ? 0U : 1U;
+        *pClientId = pending.clientId;
+
+        if( pending.api == API_REGISTER )
+        {
+            status = FleetProvisioning_GetRegisterThingTopic( pTopic, MOCK_MAX_TOPIC_LENGTH,
+                                                              ( FleetProvisioningFormat_t ) pending.format,
+                                                              ( rejected == 0U ) ? FleetProvisioningAccepted : FleetProvisioningRejected,
+                                                              pending.templateName, pending.templateNameLength,
+                                                              pTopicLength );
+        }
+        else
+        {
+            pResponseTopic = responseTopics[ pending.format ][ pending.api ][ rejected ];
+            *pTopicLength = ( uint16_t ) strlen( pResponseTopic );
+            ( void ) memcpy( pTopic, pResponseTopic, *pTopicLength );
+            status = FleetProvisioningSuccess;
+        }
+
+        ( void ) memset( &writer, 0, sizeof( writer ) );
+        writer.pBuffer = pPayload;
+        writer.capacity = MOCK_MAX_PAYLOAD_LENGTH;
+        writer.format = pending.format;
+        writeResponse( pService, &pending, &writer );
+        *pPayloadLength = writer.length;
+
+        if( pending.statusCode == 200U )
+        {
+            pService->stats.accepted[ pending.api ]++;
+        }
+        else if( pending.statusCode == 429U )
+        {
+            pService->stats.throttled[ pending.api ]++;
+        }
+        else
+        {
+            pService->stats.failed[ pending.api ]++;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,215 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file mock_service.h
+ * @brief A local stand-in for the AWS IoT Fleet Provisioning service, for
+ * end-to-end and load testing without a network.
+ *
+ * The mock answers requests published to the topics the library builds,
+ * with responses of realistic sizes in JSON or CBOR. It runs in the process
+ * of the test, on a clock passed in by the caller, which may be real or
+ * simulated: requests are answered after a configurable latency, and may be
+ * rejected as throttled, either at random or past a rate limit, or with
+ * other errors at random. As the service answers each device on its own
+ * connection, every request carries the ID of its client, and its response
+ * is returned with it.
+ */
+
+#ifndef MOCK_SERVICE_H_
+#define MOCK_SERVICE_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+
+/**
+ * @brief Longest response topic.
+ */
+#define MOCK_MAX_TOPIC_LENGTH      ( 128U )
+
+/**
+ * @brief Longest response payload.
+ */
+#define MOCK_MAX_PAYLOAD_LENGTH    ( 4096U )
+
+/**
+ * @brief Number of APIs answered by the mock.
+ */
+#define MOCK_API_COUNT             ( 3U )
+
+/**
+ * @brief Behavior of a mock service.
+ */
+typedef struct MockServiceConfig
+{
+    uint64_t minLatencyNs;     /**< @brief Shortest time to answer a request. */
+    uint64_t maxLatencyNs;     /**< @brief Longest time to answer a request; latencies are uniform in between. */
+    uint32_t throttlePercent;  /**< @brief Share of requests rejected as throttled at random. */
+    uint32_t errorPercent;     /**< @brief Share of requests rejected with another error at random. */
+
+    /**
+     * @brief Requests per second each API accepts before rejecting as
+     * throttled, with a burst of as many; 0 for no limit.
+     */
+    uint32_t ratePerSecond;
+    uint32_t maxPending;       /**< @brief Most requests waiting for their response. */
+    uint32_t seed;             /**< @brief Seed of the random choices, for reproducible runs. */
+} MockServiceConfig_t;
+
+/**
+ * @brief Counters of a mock service, for each API in
+ * CreateCertificateFromCsr, CreateKeysAndCertificate, RegisterThing order.
+ */
+typedef struct MockServiceStats
+{
+    uint64_t requests[ MOCK_API_COUNT ];  /**< @brief Requests received. */
+    uint64_t accepted[ MOCK_API_COUNT ];  /**< @brief Accepted responses sent. */
+    uint64_t throttled[ MOCK_API_COUNT ]; /**< @brief Rejected responses with status 429 sent. */
+    uint64_t failed[ MOCK_API_COUNT ];    /**< @brief Other rejected responses sent. */
+} MockServiceStats_t;
+
+/**
+ * @brief A request waiting for its response.
+ */
+typedef struct MockPending
+{
+    uint64_t dueNs;                                       /**< @brief When the response is sent. */
+    uint64_t sequence;                                    /**< @brief Order of the request, to keep equal due times in order. */
+    uint32_t number;                                      /**< @brief Number of the certificate or thing in the response. */
+    uint32_t clientId;                                    /**< @brief Client the response is sent to. */
+    uint16_t statusCode;                                  /**< @brief 200 for accepted, or the rejection status. */
+    uint8_t api;                                          /**< @brief API of the request. */
+    uint8_t format;                                       /**< @brief Format of the request. */
+    uint8_t templateNameLength;                           /**< @brief Length of the template name, for RegisterThing. */
+    char templateName[ FP_TEMPLATENAME_MAX_LENGTH + 1U ]; /**< @brief Template name, for RegisterThing. */
+} MockPending_t;
+
+/**
+ * @brief A mock service.
+ */
+typedef struct MockService
+{
+    MockServiceConfig_t config; /**< @brief Behavior of the mock. */
+    MockServiceStats_t stats;   /**< @brief Counters. */
+    MockPending_t * pPending;   /**< @brief Min-heap of the requests waiting for their response. */
+    uint32_t pendingCount;      /**< @brief Number of requests waiting. */
+    uint64_t sequence;          /**< @brief Number of requests received. */
+    uint32_t nextNumber;        /**< @brief Number of the next certificate or thing. */
+    uint32_t random;            /**< @brief State of the random generator. */
+
+    /**
+     * @brief Tokens of the rate limit of each API, in thousandths of a
+     * request.
+     */
+    uint64_t tokens[ MOCK_API_COUNT ];
+    uint64_t refillNs;          /**< @brief When the tokens were last refilled. */
+    char * pCertificatePem;     /**< @brief Body shared by the PEM certificates of the responses. */
+    char * pPrivateKey;         /**< @brief Body shared by the PEM private keys of the responses. */
+    char * pOwnershipToken;     /**< @brief Body shared by the ownership tokens of the responses. */
+} MockService_t;
+
+/**
+ * @brief Set up a mock service.
+ *
+ * @param[out] pService The mock.
+ * @param[in] pConfig Its behavior.
+ *
+ * @return FleetProvisioningSuccess, or FleetProvisioningBadParameter if the
+ * configuration is invalid or memory runs out.
+ */
+FleetProvisioningStatus_t MockService_Init( MockService_t * pService,
+                                            const MockServiceConfig_t * pConfig );
+
+/**
+ * @brief Free the memory of a mock service.
+ *
+ * @param[in] pService The mock.
+ */
+void MockService_Cleanup( MockService_t * pService );
+
+/**
+ * @brief Publish a request to a mock service.
+ *
+ * @param[in] pService The mock.
+ * @param[in] nowNs The current time.
+ * @param[in] clientId The client publishing the request.
+ * @param[in] pTopic The topic of the request.
+ * @param[in] topicLength The length of @p pTopic.
+ * @param[in] pPayload The payload of the request.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return FleetProvisioningSuccess if the request will be answered;
+ * FleetProvisioningNoMatch if the topic is not a Fleet Provisioning request
+ * topic, which the service ignores; FleetProvisioningBufferTooSmall if
+ * #MockServiceConfig_t.maxPending requests are waiting.
+ */
+FleetProvisioningStatus_t MockService_Publish( MockService_t * pService,
+                                               uint64_t nowNs,
+                                               uint32_t clientId,
+                                               const char * pTopic,
+                                               uint16_t topicLength,
+                                               const char * pPayload,
+                                               size_t payloadLength );
+
+/**
+ * @brief Get when the next response is due.
+ *
+ * @param[in] pService The mock.
+ * @param[out] pOutDueNs When the next response is due.
+ *
+ * @return FleetProvisioningSuccess, or FleetProvisioningNoMatch if no request
+ * is waiting.
+ */
+FleetProvisioningStatus_t MockService_NextDue( const MockService_t * pService,
+                                               uint64_t * pOutDueNs );
+
+/**
+ * @brief Take the next response that is due.
+ *
+ * @param[in] pService The mock.
+ * @param[in] nowNs The current time.
+ * @param[out] pClientId The client the response is sent to.
+ * @param[out] pTopic Buffer of at least #MOCK_MAX_TOPIC_LENGTH characters
+ * for the topic of the response.
+ * @param[out] pTopicLength The length of the topic.
+ * @param[out] pPayload Buffer of at least #MOCK_MAX_PAYLOAD_LENGTH bytes for
+ * the payload of the response.
+ * @param[out] pPayloadLength The length of the payload.
+ *
+ * @return FleetProvisioningSuccess if a response is returned;
+ * FleetProvisioningNoMatch if none is due.
+ */
+FleetProvisioningStatus_t MockService_Poll( MockService_t * pService,
+                                            uint64_t nowNs,
+                                            uint32_t * pClientId,
+                                            char * pTopic,
+                                            uint16_t * pTopicLength,
+                                            char * pPayload,
+                                            size_t * pPayloadLength );
+
+#endif /* MOCK_SERVICE_H_ */
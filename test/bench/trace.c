@@ -0,0 +1,293 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file trace.c
+ * @brief Implementation of the binary traces of Fleet Provisioning traffic.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+/**
+ * @brief Magic bytes starting a trace.
+ */
+#define TRACE_MAGIC           "FPTRACE"
+
+/**
+ * @brief Length of the magic bytes.
+ */
+#define TRACE_MAGIC_LENGTH    ( 7U )
+
+/**
+ * @brief Longest varint, for a 64 bit value.
+ */
+#define MAX_VARINT_LENGTH     ( 10U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Encode a varint.
+ *
+ * @param[out] pBuffer Buffer of at least #MAX_VARINT_LENGTH bytes.
+ * @param[in] value The value.
+ *
+ * @return The length of the varint.
+ */
+static size_t encodeVarint( uint8_t * pBuffer,
+                            uint64_t value );
+
+/**
+ * @brief Read a varint.
+ *
+ * @param[in] pFile The trace file.
+ * @param[out] pValue The value.
+ *
+ * @return 1 if a value is read, 0 at the end of the file before its first
+ * byte, or -1 if it is corrupt or truncated.
+ */
+static int readVarint( FILE * pFile,
+                       uint64_t * pValue );
+
+/*-----------------------------------------------------------*/
+
+static size_t encodeVarint( uint8_t * pBuffer,
+                            uint64_t value )
+{
+    size_t length = 0U;
+
+    while( value >= 0x80U )
+    {
+        pBuffer[ length ] = ( uint8_t ) ( value | 0x80U );
+        value >>= 7;
+        length++;
+    }
+
+    pBuffer[ length ] = ( uint8_t ) value;
+
+    return length + 1U;
+}
+/*-----------------------------------------------------------*/
+
+static int readVarint( FILE * pFile,
+                       uint64_t * pValue )
+{
+    uint64_t value = 0U;
+    unsigned int shift = 0U;
+    int byte = getc( pFile );
+    int status = ( byte == EOF ) ? 0 : 1;
+
+    while( ( status == 1 ) && ( ( byte & 0x80 ) != 0 ) )
+    {
+        value |= ( uint64_t ) ( byte & 0x7F ) << shift;
+        shift += 7U;
+        byte = getc( pFile );
+
+        if( ( byte == EOF ) || ( shift >= 64U ) )
+        {
+            status = -1;
+        }
+    }
+
+    if( status == 1 )
+    {
+        *pValue = value | ( ( uint64_t ) byte << shift );
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+int Trace_OpenWriter( TraceWriter_t * pWriter,
+                      const char * pPath )
+{
+    uint8_t header[ TRACE_MAGIC_LENGTH + 1U ];
+    int status = -1;
+
+    pWriter->lastNs = 0U;
+    pWriter->pFile = fopen( pPath, "wb" );
+
+    if( pWriter->pFile != NULL )
+    {
+        ( void ) memcpy( header, TRACE_MAGIC, TRACE_MAGIC_LENGTH );
+        header[ TRACE_MAGIC_LENGTH ] = TRACE_VERSION;
+
+        if( fwrite( header, 1U, sizeof( header ), pWriter->pFile ) == sizeof( header ) )
+        {
+            status = 0;
+        }
+        else
+        {
+            ( void ) fclose( pWriter->pFile );
+            pWriter->pFile = NULL;
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+int Trace_Write( TraceWriter_t * pWriter,
+                 uint64_t timestampNs,
+                 uint8_t direction,
+                 const char * pTopic,
+                 uint16_t topicLength,
+                 const char * pPayload,
+                 size_t payloadLength )
+{
+    uint8_t head[ 1U + ( 3U * MAX_VARINT_LENGTH ) ];
+    size_t length = 1U;
+    uint64_t deltaNs = ( timestampNs > pWriter->lastNs ) ? ( timestampNs - pWriter->lastNs ) : 0U;
+    int status = 0;
+
+    head[ 0 ] = direction;
+    length += encodeVarint( &( head[ length ] ), deltaNs );
+    length += encodeVarint( &( head[ length ] ), topicLength );
+    length += encodeVarint( &( head[ length ] ), payloadLength );
+    pWriter->lastNs += deltaNs;
+
+    if( ( fwrite( head, 1U, length, pWriter->pFile ) != length ) ||
+        ( fwrite( pTopic, 1U, topicLength, pWriter->pFile ) != topicLength ) ||
+        ( fwrite( pPayload, 1U, payloadLength, pWriter->pFile ) != payloadLength ) )
+    {
+        status = -1;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+int Trace_CloseWriter( TraceWriter_t * pWriter )
+{
+    int status = ( fclose( pWriter->pFile ) == 0 ) ? 0 : -1;
+
+    pWriter->pFile = NULL;
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+int Trace_OpenReader( TraceReader_t * pReader,
+                      const char * pPath )
+{
+    uint8_t header[ TRACE_MAGIC_LENGTH + 1U ];
+    int status = -1;
+
+    ( void ) memset( pReader, 0, sizeof( TraceReader_t ) );
+    pReader->pFile = fopen( pPath, "rb" );
+
+    if( pReader->pFile != NULL )
+    {
+        if( ( fread( header, 1U, sizeof( header ), pReader->pFile ) == sizeof( header ) ) &&
+            ( memcmp( header, TRACE_MAGIC, TRACE_MAGIC_LENGTH ) == 0 ) &&
+            ( header[ TRACE_MAGIC_LENGTH ] == TRACE_VERSION ) )
+        {
+            status = 0;
+        }
+        else
+        {
+            Trace_CloseReader( pReader );
+        }
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+int Trace_Read( TraceReader_t * pReader,
+                TraceRecord_t * pRecord )
+{
+    uint64_t deltaNs = 0U;
+    uint64_t topicLength = 0U;
+    uint64_t payloadLength = 0U;
+    size_t size = 0U;
+    char * pBuffer;
+    int direction = getc( pReader->pFile );
+    int status = ( direction == EOF ) ? 0 : 1;
+
+    if( ( status == 1 ) &&
+        ( ( ( direction != ( int ) TRACE_INBOUND ) && ( direction != ( int ) TRACE_OUTBOUND ) ) ||
+          ( readVarint( pReader->pFile, &deltaNs ) != 1 ) ||
+          ( readVarint( pReader->pFile, &topicLength ) != 1 ) ||
+          ( readVarint( pReader->pFile, &payloadLength ) != 1 ) ||
+          ( topicLength > UINT16_MAX ) || ( payloadLength > TRACE_MAX_PAYLOAD_LENGTH ) ) )
+    {
+        status = -1;
+    }
+
+    if( status == 1 )
+    {
+        size = ( size_t ) ( topicLength + payloadLength );
+
+        /* Grow the buffer to the largest record so far. */
+        if( size > pReader->bufferSize )
+        {
+            pBuffer = realloc( pReader->pBuffer, size );
+
+            if( pBuffer == NULL )
+            {
+                status = -1;
+            }
+            else
+            {
+                pReader->pBuffer = pBuffer;
+                pReader->bufferSize = size;
+            }
+        }
+    }
+
+    if( ( status == 1 ) && ( fread( pReader->pBuffer, 1U, size, pReader->pFile ) != size ) )
+    {
+        status = -1;
+    }
+
+    if( status == 1 )
+    {
+        pReader->lastNs += deltaNs;
+        pRecord->timestampNs = pReader->lastNs;
+        pRecord->direction = ( uint8_t ) direction;
+        pRecord->pTopic = pReader->pBuffer;
+        pRecord->topicLength = ( uint16_t ) topicLength;
+        pRecord->pPayload = &( pReader->pBuffer[ topicLength ] );
+        pRecord->payloadLength = ( size_t ) payloadLength;
+    }
+
+    return status;
+}
+/*-----------------------------------------------------------*/
+
+void Trace_CloseReader( TraceReader_t * pReader )
+{
+    if( pReader->pFile != NULL )
+    {
+        ( void ) fclose( pReader->pFile );
+    }
+
+    free( pReader->pBuffer );
+    ( void ) memset( pReader, 0, sizeof( TraceReader_t ) );
+}
+/*-----------------------------------------------------------*/
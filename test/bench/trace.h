@@ -0,0 +1,185 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file trace.h
+ * @brief Binary traces of Fleet Provisioning traffic, for recording it and
+ * replaying it offline.
+ *
+ * A trace is the 8 byte header "FPTRACE" followed by the version byte, then
+ * one record per message:
+ *
+ * - the direction byte, #TRACE_INBOUND or #TRACE_OUTBOUND;
+ * - the time since the previous record, in nanoseconds;
+ * - the topic length;
+ * - the payload length;
+ * - the topic, then the payload.
+ *
+ * The time and lengths are unsigned LEB128 varints, so a record costs 4 to
+ * 8 bytes on top of its topic and payload. The first record's time is
+ * relative to 0.
+ *
+ * To record traffic, call #Trace_Write from the MQTT publish and receive
+ * callbacks of the application.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Version of the trace format.
+ */
+#define TRACE_VERSION              ( 1U )
+
+/**
+ * @brief Direction of a message received by the device.
+ */
+#define TRACE_INBOUND              ( 0U )
+
+/**
+ * @brief Direction of a message published by the device.
+ */
+#define TRACE_OUTBOUND             ( 1U )
+
+/**
+ * @brief Longest payload a reader accepts, to reject corrupt traces.
+ */
+#define TRACE_MAX_PAYLOAD_LENGTH   ( 1048576U )
+
+/**
+ * @brief A trace being written.
+ */
+typedef struct TraceWriter
+{
+    FILE * pFile;    /**< @brief The trace file. */
+    uint64_t lastNs; /**< @brief Time of the last record. */
+} TraceWriter_t;
+
+/**
+ * @brief A message of a trace.
+ */
+typedef struct TraceRecord
+{
+    uint64_t timestampNs;  /**< @brief Time of the message. */
+    uint8_t direction;     /**< @brief #TRACE_INBOUND or #TRACE_OUTBOUND. */
+    const char * pTopic;   /**< @brief The topic. */
+    uint16_t topicLength;  /**< @brief Length of the topic. */
+    const char * pPayload; /**< @brief The payload. */
+    size_t payloadLength;  /**< @brief Length of the payload. */
+} TraceRecord_t;
+
+/**
+ * @brief A trace being read.
+ */
+typedef struct TraceReader
+{
+    FILE * pFile;      /**< @brief The trace file. */
+    uint64_t lastNs;   /**< @brief Time of the last record. */
+    char * pBuffer;    /**< @brief Buffer of the topic and payload of the last record. */
+    size_t bufferSize; /**< @brief Size of the buffer. */
+} TraceReader_t;
+
+/**
+ * @brief Create a trace.
+ *
+ * @param[out] pWriter The trace.
+ * @param[in] pPath The path of the trace file.
+ *
+ * @return 0 on success, or -1 if the file cannot be created.
+ */
+int Trace_OpenWriter( TraceWriter_t * pWriter,
+                      const char * pPath );
+
+/**
+ * @brief Record a message.
+ *
+ * Timestamps should not decrease; an earlier one is recorded as the time of
+ * the previous record.
+ *
+ * @param[in] pWriter The trace.
+ * @param[in] timestampNs The time of the message.
+ * @param[in] direction #TRACE_INBOUND or #TRACE_OUTBOUND.
+ * @param[in] pTopic The topic.
+ * @param[in] topicLength The length of @p pTopic.
+ * @param[in] pPayload The payload.
+ * @param[in] payloadLength The length of @p pPayload.
+ *
+ * @return 0 on success, or -1 on a write error.
+ */
+int Trace_Write( TraceWriter_t * pWriter,
+                 uint64_t timestampNs,
+                 uint8_t direction,
+                 const char * pTopic,
+                 uint16_t topicLength,
+                 const char * pPayload,
+                 size_t payloadLength );
+
+/**
+ * @brief Finish a trace.
+ *
+ * @param[in] pWriter The trace.
+ *
+ * @return 0 on success, or -1 on a write error.
+ */
+int Trace_CloseWriter( TraceWriter_t * pWriter );
+
+/**
+ * @brief Open a trace.
+ *
+ * @param[out] pReader The trace.
+ * @param[in] pPath The path of the trace file.
+ *
+ * @return 0 on success, or -1 if the file cannot be read or is not a trace
+ * of this version.
+ */
+int Trace_OpenReader( TraceReader_t * pReader,
+                      const char * pPath );
+
+/**
+ * @brief Read the next message of a trace.
+ *
+ * The topic and payload of the record stay valid until the next call.
+ *
+ * @param[in] pReader The trace.
+ * @param[out] pRecord The message.
+ *
+ * @return 1 if a message is read, 0 at the end of the trace, or -1 if the
+ * trace is corrupt or truncated.
+ */
+int Trace_Read( TraceReader_t * pReader,
+                TraceRecord_t * pRecord );
+
+/**
+ * @brief Close a trace.
+ *
+ * @param[in] pReader The trace.
+ */
+void Trace_CloseReader( TraceReader_t * pReader );
+
+#endif /* TRACE_H_ */
@@ -31,6 +31,7 @@
 #define FLEET_PROVISIONING_CONFIG_H_
 
 #include <stdio.h>
+#include <stdint.h>
 
 #ifdef DISABLE_LOGGING
     #ifndef LogError
@@ -58,4 +59,52 @@
     #define LogDebug( message )    printf( "Debug: " ); printf message; printf( "\n" )
 #endif /* DISABLE_LOGGING */
 
+/* The shard queue tests define this, to push from a second producer in the
+ * middle of a push. */
+#ifdef FP_TEST_SHARD_INTERFERENCE
+    uint32_t FleetProvisioningTest_AtomicLoad( const uint32_t * pValue );
+
+    #define FP_ATOMIC_LOAD_ACQUIRE( pValue )    FleetProvisioningTest_AtomicLoad( pValue )
+#endif
+
+/* The binary log tests define this, to write a record in the middle of a
+ * copy of the log. */
+#ifdef FP_TEST_BINARY_LOG_INTERFERENCE
+    void FleetProvisioningTest_ThreadFence( void );
+
+    #define FP_ATOMIC_THREAD_FENCE()    FleetProvisioningTest_ThreadFence()
+#endif
+
+/* The benchmarks define this, to use the shard queues from several threads. */
+#ifdef FP_BENCH_GCC_ATOMICS
+    #define FP_ATOMIC_LOAD_ACQUIRE( pValue )                           __atomic_load_n( ( pValue ), __ATOMIC_ACQUIRE )
+    #define FP_ATOMIC_STORE_RELEASE( pValue, value )                   __atomic_store_n( ( pValue ), ( value ), __ATOMIC_RELEASE )
+    #define FP_ATOMIC_COMPARE_AND_SWAP( pValue, expected, desired )    __sync_bool_compare_and_swap( ( pValue ), ( expected ), ( desired ) )
+#endif
+
+/* The probe tests define this, to record the probes the topic functions
+ * fire. */
+#ifdef FP_TEST_TRACE_PROBES
+    void FleetProvisioningTest_TraceProbe( const char * pName,
+                                           uint64_t arg0,
+                                           uint64_t arg1 );
+
+    #define FP_TRACE_PROBE( name, arg0, arg1 ) \
+    FleetProvisioningTest_TraceProbe( #name, ( uint64_t ) ( uintptr_t ) ( arg0 ), ( uint64_t ) ( uintptr_t ) ( arg1 ) )
+#endif
+
+/* The unit tests run with the performance counters compiled in. */
+#ifndef FP_ENABLE_PERF_COUNTERS
+    #define FP_ENABLE_PERF_COUNTERS    ( 1 )
+#endif
+
+#ifndef FP_ENABLE_PERF_HISTOGRAMS
+    #define FP_ENABLE_PERF_HISTOGRAMS    ( 1 )
+#endif
+
+/* The unit tests run with the binary log compiled in. */
+#ifndef FP_ENABLE_BINARY_LOG
+    #define FP_ENABLE_BINARY_LOG    ( 1 )
+#endif
+
 #endif /* FLEET_PROVISIONING_CONFIG_H_ */
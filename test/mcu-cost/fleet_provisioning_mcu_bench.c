@@ -0,0 +1,421 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_mcu_bench.c
+ * @brief Workload for counting the instructions the AWS IoT Fleet
+ * Provisioning topic functions retire on microcontroller targets.
+ *
+ * Usage: fleet_provisioning_mcu_bench --passes N
+ * (--match CATEGORY --corpus FILE | --register)
+ *
+ * With --match, each pass calls FleetProvisioning_MatchTopic once on every
+ * topic of one category of a corpus written by fleet_provisioning_corpus.
+ * With --register, each pass calls FleetProvisioning_GetRegisterThingTopic
+ * once for each format, topic and template name length. The number of calls
+ * made is printed at the end.
+ *
+ * The workload is run under an emulator or a simulator that counts the
+ * instructions retired, once with N passes and once with 2N passes. The
+ * difference between the two counts, divided by the difference between the
+ * two numbers of calls, is the cost of a call, without the startup and the
+ * loading of the corpus. tools/mcu-cost/mcu_cost.py runs it for each feature
+ * configuration of test/mcu-cost.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fleet Provisioning API includes. */
+#include "fleet_provisioning.h"
+#include "fleet_provisioning_binary_log.h"
+#include "fleet_provisioning_perf.h"
+
+/**
+ * @brief Length of the buffer RegisterThing topics are built in, enough for
+ * the longest template name.
+ */
+#define TOPIC_BUFFER_LENGTH       ( 128U )
+
+/**
+ * @brief Longest line of a corpus, with its category.
+ */
+#define CORPUS_LINE_LENGTH        ( 1024U )
+
+/**
+ * @brief Initial capacity of the corpus topics, doubled as needed.
+ */
+#define CORPUS_INITIAL_TOPICS     ( 256U )
+
+/**
+ * @brief Initial capacity of the corpus text, doubled as needed.
+ */
+#define CORPUS_INITIAL_TEXT       ( 16384U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The topics of one category of a corpus, in a single buffer to keep
+ * the heap of small targets from fragmenting.
+ */
+typedef struct Corpus
+{
+    char * pText;           /**< @brief The topics, one after the other. */
+    size_t textLength;      /**< @brief Bytes of pText used. */
+    size_t textSize;        /**< @brief Bytes of pText allocated. */
+    size_t * pOffsets;      /**< @brief Offset of each topic in pText. */
+    uint16_t * pLengths;    /**< @brief Length of each topic. */
+    size_t topicCount;      /**< @brief Number of topics. */
+    size_t topicSize;       /**< @brief Number of topics allocated. */
+} Corpus_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Written with the result of every call, so that the calls are not
+ * optimized out.
+ */
+static volatile uint32_t sink;
+
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+
+/**
+ * @brief Counters set when the library counts its calls, so that the cost
+ * of counting is measured.
+ */
+    static FleetProvisioningPerfCounters_t perfCounters;
+#endif
+
+#if ( FP_ENABLE_BINARY_LOG != 0 )
+
+/**
+ * @brief Binary log set when the library is built with it.
+ */
+    static FleetProvisioningBinaryLog_t binaryLog;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the topics of a category of a corpus file, or exit.
+ */
+static void loadCorpus( const char * pPath,
+                        const char * pCategory,
+                        Corpus_t * pCorpus );
+
+/**
+ * @brief Grow a buffer to hold at least a number of elements, by doubling,
+ * or exit.
+ */
+static void * growBuffer( void * pBuffer,
+                          size_t * pSize,
+                          size_t needed,
+                          size_t initialSize,
+                          size_t elementSize );
+
+/**
+ * @brief Call FleetProvisioning_MatchTopic on every topic of a corpus, a
+ * number of times. Returns the number of calls.
+ */
+static unsigned long runMatch( const Corpus_t * pCorpus,
+                               unsigned long passes );
+
+/**
+ * @brief Call FleetProvisioning_GetRegisterThingTopic for each format, topic
+ * and template name, a number of times. Returns the number of calls.
+ */
+static unsigned long runRegister( unsigned long passes );
+
+/**
+ * @brief Parse an unsigned command line value, or exit.
+ */
+static unsigned long parseNumber( const char * pArgument );
+
+/*-----------------------------------------------------------*/
+
+static void * growBuffer( void * pBuffer,
+                          size_t * pSize,
+                          size_t needed,
+                          size_t initialSize,
+                          size_t elementSize )
+{
+    void * pGrown = pBuffer;
+    size_t size = *pSize;
+
+    if( needed > size )
+    {
+        size = ( size == 0U ) ? initialSize : size;
+
+        while( size < needed )
+        {
+            size *= 2U;
+        }
+
+        pGrown = realloc( pBuffer, size * elementSize );
+
+        if( pGrown == NULL )
+        {
+            fprintf( stderr, "Out of memory.\n" );
+            exit( EXIT_FAILURE );
+        }
+
+        *pSize = size;
+    }
+
+    return pGrown;
+}
+/*-----------------------------------------------------------*/
+
+static void loadCorpus( const char * pPath,
+                        const char * pCategory,
+                        Corpus_t * pCorpus )
+{
+    static char line[ CORPUS_LINE_LENGTH ];
+    FILE * pFile = fopen( pPath, "r" );
+    char * pTopic;
+    char * pEnd;
+    size_t length;
+    size_t offsetSize;
+
+    if( pFile == NULL )
+    {
+        fprintf( stderr, "Cannot open the corpus %s.\n", pPath );
+        exit( EXIT_FAILURE );
+    }
+
+    while( fgets( line, sizeof( line ), pFile ) != NULL )
+    {
+        pTopic = strchr( line, '\t' );
+        pEnd = strchr( line, '\n' );
+
+        if( ( pTopic == NULL ) || ( pEnd == NULL ) )
+        {
+            fprintf( stderr, "Invalid line in the corpus %s.\n", pPath );
+            exit( EXIT_FAILURE );
+        }
+
+        *pTopic = '\0';
+        pTopic++;
+        *pEnd = '\0';
+
+        if( strcmp( line, pCategory ) == 0 )
+        {
+            length = strlen( pTopic );
+
+            /* Both topic arrays have the same capacity. */
+            offsetSize = pCorpus->topicSize;
+            pCorpus->pOffsets = growBuffer( pCorpus->pOffsets, &offsetSize, pCorpus->topicCount + 1U,
+                                            CORPUS_INITIAL_TOPICS, sizeof( size_t ) );
+            pCorpus->pLengths = growBuffer( pCorpus->pLengths, &( pCorpus->topicSize ), pCorpus->topicCount + 1U,
+                                            CORPUS_INITIAL_TOPICS, sizeof( uint16_t ) );
+            pCorpus->pText = growBuffer( pCorpus->pText, &( pCorpus->textSize ), pCorpus->textLength + length,
+                                         CORPUS_INITIAL_TEXT, sizeof( char ) );
+
+            ( void ) memcpy( &( pCorpus->pText[ pCorpus->textLength ] ), pTopic, length );
+            pCorpus->pOffsets[ pCorpus->topicCount ] = pCorpus->textLength;
+            pCorpus->pLengths[ pCorpus->topicCount ] = ( uint16_t ) length;
+            pCorpus->textLength += length;
+            pCorpus->topicCount++;
+        }
+    }
+
+    ( void ) fclose( pFile );
+
+    if( pCorpus->topicCount == 0U )
+    {
+        fprintf( stderr, "No %s topics in the corpus %s.\n", pCategory, pPath );
+        exit( EXIT_FAILURE );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long runMatch( const Corpus_t * pCorpus,
+                               unsigned long passes )
+{
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    unsigned long pass;
+    size_t i;
+
+    for( pass = 0UL; pass < passes; pass++ )
+    {
+        for( i = 0U; i < pCorpus->topicCount; i++ )
+        {
+            ( void ) FleetProvisioning_MatchTopic( &( pCorpus->pText[ pCorpus->pOffsets[ i ] ] ),
+                                                   pCorpus->pLengths[ i ],
+                                                   &topic );
+            sink = ( uint32_t ) topic;
+        }
+    }
+
+    return passes * ( unsigned long ) pCorpus->topicCount;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long runRegister( unsigned long passes )
+{
+    static const FleetProvisioningFormat_t formats[] = { FleetProvisioningJson, FleetProvisioningCbor };
+    static const FleetProvisioningApiTopics_t topics[] =
+    {
+        FleetProvisioningPublish, FleetProvisioningAccepted, FleetProvisioningRejected
+    };
+    static const char * const templateNames[] =
+    {
+        "FleetTemplate",
+        "FleetTemplate_0123456789abcdefghijkl"
+    };
+    char buffer[ TOPIC_BUFFER_LENGTH ];
+    uint16_t length = 0U;
+    unsigned long pass;
+    unsigned long calls = 0UL;
+    size_t format;
+    size_t topic;
+    size_t name;
+
+    for( pass = 0UL; pass < passes; pass++ )
+    {
+        for( format = 0U; format < ( sizeof( formats ) / sizeof( formats[ 0 ] ) ); format++ )
+        {
+            for( topic = 0U; topic < ( sizeof( topics ) / sizeof( topics[ 0 ] ) ); topic++ )
+            {
+                for( name = 0U; name < ( sizeof( templateNames ) / sizeof( templateNames[ 0 ] ) ); name++ )
+                {
+                    ( void ) FleetProvisioning_GetRegisterThingTopic( buffer,
+                                                                      ( uint16_t ) sizeof( buffer ),
+                                                                      formats[ format ],
+                                                                      topics[ topic ],
+                                                                      templateNames[ name ],
+                                                                      ( uint16_t ) strlen( templateNames[ name ] ),
+                                                                      &length );
+                    sink = length;
+                    calls++;
+                }
+            }
+        }
+    }
+
+    return calls;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long parseNumber( const char * pArgument )
+{
+    char * pEnd = NULL;
+    unsigned long value = 0UL;
+
+    if( pArgument != NULL )
+    {
+        value = strtoul( pArgument, &pEnd, 10 );
+    }
+
+    if( ( pArgument == NULL ) || ( *pEnd != '\0' ) || ( value == 0UL ) )
+    {
+        fprintf( stderr, "Expected a positive number.\n" );
+        exit( EXIT_FAILURE );
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static Corpus_t corpus;
+    const char * pCategory = NULL;
+    const char * pCorpusPath = NULL;
+    unsigned long passes = 1UL;
+    unsigned long calls = 0UL;
+    int matchApi = 0;
+    int registerApi = 0;
+    int arg;
+
+    for( arg = 1; arg < argc; arg++ )
+    {
+        const char * pValue = ( ( arg + 1 ) < argc ) ? argv[ arg + 1 ] : NULL;
+
+        if( strcmp( argv[ arg ], "--register" ) == 0 )
+        {
+            registerApi = 1;
+        }
+        else if( ( pValue != NULL ) && ( strcmp( argv[ arg ], "--match" ) == 0 ) )
+        {
+            matchApi = 1;
+            pCategory = pValue;
+            arg++;
+        }
+        else if( ( pValue != NULL ) && ( strcmp( argv[ arg ], "--corpus" ) == 0 ) )
+        {
+            pCorpusPath = pValue;
+            arg++;
+        }
+        else if( strcmp( argv[ arg ], "--passes" ) == 0 )
+        {
+            passes = parseNumber( pValue );
+            arg++;
+        }
+        else
+        {
+            fprintf( stderr, "Usage: %s --passes N (--match CATEGORY --corpus FILE | --register)\n",
+                     argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( ( matchApi + registerApi ) != 1 )
+    {
+        fprintf( stderr, "Expected one of --match and --register.\n" );
+        return EXIT_FAILURE;
+    }
+
+    if( ( matchApi != 0 ) && ( pCorpusPath == NULL ) )
+    {
+        fprintf( stderr, "--match needs a --corpus.\n" );
+        return EXIT_FAILURE;
+    }
+
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        FleetProvisioning_PerfSetCounters( &perfCounters );
+    #endif
+
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        ( void ) FleetProvisioning_BinaryLogInit( &binaryLog );
+        FleetProvisioning_BinaryLogSet( &binaryLog );
+    #endif
+
+    if( matchApi != 0 )
+    {
+        loadCorpus( pCorpusPath, pCategory, &corpus );
+        calls = runMatch( &corpus, passes );
+    }
+    else
+    {
+        calls = runRegister( passes );
+    }
+
+    printf( "calls: %lu\n", calls );
+
+    return EXIT_SUCCESS;
+}
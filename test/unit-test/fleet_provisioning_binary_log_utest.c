@@ -0,0 +1,293 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_binary_log_utest.c
+ * @brief Unit tests for the Fleet Provisioning binary log.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning binary log include. */
+#include "fleet_provisioning_binary_log.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of a string literal.
+ */
+#define LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/**
+ * @brief Template name used in tests.
+ */
+#define TEST_TEMPLATE_NAME    "binlog"
+
+/**
+ * @brief Log used in tests.
+ */
+static FleetProvisioningBinaryLog_t binaryLog;
+
+/**
+ * @brief Copy of the log used in tests.
+ */
+static FleetProvisioningBinaryLog_t binaryLogCopy;
+
+/**
+ * @brief Number of records the next fences write, as another thread would in
+ * the middle of a copy.
+ */
+static uint32_t interferingWrites;
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &binaryLog, 0xA5, sizeof( binaryLog ) );
+    memset( &binaryLogCopy, 0xA5, sizeof( binaryLogCopy ) );
+    interferingWrites = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_BinaryLogInit( &binaryLog ) );
+
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        FleetProvisioning_BinaryLogSet( &binaryLog );
+    #endif
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        FleetProvisioning_BinaryLogSet( NULL );
+    #endif
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_BinaryLogInit( void );
+void test_FleetProvisioning_BinaryLog_RecordsErrors( void );
+void test_FleetProvisioning_BinaryLog_Wraps( void );
+void test_FleetProvisioning_BinaryLog_NoLog( void );
+void test_FleetProvisioning_BinaryLogCopy_BadParams( void );
+void test_FleetProvisioning_BinaryLogCopy( void );
+void test_FleetProvisioning_BinaryLogCopy_WrittenDuringCopy( void );
+/*-----------------------------------------------------------*/
+
+/* Called for #FP_ATOMIC_THREAD_FENCE. */
+void FleetProvisioningTest_ThreadFence( void )
+{
+    if( interferingWrites > 0U )
+    {
+        interferingWrites--;
+
+        #if ( FP_ENABLE_BINARY_LOG != 0 )
+            FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMatchTopicBadParameter, 0xFFU, 0U, 0U, 0U, 0U, 0U );
+        #endif
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_BinaryLogInit rejects invalid
+ * parameters and clears the log.
+ */
+void test_FleetProvisioning_BinaryLogInit( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_BinaryLogInit( NULL ) );
+
+    TEST_ASSERT_EQUAL_HEX32( FP_BINARY_LOG_MAGIC, binaryLog.magic );
+    TEST_ASSERT_EQUAL_UINT32( FP_BINARY_LOG_SIZE, binaryLog.size );
+    TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.next );
+    TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.records[ 0 ].sequence );
+    TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.records[ FP_BINARY_LOG_SIZE - 1U ].sequence );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the errors of the topic functions are recorded with their
+ * arguments.
+ */
+void test_FleetProvisioning_BinaryLog_RecordsErrors( void )
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        char topicBuffer[ LITERAL_LENGTH( FP_CBOR_REGISTER_REJECTED_TOPIC( TEST_TEMPLATE_NAME ) ) ];
+        uint16_t topicLength = 0U;
+
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                    ( uint16_t ) sizeof( topicBuffer ),
+                                                                    FleetProvisioningCbor,
+                                                                    FleetProvisioningRejected,
+                                                                    TEST_TEMPLATE_NAME,
+                                                                    0U,
+                                                                    &topicLength ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                           FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                    ( uint16_t ) ( sizeof( topicBuffer ) - 1U ),
+                                                                    FleetProvisioningCbor,
+                                                                    FleetProvisioningRejected,
+                                                                    TEST_TEMPLATE_NAME,
+                                                                    ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                    &topicLength ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_MatchTopic( topicBuffer, 1U, NULL ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 3U, binaryLog.next );
+
+        TEST_ASSERT_EQUAL_UINT32( 1U, binaryLog.records[ 0 ].sequence );
+        TEST_ASSERT_EQUAL_UINT32( FleetProvisioningLogGetRegisterThingTopicBadParameter, binaryLog.records[ 0 ].message );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 0 ] == ( uint64_t ) ( uintptr_t ) topicBuffer );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 1 ] == ( uint64_t ) FleetProvisioningCbor );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 2 ] == ( uint64_t ) FleetProvisioningRejected );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 3 ] == ( uint64_t ) ( uintptr_t ) TEST_TEMPLATE_NAME );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 4 ] == 0U );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 5 ] == ( uint64_t ) ( uintptr_t ) &topicLength );
+
+        TEST_ASSERT_EQUAL_UINT32( 2U, binaryLog.records[ 1 ].sequence );
+        TEST_ASSERT_EQUAL_UINT32( FleetProvisioningLogGetRegisterThingTopicBufferTooSmall, binaryLog.records[ 1 ].message );
+        TEST_ASSERT_TRUE( binaryLog.records[ 1 ].args[ 0 ] == ( uint64_t ) ( sizeof( topicBuffer ) - 1U ) );
+        TEST_ASSERT_TRUE( binaryLog.records[ 1 ].args[ 1 ] == ( uint64_t ) sizeof( topicBuffer ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 3U, binaryLog.records[ 2 ].sequence );
+        TEST_ASSERT_EQUAL_UINT32( FleetProvisioningLogMatchTopicBadParameter, binaryLog.records[ 2 ].message );
+        TEST_ASSERT_TRUE( binaryLog.records[ 2 ].args[ 0 ] == ( uint64_t ) ( uintptr_t ) topicBuffer );
+        TEST_ASSERT_TRUE( binaryLog.records[ 2 ].args[ 1 ] == 0U );
+
+        TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.records[ 3 ].sequence );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the oldest record is overwritten when the log is full.
+ */
+void test_FleetProvisioning_BinaryLog_Wraps( void )
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        uint32_t i;
+
+        for( i = 0U; i <= FP_BINARY_LOG_SIZE; i++ )
+        {
+            FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMatchTopicBadParameter, i, 0U, 0U, 0U, 0U, 0U );
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( FP_BINARY_LOG_SIZE + 1U, binaryLog.next );
+        TEST_ASSERT_EQUAL_UINT32( FP_BINARY_LOG_SIZE + 1U, binaryLog.records[ 0 ].sequence );
+        TEST_ASSERT_TRUE( binaryLog.records[ 0 ].args[ 0 ] == FP_BINARY_LOG_SIZE );
+        TEST_ASSERT_EQUAL_UINT32( 2U, binaryLog.records[ 1 ].sequence );
+        TEST_ASSERT_TRUE( binaryLog.records[ 1 ].args[ 0 ] == 1U );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that nothing is recorded once the log is set to NULL.
+ */
+void test_FleetProvisioning_BinaryLog_NoLog( void )
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+        FleetProvisioning_BinaryLogSet( NULL );
+
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_MatchTopic( NULL, 0U, &topic ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.next );
+        TEST_ASSERT_EQUAL_UINT32( 0U, binaryLog.records[ 0 ].sequence );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_BinaryLogCopy rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_BinaryLogCopy_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_BinaryLogCopy( NULL, &binaryLogCopy ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_BinaryLogCopy( &binaryLog, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_BinaryLogCopy( &binaryLog, &binaryLog ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a log is copied with all its records.
+ */
+void test_FleetProvisioning_BinaryLogCopy( void )
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMatchTopicBadParameter, 1U, 2U, 3U, 4U, 5U, 6U );
+        FleetProvisioning_BinaryLogWrite( FleetProvisioningLogGetRegisterThingTopicBufferTooSmall, 7U, 8U, 0U, 0U, 0U, 0U );
+    #endif
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_BinaryLogCopy( &binaryLog, &binaryLogCopy ) );
+
+    TEST_ASSERT_EQUAL_MEMORY( &binaryLog, &binaryLogCopy, sizeof( binaryLog ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a record written while it is copied is marked as being
+ * written in the copy, and the others are copied.
+ */
+void test_FleetProvisioning_BinaryLogCopy_WrittenDuringCopy( void )
+{
+    #if ( FP_ENABLE_BINARY_LOG != 0 )
+        uint32_t i;
+
+        for( i = 0U; i < FP_BINARY_LOG_SIZE; i++ )
+        {
+            FleetProvisioning_BinaryLogWrite( FleetProvisioningLogMatchTopicBadParameter, i, 0U, 0U, 0U, 0U, 0U );
+        }
+
+        /* The first record is copied first, and overwritten while its
+         * arguments are read. */
+        interferingWrites = 1U;
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_BinaryLogCopy( &binaryLog, &binaryLogCopy ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 0U, interferingWrites );
+        TEST_ASSERT_EQUAL_UINT32( FP_BINARY_LOG_SIZE + 1U, binaryLog.records[ 0 ].sequence );
+        TEST_ASSERT_EQUAL_UINT32( FP_BINARY_LOG_SIZE, binaryLogCopy.next );
+        TEST_ASSERT_EQUAL_UINT32( 0U, binaryLogCopy.records[ 0 ].sequence );
+        TEST_ASSERT_EQUAL_UINT32( 2U, binaryLogCopy.records[ 1 ].sequence );
+        TEST_ASSERT_TRUE( binaryLogCopy.records[ 1 ].args[ 0 ] == 1U );
+    #endif
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,366 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_concurrency_utest.c
+ * @brief Unit tests for the Fleet Provisioning concurrency controller.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning concurrency include. */
+#include "fleet_provisioning_concurrency.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Rejected JSON response of a throttled request.
+ */
+#define TEST_JSON_THROTTLED \
+    "{\"statusCode\":429,\"errorCode\":\"ThrottlingException\",\"errorMessage\":\"Rate exceeded\"}"
+
+/**
+ * @brief Rejected JSON response of an invalid request.
+ */
+#define TEST_JSON_INVALID \
+    "{\"statusCode\":400,\"errorCode\":\"InvalidPayload\",\"errorMessage\":\"Bad\"}"
+
+/**
+ * @brief Length of a string literal.
+ */
+#define STRING_LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/**
+ * @brief Rejected CBOR response of an overloaded service:
+ * { "statusCode": 503 }.
+ */
+static const uint8_t testCborUnavailable[] =
+{
+    0xA1U, 0x6AU, 's', 't', 'a', 't', 'u', 's', 'C', 'o', 'd', 'e', 0x19U, 0x01U, 0xF7U
+};
+
+/**
+ * @brief Controller used in tests.
+ */
+static FleetProvisioningConcurrency_t controller;
+
+/**
+ * @brief Settings used in tests: limits from 2 to 40, starting at 4, halved
+ * on throttling.
+ */
+static FleetProvisioningConcurrencyConfig_t config;
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &controller, 0, sizeof( controller ) );
+    config.minLimit = 2U;
+    config.initialLimit = 4U;
+    config.maxLimit = 40U;
+    config.decreasePercent = 50U;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_ConcurrencyInit_BadParams( void );
+void test_FleetProvisioning_Concurrency_StartFinish( void );
+void test_FleetProvisioning_Concurrency_Increase( void );
+void test_FleetProvisioning_Concurrency_Decrease( void );
+void test_FleetProvisioning_Concurrency_Convergence( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to feed throttled responses.
+ *
+ * @param[in] count The number of responses.
+ */
+static void throttle( uint32_t count )
+{
+    uint32_t i;
+
+    for( i = 0U; i < count; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_ConcurrencyOnResponse( &controller,
+                                                                    FleetProvJsonRegisterThingRejected,
+                                                                    TEST_JSON_THROTTLED,
+                                                                    STRING_LITERAL_LENGTH( TEST_JSON_THROTTLED ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to feed accepted responses.
+ *
+ * @param[in] count The number of responses.
+ */
+static void accept( uint32_t count )
+{
+    uint32_t i;
+
+    for( i = 0U; i < count; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_ConcurrencyOnResponse( &controller,
+                                                                    FleetProvCborCreateKeysAndCertAccepted,
+                                                                    NULL, 0U ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that invalid settings are rejected.
+ */
+void test_FleetProvisioning_ConcurrencyInit_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( NULL, &config ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, NULL ) );
+
+    config.minLimit = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.minLimit = 5U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.minLimit = 2U;
+    config.maxLimit = 3U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.maxLimit = FP_CONCURRENCY_MAX_LIMIT + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.maxLimit = FP_CONCURRENCY_MAX_LIMIT;
+    config.decreasePercent = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.decreasePercent = 100U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    config.decreasePercent = 99U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    TEST_ASSERT_EQUAL_UINT32( 4U, controller.limit );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that sessions are only started within the limit.
+ */
+void test_FleetProvisioning_Concurrency_StartFinish( void )
+{
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyTryStart( NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_ConcurrencyFinish( NULL ) );
+
+    for( i = 0U; i < 4U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyTryStart( &controller ) );
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_ConcurrencyTryStart( &controller ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyFinish( &controller ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyTryStart( &controller ) );
+    TEST_ASSERT_EQUAL_UINT32( 4U, controller.inFlight );
+
+    for( i = 0U; i < 5U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyFinish( &controller ) );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( 0U, controller.inFlight );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that accepted responses raise the limit by one per window, up
+ * to the largest limit.
+ */
+void test_FleetProvisioning_Concurrency_Increase( void )
+{
+    config.maxLimit = 6U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ConcurrencyOnResponse( NULL, FleetProvJsonRegisterThingAccepted, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvisioningInvalidTopic, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller,
+                                                                ( FleetProvisioningTopic_t ) ( FleetProvCborRegisterThingRejected + 1 ),
+                                                                NULL, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvJsonRegisterThingPublish, NULL, 0U ) );
+
+    accept( 3U );
+    TEST_ASSERT_EQUAL_UINT32( 4U, controller.limit );
+    accept( 1U );
+    TEST_ASSERT_EQUAL_UINT32( 5U, controller.limit );
+    accept( 4U );
+    TEST_ASSERT_EQUAL_UINT32( 5U, controller.limit );
+    accept( 1U );
+    TEST_ASSERT_EQUAL_UINT32( 6U, controller.limit );
+    accept( 60U );
+    TEST_ASSERT_EQUAL_UINT32( 6U, controller.limit );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that throttling cuts the limit once per window, and that other
+ * rejections leave it as is.
+ */
+void test_FleetProvisioning_Concurrency_Decrease( void )
+{
+    uint32_t i;
+
+    config.initialLimit = 20U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+
+    for( i = 0U; i < 20U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyTryStart( &controller ) );
+    }
+
+    /* Rejections without a throttling status code. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvJsonCreateCertFromCsrRejected,
+                                                                TEST_JSON_INVALID,
+                                                                STRING_LITERAL_LENGTH( TEST_JSON_INVALID ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvJsonCreateCertFromCsrRejected,
+                                                                "{}", 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvCborRegisterThingRejected,
+                                                                NULL, 0U ) );
+    TEST_ASSERT_EQUAL_UINT32( 20U, controller.limit );
+
+    /* The first throttle cuts the limit; the responses of the other sessions
+     * in flight do not. */
+    throttle( 1U );
+    TEST_ASSERT_EQUAL_UINT32( 10U, controller.limit );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_ConcurrencyTryStart( &controller ) );
+    throttle( 19U );
+    TEST_ASSERT_EQUAL_UINT32( 10U, controller.limit );
+    accept( 1U );
+    TEST_ASSERT_EQUAL_UINT32( 10U, controller.limit );
+
+    for( i = 0U; i < 20U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyFinish( &controller ) );
+    }
+
+    /* A CBOR service unavailable response cuts the limit again. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ConcurrencyOnResponse( &controller, FleetProvCborCreateKeysAndCertRejected,
+                                                                ( const char * ) testCborUnavailable,
+                                                                sizeof( testCborUnavailable ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 5U, controller.limit );
+
+    /* Small limits are cut by one, down to the smallest limit. */
+    config.initialLimit = 3U;
+    config.minLimit = 1U;
+    config.decreasePercent = 10U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+    throttle( 1U );
+    TEST_ASSERT_EQUAL_UINT32( 2U, controller.limit );
+    throttle( 5U );
+    TEST_ASSERT_EQUAL_UINT32( 1U, controller.limit );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Simulate a service that serves up to 20 requests at once and
+ * throttles the rest, and check that the limit settles around that
+ * capacity.
+ */
+void test_FleetProvisioning_Concurrency_Convergence( void )
+{
+    const uint32_t capacity = 20U;
+    uint32_t round;
+    uint32_t started;
+    uint32_t i;
+    uint32_t accepted = 0U;
+    uint32_t throttled = 0U;
+
+    config.initialLimit = 2U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &config ) );
+
+    for( round = 0U; round < 400U; round++ )
+    {
+        started = 0U;
+
+        while( FleetProvisioning_ConcurrencyTryStart( &controller ) == FleetProvisioningSuccess )
+        {
+            started++;
+        }
+
+        TEST_ASSERT_EQUAL_UINT32( controller.limit, started );
+
+        for( i = 0U; i < started; i++ )
+        {
+            if( i < capacity )
+            {
+                accept( 1U );
+                accepted += ( round >= 100U ) ? 1U : 0U;
+            }
+            else
+            {
+                throttle( 1U );
+                throttled += ( round >= 100U ) ? 1U : 0U;
+            }
+
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyFinish( &controller ) );
+        }
+
+        /* Once warmed up, the limit stays between the cut capacity and just
+         * above the capacity. */
+        if( round >= 100U )
+        {
+            TEST_ASSERT_UINT32_WITHIN( 6U, 16U, controller.limit );
+        }
+    }
+
+    /* At least 70% of the capacity is used, with at most 2% of the requests
+     * throttled. */
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32( ( capacity * 300U * 7U ) / 10U, accepted );
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32( ( accepted + throttled ) / 50U, throttled );
+}
+/*-----------------------------------------------------------*/
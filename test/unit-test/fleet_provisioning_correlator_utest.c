@@ -0,0 +1,384 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_correlator_utest.c
+ * @brief Unit tests for the Fleet Provisioning response correlator.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning correlator include. */
+#include "fleet_provisioning_correlator.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of a string literal.
+ */
+#define LITERAL_LENGTH( literal )    ( ( uint16_t ) ( sizeof( literal ) - 1U ) )
+
+/**
+ * @brief Template name of the maximum length.
+ */
+#define TEST_LONG_TEMPLATE           "sensor-with-the-longest-name-allowed"
+
+/**
+ * @brief Correlator used in tests.
+ */
+static FleetProvisioningCorrelator_t correlator;
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &correlator, 0xA5, sizeof( correlator ) );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_CorrelatorInit_BadParams( void );
+void test_FleetProvisioning_CorrelatorPush_BadParams( void );
+void test_FleetProvisioning_CorrelatorMatch_BadParams( void );
+void test_FleetProvisioning_Correlator_Fifo( void );
+void test_FleetProvisioning_Correlator_Templates( void );
+void test_FleetProvisioning_Correlator_Limits( void );
+void test_FleetProvisioning_CorrelatorCancel( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to match a response and check its tag.
+ *
+ * @param[in] pTopic The response topic.
+ * @param[in] expectedTopic The expected topic value.
+ * @param[in] expectedTag The tag of the request expected to match.
+ */
+static void expectMatch( const char * pTopic,
+                         FleetProvisioningTopic_t expectedTopic,
+                         uint32_t expectedTag )
+{
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    uint32_t tag = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorMatch( &correlator, pTopic, ( uint16_t ) strlen( pTopic ),
+                                                          &topic, &tag ) );
+    TEST_ASSERT_EQUAL( expectedTopic, topic );
+    TEST_ASSERT_EQUAL_UINT32( expectedTag, tag );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to check that a response matches no request.
+ *
+ * @param[in] pTopic The response topic.
+ */
+static void expectNoMatch( const char * pTopic )
+{
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+    uint32_t tag = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_CorrelatorMatch( &correlator, pTopic, ( uint16_t ) strlen( pTopic ),
+                                                          &topic, &tag ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that invalid pipeline depths are rejected.
+ */
+void test_FleetProvisioning_CorrelatorInit_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_CorrelatorInit( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_CorrelatorInit( &correlator, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorInit( &correlator, FP_CORRELATOR_MAX_PENDING + 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorInit( &correlator, FP_CORRELATOR_MAX_PENDING ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that only publish topics, with a template name for
+ * RegisterThing, can be recorded.
+ */
+void test_FleetProvisioning_CorrelatorPush_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 4U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( NULL, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvisioningInvalidTopic, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator,
+                                                         ( FleetProvisioningTopic_t ) ( FleetProvCborRegisterThingRejected + 1 ),
+                                                         NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertAccepted, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish, NULL, 4U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish, "tmpl", 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvCborRegisterThingPublish, "tmpl",
+                                                         FP_TEMPLATENAME_MAX_LENGTH + 1U, 1U ) );
+
+    /* Template names are ignored for the other APIs. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvCborCreateCertFromCsrPublish, NULL, 0U, 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that invalid parameters and topics that are not responses are
+ * rejected.
+ */
+void test_FleetProvisioning_CorrelatorMatch_BadParams( void )
+{
+    FleetProvisioningTopic_t topic;
+    uint32_t tag;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 4U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 1U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorMatch( NULL, FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC,
+                                                          FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH, &topic, &tag ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorMatch( &correlator, NULL,
+                                                          FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH, &topic, &tag ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorMatch( &correlator, FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC,
+                                                          FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH, NULL, &tag ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CorrelatorMatch( &correlator, FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC,
+                                                          FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH, &topic, NULL ) );
+
+    expectNoMatch( FP_JSON_CREATE_KEYS_PUBLISH_TOPIC );
+    expectNoMatch( "$aws/things/thing1/shadow/update/accepted" );
+    expectNoMatch( "" );
+    expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, 1U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that each API and format keeps its own queue, answered in
+ * order.
+ */
+void test_FleetProvisioning_Correlator_Fifo( void )
+{
+    uint32_t tag;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 8U ) );
+
+    for( tag = 0U; tag < 4U; tag++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish,
+                                                             NULL, 0U, tag ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_CorrelatorPush( &correlator, FleetProvCborCreateKeysAndCertPublish,
+                                                             NULL, 0U, 100U + tag ) );
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateCertFromCsrPublish,
+                                                         NULL, 0U, 200U ) );
+
+    expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, 0U );
+    expectMatch( FP_CBOR_CREATE_KEYS_REJECTED_TOPIC, FleetProvCborCreateKeysAndCertRejected, 100U );
+    expectMatch( FP_JSON_CREATE_KEYS_REJECTED_TOPIC, FleetProvJsonCreateKeysAndCertRejected, 1U );
+    expectMatch( FP_JSON_CREATE_CERT_ACCEPTED_TOPIC, FleetProvJsonCreateCertFromCsrAccepted, 200U );
+    expectNoMatch( FP_JSON_CREATE_CERT_ACCEPTED_TOPIC );
+    expectNoMatch( FP_CBOR_CREATE_CERT_ACCEPTED_TOPIC );
+
+    /* Requests recorded after some were answered join the end. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish,
+                                                         NULL, 0U, 4U ) );
+
+    for( tag = 2U; tag < 5U; tag++ )
+    {
+        expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, tag );
+    }
+
+    expectNoMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that RegisterThing responses go to the oldest request of
+ * their template.
+ */
+void test_FleetProvisioning_Correlator_Templates( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 8U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "sensor", 6U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "sensor-v2", 9U, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "sensor", 6U, 3U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "sensor-v2", 9U, 4U ) );
+
+    /* A template name that is a prefix of another does not match it. */
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor-v2" ), FleetProvJsonRegisterThingAccepted, 2U );
+    expectMatch( FP_JSON_REGISTER_REJECTED_TOPIC( "sensor-v2" ), FleetProvJsonRegisterThingRejected, 4U );
+    expectNoMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor-v2" ) );
+    expectNoMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sens" ) );
+    expectNoMatch( FP_CBOR_REGISTER_ACCEPTED_TOPIC( "sensor" ) );
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor" ), FleetProvJsonRegisterThingAccepted, 1U );
+
+    /* Nor does a template name of the same length with other characters,
+     * and a request whose template name is longer than the whole topic is
+     * skipped. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         TEST_LONG_TEMPLATE, LITERAL_LENGTH( TEST_LONG_TEMPLATE ), 7U ) );
+    expectNoMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sentry" ) );
+    expectNoMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "s" ) );
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_LONG_TEMPLATE ), FleetProvJsonRegisterThingAccepted, 7U );
+
+    /* The queue still takes requests at its end after its last one was
+     * matched out of the middle. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "other", 5U, 5U ) );
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "other" ), FleetProvJsonRegisterThingAccepted, 5U );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "sensor", 6U, 6U ) );
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor" ), FleetProvJsonRegisterThingAccepted, 3U );
+    expectMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor" ), FleetProvJsonRegisterThingAccepted, 6U );
+    expectNoMatch( FP_JSON_REGISTER_ACCEPTED_TOPIC( "sensor" ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the pipeline depth of each queue and the total number of
+ * pending requests.
+ */
+void test_FleetProvisioning_Correlator_Limits( void )
+{
+    uint32_t i;
+    uint32_t pushed = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 3U ) );
+    expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, 1U );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 3U ) );
+
+    /* With the deepest pipeline, the entries run out before the queues. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorInit( &correlator, FP_CORRELATOR_MAX_PENDING ) );
+
+    for( i = 0U; i < FP_CORRELATOR_MAX_PENDING; i++ )
+    {
+        if( FleetProvisioning_CorrelatorPush( &correlator,
+                                              ( ( i % 2U ) == 0U ) ? FleetProvJsonCreateKeysAndCertPublish :
+                                              FleetProvCborCreateCertFromCsrPublish,
+                                              NULL, 0U, i ) == FleetProvisioningSuccess )
+        {
+            pushed++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( FP_CORRELATOR_MAX_PENDING, pushed );
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "tmpl", 4U, 0U ) );
+    expectMatch( FP_CBOR_CREATE_CERT_REJECTED_TOPIC, FleetProvCborCreateCertFromCsrRejected, 1U );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonRegisterThingPublish,
+                                                         "tmpl", 4U, 0U ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that cancelled requests leave every queue.
+ */
+void test_FleetProvisioning_CorrelatorCancel( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorInit( &correlator, 8U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_CorrelatorCancel( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_CorrelatorCancel( &correlator, 1U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvCborRegisterThingPublish,
+                                                         "tmpl", 4U, 1U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_CorrelatorCancel( &correlator, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_CorrelatorCancel( &correlator, 1U ) );
+    expectNoMatch( FP_CBOR_REGISTER_ACCEPTED_TOPIC( "tmpl" ) );
+
+    /* The queue is intact after removing its first and last requests. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CorrelatorPush( &correlator, FleetProvJsonCreateKeysAndCertPublish, NULL, 0U, 3U ) );
+    expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, 2U );
+    expectMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FleetProvJsonCreateKeysAndCertAccepted, 3U );
+    expectNoMatch( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC );
+}
+/*-----------------------------------------------------------*/
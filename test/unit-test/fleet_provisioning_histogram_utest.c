@@ -0,0 +1,422 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file fleet_provisioning_histogram_utest.c
+ * @brief Unit tests for the Fleet Provisioning latency histograms.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning histogram include. */
+#include "fleet_provisioning_histogram.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of a string literal.
+ */
+#define LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/**
+ * @brief Metric name used in tests.
+ */
+#define TEST_NAME                    "m"
+
+/**
+ * @brief Labels used in tests.
+ */
+#define TEST_LABELS                  "a=\"b\""
+
+/**
+ * @brief The values recorded by #recordValues, one per bucket written but
+ * for 8 and 9, which share a bucket.
+ */
+#define TEST_SUM                     ( 0U + 7U + 8U + 9U + 12U + 4294967295ULL )
+
+/**
+ * @brief The export of the values recorded by #recordValues, with the test
+ * labels.
+ */
+#define TEST_EXPORT                                  \
+    "m_bucket{a=\"b\",le=\"0\"} 1\n"                 \
+    "m_bucket{a=\"b\",le=\"7\"} 2\n"                 \
+    "m_bucket{a=\"b\",le=\"9\"} 4\n"                 \
+    "m_bucket{a=\"b\",le=\"13\"} 5\n"                \
+    "m_bucket{a=\"b\",le=\"4294967295\"} 6\n"        \
+    "m_bucket{a=\"b\",le=\"+Inf\"} 6\n"              \
+    "m_sum{a=\"b\"} 4294967331\n"                    \
+    "m_count{a=\"b\"} 6\n"
+
+/**
+ * @brief The export of the values recorded by #recordValues, without labels.
+ */
+#define TEST_EXPORT_NO_LABELS              \
+    "m_bucket{le=\"0\"} 1\n"               \
+    "m_bucket{le=\"7\"} 2\n"               \
+    "m_bucket{le=\"9\"} 4\n"               \
+    "m_bucket{le=\"13\"} 5\n"              \
+    "m_bucket{le=\"4294967295\"} 6\n"      \
+    "m_bucket{le=\"+Inf\"} 6\n"            \
+    "m_sum 4294967331\n"                   \
+    "m_count 6\n"
+
+/**
+ * @brief The `# HELP` and `# TYPE` lines of the response ticks.
+ */
+#define TEST_TICKS_HEADER                                                                      \
+    "# HELP fleet_provisioning_response_ticks Ticks from the publish of a request to its response.\n" \
+    "# TYPE fleet_provisioning_response_ticks histogram\n"
+
+/**
+ * @brief The `# HELP` and `# TYPE` lines of the handling cycles.
+ */
+#define TEST_CYCLES_HEADER                                                         \
+    "# HELP fleet_provisioning_handle_cycles Cycles taken to handle a response.\n" \
+    "# TYPE fleet_provisioning_handle_cycles histogram\n"
+
+/**
+ * @brief Histogram used in tests.
+ */
+static FleetProvisioningHistogram_t histogram;
+
+/**
+ * @brief Latency histograms used in tests.
+ */
+static FleetProvisioningLatency_t latency;
+
+/**
+ * @brief Buffer the tests export to.
+ */
+static char buffer[ 2048 ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &histogram, 0, sizeof( histogram ) );
+    memset( &latency, 0xA5, sizeof( latency ) );
+    memset( buffer, 0xA5, sizeof( buffer ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_LatencyInit( &latency ) );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_Histogram_BadParams( void );
+void test_FleetProvisioning_HistogramRecord_Buckets( void );
+void test_FleetProvisioning_HistogramRecord_RelativeError( void );
+void test_FleetProvisioning_HistogramMerge( void );
+void test_FleetProvisioning_HistogramExportPrometheus( void );
+void test_FleetProvisioning_HistogramExportPrometheus_BufferTooSmall( void );
+void test_FleetProvisioning_Latency_BadParams( void );
+void test_FleetProvisioning_LatencyMerge( void );
+void test_FleetProvisioning_LatencyExportPrometheus( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to record values in the test histogram, spread over five
+ * buckets, up to the highest one.
+ */
+static void recordValues( void )
+{
+    static const uint32_t values[] = { 9U, 0U, 4294967295U, 12U, 8U, 7U };
+    uint32_t i;
+
+    for( i = 0U; i < ( sizeof( values ) / sizeof( values[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_HistogramRecord( &histogram, values[ i ] ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the histogram functions reject invalid parameters.
+ */
+void test_FleetProvisioning_Histogram_BadParams( void )
+{
+    size_t length = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_HistogramRecord( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_HistogramMerge( NULL, &histogram ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_HistogramMerge( &histogram, NULL ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( NULL, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, NULL, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, 0U,
+                                                                    NULL, 0U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 1U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, NULL, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, buffer, sizeof( buffer ), NULL ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, length );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that small values get a bucket each, and that higher values
+ * share buckets of a quarter of their power of two.
+ */
+void test_FleetProvisioning_HistogramRecord_Buckets( void )
+{
+    recordValues();
+
+    TEST_ASSERT_EQUAL_UINT32( 1U, histogram.counts[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, histogram.counts[ 7 ] );
+    TEST_ASSERT_EQUAL_UINT32( 2U, histogram.counts[ 8 ] );
+    TEST_ASSERT_EQUAL_UINT32( 0U, histogram.counts[ 9 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, histogram.counts[ 10 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, histogram.counts[ FP_HISTOGRAM_BUCKETS - 1U ] );
+    TEST_ASSERT_EQUAL_UINT64( TEST_SUM, histogram.sum );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the buckets of increasing values never go back, and grow
+ * with the power of two of the value.
+ */
+void test_FleetProvisioning_HistogramRecord_RelativeError( void )
+{
+    uint64_t value;
+    uint32_t previous = 0U;
+    uint32_t bucket;
+    uint32_t power;
+    uint32_t i;
+
+    for( value = 1U; value <= 0xFFFFFFFFU; value += ( value / 3U ) + 1U )
+    {
+        memset( &histogram, 0, sizeof( histogram ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_HistogramRecord( &histogram, ( uint32_t ) value ) );
+
+        for( bucket = 0U, i = 0U; i < FP_HISTOGRAM_BUCKETS; i++ )
+        {
+            if( histogram.counts[ i ] != 0U )
+            {
+                bucket = i;
+            }
+        }
+
+        for( power = 0U; ( value >> ( power + 1U ) ) != 0U; power++ )
+        {
+        }
+
+        /* Each power of two 2^p from 8 up has the four buckets from 4 * ( p - 1 ),
+         * so a bucket holds values within a quarter of their power of two. */
+        TEST_ASSERT_TRUE( bucket >= previous );
+        TEST_ASSERT_TRUE( ( value < 8U ) || ( ( bucket / 4U ) == ( power - 1U ) ) );
+        previous = bucket;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that merging adds the buckets and sums of histograms.
+ */
+void test_FleetProvisioning_HistogramMerge( void )
+{
+    FleetProvisioningHistogram_t total;
+
+    memset( &total, 0, sizeof( total ) );
+    recordValues();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_HistogramMerge( &total, &histogram ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_HistogramMerge( &total, &histogram ) );
+
+    TEST_ASSERT_EQUAL_UINT32( 4U, total.counts[ 8 ] );
+    TEST_ASSERT_EQUAL_UINT32( 2U, total.counts[ FP_HISTOGRAM_BUCKETS - 1U ] );
+    TEST_ASSERT_EQUAL_UINT64( 2U * TEST_SUM, total.sum );
+    TEST_ASSERT_EQUAL_UINT32( 2U, histogram.counts[ 8 ] );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the Prometheus export of a histogram, with and without labels.
+ */
+void test_FleetProvisioning_HistogramExportPrometheus( void )
+{
+    size_t length = 0U;
+
+    /* An empty histogram only has the +Inf bucket. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( "m_bucket{le=\"+Inf\"} 0\nm_sum 0\nm_count 0\n" ), length );
+    TEST_ASSERT_EQUAL_MEMORY( "m_bucket{le=\"+Inf\"} 0\nm_sum 0\nm_count 0\n", buffer, length );
+
+    recordValues();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    TEST_LABELS, LITERAL_LENGTH( TEST_LABELS ),
+                                                                    buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( TEST_EXPORT ), length );
+    TEST_ASSERT_EQUAL_MEMORY( TEST_EXPORT, buffer, length );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                    NULL, 0U, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( TEST_EXPORT_NO_LABELS ), length );
+    TEST_ASSERT_EQUAL_MEMORY( TEST_EXPORT_NO_LABELS, buffer, length );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that an export fails without writing past the buffer when the
+ * buffer is one byte too short, or shorter.
+ */
+void test_FleetProvisioning_HistogramExportPrometheus_BufferTooSmall( void )
+{
+    size_t length = 0U;
+    size_t bufferLength;
+
+    recordValues();
+
+    for( bufferLength = 0U; bufferLength < LITERAL_LENGTH( TEST_EXPORT ); bufferLength++ )
+    {
+        memset( buffer, 0xA5, sizeof( buffer ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                           FleetProvisioning_HistogramExportPrometheus( &histogram, TEST_NAME, LITERAL_LENGTH( TEST_NAME ),
+                                                                        TEST_LABELS, LITERAL_LENGTH( TEST_LABELS ),
+                                                                        buffer, bufferLength, &length ) );
+        TEST_ASSERT_EQUAL_HEX8( 0xA5, ( uint8_t ) buffer[ bufferLength ] );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( 0U, length );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the latency functions reject invalid parameters.
+ */
+void test_FleetProvisioning_Latency_BadParams( void )
+{
+    size_t length = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_LatencyInit( NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_LatencyMerge( NULL, &latency ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_LatencyMerge( &latency, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_LatencyExportPrometheus( NULL, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_LatencyExportPrometheus( &latency, NULL, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_LatencyExportPrometheus( &latency, buffer, sizeof( buffer ), NULL ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, length );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that merging latency histograms merges the histograms of each
+ * topic.
+ */
+void test_FleetProvisioning_LatencyMerge( void )
+{
+    static FleetProvisioningLatency_t total;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_LatencyInit( &total ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramRecord( &( latency.responseTicks[ FleetProvCborRegisterThingRejected ] ), 5U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramRecord( &( latency.handleCycles[ FleetProvJsonCreateCertFromCsrAccepted ] ), 100U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_LatencyMerge( &total, &latency ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_LatencyMerge( &total, &latency ) );
+
+    TEST_ASSERT_EQUAL_UINT32( 2U, total.responseTicks[ FleetProvCborRegisterThingRejected ].counts[ 5 ] );
+    TEST_ASSERT_EQUAL_UINT64( 200U, total.handleCycles[ FleetProvJsonCreateCertFromCsrAccepted ].sum );
+    TEST_ASSERT_EQUAL_UINT64( 0U, total.responseTicks[ FleetProvJsonCreateCertFromCsrAccepted ].sum );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the Prometheus export of latency histograms, labeled by
+ * topic.
+ */
+void test_FleetProvisioning_LatencyExportPrometheus( void )
+{
+    static const char expected[] =
+        TEST_TICKS_HEADER
+        "fleet_provisioning_response_ticks_bucket{format=\"json\",api=\"create_keys_and_certificate\",response=\"request\",le=\"1\"} 1\n"
+        "fleet_provisioning_response_ticks_bucket{format=\"json\",api=\"create_keys_and_certificate\",response=\"request\",le=\"+Inf\"} 1\n"
+        "fleet_provisioning_response_ticks_sum{format=\"json\",api=\"create_keys_and_certificate\",response=\"request\"} 1\n"
+        "fleet_provisioning_response_ticks_count{format=\"json\",api=\"create_keys_and_certificate\",response=\"request\"} 1\n"
+        "fleet_provisioning_response_ticks_bucket{format=\"cbor\",api=\"register_thing\",response=\"rejected\",le=\"5\"} 1\n"
+        "fleet_provisioning_response_ticks_bucket{format=\"cbor\",api=\"register_thing\",response=\"rejected\",le=\"+Inf\"} 1\n"
+        "fleet_provisioning_response_ticks_sum{format=\"cbor\",api=\"register_thing\",response=\"rejected\"} 5\n"
+        "fleet_provisioning_response_ticks_count{format=\"cbor\",api=\"register_thing\",response=\"rejected\"} 1\n"
+        TEST_CYCLES_HEADER
+        "fleet_provisioning_handle_cycles_bucket{format=\"json\",api=\"create_certificate_from_csr\",response=\"accepted\",le=\"111\"} 1\n"
+        "fleet_provisioning_handle_cycles_bucket{format=\"json\",api=\"create_certificate_from_csr\",response=\"accepted\",le=\"+Inf\"} 1\n"
+        "fleet_provisioning_handle_cycles_sum{format=\"json\",api=\"create_certificate_from_csr\",response=\"accepted\"} 100\n"
+        "fleet_provisioning_handle_cycles_count{format=\"json\",api=\"create_certificate_from_csr\",response=\"accepted\"} 1\n";
+    size_t length = 0U;
+
+    /* Only the metric headers are written without values. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_LatencyExportPrometheus( &latency, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( TEST_TICKS_HEADER TEST_CYCLES_HEADER ), length );
+    TEST_ASSERT_EQUAL_MEMORY( TEST_TICKS_HEADER TEST_CYCLES_HEADER, buffer, length );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramRecord( &( latency.responseTicks[ FleetProvCborRegisterThingRejected ] ), 5U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramRecord( &( latency.responseTicks[ FleetProvJsonCreateKeysAndCertPublish ] ), 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_HistogramRecord( &( latency.handleCycles[ FleetProvJsonCreateCertFromCsrAccepted ] ), 100U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_LatencyExportPrometheus( &latency, buffer, sizeof( buffer ), &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( expected ), length );
+    TEST_ASSERT_EQUAL_MEMORY( expected, buffer, length );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_LatencyExportPrometheus( &latency, buffer, LITERAL_LENGTH( expected ) - 1U, &length ) );
+    TEST_ASSERT_EQUAL_UINT32( LITERAL_LENGTH( expected ), length );
+}
@@ -0,0 +1,763 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_parser_utest.c
+ * @brief Unit tests for the Fleet Provisioning response parser.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning parser include. */
+#include "fleet_provisioning_parser.h"
+
+/* Helper macro to calculate the length of a string literal. */
+#define STRING_LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/* JSON RegisterThing accepted response used in the tests. */
+#define TEST_JSON_RESPONSE                                       \
+    "{ \"deviceConfiguration\": {"                               \
+    " \"serverUrl\": \"https://example.com\","                   \
+    " \"escaped\": \"a\\\"b\","                                  \
+    " \"retries\": 5,"                                           \
+    " \"nested\": { \"list\": [ 1, \"]\", { } ] },"              \
+    " \"enabled\" : true },"                                     \
+    " \"ignored\": [ \"x\", { \"y\": null } ],"                  \
+    " \"thingName\": \"TestThing\" }"
+
+/* CBOR encoding of { "thingName": "TestThing",
+ *                    "deviceConfiguration": { "k1": "v1", "num": 5,
+ *                                             "tag": 1( [ 1, { 2: h'00' } ] ) } }. */
+static const char testCborResponse[] =
+    "\xA2"
+    "\x69" "thingName" "\x69" "TestThing"
+    "\x73" "deviceConfiguration"
+    "\xA3"
+    "\x62" "k1" "\x62" "v1"
+    "\x63" "num" "\x05"
+    "\x63" "tag" "\xC1\x82\x01\xA1\x02\x41\x00";
+
+#define TEST_CBOR_RESPONSE_LENGTH    ( sizeof( testCborResponse ) - 1U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Response used in tests.
+ */
+static FleetProvisioningRegisterThingResponse_t response;
+
+/**
+ * @brief Buffer for generated payloads.
+ */
+static char generatedPayload[ 64U + ( ( FP_DEVICE_CONFIG_MAX_ENTRIES + 1U ) * 16U ) ];
+
+/**
+ * @brief Buffer for a payload with a key longer than UINT16_MAX.
+ */
+static char longKeyPayload[ UINT16_MAX + 128U ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &response, 0xA5, sizeof( response ) );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_ParseRegisterThingAccepted_BadParams( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_JsonHappyPath( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_CborHappyPath( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_JsonWhitespace( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_CborByteStrings( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_LongKey( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_NoDeviceConfig( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_TooManyEntries( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_MalformedJson( void );
+void test_FleetProvisioning_ParseRegisterThingAccepted_MalformedCbor( void );
+void test_FleetProvisioning_GetDeviceConfigValue_BadParams( void );
+void test_FleetProvisioning_GetDeviceConfigValue_Collisions( void );
+void test_FleetProvisioning_GetDeviceConfigValue_HashCollisions( void );
+void test_FleetProvisioning_GetDeviceConfigValue_FullIndex( void );
+void test_FleetProvisioning_GetDeviceConfigEntry_BadParams( void );
+void test_FleetProvisioning_GetResponseString_BadParams( void );
+void test_FleetProvisioning_GetResponseString_Json( void );
+void test_FleetProvisioning_GetResponseString_Cbor( void );
+void test_FleetProvisioning_GetResponseStatusCode_BadParams( void );
+void test_FleetProvisioning_GetResponseStatusCode_Json( void );
+void test_FleetProvisioning_GetResponseStatusCode_Cbor( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to check a span against a string literal.
+ */
+static void expectSpan( const char * pExpected,
+                        const FleetProvisioningSpan_t * pSpan )
+{
+    TEST_ASSERT_EQUAL( strlen( pExpected ), pSpan->length );
+    TEST_ASSERT_EQUAL_MEMORY( pExpected, pSpan->pData, pSpan->length );
+}
+
+/**
+ * @brief Helper to check the value of a device configuration key.
+ */
+static void expectValue( const char * pKey,
+                         const char * pExpected )
+{
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetDeviceConfigValue( &response, pKey, strlen( pKey ), &value ) );
+    expectSpan( pExpected, &value );
+}
+
+/**
+ * @brief Helper to parse a JSON payload given as a string.
+ */
+static FleetProvisioningStatus_t parseJson( const char * pPayload )
+{
+    return FleetProvisioning_ParseRegisterThingAccepted( pPayload,
+                                                         strlen( pPayload ),
+                                                         FleetProvisioningJson,
+                                                         &response );
+}
+
+/**
+ * @brief Helper to parse a CBOR payload.
+ */
+static FleetProvisioningStatus_t parseCbor( const char * pPayload,
+                                            size_t length )
+{
+    return FleetProvisioning_ParseRegisterThingAccepted( pPayload,
+                                                         length,
+                                                         FleetProvisioningCbor,
+                                                         &response );
+}
+
+/**
+ * @brief Helper to generate a JSON payload with the given number of device
+ * configuration entries. Each entry has a three digit key equal to its value.
+ */
+static const char * generatePayload( size_t entryCount )
+{
+    size_t length;
+    size_t i;
+
+    length = ( size_t ) sprintf( generatedPayload, "{\"thingName\":\"T\",\"deviceConfiguration\":{" );
+
+    for( i = 0U; i < entryCount; i++ )
+    {
+        length += ( size_t ) sprintf( &( generatedPayload[ length ] ), "%s\"%03u\":\"%03u\"",
+                                      ( i == 0U ) ? "" : ",",
+                                      ( unsigned int ) i,
+                                      ( unsigned int ) i );
+    }
+
+    ( void ) sprintf( &( generatedPayload[ length ] ), "}}" );
+
+    return generatedPayload;
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ParseRegisterThingAccepted( NULL,
+                                                                     STRING_LITERAL_LENGTH( TEST_JSON_RESPONSE ),
+                                                                     FleetProvisioningJson,
+                                                                     &response ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ParseRegisterThingAccepted( TEST_JSON_RESPONSE,
+                                                                     0U,
+                                                                     FleetProvisioningJson,
+                                                                     &response ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ParseRegisterThingAccepted( TEST_JSON_RESPONSE,
+                                                                     STRING_LITERAL_LENGTH( TEST_JSON_RESPONSE ),
+                                                                     ( FleetProvisioningFormat_t ) ( FleetProvisioningCbor + 1 ),
+                                                                     &response ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ParseRegisterThingAccepted( TEST_JSON_RESPONSE,
+                                                                     STRING_LITERAL_LENGTH( TEST_JSON_RESPONSE ),
+                                                                     FleetProvisioningJson,
+                                                                     NULL ) );
+
+    if( sizeof( size_t ) > sizeof( uint32_t ) )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_ParseRegisterThingAccepted( TEST_JSON_RESPONSE,
+                                                                         ( size_t ) UINT32_MAX + 1U,
+                                                                         FleetProvisioningJson,
+                                                                         &response ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_JsonHappyPath( void )
+{
+    FleetProvisioningSpan_t key;
+    FleetProvisioningSpan_t value;
+    static const char * const expectedKeys[] =
+    {
+        "serverUrl", "escaped", "retries", "nested", "enabled"
+    };
+    size_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( TEST_JSON_RESPONSE ) );
+    expectSpan( "TestThing", &( response.thingName ) );
+
+    expectValue( "serverUrl", "https://example.com" );
+    expectValue( "escaped", "a\\\"b" );
+    expectValue( "retries", "5" );
+    expectValue( "nested", "{ \"list\": [ 1, \"]\", { } ] }" );
+    expectValue( "enabled", "true" );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "ignored", 7U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "server", 6U, &value ) );
+
+    /* Entries are iterated in payload order. */
+    for( i = 0U; i < ( sizeof( expectedKeys ) / sizeof( expectedKeys[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetDeviceConfigEntry( &response, i, &key, &value ) );
+        expectSpan( expectedKeys[ i ], &key );
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigEntry( &response, i, &key, &value ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_CborHappyPath( void )
+{
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseCbor( testCborResponse, TEST_CBOR_RESPONSE_LENGTH ) );
+    expectSpan( "TestThing", &( response.thingName ) );
+    expectValue( "k1", "v1" );
+
+    /* Non-string values are returned as their encoded items. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "num", 3U, &value ) );
+    TEST_ASSERT_EQUAL( 1U, value.length );
+    TEST_ASSERT_EQUAL( 0x05, value.pData[ 0 ] );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "tag", 3U, &value ) );
+    TEST_ASSERT_EQUAL( 7U, value.length );
+    TEST_ASSERT_EQUAL_MEMORY( "\xC1\x82\x01\xA1\x02\x41\x00", value.pData, 7U );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_JsonWhitespace( void )
+{
+    /* Every kind of JSON whitespace, between tokens and after scalars, a key
+     * as long as "thingName", and whitespace up to the end of the payload. */
+    static const char payload[] =
+        "{\r\n\t\"thingNamX\":\"X\",\r\n"
+        "\t\"thingName\" :\t\"T\",\r\n"
+        "\t\"deviceConfiguration\":{\"a\":1\t,\"b\":2\r,\"c\":3\n,\"d\":4 }\r\n}\r\n\t ";
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ParseRegisterThingAccepted( payload,
+                                                                     STRING_LITERAL_LENGTH( payload ),
+                                                                     FleetProvisioningJson,
+                                                                     &response ) );
+    expectSpan( "T", &( response.thingName ) );
+    expectValue( "a", "1" );
+    expectValue( "b", "2" );
+    expectValue( "c", "3" );
+    expectValue( "d", "4" );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_CborByteStrings( void )
+{
+    /* { "thingName": "T", "deviceConfiguration": { "bs": h'7879' } } */
+    static const char payload[] =
+        "\xA2"
+        "\x69" "thingName" "\x61" "T"
+        "\x73" "deviceConfiguration"
+        "\xA1"
+        "\x62" "bs" "\x42" "xy";
+
+    /* Byte string values are returned as their content. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseCbor( payload, STRING_LITERAL_LENGTH( payload ) ) );
+    expectValue( "bs", "xy" );
+
+    /* Byte string keys are not allowed. */
+    TEST_ASSERT_EQUAL( FleetProvisioningError, parseCbor( "\xA1\x41" "a" "\x01", 4U ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_LongKey( void )
+{
+    static const char prefix[] = "{\"thingName\":\"T\",\"deviceConfiguration\":{\"";
+    static const char suffix[] = "\":\"v\"}}";
+    size_t length = 0U;
+
+    /* Keys are indexed with 16-bit lengths. */
+    ( void ) memcpy( longKeyPayload, prefix, STRING_LITERAL_LENGTH( prefix ) );
+    length += STRING_LITERAL_LENGTH( prefix );
+    ( void ) memset( &( longKeyPayload[ length ] ), 'k', ( size_t ) UINT16_MAX + 1U );
+    length += ( size_t ) UINT16_MAX + 1U;
+    ( void ) memcpy( &( longKeyPayload[ length ] ), suffix, STRING_LITERAL_LENGTH( suffix ) );
+    length += STRING_LITERAL_LENGTH( suffix );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_ParseRegisterThingAccepted( longKeyPayload,
+                                                                     length,
+                                                                     FleetProvisioningJson,
+                                                                     &response ) );
+
+    /* One byte shorter fits. */
+    ( void ) memmove( &( longKeyPayload[ STRING_LITERAL_LENGTH( prefix ) + UINT16_MAX ] ),
+                      &( longKeyPayload[ STRING_LITERAL_LENGTH( prefix ) + UINT16_MAX + 1U ] ),
+                      STRING_LITERAL_LENGTH( suffix ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ParseRegisterThingAccepted( longKeyPayload,
+                                                                     length - 1U,
+                                                                     FleetProvisioningJson,
+                                                                     &response ) );
+    TEST_ASSERT_EQUAL( 1U, response.entryCount );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_NoDeviceConfig( void )
+{
+    FleetProvisioningSpan_t value;
+    /* A CBOR map using one and two byte length arguments, and skipped
+     * members holding an 8 byte integer and a float. */
+    static const char cborPayload[] =
+        "\xB9\x00\x03"
+        "\x78\x09" "thingName" "\x79\x00\x01" "T"
+        "\x61" "a" "\x1B\x00\x00\x00\x01\x00\x00\x00\x00"
+        "\x61" "b" "\xFA\x00\x00\x00\x00";
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( "{\"thingName\":\"T\",\"deviceConfiguration\":{}}" ) );
+    expectSpan( "T", &( response.thingName ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "a", 1U, &value ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( " {\"thingName\":\"T\"} " ) );
+    expectSpan( "T", &( response.thingName ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseCbor( cborPayload, sizeof( cborPayload ) - 1U ) );
+    expectSpan( "T", &( response.thingName ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_TooManyEntries( void )
+{
+    /* Exactly the maximum number of entries fits. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( generatePayload( FP_DEVICE_CONFIG_MAX_ENTRIES ) ) );
+    expectValue( "000", "000" );
+
+    /* One more does not. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall, parseJson( generatePayload( FP_DEVICE_CONFIG_MAX_ENTRIES + 1U ) ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_MalformedJson( void )
+{
+    static const char * const payloads[] =
+    {
+        "",
+        "[]",
+        "{",
+        "{\"thingName\":\"T\"",
+        "{\"thingName\" \"T\"}",
+        "{\"thingName\":\"T\" \"a\":1}",
+        "{\"thingName\":\"T\",}",
+        "{\"thingName\":\"T\", 1:2}",
+        "{\"thingName\":\"T",
+        "{\"thingName\":\"T\\",
+        "{\"thingName\":}",
+        "{\"thingName\":",
+        "{\"thingName\":1}",
+        "{\"thingName\":\"T\",\"a\":{\"b\":[1}",
+        "{\"thingName\":\"T\",\"deviceConfiguration\":[]}",
+        "{\"thingName\":\"T\",\"deviceConfiguration\":{\"a\"}}",
+        "{\"thingName\":\"T\",\"a\":1]}",
+        "{\"thingName\":\"T\",\"a\":1",
+        "{\"thingName\":\"T\",\"a\":[1,{\"b\":2}",
+        "{\"thingName\":\"T\",\"a\":[\"b}",
+        "{\"thingName\":\"T\",\"a\": ",
+        "{\"thingName\":\"T\" ",
+        "{\"a\":\"b\"}"
+    };
+    size_t i;
+
+    /* Each payload is parsed with and without a terminating NUL, so that
+     * truncated tokens run to the end of the payload. */
+    for( i = 0U; i < ( sizeof( payloads ) / sizeof( payloads[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningError,
+                           FleetProvisioning_ParseRegisterThingAccepted( payloads[ i ],
+                                                                         strlen( payloads[ i ] ) + 1U,
+                                                                         FleetProvisioningJson,
+                                                                         &response ) );
+
+        if( payloads[ i ][ 0 ] != '\0' )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningError, parseJson( payloads[ i ] ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_ParseRegisterThingAccepted_MalformedCbor( void )
+{
+    size_t i;
+
+    static const struct
+    {
+        const char * pPayload;
+        size_t length;
+    } payloads[] =
+    {
+        /* Not a map. */
+        { "\x80",                                                       1U  },
+        /* Map count larger than the payload. */
+        { "\xA5\x61" "a",                                               3U  },
+        /* Indefinite length map. */
+        { "\xBF\xFF",                                                   2U  },
+        /* Truncated argument. */
+        { "\xB8",                                                       1U  },
+        /* Reserved additional information. */
+        { "\xA1\x7C",                                                   2U  },
+        /* Non-text key. */
+        { "\xA1\x01\x01",                                               3U  },
+        /* Truncated key length. */
+        { "\xA1\x79\x00",                                               3U  },
+        /* Key longer than the payload. */
+        { "\xA1\x65" "ab",                                              4U  },
+        /* Missing value. */
+        { "\xA1\x61" "a",                                               3U  },
+        /* String value longer than the payload. */
+        { "\xA1\x61" "a" "\x65" "ab",                                   6U  },
+        /* Nested byte string, array and map longer than the payload. */
+        { "\xA1\x61" "a" "\xC1\x45" "ab",                               7U  },
+        { "\xA1\x61" "a" "\x85\x01",                                    5U  },
+        { "\xA1\x61" "a" "\xA5\x01",                                    5U  },
+        /* Nested array missing its last item. */
+        { "\xA1\x61" "a" "\x82\x61" "b",                                6U  },
+        /* Saturated 8 byte length. */
+        { "\xA1\x61" "a" "\x7B\x01\x00\x00\x00\x00\x00\x00\x01" "a",    13U },
+        /* Thing name is not a string. */
+        { "\xA1\x69" "thingName" "\x01",                                12U },
+        /* Device configuration is not a map. */
+        { "\xA1\x73" "deviceConfiguration" "\x80",                      22U },
+        /* Thing name missing. */
+        { "\xA0",                                                       1U  }
+    };
+
+    for( i = 0U; i < ( sizeof( payloads ) / sizeof( payloads[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningError, parseCbor( payloads[ i ].pPayload, payloads[ i ].length ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetDeviceConfigValue_BadParams( void )
+{
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( TEST_JSON_RESPONSE ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigValue( NULL, "a", 1U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigValue( &response, NULL, 1U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "a", 1U, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetDeviceConfigValue_Collisions( void )
+{
+    FleetProvisioningSpan_t value;
+    char key[ 8 ];
+    size_t i;
+
+    /* Fill the index so that probing wraps around the slot table and lookups
+     * of missing keys visit occupied slots. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( generatePayload( FP_DEVICE_CONFIG_MAX_ENTRIES ) ) );
+
+    for( i = 0U; i < FP_DEVICE_CONFIG_MAX_ENTRIES; i++ )
+    {
+        ( void ) sprintf( key, "%03u", ( unsigned int ) i );
+        expectValue( key, key );
+    }
+
+    for( i = FP_DEVICE_CONFIG_MAX_ENTRIES; i < ( 4U * FP_DEVICE_CONFIG_MAX_ENTRIES ); i++ )
+    {
+        ( void ) sprintf( key, "%03u", ( unsigned int ) i );
+        TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                           FleetProvisioning_GetDeviceConfigValue( &response, key, 3U, &value ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetDeviceConfigValue_HashCollisions( void )
+{
+    FleetProvisioningSpan_t value;
+
+    /* "LLcJ5" and "ljkEj" have the same FNV-1a hash, as do "f4Y89" and
+     * "po3m3B", so lookups of the second keys compare the key bytes and
+     * lengths of the first. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       parseJson( "{\"thingName\":\"T\",\"deviceConfiguration\":{\"LLcJ5\":\"1\",\"f4Y89\":\"2\"}}" ) );
+    expectValue( "LLcJ5", "1" );
+    expectValue( "f4Y89", "2" );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "ljkEj", 5U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "po3m3B", 6U, &value ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetDeviceConfigValue_FullIndex( void )
+{
+    FleetProvisioningSpan_t value;
+
+    /* A parsed index is never more than half full. Lookups in a response
+     * filled by the application still end after one pass over the slots. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( generatePayload( 1U ) ) );
+    ( void ) memset( response.slots, 1, sizeof( response.slots ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetDeviceConfigValue( &response, "missing", 7U, &value ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetDeviceConfigEntry_BadParams( void )
+{
+    FleetProvisioningSpan_t key;
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, parseJson( TEST_JSON_RESPONSE ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigEntry( NULL, 0U, &key, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigEntry( &response, 0U, NULL, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetDeviceConfigEntry( &response, 0U, &key, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseString_BadParams( void )
+{
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseString( NULL, 10U, FleetProvisioningJson,
+                                                            "thingName", 9U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseString( TEST_JSON_RESPONSE, 0U, FleetProvisioningJson,
+                                                            "thingName", 9U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseString( TEST_JSON_RESPONSE, 10U, ( FleetProvisioningFormat_t ) 2,
+                                                            "thingName", 9U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseString( TEST_JSON_RESPONSE, 10U, FleetProvisioningJson,
+                                                            NULL, 9U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseString( TEST_JSON_RESPONSE, 10U, FleetProvisioningJson,
+                                                            "thingName", 9U, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseString_Json( void )
+{
+    static const char payload[] =
+        "{ \"certificateId\": \"id\", \"nested\": { \"certificateOwnershipToken\": \"no\" },"
+        " \"certificateOwnershipToken\": \"tok\\/en\", \"count\": 3 }";
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseString( payload, STRING_LITERAL_LENGTH( payload ),
+                                                            FleetProvisioningJson,
+                                                            FP_API_OWNERSHIP_TOKEN_KEY,
+                                                            STRING_LITERAL_LENGTH( FP_API_OWNERSHIP_TOKEN_KEY ),
+                                                            &value ) );
+    expectSpan( "tok\\/en", &value );
+
+    /* The span points into the payload. */
+    TEST_ASSERT_EQUAL_PTR( strstr( payload, "tok\\/en" ), value.pData );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseString( payload, STRING_LITERAL_LENGTH( payload ),
+                                                            FleetProvisioningJson, "count", 5U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetResponseString( payload, STRING_LITERAL_LENGTH( payload ),
+                                                            FleetProvisioningJson, "missing", 7U, &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseString( payload, STRING_LITERAL_LENGTH( payload ) - 10U,
+                                                            FleetProvisioningJson, "missing", 7U, &value ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseString_Cbor( void )
+{
+    FleetProvisioningSpan_t value;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseString( testCborResponse, TEST_CBOR_RESPONSE_LENGTH,
+                                                            FleetProvisioningCbor, "thingName", 9U, &value ) );
+    expectSpan( "TestThing", &value );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseString( testCborResponse, TEST_CBOR_RESPONSE_LENGTH,
+                                                            FleetProvisioningCbor, "deviceConfiguration", 19U,
+                                                            &value ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetResponseString( testCborResponse, TEST_CBOR_RESPONSE_LENGTH,
+                                                            FleetProvisioningCbor, "k1", 2U, &value ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseStatusCode_BadParams( void )
+{
+    uint32_t statusCode;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseStatusCode( NULL, 10U, FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseStatusCode( TEST_JSON_RESPONSE, 0U, FleetProvisioningJson,
+                                                                &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseStatusCode( TEST_JSON_RESPONSE, 10U,
+                                                                ( FleetProvisioningFormat_t ) 2, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetResponseStatusCode( TEST_JSON_RESPONSE, 10U, FleetProvisioningJson,
+                                                                NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseStatusCode_Json( void )
+{
+    static const char rejected[] =
+        "{\"statusCode\":429,\"errorCode\":\"ThrottlingException\",\"errorMessage\":\"Rate exceeded\"}";
+    static const char maximum[] = "{ \"statusCode\": 4294967295 }";
+    static const char overflow[] = "{ \"statusCode\": 4294967296 }";
+    static const char negative[] = "{ \"statusCode\": -1 }";
+    static const char quoted[] = "{ \"statusCode\": \"429\" }";
+    uint32_t statusCode = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseStatusCode( rejected, STRING_LITERAL_LENGTH( rejected ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL_UINT32( 429U, statusCode );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseStatusCode( maximum, STRING_LITERAL_LENGTH( maximum ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL_UINT32( UINT32_MAX, statusCode );
+
+    statusCode = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( overflow, STRING_LITERAL_LENGTH( overflow ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( negative, STRING_LITERAL_LENGTH( negative ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( quoted, STRING_LITERAL_LENGTH( quoted ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetResponseStatusCode( TEST_JSON_RESPONSE,
+                                                                STRING_LITERAL_LENGTH( TEST_JSON_RESPONSE ),
+                                                                FleetProvisioningJson, &statusCode ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, statusCode );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GetResponseStatusCode_Cbor( void )
+{
+    /* { "statusCode": 429, "errorCode": "x" } */
+    static const uint8_t rejected[] =
+    {
+        0xA2U, 0x6AU, 's', 't', 'a', 't', 'u', 's', 'C', 'o', 'd', 'e', 0x19U, 0x01U, 0xADU,
+        0x69U, 'e', 'r', 'r', 'o', 'r', 'C', 'o', 'd', 'e', 0x61U, 'x'
+    };
+    /* { "statusCode": -1 } */
+    static const uint8_t negative[] =
+    {
+        0xA1U, 0x6AU, 's', 't', 'a', 't', 'u', 's', 'C', 'o', 'd', 'e', 0x20U
+    };
+    /* { "statusCode": 2^32 } */
+    static const uint8_t overflow[] =
+    {
+        0xA1U, 0x6AU, 's', 't', 'a', 't', 'u', 's', 'C', 'o', 'd', 'e',
+        0x1BU, 0x00U, 0x00U, 0x00U, 0x01U, 0x00U, 0x00U, 0x00U, 0x00U
+    };
+    uint32_t statusCode = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseStatusCode( ( const char * ) rejected, sizeof( rejected ),
+                                                                FleetProvisioningCbor, &statusCode ) );
+    TEST_ASSERT_EQUAL_UINT32( 429U, statusCode );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( ( const char * ) negative, sizeof( negative ),
+                                                                FleetProvisioningCbor, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( ( const char * ) overflow, sizeof( overflow ),
+                                                                FleetProvisioningCbor, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningError,
+                       FleetProvisioning_GetResponseStatusCode( ( const char * ) rejected, 7U,
+                                                                FleetProvisioningCbor, &statusCode ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_GetResponseStatusCode( testCborResponse, TEST_CBOR_RESPONSE_LENGTH,
+                                                                FleetProvisioningCbor, &statusCode ) );
+    TEST_ASSERT_EQUAL_UINT32( 429U, statusCode );
+}
+/*-----------------------------------------------------------*/
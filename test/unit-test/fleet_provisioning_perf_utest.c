@@ -0,0 +1,220 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_perf_utest.c
+ * @brief Unit tests for the Fleet Provisioning performance counters.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning perf include. */
+#include "fleet_provisioning_perf.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of a string literal.
+ */
+#define LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/**
+ * @brief Template name used in tests.
+ */
+#define TEST_TEMPLATE_NAME    "perf"
+
+/* The default configuration does not compile the counters in, and the tests
+ * then only check that the library builds. */
+#if ( FP_ENABLE_PERF_COUNTERS != 0 )
+
+/**
+ * @brief Counters used in tests.
+ */
+    static FleetProvisioningPerfCounters_t counters;
+#endif
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        memset( &counters, 0, sizeof( counters ) );
+        FleetProvisioning_PerfSetCounters( &counters );
+    #endif
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        FleetProvisioning_PerfSetCounters( NULL );
+    #endif
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_Perf_CountsCallsByStatus( void );
+void test_FleetProvisioning_Perf_CountsTopics( void );
+void test_FleetProvisioning_Perf_Histogram( void );
+void test_FleetProvisioning_Perf_NoCounters( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that calls are counted by function and returned status.
+ */
+void test_FleetProvisioning_Perf_CountsCallsByStatus( void )
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        char topicBuffer[ LITERAL_LENGTH( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ) ) ];
+        uint16_t topicLength = 0U;
+
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                    ( uint16_t ) sizeof( topicBuffer ),
+                                                                    FleetProvisioningJson,
+                                                                    FleetProvisioningAccepted,
+                                                                    TEST_TEMPLATE_NAME,
+                                                                    ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                    &topicLength ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                           FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                    ( uint16_t ) ( sizeof( topicBuffer ) - 1U ),
+                                                                    FleetProvisioningJson,
+                                                                    FleetProvisioningAccepted,
+                                                                    TEST_TEMPLATE_NAME,
+                                                                    ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                    &topicLength ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_GetRegisterThingTopic( NULL,
+                                                                    ( uint16_t ) sizeof( topicBuffer ),
+                                                                    FleetProvisioningJson,
+                                                                    FleetProvisioningAccepted,
+                                                                    TEST_TEMPLATE_NAME,
+                                                                    ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                    &topicLength ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfGetRegisterThingTopic ][ FleetProvisioningSuccess ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfGetRegisterThingTopic ][ FleetProvisioningBufferTooSmall ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfGetRegisterThingTopic ][ FleetProvisioningBadParameter ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.calls[ FleetProvisioningPerfGetRegisterThingTopic ][ FleetProvisioningNoMatch ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningSuccess ] );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the topics matched by #FleetProvisioning_MatchTopic are
+ * counted, and that invalid parameters count no topic.
+ */
+void test_FleetProvisioning_Perf_CountsTopics( void )
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_MatchTopic( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ),
+                                                         ( uint16_t ) LITERAL_LENGTH( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ) ),
+                                                         &topic ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_MatchTopic( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ),
+                                                         ( uint16_t ) LITERAL_LENGTH( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ) ),
+                                                         &topic ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                           FleetProvisioning_MatchTopic( "some/other/topic",
+                                                         ( uint16_t ) LITERAL_LENGTH( "some/other/topic" ),
+                                                         &topic ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_MatchTopic( NULL, 0U, &topic ) );
+
+        TEST_ASSERT_EQUAL_UINT32( 2U, counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningSuccess ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningNoMatch ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningBadParameter ] );
+        TEST_ASSERT_EQUAL_UINT32( 2U, counters.topics[ FleetProvJsonRegisterThingAccepted ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.topics[ FleetProvisioningInvalidTopic ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.topics[ FleetProvCborRegisterThingAccepted ] );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that calls are counted in the histogram bucket of the log2 of
+ * their cycle count.
+ */
+void test_FleetProvisioning_Perf_Histogram( void )
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        /* The test configuration reads 0 cycles, so a call started 100 cycles
+         * before 0 took 100 cycles, from 2^6 to 2^7 - 1. */
+        FleetProvisioning_PerfRecord( FleetProvisioningPerfDedupCheck, FleetProvisioningSuccess, 0U - 100U );
+        FleetProvisioning_PerfRecord( FleetProvisioningPerfDedupCheck, FleetProvisioningSuccess, 0U - 1U );
+        FleetProvisioning_PerfRecord( FleetProvisioningPerfDedupCheck, FleetProvisioningNoMatch, 0U );
+
+        TEST_ASSERT_EQUAL_UINT32( 2U, counters.calls[ FleetProvisioningPerfDedupCheck ][ FleetProvisioningSuccess ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.calls[ FleetProvisioningPerfDedupCheck ][ FleetProvisioningNoMatch ] );
+        TEST_ASSERT_EQUAL_UINT32( 2U, counters.cycles[ FleetProvisioningPerfDedupCheck ][ 0 ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.cycles[ FleetProvisioningPerfDedupCheck ][ 5 ] );
+        TEST_ASSERT_EQUAL_UINT32( 1U, counters.cycles[ FleetProvisioningPerfDedupCheck ][ 6 ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.cycles[ FleetProvisioningPerfDedupCheck ][ 7 ] );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that nothing is counted once the counters are set to NULL.
+ */
+void test_FleetProvisioning_Perf_NoCounters( void )
+{
+    #if ( FP_ENABLE_PERF_COUNTERS != 0 )
+        FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+        FleetProvisioning_PerfSetCounters( NULL );
+
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_MatchTopic( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ),
+                                                         ( uint16_t ) LITERAL_LENGTH( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ) ),
+                                                         &topic ) );
+        FleetProvisioning_PerfRecord( FleetProvisioningPerfDedupCheck, FleetProvisioningSuccess, 0U );
+
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.calls[ FleetProvisioningPerfMatchTopic ][ FleetProvisioningSuccess ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.topics[ FleetProvJsonRegisterThingAccepted ] );
+        TEST_ASSERT_EQUAL_UINT32( 0U, counters.calls[ FleetProvisioningPerfDedupCheck ][ FleetProvisioningSuccess ] );
+    #endif
+}
+/*-----------------------------------------------------------*/
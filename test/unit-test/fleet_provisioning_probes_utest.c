@@ -0,0 +1,269 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_probes_utest.c
+ * @brief Unit tests for the static probes of the Fleet Provisioning topic
+ * functions.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning API include. */
+#include "fleet_provisioning.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of a string literal.
+ */
+#define LITERAL_LENGTH( literal )    ( sizeof( literal ) - 1U )
+
+/**
+ * @brief Template name used in tests.
+ */
+#define TEST_TEMPLATE_NAME    "probes"
+
+/**
+ * @brief Most probes recorded by a test.
+ */
+#define MAX_PROBES            ( 8U )
+
+/**
+ * @brief A probe fired by the library.
+ */
+typedef struct Probe
+{
+    const char * pName; /**< @brief Name of the probe. */
+    uint64_t arg0;      /**< @brief First argument. */
+    uint64_t arg1;      /**< @brief Second argument. */
+} Probe_t;
+
+/**
+ * @brief Probes fired since the test started.
+ */
+static Probe_t probes[ MAX_PROBES ];
+
+/**
+ * @brief Number of probes fired since the test started.
+ */
+static size_t probeCount;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record a probe; called by the library.
+ */
+void FleetProvisioningTest_TraceProbe( const char * pName,
+                                       uint64_t arg0,
+                                       uint64_t arg1 )
+{
+    TEST_ASSERT_TRUE( probeCount < MAX_PROBES );
+
+    probes[ probeCount ].pName = pName;
+    probes[ probeCount ].arg0 = arg0;
+    probes[ probeCount ].arg1 = arg1;
+    probeCount++;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check a recorded probe.
+ *
+ * @param[in] index Index of the probe.
+ * @param[in] pName Expected name.
+ * @param[in] arg0 Expected first argument.
+ * @param[in] arg1 Expected second argument.
+ */
+static void expectProbe( size_t index,
+                         const char * pName,
+                         uint64_t arg0,
+                         uint64_t arg1 )
+{
+    TEST_ASSERT_TRUE( index < probeCount );
+    TEST_ASSERT_EQUAL_STRING( pName, probes[ index ].pName );
+    TEST_ASSERT_TRUE( probes[ index ].arg0 == arg0 );
+    TEST_ASSERT_TRUE( probes[ index ].arg1 == arg1 );
+}
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( probes, 0, sizeof( probes ) );
+    probeCount = 0U;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_Probes_MatchTopic( void );
+void test_FleetProvisioning_Probes_MatchTopicNoMatch( void );
+void test_FleetProvisioning_Probes_MatchTopicBadParams( void );
+void test_FleetProvisioning_Probes_GetRegisterThingTopic( void );
+void test_FleetProvisioning_Probes_GetRegisterThingTopicBadParams( void );
+void test_FleetProvisioning_Probes_GetRegisterThingTopicBufferTooSmall( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of a topic that matches.
+ */
+void test_FleetProvisioning_Probes_MatchTopic( void )
+{
+    const char * pTopic = FP_CBOR_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME );
+    uint16_t topicLength = ( uint16_t ) LITERAL_LENGTH( FP_CBOR_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ) );
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_MatchTopic( pTopic, topicLength, &topic ) );
+
+    TEST_ASSERT_EQUAL( 3U, probeCount );
+    expectProbe( 0U, "match_topic_entry", ( uint64_t ) ( uintptr_t ) pTopic, topicLength );
+    expectProbe( 1U, "match_topic_matched", FleetProvCborRegisterThingAccepted, topicLength );
+    expectProbe( 2U, "match_topic_return", FleetProvisioningSuccess, topicLength );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of a topic that does not match.
+ */
+void test_FleetProvisioning_Probes_MatchTopicNoMatch( void )
+{
+    const char * pTopic = "$aws/things/thing/shadow/update";
+    FleetProvisioningTopic_t topic = FleetProvisioningInvalidTopic;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_MatchTopic( pTopic, 5U, &topic ) );
+
+    TEST_ASSERT_EQUAL( 3U, probeCount );
+    expectProbe( 0U, "match_topic_entry", ( uint64_t ) ( uintptr_t ) pTopic, 5U );
+    expectProbe( 1U, "match_topic_no_match", ( uint64_t ) ( uintptr_t ) pTopic, 5U );
+    expectProbe( 2U, "match_topic_return", FleetProvisioningNoMatch, 5U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of #FleetProvisioning_MatchTopic with invalid
+ * parameters.
+ */
+void test_FleetProvisioning_Probes_MatchTopicBadParams( void )
+{
+    const char * pTopic = FP_JSON_CREATE_KEYS_PUBLISH_TOPIC;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_MatchTopic( pTopic, 1U, NULL ) );
+
+    TEST_ASSERT_EQUAL( 3U, probeCount );
+    expectProbe( 0U, "match_topic_entry", ( uint64_t ) ( uintptr_t ) pTopic, 1U );
+    expectProbe( 1U, "match_topic_bad_parameter", ( uint64_t ) ( uintptr_t ) pTopic, 0U );
+    expectProbe( 2U, "match_topic_return", FleetProvisioningBadParameter, 1U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of a topic that is built.
+ */
+void test_FleetProvisioning_Probes_GetRegisterThingTopic( void )
+{
+    char topicBuffer[ LITERAL_LENGTH( FP_JSON_REGISTER_REJECTED_TOPIC( TEST_TEMPLATE_NAME ) ) ];
+    uint16_t topicLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                ( uint16_t ) sizeof( topicBuffer ),
+                                                                FleetProvisioningJson,
+                                                                FleetProvisioningRejected,
+                                                                TEST_TEMPLATE_NAME,
+                                                                ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                &topicLength ) );
+
+    TEST_ASSERT_EQUAL( 2U, probeCount );
+    expectProbe( 0U, "get_register_thing_topic_entry", FleetProvisioningJson, FleetProvisioningRejected );
+    expectProbe( 1U, "get_register_thing_topic_return", FleetProvisioningSuccess, sizeof( topicBuffer ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of #FleetProvisioning_GetRegisterThingTopic with
+ * invalid parameters.
+ */
+void test_FleetProvisioning_Probes_GetRegisterThingTopicBadParams( void )
+{
+    uint16_t topicLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetRegisterThingTopic( NULL,
+                                                                1U,
+                                                                FleetProvisioningCbor,
+                                                                FleetProvisioningPublish,
+                                                                TEST_TEMPLATE_NAME,
+                                                                ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                &topicLength ) );
+
+    TEST_ASSERT_EQUAL( 3U, probeCount );
+    expectProbe( 0U, "get_register_thing_topic_entry", FleetProvisioningCbor, FleetProvisioningPublish );
+    expectProbe( 1U, "get_register_thing_topic_bad_parameter", 0U, ( uint64_t ) ( uintptr_t ) TEST_TEMPLATE_NAME );
+    expectProbe( 2U, "get_register_thing_topic_return", FleetProvisioningBadParameter, 0U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the probes of a topic that does not fit in the buffer.
+ */
+void test_FleetProvisioning_Probes_GetRegisterThingTopicBufferTooSmall( void )
+{
+    char topicBuffer[ LITERAL_LENGTH( FP_CBOR_REGISTER_PUBLISH_TOPIC( TEST_TEMPLATE_NAME ) ) ];
+    uint16_t topicLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_GetRegisterThingTopic( topicBuffer,
+                                                                ( uint16_t ) ( sizeof( topicBuffer ) - 1U ),
+                                                                FleetProvisioningCbor,
+                                                                FleetProvisioningPublish,
+                                                                TEST_TEMPLATE_NAME,
+                                                                ( uint16_t ) LITERAL_LENGTH( TEST_TEMPLATE_NAME ),
+                                                                &topicLength ) );
+
+    TEST_ASSERT_EQUAL( 3U, probeCount );
+    expectProbe( 0U, "get_register_thing_topic_entry", FleetProvisioningCbor, FleetProvisioningPublish );
+    expectProbe( 1U, "get_register_thing_topic_buffer_too_small", sizeof( topicBuffer ) - 1U, sizeof( topicBuffer ) );
+    expectProbe( 2U, "get_register_thing_topic_return", FleetProvisioningBufferTooSmall, sizeof( topicBuffer ) );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,225 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_rate_limiter_utest.c
+ * @brief Unit tests for the Fleet Provisioning rate limiter.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning rate limiter include. */
+#include "fleet_provisioning_rate_limiter.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Rate limiter used in tests.
+ */
+static FleetProvisioningRateLimiter_t limiter;
+
+/**
+ * @brief Limits used in tests: 3 CreateCertificateFromCsr requests every 10
+ * ticks in bursts of 5, no limit for CreateKeysAndCertificate, and 1
+ * RegisterThing request every 4 ticks without bursts.
+ */
+static FleetProvisioningRateLimit_t limits[ FP_API_COUNT ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &limiter, 0, sizeof( limiter ) );
+    limits[ FleetProvisioningCreateCertFromCsrApi ].requestsPerPeriod = 3U;
+    limits[ FleetProvisioningCreateCertFromCsrApi ].periodTicks = 10U;
+    limits[ FleetProvisioningCreateCertFromCsrApi ].burst = 5U;
+    limits[ FleetProvisioningCreateKeysAndCertApi ].requestsPerPeriod = 0U;
+    limits[ FleetProvisioningCreateKeysAndCertApi ].periodTicks = 0U;
+    limits[ FleetProvisioningCreateKeysAndCertApi ].burst = 0U;
+    limits[ FleetProvisioningRegisterThingApi ].requestsPerPeriod = 1U;
+    limits[ FleetProvisioningRegisterThingApi ].periodTicks = 4U;
+    limits[ FleetProvisioningRegisterThingApi ].burst = 1U;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_RateLimiterInit_BadParams( void );
+void test_FleetProvisioning_RateLimiter_Burst( void );
+void test_FleetProvisioning_RateLimiter_SustainedRate( void );
+void test_FleetProvisioning_RateLimiter_Ticks( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to count the requests allowed at a tick.
+ *
+ * @param[in] request The publish topic of the requests.
+ * @param[in] now The tick.
+ *
+ * @return The number of requests allowed before one must wait.
+ */
+static uint32_t drain( FleetProvisioningTopic_t request,
+                       uint32_t now )
+{
+    uint32_t count = 0U;
+
+    while( FleetProvisioning_RateLimiterTryAcquire( &limiter, request, now, NULL ) == FleetProvisioningSuccess )
+    {
+        count++;
+    }
+
+    return count;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_RateLimiterInit and
+ * #FleetProvisioning_RateLimiterTryAcquire reject invalid parameters.
+ */
+void test_FleetProvisioning_RateLimiterInit_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_RateLimiterInit( NULL, limits, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_RateLimiterInit( &limiter, NULL, 0U ) );
+
+    limits[ FleetProvisioningRegisterThingApi ].periodTicks = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    limits[ FleetProvisioningRegisterThingApi ].periodTicks = 4U;
+    limits[ FleetProvisioningRegisterThingApi ].burst = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+
+    /* The credits of a full bucket must fit 32 bits. */
+    limits[ FleetProvisioningRegisterThingApi ].burst = ( UINT32_MAX / 4U ) + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    limits[ FleetProvisioningRegisterThingApi ].burst = UINT32_MAX / 4U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_RateLimiterTryAcquire( NULL, FleetProvJsonRegisterThingPublish, 0U, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvisioningInvalidTopic, 0U, NULL ) );
+}
+
+/**
+ * @brief Test that a full bucket allows a burst, and that a quiet period
+ * refills it up to the burst only.
+ */
+void test_FleetProvisioning_RateLimiter_Burst( void )
+{
+    uint32_t waitTicks = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 100U ) );
+
+    TEST_ASSERT_EQUAL( 5U, drain( FleetProvJsonCreateCertFromCsrPublish, 100U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvCborCreateCertFromCsrPublish, 100U, &waitTicks ) );
+    TEST_ASSERT_EQUAL( 4U, waitTicks );
+
+    /* A long quiet period only refills the burst. */
+    TEST_ASSERT_EQUAL( 5U, drain( FleetProvJsonCreateCertFromCsrPublish, 100000U ) );
+
+    /* The APIs have separate buckets, and unlimited APIs are always
+     * allowed. */
+    TEST_ASSERT_EQUAL( 1U, drain( FleetProvJsonRegisterThingPublish, 100000U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvJsonRegisterThingPublish, 100000U, &waitTicks ) );
+    TEST_ASSERT_EQUAL( 4U, waitTicks );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvJsonCreateKeysAndCertPublish, 100000U, &waitTicks ) );
+}
+
+/**
+ * @brief Test that a drained bucket allows the configured rate, including
+ * rates that are not a whole number of requests per tick.
+ */
+void test_FleetProvisioning_RateLimiter_SustainedRate( void )
+{
+    uint32_t tick;
+    uint32_t count = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    TEST_ASSERT_EQUAL( 5U, drain( FleetProvJsonCreateCertFromCsrPublish, 0U ) );
+
+    for( tick = 1U; tick <= 1000U; tick++ )
+    {
+        count += drain( FleetProvJsonCreateCertFromCsrPublish, tick );
+    }
+
+    TEST_ASSERT_EQUAL( 300U, count );
+
+    /* Very high rates are capped at the burst without wrapping. */
+    limits[ FleetProvisioningRegisterThingApi ].requestsPerPeriod = UINT32_MAX;
+    limits[ FleetProvisioningRegisterThingApi ].periodTicks = 1U;
+    limits[ FleetProvisioningRegisterThingApi ].burst = 3U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    TEST_ASSERT_EQUAL( 3U, drain( FleetProvJsonRegisterThingPublish, 0U ) );
+    TEST_ASSERT_EQUAL( 3U, drain( FleetProvJsonRegisterThingPublish, 1U ) );
+    TEST_ASSERT_EQUAL( 3U, drain( FleetProvJsonRegisterThingPublish, 0x7FFFFFFFU ) );
+}
+
+/**
+ * @brief Test that ticks wrap around, and that a bucket idle while the tick
+ * counter wrapped is full.
+ */
+void test_FleetProvisioning_RateLimiter_Ticks( void )
+{
+    uint32_t waitTicks = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0xFFFFFFFEU ) );
+    TEST_ASSERT_EQUAL( 1U, drain( FleetProvJsonRegisterThingPublish, 0xFFFFFFFEU ) );
+    TEST_ASSERT_EQUAL( 0U, drain( FleetProvJsonRegisterThingPublish, 1U ) );
+    TEST_ASSERT_EQUAL( 1U, drain( FleetProvJsonRegisterThingPublish, 2U ) );
+
+    /* Waiting for a token counts whole ticks. */
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvJsonRegisterThingPublish, 3U, &waitTicks ) );
+    TEST_ASSERT_EQUAL( 3U, waitTicks );
+
+    /* Idle for 2^31 + 5 ticks, the difference wraps to a tick behind the
+     * last one, but the bucket is full. */
+    TEST_ASSERT_EQUAL( 5U, drain( FleetProvJsonCreateCertFromCsrPublish, 3U ) );
+    TEST_ASSERT_EQUAL( 5U, drain( FleetProvJsonCreateCertFromCsrPublish, 0x80000008U ) );
+    TEST_ASSERT_EQUAL( 0U, drain( FleetProvJsonCreateCertFromCsrPublish, 0x80000008U ) );
+}
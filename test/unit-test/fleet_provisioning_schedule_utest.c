@@ -0,0 +1,234 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file fleet_provisioning_schedule_utest.c
+ * @brief Unit tests for the Fleet Provisioning request scheduling helpers.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning schedule include. */
+#include "fleet_provisioning_schedule.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of device IDs used to check the spread.
+ */
+#define TEST_DEVICE_COUNT    ( 10000U )
+
+/**
+ * @brief Number of buckets used to check the spread.
+ */
+#define TEST_BUCKET_COUNT    ( 10U )
+
+/**
+ * @brief Validity period of the certificates used in tests: one year from
+ * 2024-01-01, in seconds since the Unix epoch.
+ */
+#define TEST_NOT_BEFORE      ( 1704067200U )
+#define TEST_NOT_AFTER       ( TEST_NOT_BEFORE + 31536000U )
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_GetStartDelay_BadParams( void );
+void test_FleetProvisioning_GetStartDelay_Spread( void );
+void test_FleetProvisioning_GetRotationTime_BadParams( void );
+void test_FleetProvisioning_GetRotationTime_Spread( void );
+void test_FleetProvisioning_GetRotationTime_ShortLifetime( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the serial number of a test device.
+ *
+ * @param[out] pBuffer Buffer of at least 16 characters.
+ * @param[in] index The index of the device.
+ *
+ * @return The length of the serial number.
+ */
+static size_t writeSerial( char * pBuffer,
+                           uint32_t index )
+{
+    ( void ) sprintf( pBuffer, "SN-%08u", ( unsigned int ) index );
+
+    return strlen( pBuffer );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_GetStartDelay rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_GetStartDelay_BadParams( void )
+{
+    uint32_t delay;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetStartDelay( NULL, 4U, 100U, &delay ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetStartDelay( "abcd", 0U, 100U, &delay ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetStartDelay( "abcd", 4U, 100U, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that start delays are stable for a device, below the window,
+ * and spread evenly over it.
+ */
+void test_FleetProvisioning_GetStartDelay_Spread( void )
+{
+    uint32_t buckets[ TEST_BUCKET_COUNT ] = { 0U };
+    char serial[ 16 ];
+    size_t serialLength;
+    uint32_t delay;
+    uint32_t again;
+    uint32_t i;
+
+    for( i = 0U; i < TEST_DEVICE_COUNT; i++ )
+    {
+        serialLength = writeSerial( serial, i );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetStartDelay( serial, serialLength, 600000U, &delay ) );
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32( 599999U, delay );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetStartDelay( serial, serialLength, 600000U, &again ) );
+        TEST_ASSERT_EQUAL_UINT32( delay, again );
+        buckets[ delay / 60000U ]++;
+    }
+
+    /* Each tenth of the window gets its share of 1000 starts within 10%. */
+    for( i = 0U; i < TEST_BUCKET_COUNT; i++ )
+    {
+        TEST_ASSERT_UINT32_WITHIN( 100U, TEST_DEVICE_COUNT / TEST_BUCKET_COUNT, buckets[ i ] );
+    }
+
+    /* An empty window gives no delay. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetStartDelay( serial, serialLength, 0U, &delay ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, delay );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_GetRotationTime rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_GetRotationTime_BadParams( void )
+{
+    uint32_t rotation;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetRotationTime( NULL, 4U, TEST_NOT_BEFORE, TEST_NOT_AFTER, &rotation ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetRotationTime( "abcd", 0U, TEST_NOT_BEFORE, TEST_NOT_AFTER, &rotation ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetRotationTime( "abcd", 4U, TEST_NOT_AFTER, TEST_NOT_AFTER, &rotation ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetRotationTime( "abcd", 4U, TEST_NOT_BEFORE, TEST_NOT_AFTER, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the rotations of certificates issued together fall in
+ * the rotation window and are spread evenly over it.
+ */
+void test_FleetProvisioning_GetRotationTime_Spread( void )
+{
+    uint32_t buckets[ TEST_BUCKET_COUNT ] = { 0U };
+    uint32_t lifetime = TEST_NOT_AFTER - TEST_NOT_BEFORE;
+    uint32_t windowStart = TEST_NOT_BEFORE + ( ( lifetime / 100U ) * FP_ROTATION_WINDOW_START_PERCENT );
+    uint32_t windowEnd = TEST_NOT_BEFORE + ( ( lifetime / 100U ) * FP_ROTATION_WINDOW_END_PERCENT );
+    uint32_t bucketLength = ( windowEnd - windowStart ) / TEST_BUCKET_COUNT;
+    char serial[ 16 ];
+    size_t serialLength;
+    uint32_t rotation;
+    uint32_t i;
+
+    for( i = 0U; i < TEST_DEVICE_COUNT; i++ )
+    {
+        serialLength = writeSerial( serial, i );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetRotationTime( serial, serialLength, TEST_NOT_BEFORE,
+                                                              TEST_NOT_AFTER, &rotation ) );
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32( windowStart, rotation );
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32( windowEnd - 1U, rotation );
+        buckets[ ( rotation - windowStart ) / bucketLength ]++;
+    }
+
+    for( i = 0U; i < TEST_BUCKET_COUNT; i++ )
+    {
+        TEST_ASSERT_UINT32_WITHIN( 100U, TEST_DEVICE_COUNT / TEST_BUCKET_COUNT, buckets[ i ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a certificate too short-lived to spread its rotations
+ * rotates at the start of its window.
+ */
+void test_FleetProvisioning_GetRotationTime_ShortLifetime( void )
+{
+    uint32_t rotation;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetRotationTime( "abcd", 4U, 1000U, 1001U, &rotation ) );
+    TEST_ASSERT_EQUAL_UINT32( 1000U, rotation );
+
+    /* Validity periods may end at the end of the epoch. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetRotationTime( "abcd", 4U, 0U, UINT32_MAX, &rotation ) );
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32( ( UINT32_MAX / 100U ) * FP_ROTATION_WINDOW_START_PERCENT, rotation );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,676 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_serializer_utest.c
+ * @brief Unit tests for the Fleet Provisioning request serializer.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning serializer include. */
+#include "fleet_provisioning_serializer.h"
+
+/* Fleet Provisioning PEM include. */
+#include "fleet_provisioning_pem.h"
+
+/* Base64 line of the first 48 bytes of the test CSR. */
+#define TEST_BASE64_LINE       "AwoRGB8mLTQ7QklQV15lbHN6gYiPlp2kq7K5wMfO1dzj6vH4/wYNFBsiKTA3PkVM"
+
+/* JSON request for the first 48 bytes of the test CSR. */
+#define TEST_JSON_REQUEST                                 \
+    "{\"certificateSigningRequest\":\""                   \
+    "-----BEGIN CERTIFICATE REQUEST-----\\n"              \
+    TEST_BASE64_LINE "\\n"                                \
+    "-----END CERTIFICATE REQUEST-----\\n\"}"
+
+/* Test ownership tokens. */
+#define TEST_TOKEN             "tokenA+/="
+#define TEST_SHORT_TOKEN       "tok"
+
+/* RegisterThing parameters used in template tests, with two slots. */
+#define TEST_PARAMETERS                      \
+    {                                        \
+        { "Location", 8U, "Line3", 5U },     \
+        { "SerialNumber", 12U, NULL, 6U },   \
+        { "Mac", 3U, NULL, 4U }              \
+    }
+
+/* Length of #FP_API_CSR_KEY. */
+#define TEST_CSR_KEY_LENGTH    ( sizeof( FP_API_CSR_KEY ) - 1U )
+
+/* Length of the test CSR, large enough to need a four byte CBOR length. */
+#define TEST_CSR_LENGTH        50000U
+
+/* Length of the buffer used in tests. */
+#define TEST_BUFFER_LENGTH     70000U
+
+/* Length past the 32-bit string lengths of the payloads, if size_t is wider. */
+#if ( SIZE_MAX > UINT32_MAX )
+    #define TEST_OVERLONG_LENGTH    ( ( size_t ) UINT32_MAX + 1U )
+#endif
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief DER certificate signing request used in tests.
+ */
+static uint8_t testCsr[ TEST_CSR_LENGTH ];
+
+/**
+ * @brief Buffer holding the serialized payload in tests.
+ */
+static char payloadBuffer[ TEST_BUFFER_LENGTH ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    size_t i;
+
+    memset( payloadBuffer, 0xA5, sizeof( payloadBuffer ) );
+
+    for( i = 0U; i < TEST_CSR_LENGTH; i++ )
+    {
+        testCsr[ i ] = ( uint8_t ) ( ( i * 7U ) + 3U );
+    }
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_BadParams( void );
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_Json( void );
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_Cbor( void );
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_BufferTooSmall( void );
+void test_FleetProvisioning_InitRegisterThingTemplate_BadParams( void );
+void test_FleetProvisioning_InitRegisterThingTemplate_BufferTooSmall( void );
+void test_FleetProvisioning_RegisterThingTemplate_Json( void );
+void test_FleetProvisioning_RegisterThingTemplate_Cbor( void );
+void test_FleetProvisioning_RegisterThingTemplate_NoParameters( void );
+void test_FleetProvisioning_SetTemplateSlot_BadParams( void );
+void test_FleetProvisioning_CompleteRegisterThingTemplate_BadParams( void );
+void test_FleetProvisioning_GatherRegisterThingTemplate_Json( void );
+void test_FleetProvisioning_GatherRegisterThingTemplate_Cbor( void );
+void test_FleetProvisioning_GatherRegisterThingTemplate_BadParams( void );
+void test_FleetProvisioning_RequestMaxLength( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to check a CBOR request for a CSR of the given length.
+ *
+ * @param[in] csrLength The length of the test CSR to serialize.
+ * @param[in] pExpectedHeader The expected CBOR header of the PEM value.
+ * @param[in] headerLength The length of @p pExpectedHeader.
+ */
+static void checkCborRequest( size_t csrLength,
+                              const char * pExpectedHeader,
+                              size_t headerLength )
+{
+    size_t payloadLength = 0U;
+    size_t pemLength = FleetProvisioning_GetPemLength( csrLength,
+                                                       FP_CSR_PEM_LABEL_LENGTH,
+                                                       FleetProvisioningCbor );
+    size_t valueStart = 3U + TEST_CSR_KEY_LENGTH + headerLength;
+    size_t derLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr,
+                                                                            csrLength,
+                                                                            FleetProvisioningCbor,
+                                                                            payloadBuffer,
+                                                                            TEST_BUFFER_LENGTH,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( valueStart + pemLength, payloadLength );
+
+    /* Map of one pair, with a 25 byte text string key. */
+    TEST_ASSERT_EQUAL_MEMORY( "\xA1\x78\x19", payloadBuffer, 3U );
+    TEST_ASSERT_EQUAL_MEMORY( FP_API_CSR_KEY, &( payloadBuffer[ 3 ] ), TEST_CSR_KEY_LENGTH );
+    TEST_ASSERT_EQUAL_MEMORY( pExpectedHeader, &( payloadBuffer[ 3U + TEST_CSR_KEY_LENGTH ] ), headerLength );
+
+    /* The value decodes back to the CSR. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_PemToDer( &( payloadBuffer[ valueStart ] ), pemLength, &derLength ) );
+    TEST_ASSERT_EQUAL( csrLength, derLength );
+    TEST_ASSERT_EQUAL_MEMORY( testCsr, &( payloadBuffer[ valueStart ] ), csrLength );
+    TEST_ASSERT_EACH_EQUAL_HEX8( 0xA5, &( payloadBuffer[ payloadLength ] ), TEST_BUFFER_LENGTH - payloadLength );
+}
+/**
+ * @brief Helper to check that the segments of a gathered payload match a
+ * payload built with #FleetProvisioning_CompleteRegisterThingTemplate.
+ *
+ * @param[in] pGather The gathered payload.
+ * @param[in] pExpected The expected payload.
+ * @param[in] expectedLength The length of @p pExpected.
+ */
+static void checkGather( const FleetProvisioningPayloadGather_t * pGather,
+                         const char * pExpected,
+                         size_t expectedLength )
+{
+    size_t offset = 0U;
+    size_t i;
+
+    TEST_ASSERT_EQUAL( expectedLength, pGather->payloadLength );
+
+    for( i = 0U; i < pGather->segmentCount; i++ )
+    {
+        TEST_ASSERT_LESS_OR_EQUAL( expectedLength, offset + pGather->segments[ i ].length );
+        TEST_ASSERT_EQUAL_MEMORY( &( pExpected[ offset ] ), pGather->segments[ i ].pData, pGather->segments[ i ].length );
+        offset += pGather->segments[ i ].length;
+    }
+
+    TEST_ASSERT_EQUAL( expectedLength, offset );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_BadParams( void )
+{
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( NULL, 48U, FleetProvisioningJson,
+                                                                            payloadBuffer, TEST_BUFFER_LENGTH,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 0U, FleetProvisioningJson,
+                                                                            payloadBuffer, TEST_BUFFER_LENGTH,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 48U, ( FleetProvisioningFormat_t ) 2,
+                                                                            payloadBuffer, TEST_BUFFER_LENGTH,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 48U, FleetProvisioningJson,
+                                                                            NULL, TEST_BUFFER_LENGTH,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 48U, FleetProvisioningJson,
+                                                                            payloadBuffer, TEST_BUFFER_LENGTH,
+                                                                            NULL ) );
+
+    #ifdef TEST_OVERLONG_LENGTH
+        /* The PEM string of the CSR would not fit a 32-bit length. */
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, TEST_OVERLONG_LENGTH,
+                                                                                FleetProvisioningJson,
+                                                                                payloadBuffer, TEST_BUFFER_LENGTH,
+                                                                                &payloadLength ) );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_Json( void )
+{
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 48U, FleetProvisioningJson,
+                                                                            payloadBuffer, sizeof( TEST_JSON_REQUEST ) - 1U,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( sizeof( TEST_JSON_REQUEST ) - 1U, payloadLength );
+    TEST_ASSERT_EQUAL_MEMORY( TEST_JSON_REQUEST, payloadBuffer, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_Cbor( void )
+{
+    /* PEM lengths of 75, 135, 477 and 67780 bytes. */
+    checkCborRequest( 1U, "\x78\x4B", 2U );
+    checkCborRequest( 48U, "\x78\x87", 2U );
+    checkCborRequest( 300U, "\x79\x01\xDD", 3U );
+    checkCborRequest( TEST_CSR_LENGTH, "\x7A\x00\x01\x08\xC4", 5U );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_SerializeCreateCertFromCsrRequest_BufferTooSmall( void )
+{
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, 48U, FleetProvisioningJson,
+                                                                            payloadBuffer, sizeof( TEST_JSON_REQUEST ) - 2U,
+                                                                            &payloadLength ) );
+    TEST_ASSERT_EQUAL( 0U, payloadLength );
+    TEST_ASSERT_EACH_EQUAL_HEX8( 0xA5, payloadBuffer, TEST_BUFFER_LENGTH );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_InitRegisterThingTemplate_BadParams( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    FleetProvisioningTemplateParameter_t badParameters[] =
+    {
+        { NULL, 3U, "abc", 3U },
+        { "", 0U, "abc", 3U },
+        { "abc", 3U, NULL, 0U },
+        { "a\"c", 3U, "abc", 3U },
+        { "abc", 3U, "a\\c", 3U },
+        { "abc", 3U, "a\nc", 3U }
+    };
+    size_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_InitRegisterThingTemplate( NULL, FleetProvisioningJson, parameters, 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson, NULL, 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson, parameters, 3U,
+                                                                    NULL, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, ( FleetProvisioningFormat_t ) 2,
+                                                                    parameters, 3U, payloadBuffer, TEST_BUFFER_LENGTH ) );
+
+    for( i = 0U; i < ( sizeof( badParameters ) / sizeof( badParameters[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                        &( badParameters[ i ] ), 1U,
+                                                                        payloadBuffer, TEST_BUFFER_LENGTH ) );
+    }
+
+    #ifdef TEST_OVERLONG_LENGTH
+        /* Keys and values must fit a 32-bit length. */
+        badParameters[ 0 ].pKey = "abc";
+        badParameters[ 0 ].keyLength = TEST_OVERLONG_LENGTH;
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                        &( badParameters[ 0 ] ), 1U,
+                                                                        payloadBuffer, TEST_BUFFER_LENGTH ) );
+        badParameters[ 0 ].keyLength = 3U;
+        badParameters[ 0 ].valueLength = TEST_OVERLONG_LENGTH;
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                        &( badParameters[ 0 ] ), 1U,
+                                                                        payloadBuffer, TEST_BUFFER_LENGTH ) );
+
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                        parameters, 3U,
+                                                                        payloadBuffer, TEST_OVERLONG_LENGTH ) );
+    #endif
+
+    /* Characters that need escaping in JSON are valid in CBOR. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    &( badParameters[ 3 ] ), 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_InitRegisterThingTemplate_BufferTooSmall( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    FleetProvisioningTemplateParameter_t slots[ FP_TEMPLATE_MAX_SLOTS + 1U ];
+    size_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                    parameters, 3U, payloadBuffer, 50U ) );
+    TEST_ASSERT_EACH_EQUAL_HEX8( 0xA5, &( payloadBuffer[ 50 ] ), TEST_BUFFER_LENGTH - 50U );
+
+    for( i = 0U; i < ( FP_TEMPLATE_MAX_SLOTS + 1U ); i++ )
+    {
+        slots[ i ].pKey = "Slot";
+        slots[ i ].keyLength = 4U;
+        slots[ i ].pValue = NULL;
+        slots[ i ].valueLength = 1U;
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    slots, FP_TEMPLATE_MAX_SLOTS,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FP_TEMPLATE_MAX_SLOTS, registerTemplate.slotCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    slots, FP_TEMPLATE_MAX_SLOTS + 1U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_RegisterThingTemplate_Json( void )
+{
+    static const char expectedPrefix[] =
+        "{\"parameters\":{\"Location\":\"Line3\",\"SerialNumber\":\"";
+    static const char expected[] =
+        "{\"parameters\":{\"Location\":\"Line3\",\"SerialNumber\":\"SN0001\",\"Mac\":\"0a1b\"},"
+        "\"certificateOwnershipToken\":\"" TEST_TOKEN "\"}";
+    static const char expectedNext[] =
+        "{\"parameters\":{\"Location\":\"Line3\",\"SerialNumber\":\"SN0002\",\"Mac\":\"0a1b\"},"
+        "\"certificateOwnershipToken\":\"" TEST_SHORT_TOKEN "\"}";
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                    parameters, 3U,
+                                                                    payloadBuffer, sizeof( expected ) - 1U ) );
+    TEST_ASSERT_EQUAL( 2U, registerTemplate.slotCount );
+    TEST_ASSERT_EQUAL( sizeof( expectedPrefix ) - 1U, registerTemplate.slots[ 0 ].offset );
+    TEST_ASSERT_EQUAL( 6U, registerTemplate.slots[ 0 ].length );
+
+    /* Each device only sets its slots and token. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN0001", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 1U, "0a1b", 4U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                        sizeof( TEST_TOKEN ) - 1U,
+                                                                        &payloadLength ) );
+    TEST_ASSERT_EQUAL( sizeof( expected ) - 1U, payloadLength );
+    TEST_ASSERT_EQUAL_MEMORY( expected, payloadBuffer, payloadLength );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN0002", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_SHORT_TOKEN,
+                                                                        sizeof( TEST_SHORT_TOKEN ) - 1U,
+                                                                        &payloadLength ) );
+    TEST_ASSERT_EQUAL( sizeof( expectedNext ) - 1U, payloadLength );
+    TEST_ASSERT_EQUAL_MEMORY( expectedNext, payloadBuffer, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_RegisterThingTemplate_Cbor( void )
+{
+    static const char expected[] =
+        "\xA2"
+        "\x6A" "parameters" "\xA3"
+        "\x68" "Location" "\x65" "Line3"
+        "\x6C" "SerialNumber" "\x66" "SN0001"
+        "\x63" "Mac" "\x64" "\"a\\b"
+        "\x78\x19" "certificateOwnershipToken" "\x69" TEST_TOKEN;
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    parameters, 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN0001", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 1U, "\"a\\b", 4U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                        sizeof( TEST_TOKEN ) - 1U,
+                                                                        &payloadLength ) );
+    TEST_ASSERT_EQUAL( sizeof( expected ) - 1U, payloadLength );
+    TEST_ASSERT_EQUAL_MEMORY( expected, payloadBuffer, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_RegisterThingTemplate_NoParameters( void )
+{
+    static const char expected[] =
+        "{\"parameters\":{},\"certificateOwnershipToken\":\"" TEST_TOKEN "\"}";
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                    NULL, 0U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( 0U, registerTemplate.slotCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                        sizeof( TEST_TOKEN ) - 1U,
+                                                                        &payloadLength ) );
+    TEST_ASSERT_EQUAL( sizeof( expected ) - 1U, payloadLength );
+    TEST_ASSERT_EQUAL_MEMORY( expected, payloadBuffer, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_SetTemplateSlot_BadParams( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                    parameters, 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SetTemplateSlot( NULL, 0U, "SN0001", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, NULL, 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 2U, "SN0001", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN001", 5U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN\"001", 6U ) );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_CompleteRegisterThingTemplate_BadParams( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    size_t payloadLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    parameters, 3U, payloadBuffer, 100U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CompleteRegisterThingTemplate( NULL, TEST_TOKEN, 9U, &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, NULL, 9U, &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 0U, &payloadLength ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 9U, NULL ) );
+
+    #ifdef TEST_OVERLONG_LENGTH
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                            TEST_OVERLONG_LENGTH, &payloadLength ) );
+    #endif
+
+    /* The token does not fit in the rest of the buffer. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate, ( const char * ) testCsr,
+                                                                        100U - registerTemplate.prefixLength,
+                                                                        &payloadLength ) );
+    TEST_ASSERT_EQUAL( 0U, payloadLength );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GatherRegisterThingTemplate_Json( void )
+{
+    static const char response[] =
+        "{\"certificateId\":\"id\",\"certificateOwnershipToken\":\"" TEST_TOKEN "\"}";
+    static const char expected[] =
+        "{\"parameters\":{\"Location\":\"Line3\",\"SerialNumber\":\"SN0001\",\"Mac\":\"0a1b\"},"
+        "\"certificateOwnershipToken\":\"" TEST_TOKEN "\"}";
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[] = TEST_PARAMETERS;
+    FleetProvisioningPayloadGather_t gather;
+    FleetProvisioningSpan_t token;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningJson,
+                                                                    parameters, 3U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 0U, "SN0001", 6U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SetTemplateSlot( &registerTemplate, 1U, "0a1b", 4U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetResponseString( response, sizeof( response ) - 1U, FleetProvisioningJson,
+                                                            FP_API_OWNERSHIP_TOKEN_KEY, sizeof( FP_API_OWNERSHIP_TOKEN_KEY ) - 1U,
+                                                            &token ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, token.pData, token.length,
+                                                                      &gather ) );
+
+    /* The token is referenced in the response, not copied. */
+    TEST_ASSERT_EQUAL( 3U, gather.segmentCount );
+    TEST_ASSERT_EQUAL_PTR( payloadBuffer, gather.segments[ 0 ].pData );
+    TEST_ASSERT_EQUAL_PTR( token.pData, gather.segments[ 1 ].pData );
+    checkGather( &gather, expected, sizeof( expected ) - 1U );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GatherRegisterThingTemplate_Cbor( void )
+{
+    static const char expected[] =
+        "\xA2"
+        "\x6A" "parameters" "\xA0"
+        "\x78\x19" "certificateOwnershipToken" "\x69" TEST_TOKEN;
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningPayloadGather_t gather;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    NULL, 0U,
+                                                                    payloadBuffer, TEST_BUFFER_LENGTH ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                      sizeof( TEST_TOKEN ) - 1U, &gather ) );
+    TEST_ASSERT_EQUAL( 2U, gather.segmentCount );
+    checkGather( &gather, expected, sizeof( expected ) - 1U );
+}
+/*-----------------------------------------------------------*/
+
+void test_FleetProvisioning_GatherRegisterThingTemplate_BadParams( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningPayloadGather_t gather;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_InitRegisterThingTemplate( &registerTemplate, FleetProvisioningCbor,
+                                                                    NULL, 0U, payloadBuffer, 41U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GatherRegisterThingTemplate( NULL, TEST_TOKEN, 9U, &gather ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, NULL, 9U, &gather ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 0U, &gather ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 9U, NULL ) );
+
+    #ifdef TEST_OVERLONG_LENGTH
+        TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                           FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN,
+                                                                          TEST_OVERLONG_LENGTH, &gather ) );
+    #endif
+
+    /* Only the token header needs room in the template buffer. */
+    TEST_ASSERT_EQUAL( 40U, registerTemplate.prefixLength );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 9U, &gather ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_GatherRegisterThingTemplate( &registerTemplate, TEST_TOKEN, 24U, &gather ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the request length bounds hold the serialized requests.
+ */
+void test_FleetProvisioning_RequestMaxLength( void )
+{
+    FleetProvisioningRegisterThingTemplate_t registerTemplate;
+    FleetProvisioningTemplateParameter_t parameters[ 2 ];
+    FleetProvisioningFormat_t format;
+    size_t payloadLength = 0U;
+    size_t csrLength;
+    size_t tokenLength;
+
+    for( format = FleetProvisioningJson; format <= FleetProvisioningCbor; format++ )
+    {
+        for( csrLength = 1U; csrLength <= 2000U; csrLength++ )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr,
+                                                                                    csrLength,
+                                                                                    format,
+                                                                                    payloadBuffer,
+                                                                                    TEST_BUFFER_LENGTH,
+                                                                                    &payloadLength ) );
+            TEST_ASSERT_LESS_OR_EQUAL( FP_CSR_REQUEST_MAX_LENGTH( csrLength ), payloadLength );
+        }
+
+        parameters[ 0 ].pKey = "Location";
+        parameters[ 0 ].keyLength = 8U;
+        parameters[ 0 ].pValue = "Line3";
+        parameters[ 0 ].valueLength = 5U;
+        parameters[ 1 ].pKey = "Serial";
+        parameters[ 1 ].keyLength = 6U;
+        parameters[ 1 ].pValue = "0123456789012345678901234567890123456789";
+        parameters[ 1 ].valueLength = 40U;
+
+        /* Token lengths across the one, two and three byte CBOR headers. The
+         * token bytes are written as given, so the CSR bytes can stand in. */
+        for( tokenLength = 1U; tokenLength <= 1000U; tokenLength += 7U )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_InitRegisterThingTemplate( &registerTemplate,
+                                                                            format,
+                                                                            parameters,
+                                                                            2U,
+                                                                            payloadBuffer,
+                                                                            TEST_BUFFER_LENGTH ) );
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_CompleteRegisterThingTemplate( &registerTemplate,
+                                                                                ( const char * ) testCsr,
+                                                                                tokenLength,
+                                                                                &payloadLength ) );
+            TEST_ASSERT_LESS_OR_EQUAL( FP_REGISTER_REQUEST_MAX_LENGTH( 8U + 5U + 6U + 40U + ( 2U * 6U ), tokenLength ),
+                                       payloadLength );
+        }
+    }
+}
@@ -0,0 +1,899 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session_pool_utest.c
+ * @brief Unit tests for the Fleet Provisioning session pool.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning session pool include. */
+#include "fleet_provisioning_session_pool.h"
+
+/* Number of sessions in the test pool. */
+#define TEST_CAPACITY         4U
+
+/* Response timeout of the test pool. */
+#define TEST_TIMEOUT_TICKS    10U
+
+/* Number of sessions in the pool of the scheduling test: enough RegisterThing
+ * requests to reach the starvation limit and one more, and a new flow. */
+#define TEST_SCHEDULING_CAPACITY    ( FP_SESSION_POOL_STARVATION_LIMIT + 3U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Arena of the test pool.
+ */
+static uint64_t arena[ ( FP_SESSION_POOL_ARENA_LENGTH( TEST_CAPACITY ) + 7U ) / 8U ];
+
+/**
+ * @brief Arena of the pool of the scheduling test.
+ */
+static uint64_t schedulingArena[ ( FP_SESSION_POOL_ARENA_LENGTH( TEST_SCHEDULING_CAPACITY ) + 7U ) / 8U ];
+
+/**
+ * @brief Pool used in tests.
+ */
+static FleetProvisioningSessionPool_t pool;
+
+/**
+ * @brief Session configuration used in tests.
+ */
+static FleetProvisioningSessionConfig_t config;
+
+/**
+ * @brief RegisterThing parameters used in tests.
+ */
+static FleetProvisioningTemplateParameter_t parameters[ 2 ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( arena, 0xA5, sizeof( arena ) );
+    memset( &pool, 0, sizeof( pool ) );
+    memset( &config, 0, sizeof( config ) );
+    config.format = FleetProvisioningJson;
+    config.pTemplateName = "tmpl";
+    config.templateNameLength = 4U;
+    config.pParameters = parameters;
+    config.parameterCount = 2U;
+    parameters[ 0 ].pKey = "SerialNumber";
+    parameters[ 0 ].keyLength = 12U;
+    parameters[ 0 ].pValue = "123";
+    parameters[ 0 ].valueLength = 3U;
+    parameters[ 1 ].pKey = "Location";
+    parameters[ 1 ].keyLength = 8U;
+    parameters[ 1 ].pValue = "Line3";
+    parameters[ 1 ].valueLength = 5U;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_SessionPoolInit_BadParams( void );
+void test_FleetProvisioning_SessionPoolInit_Layout( void );
+void test_FleetProvisioning_SessionPool_AcquireRelease( void );
+void test_FleetProvisioning_SessionPoolAcquire_Limits( void );
+void test_FleetProvisioning_SessionPoolHandleEvent( void );
+void test_FleetProvisioning_SessionPool_Timeouts( void );
+void test_FleetProvisioning_SessionPool_TimeoutsDisabled( void );
+void test_FleetProvisioning_SessionPool_RateLimit( void );
+void test_FleetProvisioning_SessionPool_RateLimitRelease( void );
+void test_FleetProvisioning_SessionPool_Concurrency( void );
+void test_FleetProvisioning_SessionPool_CompletionFirst( void );
+void test_FleetProvisioning_SessionPool_CompletionFirstBlocked( void );
+void test_FleetProvisioning_SessionPool_Latency( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to initialize the test pool.
+ */
+static void initPool( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), TEST_CAPACITY,
+                                                          TEST_TIMEOUT_TICKS ) );
+}
+
+/**
+ * @brief Helper to feed an event without payload to a session of the test
+ * pool.
+ *
+ * @param[in] index The index of the session.
+ * @param[in] type The type of event.
+ * @param[in] expectedAction The type of action expected.
+ */
+static void sendEvent( uint32_t index,
+                       FleetProvisioningEventType_t type,
+                       FleetProvisioningActionType_t expectedAction )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U };
+    FleetProvisioningAction_t action;
+
+    event.type = type;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolHandleEvent( &pool, index, &event, &action ) );
+    TEST_ASSERT_EQUAL( expectedAction, action.type );
+}
+
+/**
+ * @brief Helper to set up a rate limiter allowing one CreateKeysAndCertificate
+ * and one CreateCertificateFromCsr request every 10 ticks, for the test pool.
+ *
+ * @param[out] pLimiter The rate limiter.
+ */
+static void setRateLimiter( FleetProvisioningRateLimiter_t * pLimiter )
+{
+    static const FleetProvisioningRateLimit_t limits[ FP_API_COUNT ] =
+    {
+        { 1U, 10U, 1U },
+        { 1U, 10U, 1U },
+        { 0U, 0U,  0U }
+    };
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( pLimiter, limits, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetRateLimiter( &pool, pLimiter ) );
+}
+
+/**
+ * @brief Helper to check that a region lies in the arena.
+ *
+ * @param[in] pRegion The start of the region.
+ * @param[in] length The length of the region.
+ */
+static void checkInArena( const void * pRegion,
+                          size_t length )
+{
+    const uint8_t * pStart = ( const uint8_t * ) arena;
+    const uint8_t * pByte = ( const uint8_t * ) pRegion;
+
+    TEST_ASSERT_TRUE( pByte >= pStart );
+    TEST_ASSERT_TRUE( &( pByte[ length ] ) <= &( pStart[ FP_SESSION_POOL_ARENA_LENGTH( TEST_CAPACITY ) ] ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_SessionPoolInit rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_SessionPoolInit_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( NULL, arena, sizeof( arena ), TEST_CAPACITY, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( &pool, NULL, sizeof( arena ), TEST_CAPACITY, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), 0U, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), FP_SESSION_POOL_INVALID_INDEX, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), TEST_CAPACITY, 0x80000000U ) );
+
+    /* Misaligned arena. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolInit( &pool, &( ( ( uint8_t * ) arena )[ 1 ] ), sizeof( arena ) - 1U, 1U, 0U ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, FP_SESSION_POOL_ARENA_LENGTH( TEST_CAPACITY ) - 1U,
+                                                          TEST_CAPACITY, 0U ) );
+}
+
+/**
+ * @brief Test that the arrays of a pool are carved from the arena without
+ * overlapping.
+ */
+void test_FleetProvisioning_SessionPoolInit_Layout( void )
+{
+    uint32_t i;
+
+    initPool();
+
+    TEST_ASSERT_EQUAL( TEST_CAPACITY, pool.capacity );
+    TEST_ASSERT_EQUAL( 0U, pool.inUseCount );
+    TEST_ASSERT_EQUAL_PTR( arena, pool.pSessions );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pSessions[ TEST_CAPACITY ] ), pool.wheel.pNodes );
+    TEST_ASSERT_EQUAL_PTR( &( pool.wheel.pNodes[ TEST_CAPACITY ] ), pool.pNext );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pNext[ TEST_CAPACITY ] ), pool.pSentTicks );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pSentTicks[ TEST_CAPACITY ] ), pool.pStates );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pStates[ TEST_CAPACITY ] ), pool.pQueues );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pQueues[ TEST_CAPACITY ] ), pool.pTopicBuffers );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pTopicBuffers[ TEST_CAPACITY * FP_SESSION_TOPIC_BUFFER_LENGTH ] ),
+                           pool.pPayloadBuffers );
+    checkInArena( pool.pPayloadBuffers, TEST_CAPACITY * FP_SESSION_PAYLOAD_BUFFER_LENGTH );
+
+    for( i = 0U; i < TEST_CAPACITY; i++ )
+    {
+        TEST_ASSERT_EQUAL( FP_SESSION_STATE_FREE, pool.pStates[ i ] );
+        TEST_ASSERT_EQUAL( FP_SESSION_POOL_NOT_QUEUED, pool.pQueues[ i ] );
+    }
+}
+
+/**
+ * @brief Test that sessions are acquired and released through the free
+ * list.
+ */
+void test_FleetProvisioning_SessionPool_AcquireRelease( void )
+{
+    uint32_t index = 0U;
+    uint32_t i;
+
+    initPool();
+
+    for( i = 0U; i < TEST_CAPACITY; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+        TEST_ASSERT_EQUAL( i, index );
+        TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, pool.pStates[ index ] );
+        TEST_ASSERT_EQUAL_PTR( &( pool.pTopicBuffers[ index * FP_SESSION_TOPIC_BUFFER_LENGTH ] ),
+                               pool.pSessions[ index ].pTopicBuffer );
+        TEST_ASSERT_EQUAL_PTR( &( pool.pPayloadBuffers[ index * FP_SESSION_PAYLOAD_BUFFER_LENGTH ] ),
+                               pool.pSessions[ index ].pPayloadBuffer );
+    }
+
+    TEST_ASSERT_EQUAL( TEST_CAPACITY, pool.inUseCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+
+    /* The last released session is the next acquired. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 2U ) );
+    TEST_ASSERT_EQUAL( FP_SESSION_STATE_FREE, pool.pStates[ 2 ] );
+    TEST_ASSERT_EQUAL( TEST_CAPACITY - 2U, pool.inUseCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( 2U, index );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( 1U, index );
+
+    /* Invalid releases. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolRelease( &pool, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolRelease( &pool, TEST_CAPACITY ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolRelease( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( TEST_CAPACITY - 1U, pool.inUseCount );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( NULL, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, NULL, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, NULL ) );
+}
+
+/**
+ * @brief Test that configurations beyond the session limits, or otherwise
+ * invalid, are rejected without using up a session.
+ */
+void test_FleetProvisioning_SessionPoolAcquire_Limits( void )
+{
+    static const uint8_t csr[ FP_SESSION_MAX_CSR_LENGTH + 1U ] = { 0 };
+    uint32_t index = 0U;
+
+    initPool();
+
+    config.pCsrDer = csr;
+    config.csrDerLength = FP_SESSION_MAX_CSR_LENGTH + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    config.csrDerLength = FP_SESSION_MAX_CSR_LENGTH;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, index ) );
+    config.pCsrDer = NULL;
+    config.csrDerLength = 0U;
+
+    /* Parameters one byte over the limit in total. */
+    parameters[ 1 ].valueLength = FP_SESSION_MAX_PARAMETERS_LENGTH - ( 12U + 3U + 6U ) - ( 8U + 6U ) + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+
+    /* A single length over the limit. */
+    parameters[ 1 ].valueLength = ( size_t ) -1;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    parameters[ 1 ].valueLength = 5U;
+    parameters[ 1 ].keyLength = FP_SESSION_MAX_PARAMETERS_LENGTH + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    parameters[ 1 ].keyLength = 8U;
+
+    /* No parameters, and a parameter count without parameters, which the
+     * session rejects. */
+    config.pParameters = NULL;
+    config.parameterCount = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, index ) );
+    config.parameterCount = 2U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    config.pParameters = parameters;
+
+    /* Rejected by the session itself. */
+    config.pTemplateName = NULL;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+
+    TEST_ASSERT_EQUAL( 0U, pool.inUseCount );
+    TEST_ASSERT_EQUAL( 0U, pool.freeHead );
+}
+
+/**
+ * @brief Test that events drive pooled sessions and update their states.
+ */
+void test_FleetProvisioning_SessionPoolHandleEvent( void )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U };
+    FleetProvisioningAction_t action;
+    uint32_t first = 0U;
+    uint32_t second = 0U;
+
+    initPool();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &first ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &second ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolHandleEvent( &pool, second, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionSubscribe, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionSubscribingCredentials, pool.pStates[ second ] );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, pool.pStates[ first ] );
+
+    /* The RegisterThing topics of each session are in its own buffer. */
+    event.type = FleetProvisioningEventSubscribed;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolHandleEvent( &pool, second, &event, &action ) );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pTopicBuffers[ second * FP_SESSION_TOPIC_BUFFER_LENGTH ] ), action.topics[ 0 ].pData );
+
+    /* Events for sessions that are not acquired. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolHandleEvent( &pool, 2U, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolHandleEvent( NULL, first, &event, &action ) );
+
+    /* Events the session does not expect leave its state. */
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_SessionPoolHandleEvent( &pool, first, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, pool.pStates[ first ] );
+}
+
+/**
+ * @brief Test that sessions time out when a response does not come in
+ * time, and only then.
+ */
+void test_FleetProvisioning_SessionPool_Timeouts( void )
+{
+    static const char accepted[] =
+        "{\"certificateId\":\"id1\",\"certificatePem\":\"cert\",\"privateKey\":\"key\","
+        "\"certificateOwnershipToken\":\"tok\"}";
+    static const char registered[] = "{\"thingName\":\"thing1\"}";
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, NULL, 0U };
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    initPool();
+
+    for( i = 0U; i < 3U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    }
+
+    /* Session 0 waits from tick 0 and session 1 from tick 5. */
+    sendEvent( 0U, FleetProvisioningEventStart, FleetProvisioningActionSubscribe );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 5U ) );
+    sendEvent( 1U, FleetProvisioningEventStart, FleetProvisioningActionSubscribe );
+    sendEvent( 2U, FleetProvisioningEventStart, FleetProvisioningActionSubscribe );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 9U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 10U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( 0U, index );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, pool.pStates[ 0 ] );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+
+    /* Each new action restarts the timeout, and the end of a session or its
+     * release stops it. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 12U ) );
+    sendEvent( 1U, FleetProvisioningEventSubscribed, FleetProvisioningActionSubscribe );
+    sendEvent( 2U, FleetProvisioningEventTimeout, FleetProvisioningActionFailed );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 21U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 100U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+
+    /* A session that completes stops its timeout. */
+    config.sharedSubscriptions = 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( index, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    event.pPayload = accepted;
+    event.payloadLength = sizeof( accepted ) - 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, index, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    event.topic = FleetProvJsonRegisterThingAccepted;
+    event.pPayload = registered;
+    event.payloadLength = sizeof( registered ) - 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, index, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionDone, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 200U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolTick( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextTimeout( NULL, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextTimeout( &pool, NULL, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextTimeout( &pool, &index, NULL ) );
+}
+
+/**
+ * @brief Test that a pool without a timeout never times sessions out.
+ */
+void test_FleetProvisioning_SessionPool_TimeoutsDisabled( void )
+{
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), TEST_CAPACITY, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( index, FleetProvisioningEventStart, FleetProvisioningActionSubscribe );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 1000U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionSubscribingCredentials, pool.pStates[ index ] );
+}
+
+/**
+ * @brief Test that publishes beyond the rate limit are deferred, then sent
+ * in order with the APIs taking turns.
+ */
+void test_FleetProvisioning_SessionPool_RateLimit( void )
+{
+    static const uint8_t csr[] = { 0x30, 0x03, 0x02, 0x01, 0x00 };
+    FleetProvisioningRateLimiter_t limiter;
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    initPool();
+    setRateLimiter( &limiter );
+    config.sharedSubscriptions = 1U;
+
+    /* Sessions 0 and 1 use CreateKeysAndCertificate, 2 and 3
+     * CreateCertificateFromCsr. */
+    for( i = 0U; i < TEST_CAPACITY; i++ )
+    {
+        if( i == 2U )
+        {
+            config.pCsrDer = csr;
+            config.csrDerLength = sizeof( csr );
+        }
+
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    }
+
+    sendEvent( 0U, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    sendEvent( 1U, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+    sendEvent( 2U, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    sendEvent( 3U, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingCredentials, pool.pStates[ 1 ] );
+
+    /* Nothing is written when no deferred publish can go out. */
+    memset( &action, 0xA5, sizeof( action ) );
+    index = TEST_CAPACITY;
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EACH_EQUAL_HEX8( 0xA5, &action, sizeof( action ) );
+    TEST_ASSERT_EQUAL( TEST_CAPACITY, index );
+
+    /* Deferred sessions do not time out. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, TEST_TIMEOUT_TICKS ) );
+
+    for( i = 0U; i < 2U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, pool.pStates[ index ] );
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingCredentials, pool.pStates[ 1 ] );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingCredentials, pool.pStates[ 3 ] );
+
+    /* The queue of CreateCertificateFromCsr is served first, then the other
+     * one. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( 3U, index );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateCertFromCsrPublish, action.request );
+    TEST_ASSERT_EQUAL_PTR( &( pool.pPayloadBuffers[ 3U * FP_SESSION_PAYLOAD_BUFFER_LENGTH ] ), action.payload.pData );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( 1U, index );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateKeysAndCertPublish, action.request );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+
+    /* The timeout of a deferred session starts with its publish. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 2U * TEST_TIMEOUT_TICKS ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextTimeout( &pool, &index, &action ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolSetRateLimiter( NULL, &limiter ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextPublish( NULL, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextPublish( &pool, NULL, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionPoolNextPublish( &pool, &index, NULL ) );
+}
+
+/**
+ * @brief Test that deferred sessions leave their queue when released or
+ * when they handle another event.
+ */
+void test_FleetProvisioning_SessionPool_RateLimitRelease( void )
+{
+    FleetProvisioningRateLimiter_t limiter;
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    initPool();
+    setRateLimiter( &limiter );
+    config.sharedSubscriptions = 1U;
+
+    for( i = 0U; i < TEST_CAPACITY; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+        sendEvent( i, FleetProvisioningEventStart, ( i == 0U ) ? FleetProvisioningActionPublish :
+                   FleetProvisioningActionDeferred );
+    }
+
+    /* Out of the middle, the end and the front of the queue. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 3U ) );
+    sendEvent( 1U, FleetProvisioningEventTimeout, FleetProvisioningActionFailed );
+    TEST_ASSERT_EQUAL( FP_SESSION_POOL_NOT_QUEUED, pool.pQueues[ 1 ] );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 100U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+
+    /* A session acquired again can be deferred again, and without a rate
+     * limiter deferred sessions go out at once. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( 3U, index );
+    sendEvent( 3U, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( 2U, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetRateLimiter( &pool, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( 2U, index );
+    TEST_ASSERT_EQUAL( FP_SESSION_POOL_NOT_QUEUED, pool.pQueues[ 2 ] );
+}
+
+/**
+ * @brief Test that a concurrency controller limits the acquired sessions,
+ * and that throttled responses lower the limit.
+ */
+void test_FleetProvisioning_SessionPool_Concurrency( void )
+{
+    static const char throttled[] = "{\"statusCode\":429,\"errorCode\":\"ThrottlingException\"}";
+    static const FleetProvisioningConcurrencyConfig_t limits = { 1U, 2U, TEST_CAPACITY, 50U };
+    FleetProvisioningConcurrency_t controller;
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertRejected, NULL, 0U };
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+
+    initPool();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_ConcurrencyInit( &controller, &limits ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolSetConcurrency( NULL, &controller ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetConcurrency( &pool, &controller ) );
+    config.sharedSubscriptions = 1U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( 2U, pool.inUseCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolSetConcurrency( &pool, NULL ) );
+
+    /* A response the session does not take is not counted. */
+    sendEvent( 0U, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    event.topic = FleetProvJsonRegisterThingRejected;
+    event.pPayload = throttled;
+    event.payloadLength = sizeof( throttled ) - 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolHandleEvent( &pool, 0U, &event, &action ) );
+    TEST_ASSERT_EQUAL_UINT32( 2U, controller.limit );
+
+    event.topic = FleetProvJsonCreateKeysAndCertRejected;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, 0U, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL_UINT32( 1U, controller.limit );
+
+    /* Releasing one session leaves the other in flight, at the new limit. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetConcurrency( &pool, NULL ) );
+    TEST_ASSERT_EQUAL( 0U, controller.inFlight );
+}
+
+/**
+ * @brief Test that deferred RegisterThing requests go before new flows, and
+ * that new flows still start after #FP_SESSION_POOL_STARVATION_LIMIT of
+ * them.
+ */
+void test_FleetProvisioning_SessionPool_CompletionFirst( void )
+{
+    static const char accepted[] =
+        "{\"certificateId\":\"id1\",\"certificatePem\":\"cert\",\"privateKey\":\"key\","
+        "\"certificateOwnershipToken\":\"tok\"}";
+    static const FleetProvisioningRateLimit_t limits[ FP_API_COUNT ] =
+    {
+        { 0U, 0U,  0U },
+        { 0U, 0U,  0U },
+        { 1U, 10U, 1U }
+    };
+    FleetProvisioningRateLimiter_t limiter;
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, NULL, 0U };
+    FleetProvisioningAction_t action;
+    const uint32_t newFlow = TEST_SCHEDULING_CAPACITY - 1U;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolInit( &pool, schedulingArena, sizeof( schedulingArena ),
+                                                          TEST_SCHEDULING_CAPACITY, 0U ) );
+    setRateLimiter( &limiter );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    config.sharedSubscriptions = 1U;
+    event.pPayload = accepted;
+    event.payloadLength = sizeof( accepted ) - 1U;
+
+    /* All sessions but the last get a certificate; only the first can send
+     * its RegisterThing request at once. */
+    for( i = 0U; i < newFlow; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+        sendEvent( i, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    }
+
+    for( i = 0U; i < newFlow; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, i, &event, &action ) );
+        TEST_ASSERT_EQUAL( ( i == 0U ) ? FleetProvisioningActionPublish : FleetProvisioningActionDeferred, action.type );
+    }
+
+    /* The new flow waits behind them, although its API has no limit. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( newFlow, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+
+    for( i = 1U; i <= FP_SESSION_POOL_STARVATION_LIMIT; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, i * 10U ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+        TEST_ASSERT_EQUAL( i, index );
+        TEST_ASSERT_EQUAL( FleetProvJsonRegisterThingPublish, action.request );
+
+        if( i < FP_SESSION_POOL_STARVATION_LIMIT )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                               FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+        }
+    }
+
+    /* The starvation limit lets the new flow through, then RegisterThing
+     * requests go first again. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( newFlow, index );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateKeysAndCertPublish, action.request );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 1000U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( newFlow - 1U, index );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+}
+
+/**
+ * @brief Test that deferred RegisterThing requests still go out once they
+ * reached #FP_SESSION_POOL_STARVATION_LIMIT, while the new flow is held back
+ * by its own rate limit, and that the new flow goes first once it can.
+ */
+void test_FleetProvisioning_SessionPool_CompletionFirstBlocked( void )
+{
+    static const uint8_t csr[] = { 0x30, 0x03, 0x02, 0x01, 0x00 };
+    static const char accepted[] =
+        "{\"certificateId\":\"id1\",\"certificatePem\":\"cert\",\"privateKey\":\"key\","
+        "\"certificateOwnershipToken\":\"tok\"}";
+    static const FleetProvisioningRateLimit_t limits[ FP_API_COUNT ] =
+    {
+        { 1U, 1000U, 1U },
+        { 0U, 0U,    0U },
+        { 1U, 10U,   1U }
+    };
+    FleetProvisioningRateLimiter_t limiter;
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, NULL, 0U };
+    FleetProvisioningAction_t action;
+    const uint32_t newFlow = TEST_SCHEDULING_CAPACITY - 1U;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolInit( &pool, schedulingArena, sizeof( schedulingArena ),
+                                                          TEST_SCHEDULING_CAPACITY, 0U ) );
+    setRateLimiter( &limiter );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_RateLimiterInit( &limiter, limits, 0U ) );
+    config.sharedSubscriptions = 1U;
+    event.pPayload = accepted;
+    event.payloadLength = sizeof( accepted ) - 1U;
+
+    /* Another client takes the only CreateCertificateFromCsr request until
+     * tick 1000. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_RateLimiterTryAcquire( &limiter, FleetProvJsonCreateCertFromCsrPublish, 0U, NULL ) );
+
+    /* One more RegisterThing request is deferred than the starvation limit
+     * lets through before a new flow. */
+    for( i = 0U; i < newFlow; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+        sendEvent( i, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    }
+
+    for( i = 0U; i < newFlow; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, i, &event, &action ) );
+        TEST_ASSERT_EQUAL( ( i == 0U ) ? FleetProvisioningActionPublish : FleetProvisioningActionDeferred, action.type );
+    }
+
+    config.pCsrDer = csr;
+    config.csrDerLength = sizeof( csr );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( newFlow, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+
+    /* The new flow cannot take its turn, so RegisterThing requests keep
+     * going past the starvation limit. */
+    for( i = 1U; i < newFlow; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, i * 10U ) );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+        TEST_ASSERT_EQUAL( i, index );
+        TEST_ASSERT_EQUAL( FleetProvJsonRegisterThingPublish, action.request );
+        TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( FP_SESSION_POOL_STARVATION_LIMIT, pool.registerStreak );
+
+    /* Once it can, the new flow goes. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 1000U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( newFlow, index );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateCertFromCsrPublish, action.request );
+    TEST_ASSERT_EQUAL_UINT32( 0U, pool.registerStreak );
+}
+
+/**
+ * @brief Test that the latency of each response is recorded by topic, from
+ * the publish of its request.
+ */
+void test_FleetProvisioning_SessionPool_Latency( void )
+{
+    static const char accepted[] =
+        "{\"certificateId\":\"id1\",\"certificatePem\":\"cert\",\"privateKey\":\"key\","
+        "\"certificateOwnershipToken\":\"tok\"}";
+    static const char registered[] = "{\"thingName\":\"thing1\"}";
+    static FleetProvisioningLatency_t latency;
+    FleetProvisioningRateLimiter_t limiter;
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, NULL, 0U };
+    FleetProvisioningAction_t action;
+    uint32_t index = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionPoolInit( &pool, arena, sizeof( arena ), TEST_CAPACITY, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_LatencyInit( &latency ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionPoolSetLatency( NULL, &latency ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetLatency( &pool, &latency ) );
+    setRateLimiter( &limiter );
+    config.sharedSubscriptions = 1U;
+
+    /* The second request is deferred until tick 10. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( 0U, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    sendEvent( 1U, FleetProvisioningEventStart, FleetProvisioningActionDeferred );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 10U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolNextPublish( &pool, &index, &action ) );
+    TEST_ASSERT_EQUAL( 1U, index );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 12U ) );
+    event.pPayload = accepted;
+    event.payloadLength = sizeof( accepted ) - 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, 0U, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+
+    /* The time the request spent deferred is not counted. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 13U ) );
+    event.topic = FleetProvJsonCreateKeysAndCertRejected;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, 1U, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+
+    /* A response the session does not take is not recorded. */
+    event.topic = FleetProvJsonRegisterThingRejected;
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionPoolHandleEvent( &pool, 1U, &event, &action ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolTick( &pool, 15U ) );
+    event.topic = FleetProvJsonRegisterThingAccepted;
+    event.pPayload = registered;
+    event.payloadLength = sizeof( registered ) - 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, 0U, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionDone, action.type );
+
+    TEST_ASSERT_EQUAL_UINT64( 12U, latency.responseTicks[ FleetProvJsonCreateKeysAndCertAccepted ].sum );
+    TEST_ASSERT_EQUAL_UINT64( 3U, latency.responseTicks[ FleetProvJsonCreateKeysAndCertRejected ].sum );
+    TEST_ASSERT_EQUAL_UINT64( 3U, latency.responseTicks[ FleetProvJsonRegisterThingAccepted ].sum );
+    TEST_ASSERT_EQUAL_UINT32( 1U, latency.responseTicks[ FleetProvJsonRegisterThingAccepted ].counts[ 3 ] );
+    TEST_ASSERT_EQUAL_UINT32( 0U, latency.responseTicks[ FleetProvJsonRegisterThingRejected ].counts[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, latency.handleCycles[ FleetProvJsonCreateKeysAndCertAccepted ].counts[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT32( 0U, latency.handleCycles[ FleetProvJsonRegisterThingRejected ].counts[ 0 ] );
+
+    /* Nothing is recorded once the histograms are removed. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetLatency( &pool, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolSetRateLimiter( &pool, NULL ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolRelease( &pool, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolAcquire( &pool, &config, &index ) );
+    sendEvent( index, FleetProvisioningEventStart, FleetProvisioningActionPublish );
+    event.topic = FleetProvJsonCreateKeysAndCertRejected;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionPoolHandleEvent( &pool, index, &event, &action ) );
+    TEST_ASSERT_EQUAL_UINT64( 3U, latency.responseTicks[ FleetProvJsonCreateKeysAndCertRejected ].sum );
+}
@@ -0,0 +1,687 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_session_utest.c
+ * @brief Unit tests for the Fleet Provisioning session state machine.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning session include. */
+#include "fleet_provisioning_session.h"
+
+/* Template name used in tests. */
+#define TEST_TEMPLATE_NAME           "tmpl"
+#define TEST_TEMPLATE_NAME_LENGTH    ( ( uint16_t ) ( sizeof( TEST_TEMPLATE_NAME ) - 1U ) )
+
+/* JSON CreateKeysAndCertificate accepted response. */
+#define TEST_JSON_KEYS_ACCEPTED                  \
+    "{\"certificateId\":\"id1\","                \
+    "\"certificatePem\":\"cert\","               \
+    "\"privateKey\":\"key\","                    \
+    "\"certificateOwnershipToken\":\"tok\"}"
+
+/* JSON RegisterThing request for the test parameters. */
+#define TEST_JSON_REGISTER_REQUEST                \
+    "{\"parameters\":{\"SerialNumber\":\"123\"}," \
+    "\"certificateOwnershipToken\":\"tok\"}"
+
+/* JSON RegisterThing accepted response. */
+#define TEST_JSON_REGISTER_ACCEPTED    "{\"deviceConfiguration\":{},\"thingName\":\"thing1\"}"
+
+/* CBOR CreateCertificateFromCSR accepted response, with only a token. */
+#define TEST_CBOR_CERT_ACCEPTED        "\xA1\x78\x19" "certificateOwnershipToken" "\x63" "tok"
+
+/* CBOR RegisterThing request for the test parameters. */
+#define TEST_CBOR_REGISTER_REQUEST         \
+    "\xA2\x6A" "parameters"                \
+    "\xA1\x6C" "SerialNumber" "\x63" "123" \
+    "\x78\x19" "certificateOwnershipToken" "\x63" "tok"
+
+/* CBOR RegisterThing accepted response. */
+#define TEST_CBOR_REGISTER_ACCEPTED    "\xA1\x69" "thingName" "\x66" "thing1"
+
+/* Length of the payload buffer used in tests. */
+#define TEST_PAYLOAD_BUFFER_LENGTH     512U
+
+/* Length of a string literal. */
+#define LITERAL_LENGTH( x )    ( sizeof( x ) - 1U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief RegisterThing parameters used in tests.
+ */
+static const FleetProvisioningTemplateParameter_t testParameters[] =
+{
+    { "SerialNumber", 12U, "123", 3U }
+};
+
+/**
+ * @brief DER certificate signing request used in tests.
+ */
+static const uint8_t testCsr[] = { 0x30, 0x82, 0x01, 0x0A, 0x02, 0x01 };
+
+/**
+ * @brief Topic buffer of the session in tests.
+ */
+static char topicBuffer[ FP_SESSION_TOPIC_BUFFER_LENGTH ];
+
+/**
+ * @brief Payload buffer of the session in tests.
+ */
+static char payloadBuffer[ TEST_PAYLOAD_BUFFER_LENGTH ];
+
+/**
+ * @brief Session used in tests.
+ */
+static FleetProvisioningSession_t session;
+
+/**
+ * @brief Session configuration used in tests.
+ */
+static FleetProvisioningSessionConfig_t config;
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &session, 0, sizeof( session ) );
+    memset( &config, 0, sizeof( config ) );
+    config.format = FleetProvisioningJson;
+    config.pTemplateName = TEST_TEMPLATE_NAME;
+    config.templateNameLength = TEST_TEMPLATE_NAME_LENGTH;
+    config.pParameters = testParameters;
+    config.parameterCount = 1U;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_SessionInit_BadParams( void );
+void test_FleetProvisioning_SessionInit_TopicBufferTooSmall( void );
+void test_FleetProvisioning_SessionHandleEvent_BadParams( void );
+void test_FleetProvisioning_Session_JsonCreateKeys( void );
+void test_FleetProvisioning_Session_CborCreateCertSharedSubscriptions( void );
+void test_FleetProvisioning_Session_Rejected( void );
+void test_FleetProvisioning_Session_Timeout( void );
+void test_FleetProvisioning_Session_IgnoredEvents( void );
+void test_FleetProvisioning_Session_BuildFailures( void );
+void test_FleetProvisioning_SessionGetRequest( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to initialize the test session from #config.
+ */
+static void initSession( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session,
+                                                      &config,
+                                                      topicBuffer,
+                                                      sizeof( topicBuffer ),
+                                                      payloadBuffer,
+                                                      sizeof( payloadBuffer ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, session.state );
+}
+
+/**
+ * @brief Helper to feed an event to the test session.
+ *
+ * @param[in] type The type of the event.
+ * @param[in] topic The topic of a message.
+ * @param[in] pPayload The payload of a message.
+ * @param[in] payloadLength The length of @p pPayload.
+ * @param[out] pAction The action requested by the session.
+ *
+ * @return The status of #FleetProvisioning_SessionHandleEvent.
+ */
+static FleetProvisioningStatus_t sendEvent( FleetProvisioningEventType_t type,
+                                            FleetProvisioningTopic_t topic,
+                                            const char * pPayload,
+                                            size_t payloadLength,
+                                            FleetProvisioningAction_t * pAction )
+{
+    FleetProvisioningEvent_t event;
+
+    event.type = type;
+    event.topic = topic;
+    event.pPayload = pPayload;
+    event.payloadLength = payloadLength;
+
+    return FleetProvisioning_SessionHandleEvent( &session, &event, pAction );
+}
+
+/**
+ * @brief Helper to check that a span holds a string.
+ *
+ * @param[in] pExpected The expected string.
+ * @param[in] expectedLength The length of @p pExpected.
+ * @param[in] pSpan The span.
+ */
+static void checkSpan( const char * pExpected,
+                       size_t expectedLength,
+                       const FleetProvisioningSpan_t * pSpan )
+{
+    TEST_ASSERT_EQUAL( expectedLength, pSpan->length );
+    TEST_ASSERT_EQUAL_MEMORY( pExpected, pSpan->pData, expectedLength );
+}
+
+/**
+ * @brief Helper to start the test session without subscriptions and
+ * deliver the JSON CreateKeysAndCertificate accepted response.
+ */
+static void startJsonSession( void )
+{
+    FleetProvisioningAction_t action;
+
+    config.sharedSubscriptions = 1U;
+    initSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvJsonCreateKeysAndCertAccepted,
+                                  TEST_JSON_KEYS_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_JSON_KEYS_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingRegister, session.state );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_SessionInit rejects invalid parameters.
+ */
+void test_FleetProvisioning_SessionInit_BadParams( void )
+{
+    FleetProvisioningTemplateParameter_t slotParameter = { "SerialNumber", 12U, NULL, 3U };
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( NULL, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, NULL, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, NULL, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      NULL, sizeof( payloadBuffer ) ) );
+
+    /* CSR length without a CSR. */
+    config.csrDerLength = 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    config.csrDerLength = 0U;
+
+    /* Parameter count without parameters. */
+    config.pParameters = NULL;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+
+    /* No parameters at all is valid. */
+    config.parameterCount = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    config.parameterCount = 1U;
+
+    /* Template slots are not supported. */
+    config.pParameters = &slotParameter;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    config.pParameters = testParameters;
+
+    /* Invalid template name and format. */
+    config.templateNameLength = FP_TEMPLATENAME_MAX_LENGTH + 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    config.templateNameLength = TEST_TEMPLATE_NAME_LENGTH;
+    config.format = ( FleetProvisioningFormat_t ) 2;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+}
+
+/**
+ * @brief Test that #FleetProvisioning_SessionInit reports a topic buffer
+ * that cannot hold the RegisterThing topics, and that the buffer length for
+ * the longest template name is enough.
+ */
+void test_FleetProvisioning_SessionInit_TopicBufferTooSmall( void )
+{
+    char longName[ FP_TEMPLATENAME_MAX_LENGTH ];
+    size_t needed = FP_JSON_REGISTER_ACCEPTED_LENGTH( TEST_TEMPLATE_NAME_LENGTH ) +
+                    FP_JSON_REGISTER_REJECTED_LENGTH( TEST_TEMPLATE_NAME_LENGTH );
+
+    /* No room for the accepted topic. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, 10U,
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+
+    /* No room for the rejected topic. */
+    TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, needed - 1U,
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, needed,
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+
+    /* A length beyond 16 bits is clamped. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, 0x10000U,
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+
+    memset( longName, 'n', sizeof( longName ) );
+    config.pTemplateName = longName;
+    config.templateNameLength = FP_TEMPLATENAME_MAX_LENGTH;
+    config.format = FleetProvisioningCbor;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, sizeof( payloadBuffer ) ) );
+}
+
+/**
+ * @brief Test that #FleetProvisioning_SessionHandleEvent rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_SessionHandleEvent_BadParams( void )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U };
+    FleetProvisioningAction_t action;
+
+    initSession();
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionHandleEvent( NULL, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionHandleEvent( &session, NULL, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionHandleEvent( &session, &event, NULL ) );
+
+    /* Message without a payload. */
+    event.type = FleetProvisioningEventMessage;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionHandleEvent( &session, &event, &action ) );
+
+    /* Unknown event. */
+    event.type = ( FleetProvisioningEventType_t ) 10;
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_SessionHandleEvent( &session, &event, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionNone, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, session.state );
+}
+
+/**
+ * @brief Test a JSON CreateKeysAndCertificate session from start to end,
+ * with the session requesting its own subscriptions.
+ */
+void test_FleetProvisioning_Session_JsonCreateKeys( void )
+{
+    FleetProvisioningAction_t action;
+
+    initSession();
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionSubscribe, action.type );
+    TEST_ASSERT_EQUAL( 2U, action.topicCount );
+    checkSpan( FP_JSON_CREATE_KEYS_ACCEPTED_TOPIC, FP_JSON_CREATE_KEYS_ACCEPTED_LENGTH, &( action.topics[ 0 ] ) );
+    checkSpan( FP_JSON_CREATE_KEYS_REJECTED_TOPIC, FP_JSON_CREATE_KEYS_REJECTED_LENGTH, &( action.topics[ 1 ] ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionSubscribingCredentials, session.state );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventSubscribed, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionSubscribe, action.type );
+    checkSpan( FP_JSON_REGISTER_ACCEPTED_TOPIC( TEST_TEMPLATE_NAME ),
+               FP_JSON_REGISTER_ACCEPTED_LENGTH( TEST_TEMPLATE_NAME_LENGTH ),
+               &( action.topics[ 0 ] ) );
+    checkSpan( FP_JSON_REGISTER_REJECTED_TOPIC( TEST_TEMPLATE_NAME ),
+               FP_JSON_REGISTER_REJECTED_LENGTH( TEST_TEMPLATE_NAME_LENGTH ),
+               &( action.topics[ 1 ] ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionSubscribingRegister, session.state );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventSubscribed, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateKeysAndCertPublish, action.request );
+    TEST_ASSERT_EQUAL( 1U, action.topicCount );
+    checkSpan( FP_JSON_CREATE_KEYS_PUBLISH_TOPIC, FP_JSON_CREATE_KEYS_PUBLISH_LENGTH, &( action.topics[ 0 ] ) );
+    checkSpan( "{}", 2U, &( action.payload ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingCredentials, session.state );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvJsonCreateKeysAndCertAccepted,
+                                  TEST_JSON_KEYS_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_JSON_KEYS_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvJsonRegisterThingPublish, action.request );
+    checkSpan( FP_JSON_REGISTER_PUBLISH_TOPIC( TEST_TEMPLATE_NAME ),
+               FP_JSON_REGISTER_PUBLISH_LENGTH( TEST_TEMPLATE_NAME_LENGTH ),
+               &( action.topics[ 0 ] ) );
+    checkSpan( TEST_JSON_REGISTER_REQUEST, LITERAL_LENGTH( TEST_JSON_REGISTER_REQUEST ), &( action.payload ) );
+    checkSpan( "id1", 3U, &( action.credentials.certificateId ) );
+    checkSpan( "cert", 4U, &( action.credentials.certificatePem ) );
+    checkSpan( "key", 3U, &( action.credentials.privateKey ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingRegister, session.state );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvJsonRegisterThingAccepted,
+                                  TEST_JSON_REGISTER_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_JSON_REGISTER_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionDone, action.type );
+    checkSpan( "thing1", 6U, &( action.thingName ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionDone, session.state );
+}
+
+/**
+ * @brief Test a CBOR CreateCertificateFromCSR session with subscriptions
+ * made by the application.
+ */
+void test_FleetProvisioning_Session_CborCreateCertSharedSubscriptions( void )
+{
+    FleetProvisioningAction_t action;
+    char expected[ TEST_PAYLOAD_BUFFER_LENGTH ];
+    size_t expectedLength = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SerializeCreateCertFromCsrRequest( testCsr, sizeof( testCsr ),
+                                                                            FleetProvisioningCbor,
+                                                                            expected, sizeof( expected ),
+                                                                            &expectedLength ) );
+
+    config.format = FleetProvisioningCbor;
+    config.pCsrDer = testCsr;
+    config.csrDerLength = sizeof( testCsr );
+    config.sharedSubscriptions = 1U;
+    initSession();
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvCborCreateCertFromCsrPublish, action.request );
+    checkSpan( FP_CBOR_CREATE_CERT_PUBLISH_TOPIC, FP_CBOR_CREATE_CERT_PUBLISH_LENGTH, &( action.topics[ 0 ] ) );
+    checkSpan( expected, expectedLength, &( action.payload ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvCborCreateCertFromCsrAccepted,
+                                  TEST_CBOR_CERT_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_CBOR_CERT_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, action.type );
+    TEST_ASSERT_EQUAL( FleetProvCborRegisterThingPublish, action.request );
+    checkSpan( FP_CBOR_REGISTER_PUBLISH_TOPIC( TEST_TEMPLATE_NAME ),
+               FP_CBOR_REGISTER_PUBLISH_LENGTH( TEST_TEMPLATE_NAME_LENGTH ),
+               &( action.topics[ 0 ] ) );
+    checkSpan( TEST_CBOR_REGISTER_REQUEST, LITERAL_LENGTH( TEST_CBOR_REGISTER_REQUEST ), &( action.payload ) );
+
+    /* Missing credentials are left empty. */
+    TEST_ASSERT_EQUAL( 0U, action.credentials.certificateId.length );
+    TEST_ASSERT_EQUAL( 0U, action.credentials.privateKey.length );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvCborRegisterThingAccepted,
+                                  TEST_CBOR_REGISTER_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_CBOR_REGISTER_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionDone, action.type );
+    checkSpan( "thing1", 6U, &( action.thingName ) );
+}
+
+/**
+ * @brief Test that rejected responses fail the session.
+ */
+void test_FleetProvisioning_Session_Rejected( void )
+{
+    FleetProvisioningAction_t action;
+
+    config.sharedSubscriptions = 1U;
+    initSession();
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertRejected, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, session.state );
+
+    /* CBOR CreateKeysAndCertificate sends an empty map. */
+    config.format = FleetProvisioningCbor;
+    initSession();
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    checkSpan( "\xA0", 1U, &( action.payload ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvCborCreateKeysAndCertRejected, "\xA0", 1U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    config.format = FleetProvisioningJson;
+
+    startJsonSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonRegisterThingRejected, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( 0U, action.topicCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, session.state );
+}
+
+/**
+ * @brief Test that timeouts fail a waiting session, and are ignored
+ * otherwise.
+ */
+void test_FleetProvisioning_Session_Timeout( void )
+{
+    FleetProvisioningAction_t action;
+
+    initSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionNone, action.type );
+
+    /* Subscription timeout. */
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+
+    /* Response timeout. */
+    startJsonSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, session.state );
+
+    /* A timeout after the response is stale. */
+    startJsonSession();
+    ( void ) sendEvent( FleetProvisioningEventMessage,
+                        FleetProvJsonRegisterThingAccepted,
+                        TEST_JSON_REGISTER_ACCEPTED,
+                        LITERAL_LENGTH( TEST_JSON_REGISTER_ACCEPTED ),
+                        &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionDone, session.state );
+}
+
+/**
+ * @brief Test that events which do not apply to the session in its state
+ * are ignored.
+ */
+void test_FleetProvisioning_Session_IgnoredEvents( void )
+{
+    FleetProvisioningAction_t action;
+
+    initSession();
+
+    /* Nothing is expected before the start. */
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventSubscribed, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonRegisterThingAccepted, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionIdle, session.state );
+
+    /* A second start. */
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionNone, action.type );
+
+    /* Responses of other APIs, formats and flows. */
+    startJsonSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvCborRegisterThingAccepted, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       sendEvent( FleetProvisioningEventSubscribed, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionNone, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionAwaitingRegister, session.state );
+}
+
+/**
+ * @brief Test that requests which cannot be built, and responses without
+ * the expected members, fail the session.
+ */
+void test_FleetProvisioning_Session_BuildFailures( void )
+{
+    FleetProvisioningAction_t action;
+
+    /* No room for the CSR request. */
+    config.pCsrDer = testCsr;
+    config.csrDerLength = sizeof( testCsr );
+    config.sharedSubscriptions = 1U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, 20U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+
+    /* No room for the RegisterThing request. */
+    config.pCsrDer = NULL;
+    config.csrDerLength = 0U;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_SessionInit( &session, &config, topicBuffer, sizeof( topicBuffer ),
+                                                      payloadBuffer, LITERAL_LENGTH( TEST_JSON_REGISTER_REQUEST ) - 1U ) );
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage,
+                                  FleetProvJsonCreateKeysAndCertAccepted,
+                                  TEST_JSON_KEYS_ACCEPTED,
+                                  LITERAL_LENGTH( TEST_JSON_KEYS_ACCEPTED ),
+                                  &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( 0U, action.credentials.certificateId.length );
+
+    /* No ownership token. */
+    initSession();
+    ( void ) sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+
+    /* No thing name. */
+    startJsonSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventMessage, FleetProvJsonRegisterThingAccepted, "{}", 2U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionFailed, action.type );
+    TEST_ASSERT_EQUAL( FleetProvisioningSessionFailed, session.state );
+}
+
+/**
+ * @brief Test that the outstanding request of a session can be fetched
+ * again.
+ */
+void test_FleetProvisioning_SessionGetRequest( void )
+{
+    FleetProvisioningAction_t action;
+    FleetProvisioningAction_t request;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionGetRequest( NULL, &request ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_SessionGetRequest( &session, NULL ) );
+
+    /* No request before the publish. */
+    initSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionGetRequest( &session, &request ) );
+
+    /* CreateCertificateFromCSR, from the payload buffer. */
+    config.pCsrDer = testCsr;
+    config.csrDerLength = sizeof( testCsr );
+    config.sharedSubscriptions = 1U;
+    initSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       sendEvent( FleetProvisioningEventStart, FleetProvisioningInvalidTopic, NULL, 0U, &action ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionGetRequest( &session, &request ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningActionPublish, request.type );
+    TEST_ASSERT_EQUAL( FleetProvJsonCreateCertFromCsrPublish, request.request );
+    TEST_ASSERT_EQUAL( 1U, request.topicCount );
+    checkSpan( FP_JSON_CREATE_CERT_PUBLISH_TOPIC, FP_JSON_CREATE_CERT_PUBLISH_LENGTH, &( request.topics[ 0 ] ) );
+    checkSpan( action.payload.pData, action.payload.length, &( request.payload ) );
+
+    /* RegisterThing, without the credentials. */
+    config.pCsrDer = NULL;
+    config.csrDerLength = 0U;
+    startJsonSession();
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_SessionGetRequest( &session, &request ) );
+    TEST_ASSERT_EQUAL( FleetProvJsonRegisterThingPublish, request.request );
+    checkSpan( TEST_JSON_REGISTER_REQUEST, LITERAL_LENGTH( TEST_JSON_REGISTER_REQUEST ), &( request.payload ) );
+    TEST_ASSERT_EQUAL( 0U, request.credentials.certificateId.length );
+
+    /* No request once the session is over. */
+    ( void ) sendEvent( FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U, &action );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_SessionGetRequest( &session, &request ) );
+}
@@ -0,0 +1,360 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file fleet_provisioning_shard_utest.c
+ * @brief Unit tests for the Fleet Provisioning shard queues.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning shard include. */
+#include "fleet_provisioning_shard.h"
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of slots of the queue used in tests.
+ */
+#define TEST_SLOT_COUNT    ( 4U )
+
+/**
+ * @brief Tag of the events pushed by the interfering producer.
+ */
+#define INTERFERING_TAG    ( 0xBEEFU )
+
+/**
+ * @brief Where the interfering producer pushes, within a push of the test.
+ */
+typedef enum InterferencePoint
+{
+    InterfereNever,             /**< @brief Do not interfere. */
+    InterfereAfterPositionLoad, /**< @brief After the push position is read. */
+    InterfereBeforeClaim        /**< @brief After the sequence of the slot is read, just before the push position is claimed. */
+} InterferencePoint_t;
+
+/**
+ * @brief Queue used in tests.
+ */
+static FleetProvisioningShardQueue_t queue;
+
+/**
+ * @brief Slots of the queue used in tests.
+ */
+static FleetProvisioningShardSlot_t slots[ TEST_SLOT_COUNT ];
+
+/**
+ * @brief Where the interfering producer pushes next.
+ */
+static InterferencePoint_t interference;
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &queue, 0xA5, sizeof( queue ) );
+    memset( slots, 0xA5, sizeof( slots ) );
+    interference = InterfereNever;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_GetShard_BadParams( void );
+void test_FleetProvisioning_GetShard_Spread( void );
+void test_FleetProvisioning_ShardQueueInit_BadParams( void );
+void test_FleetProvisioning_ShardQueuePush_BadParams( void );
+void test_FleetProvisioning_ShardQueuePop_BadParams( void );
+void test_FleetProvisioning_ShardQueue_Fifo( void );
+void test_FleetProvisioning_ShardQueue_ConcurrentPush( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Push an event from the interfering producer.
+ */
+static void pushInterfering( void )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U };
+
+    interference = InterfereNever;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePush( &queue, INTERFERING_TAG, &event ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t FleetProvisioningTest_AtomicLoad( const uint32_t * pValue )
+{
+    uint32_t value = *pValue;
+
+    /* A push reads the push position, then the sequence of its slot, then
+     * claims the position. */
+    if( ( ( interference == InterfereAfterPositionLoad ) && ( pValue == &( queue.pushPosition ) ) ) ||
+        ( ( interference == InterfereBeforeClaim ) && ( pValue != &( queue.pushPosition ) ) ) )
+    {
+        pushInterfering();
+    }
+
+    return value;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_GetShard rejects invalid parameters.
+ */
+void test_FleetProvisioning_GetShard_BadParams( void )
+{
+    uint32_t shard;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetShard( NULL, 4U, 2U, &shard ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetShard( "abcd", 0U, 2U, &shard ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetShard( "abcd", 4U, 0U, &shard ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetShard( "abcd", 4U, 2U, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_GetShard is stable and spreads serial
+ * numbers evenly over the shards.
+ */
+void test_FleetProvisioning_GetShard_Spread( void )
+{
+    uint32_t counts[ 8 ] = { 0U };
+    char serial[ 16 ];
+    uint32_t shard;
+    uint32_t again;
+    uint32_t i;
+
+    for( i = 0U; i < 8000U; i++ )
+    {
+        ( void ) sprintf( serial, "SN-%06u", ( unsigned int ) i );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetShard( serial, strlen( serial ), 8U, &shard ) );
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32( 7U, shard );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetShard( serial, strlen( serial ), 8U, &again ) );
+        TEST_ASSERT_EQUAL_UINT32( shard, again );
+        counts[ shard ]++;
+    }
+
+    /* Each shard gets its share of 1000 within 10%. */
+    for( i = 0U; i < 8U; i++ )
+    {
+        TEST_ASSERT_UINT32_WITHIN( 100U, 1000U, counts[ i ] );
+    }
+
+    /* A single shard takes every key. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_GetShard( serial, strlen( serial ), 1U, &shard ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, shard );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_ShardQueueInit rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_ShardQueueInit_BadParams( void )
+{
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueueInit( NULL, slots, TEST_SLOT_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueueInit( &queue, NULL, TEST_SLOT_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, 3U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, FP_SHARD_QUEUE_MAX_SLOTS + 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, 2U ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_ShardQueuePush rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_ShardQueuePush_BadParams( void )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U };
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, TEST_SLOT_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueuePush( NULL, 0U, &event ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueuePush( &queue, 0U, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that #FleetProvisioning_ShardQueuePop rejects invalid
+ * parameters.
+ */
+void test_FleetProvisioning_ShardQueuePop_BadParams( void )
+{
+    FleetProvisioningEvent_t event;
+    uint32_t tag;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, TEST_SLOT_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueuePop( NULL, &tag, &event ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueuePop( &queue, NULL, &event ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a shard queue hands events over in order, rejects pushes
+ * while full, and reuses its slots over many laps.
+ */
+void test_FleetProvisioning_ShardQueue_Fifo( void )
+{
+    static const char payload[] = "{}";
+    FleetProvisioningEvent_t event = { FleetProvisioningEventMessage, FleetProvJsonCreateKeysAndCertAccepted, payload, 2U };
+    FleetProvisioningEvent_t popped;
+    uint32_t tag;
+    uint32_t pushed = 0U;
+    uint32_t expected = 0U;
+    uint32_t lap;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, TEST_SLOT_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+
+    for( lap = 0U; lap < 10U; lap++ )
+    {
+        /* Fill the queue, leaving it one event ahead of the previous lap. */
+        for( i = 0U; i < TEST_SLOT_COUNT; i++ )
+        {
+            event.payloadLength = pushed;
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_ShardQueuePush( &queue, pushed, &event ) );
+            pushed++;
+        }
+
+        TEST_ASSERT_EQUAL( FleetProvisioningBufferTooSmall,
+                           FleetProvisioning_ShardQueuePush( &queue, pushed, &event ) );
+
+        for( i = 0U; i < ( TEST_SLOT_COUNT - 1U ); i++ )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+            TEST_ASSERT_EQUAL_UINT32( expected, tag );
+            TEST_ASSERT_EQUAL( FleetProvisioningEventMessage, popped.type );
+            TEST_ASSERT_EQUAL( FleetProvJsonCreateKeysAndCertAccepted, popped.topic );
+            TEST_ASSERT_EQUAL_PTR( payload, popped.pPayload );
+            TEST_ASSERT_EQUAL_UINT32( expected, popped.payloadLength );
+            expected++;
+        }
+
+        /* One slot is free again. */
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_ShardQueuePush( &queue, pushed, &event ) );
+        pushed++;
+
+        for( i = 0U; i < 2U; i++ )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+            TEST_ASSERT_EQUAL_UINT32( expected, tag );
+            expected++;
+        }
+
+        TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                           FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that a push racing with another producer takes the next free
+ * slot, whether the other producer claims the slot before or after the
+ * push reads it.
+ */
+void test_FleetProvisioning_ShardQueue_ConcurrentPush( void )
+{
+    FleetProvisioningEvent_t event = { FleetProvisioningEventTimeout, FleetProvisioningInvalidTopic, NULL, 0U };
+    FleetProvisioningEvent_t popped;
+    uint32_t tag;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueueInit( &queue, slots, TEST_SLOT_COUNT ) );
+
+    interference = InterfereAfterPositionLoad;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePush( &queue, 1U, &event ) );
+
+    interference = InterfereBeforeClaim;
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePush( &queue, 2U, &event ) );
+
+    /* Each interfering push went into the slot the racing push first saw. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+    TEST_ASSERT_EQUAL_UINT32( INTERFERING_TAG, tag );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+    TEST_ASSERT_EQUAL_UINT32( 1U, tag );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+    TEST_ASSERT_EQUAL_UINT32( INTERFERING_TAG, tag );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+    TEST_ASSERT_EQUAL_UINT32( 2U, tag );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch,
+                       FleetProvisioning_ShardQueuePop( &queue, &tag, &popped ) );
+}
+/*-----------------------------------------------------------*/
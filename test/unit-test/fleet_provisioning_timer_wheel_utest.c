@@ -0,0 +1,336 @@
+/*
+ * AWS IoT Fleet Provisioning v1.2.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file fleet_provisioning_timer_wheel_utest.c
+ * @brief Unit tests for the Fleet Provisioning timer wheel.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Test framework include. */
+#include "unity.h"
+
+/* Fleet Provisioning timer wheel include. */
+#include "fleet_provisioning_timer_wheel.h"
+
+/* Number of timers of the test wheel. */
+#define TEST_TIMER_COUNT    8U
+
+/* Number of timers of the stress test. */
+#define STRESS_TIMER_COUNT    100000U
+
+/* Longest delay of the stress test, beyond two levels of the wheel. */
+#define STRESS_MAX_DELAY      200000U
+
+/* Number of ticks the test wheel holds without re-queuing. */
+#define TEST_WHEEL_RANGE      ( 1UL << ( FP_TIMER_WHEEL_SLOT_BITS * FP_TIMER_WHEEL_LEVELS ) )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Timer wheel used in tests.
+ */
+static FleetProvisioningTimerWheel_t wheel;
+
+/**
+ * @brief Timers of the test wheel.
+ */
+static FleetProvisioningTimerNode_t nodes[ TEST_TIMER_COUNT ];
+
+/**
+ * @brief Timers of the stress test.
+ */
+static FleetProvisioningTimerNode_t stressNodes[ STRESS_TIMER_COUNT ];
+
+/**
+ * @brief Expected expiry of each timer of the stress test.
+ */
+static uint32_t stressExpiries[ STRESS_TIMER_COUNT ];
+/*-----------------------------------------------------------*/
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    memset( &wheel, 0, sizeof( wheel ) );
+    memset( nodes, 0xA5, sizeof( nodes ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_TimerWheelInit( &wheel, nodes, TEST_TIMER_COUNT ) );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+/*-----------------------------------------------------------*/
+
+/* Prototypes for test functions. */
+void test_FleetProvisioning_TimerWheel_BadParams( void );
+void test_FleetProvisioning_TimerWheel_ArmCancel( void );
+void test_FleetProvisioning_TimerWheel_ExpiryOrder( void );
+void test_FleetProvisioning_TimerWheel_Levels( void );
+void test_FleetProvisioning_TimerWheel_Wrap( void );
+void test_FleetProvisioning_TimerWheel_Stress( void );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Helper to check the next expired timer.
+ *
+ * @param[in] expectedTimer The timer expected, or
+ * #FP_TIMER_WHEEL_INVALID_TIMER for none.
+ */
+static void checkPop( uint32_t expectedTimer )
+{
+    uint32_t timer = FP_TIMER_WHEEL_INVALID_TIMER;
+
+    if( expectedTimer == FP_TIMER_WHEEL_INVALID_TIMER )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_TimerWheelPopExpired( &wheel, &timer ) );
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelPopExpired( &wheel, &timer ) );
+        TEST_ASSERT_EQUAL( expectedTimer, timer );
+    }
+}
+
+/**
+ * @brief Helper to check that a timer armed at the current tick expires
+ * exactly after its delay.
+ *
+ * @param[in] timer The timer.
+ * @param[in] delayTicks The delay.
+ */
+static void checkExpiry( uint32_t timer,
+                         uint32_t delayTicks )
+{
+    uint32_t expiry = wheel.now + delayTicks;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, timer, delayTicks ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, expiry - 1U ) );
+    checkPop( FP_TIMER_WHEEL_INVALID_TIMER );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, expiry ) );
+    checkPop( timer );
+    checkPop( FP_TIMER_WHEEL_INVALID_TIMER );
+    TEST_ASSERT_EQUAL( 0U, wheel.pendingCount );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that the timer wheel functions reject invalid parameters.
+ */
+void test_FleetProvisioning_TimerWheel_BadParams( void )
+{
+    uint32_t timer;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_TimerWheelInit( NULL, nodes, TEST_TIMER_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_TimerWheelInit( &wheel, NULL, TEST_TIMER_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_TimerWheelInit( &wheel, nodes, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_TimerWheelInit( &wheel, nodes, FP_TIMER_WHEEL_INVALID_TIMER ) );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelArm( NULL, 0U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelArm( &wheel, TEST_TIMER_COUNT, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelArm( &wheel, 0U, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelArm( &wheel, 0U, 0x80000000U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelCancel( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelCancel( &wheel, TEST_TIMER_COUNT ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelAdvance( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelPopExpired( NULL, &timer ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_TimerWheelPopExpired( &wheel, NULL ) );
+    TEST_ASSERT_EQUAL( 0U, wheel.pendingCount );
+}
+
+/**
+ * @brief Test arming, re-arming and cancelling timers, pending or expired.
+ */
+void test_FleetProvisioning_TimerWheel_ArmCancel( void )
+{
+    checkExpiry( 0U, 1U );
+    checkExpiry( 0U, 3U );
+
+    /* Re-arming replaces the previous expiry. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 1U, 2U ) );
+    checkExpiry( 1U, 5U );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 1U, 500U ) );
+    checkExpiry( 1U, 2U );
+
+    /* Cancelling a pending timer. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 2U, 2U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 3U, 2U ) );
+    TEST_ASSERT_EQUAL( 2U, wheel.pendingCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelCancel( &wheel, 3U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningNoMatch, FleetProvisioning_TimerWheelCancel( &wheel, 3U ) );
+    TEST_ASSERT_EQUAL( 1U, wheel.pendingCount );
+
+    /* Cancelling expired timers, at the end and at the start of the
+     * expired list. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 4U, 1U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 5U, 3U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, wheel.now + 3U ) );
+    TEST_ASSERT_EQUAL( 0U, wheel.pendingCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelCancel( &wheel, 5U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelCancel( &wheel, 4U ) );
+    checkPop( 2U );
+    checkPop( FP_TIMER_WHEEL_INVALID_TIMER );
+
+    /* A cancelled timer can be armed again. */
+    checkExpiry( 5U, 7U );
+}
+
+/**
+ * @brief Test that expired timers are returned in expiry order.
+ */
+void test_FleetProvisioning_TimerWheel_ExpiryOrder( void )
+{
+    static const uint32_t delays[ 5 ] = { 70U, 2U, 3U, 1U, 64U };
+
+    uint32_t i;
+
+    for( i = 0U; i < 5U; i++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, i, delays[ i ] ) );
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 100U ) );
+    checkPop( 3U );
+    checkPop( 1U );
+    checkPop( 2U );
+    checkPop( 4U );
+    checkPop( 0U );
+    checkPop( FP_TIMER_WHEEL_INVALID_TIMER );
+
+    /* Ticks from the past are ignored. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 50U ) );
+    TEST_ASSERT_EQUAL( 100U, wheel.now );
+}
+
+/**
+ * @brief Test that timers expire at their tick from every level of the
+ * wheel, and beyond its range.
+ */
+void test_FleetProvisioning_TimerWheel_Levels( void )
+{
+    uint32_t level;
+    uint32_t span;
+
+    for( level = 1U; level <= FP_TIMER_WHEEL_LEVELS; level++ )
+    {
+        span = ( uint32_t ) ( 1UL << ( FP_TIMER_WHEEL_SLOT_BITS * level ) );
+
+        /* The last tick of a level and the first of the next one, from an
+         * unaligned start. */
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, wheel.now + 37U ) );
+        checkExpiry( level, span - 1U );
+        checkExpiry( level, span );
+        checkExpiry( level, span + ( span / 2U ) + 3U );
+    }
+
+    /* Beyond the range, the timer waits in the top level more than once. */
+    checkExpiry( 0U, ( uint32_t ) ( ( 2UL * TEST_WHEEL_RANGE ) + 5U ) );
+}
+
+/**
+ * @brief Test that the ticks of the wheel wrap around.
+ */
+void test_FleetProvisioning_TimerWheel_Wrap( void )
+{
+    /* With no timer pending, the wheel jumps to the tick, up to 2^31 - 1
+     * ticks at once. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 0x80000000U ) );
+    TEST_ASSERT_EQUAL( 0U, wheel.now );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 0x7FFFFFF8U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 0xFFFFFFF0U ) );
+    TEST_ASSERT_EQUAL( 0xFFFFFFF0U, wheel.now );
+
+    checkExpiry( 0U, 0x20U );
+    TEST_ASSERT_EQUAL( 0x10U, wheel.now );
+
+    /* A tick more than 2^31 ticks ahead is from the past, also with a timer
+     * pending. */
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelArm( &wheel, 1U, 5U ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 0xFU ) );
+    TEST_ASSERT_EQUAL( 0x10U, wheel.now );
+    TEST_ASSERT_EQUAL( 1U, wheel.pendingCount );
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, 0x15U ) );
+    checkPop( 1U );
+}
+
+/**
+ * @brief Test that every one of many timers expires exactly at its tick.
+ */
+void test_FleetProvisioning_TimerWheel_Stress( void )
+{
+    uint32_t timer;
+    uint32_t tick;
+    uint32_t expiredCount = 0U;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                       FleetProvisioning_TimerWheelInit( &wheel, stressNodes, STRESS_TIMER_COUNT ) );
+
+    for( timer = 0U; timer < STRESS_TIMER_COUNT; timer++ )
+    {
+        stressExpiries[ timer ] = 1U + ( ( timer * 7919U ) % STRESS_MAX_DELAY );
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_TimerWheelArm( &wheel, timer, stressExpiries[ timer ] ) );
+    }
+
+    /* Cancel every tenth timer. */
+    for( timer = 0U; timer < STRESS_TIMER_COUNT; timer += 10U )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelCancel( &wheel, timer ) );
+        stressExpiries[ timer ] = 0U;
+    }
+
+    for( tick = 1U; tick <= STRESS_MAX_DELAY; tick++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_TimerWheelAdvance( &wheel, tick ) );
+
+        while( FleetProvisioning_TimerWheelPopExpired( &wheel, &timer ) == FleetProvisioningSuccess )
+        {
+            TEST_ASSERT_EQUAL( tick, stressExpiries[ timer ] );
+            expiredCount++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL( STRESS_TIMER_COUNT - ( STRESS_TIMER_COUNT / 10U ), expiredCount );
+    TEST_ASSERT_EQUAL( 0U, wheel.pendingCount );
+}
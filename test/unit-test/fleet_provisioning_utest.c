@@ -193,6 +193,8 @@ void test_FleetProvisioning_MatchTopic_RegisterThingJsonRejectedHappyPath( void
 void test_FleetProvisioning_MatchTopic_RegisterThingCborPublishHappyPath( void );
 void test_FleetProvisioning_MatchTopic_RegisterThingCborAcceptedHappyPath( void );
 void test_FleetProvisioning_MatchTopic_RegisterThingCborRejectedHappyPath( void );
+void test_FleetProvisioning_GetTopicInfo( void );
+void test_FleetProvisioning_HashFnv1a( void );
 
 /*-----------------------------------------------------------*/
 
@@ -938,3 +940,71 @@ void test_FleetProvisioning_MatchTopic_RegisterThingCborRejectedHappyPath( void
     TEST_ASSERT_EQUAL( FleetProvCborRegisterThingRejected, api );
 }
 /*-----------------------------------------------------------*/
+
+/**
+ * @brief Test that each topic maps to its format, API and kind, and that the
+ * matched topics round trip.
+ */
+void test_FleetProvisioning_GetTopicInfo( void )
+{
+    FleetProvisioningTopicInfo_t info;
+    FleetProvisioningTopic_t matched;
+    char topicBuffer[ TEST_REGISTER_CBOR_REJECTED_LENGTH ];
+    uint16_t topicLength;
+    int topic;
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_GetTopicInfo( FleetProvJsonCreateCertFromCsrPublish, &info ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningJson, info.format );
+    TEST_ASSERT_EQUAL( FleetProvisioningCreateCertFromCsrApi, info.api );
+    TEST_ASSERT_EQUAL( FleetProvisioningPublish, info.kind );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_GetTopicInfo( FleetProvCborCreateKeysAndCertAccepted, &info ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningCbor, info.format );
+    TEST_ASSERT_EQUAL( FleetProvisioningCreateKeysAndCertApi, info.api );
+    TEST_ASSERT_EQUAL( FleetProvisioningAccepted, info.kind );
+
+    TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_GetTopicInfo( FleetProvJsonRegisterThingRejected, &info ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningJson, info.format );
+    TEST_ASSERT_EQUAL( FleetProvisioningRegisterThingApi, info.api );
+    TEST_ASSERT_EQUAL( FleetProvisioningRejected, info.kind );
+
+    /* The RegisterThing topic built for the format and kind of each
+     * RegisterThing topic matches back to it. */
+    for( topic = ( int ) FleetProvJsonCreateCertFromCsrPublish; topic <= ( int ) FleetProvCborRegisterThingRejected; topic++ )
+    {
+        TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                           FleetProvisioning_GetTopicInfo( ( FleetProvisioningTopic_t ) topic, &info ) );
+
+        if( info.api == FleetProvisioningRegisterThingApi )
+        {
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess,
+                               FleetProvisioning_GetRegisterThingTopic( topicBuffer, ( uint16_t ) sizeof( topicBuffer ),
+                                                                        info.format, info.kind,
+                                                                        TEST_TEMPLATE_NAME, TEST_TEMPLATE_NAME_LENGTH,
+                                                                        &topicLength ) );
+            TEST_ASSERT_EQUAL( FleetProvisioningSuccess, FleetProvisioning_MatchTopic( topicBuffer, topicLength, &matched ) );
+            TEST_ASSERT_EQUAL( topic, matched );
+        }
+    }
+
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_GetTopicInfo( FleetProvisioningInvalidTopic, &info ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter,
+                       FleetProvisioning_GetTopicInfo( ( FleetProvisioningTopic_t ) ( FleetProvCborRegisterThingRejected + 1 ), &info ) );
+    TEST_ASSERT_EQUAL( FleetProvisioningBadParameter, FleetProvisioning_GetTopicInfo( FleetProvJsonRegisterThingPublish, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test the FNV-1a hash against published values, and that a hash
+ * continued over a second part equals the hash of the whole.
+ */
+void test_FleetProvisioning_HashFnv1a( void )
+{
+    TEST_ASSERT_EQUAL_HEX32( 0x811C9DC5U, FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, NULL, 0U ) );
+    TEST_ASSERT_EQUAL_HEX32( 0xE40C292CU, FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, "a", 1U ) );
+    TEST_ASSERT_EQUAL_HEX32( 0xBF9CF968U, FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, "foobar", 6U ) );
+    TEST_ASSERT_EQUAL_HEX32( 0xBF9CF968U,
+                             FleetProvisioning_HashFnv1a( FleetProvisioning_HashFnv1a( FP_FNV1A_OFFSET_BASIS, "foo", 3U ),
+                                                          "bar", 3U ) );
+}
+/*-----------------------------------------------------------*/
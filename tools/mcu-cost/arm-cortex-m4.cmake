@@ -0,0 +1,26 @@
+# Toolchain for the MCU cost report of test/mcu-cost on an Arm Cortex-M4,
+# with the GNU Arm Embedded toolchain. The workloads run under QEMU user
+# mode, with newlib semihosting for their files and output:
+#
+#   cmake -S test -B build-cortex-m4 -DMCU_COST=1 \
+#         -DCMAKE_TOOLCHAIN_FILE=tools/mcu-cost/arm-cortex-m4.cmake \
+#         -DMCU_COST_QEMU_PLUGIN=/path/to/qemu/build/tests/plugin/libinsn.so
+#   cmake --build build-cortex-m4 --target mcu_cost
+
+set( CMAKE_SYSTEM_NAME Generic )
+set( CMAKE_SYSTEM_PROCESSOR cortex-m4 )
+
+set( CMAKE_C_COMPILER arm-none-eabi-gcc )
+set( CMAKE_C_FLAGS_INIT "-mcpu=cortex-m4 -mthumb -mfloat-abi=soft" )
+set( CMAKE_EXE_LINKER_FLAGS_INIT "--specs=rdimon.specs" )
+
+# The compiler cannot link without the semihosting specs, so only compile in
+# its checks.
+set( CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY )
+
+set( CMAKE_CROSSCOMPILING_EMULATOR qemu-arm -cpu cortex-m4 )
+set( MCU_COST_SIZE arm-none-eabi-size )
+
+set( CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER )
+set( CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY )
+set( CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY )
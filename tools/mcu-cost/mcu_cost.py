@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: MIT
+
+import argparse
+import glob
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+
+DESCRIPTION = """Report the cost of the Fleet Provisioning library on a
+microcontroller target: the instructions retired per call of the topic
+functions, their worst-case stack depth, and the code and data size of the
+library, for each feature configuration built by test/mcu-cost. Run by the
+mcu_cost target of test/mcu-cost."""
+
+# Functions whose stack depth is reported.
+STACK_ROOTS = [
+    "FleetProvisioning_MatchTopic",
+    "FleetProvisioning_GetRegisterThingTopic",
+]
+
+# Workloads of fleet_provisioning_mcu_bench whose instructions are counted.
+WORKLOADS = [
+    ("MatchTopic valid", ["--match", "valid"]),
+    ("MatchTopic near-miss", ["--match", "near-miss"]),
+    ("MatchTopic foreign", ["--match", "foreign"]),
+    ("GetRegisterThingTopic", ["--register"]),
+]
+
+# Object of the topic functions in the library.
+TOPIC_OBJECT = "fleet_provisioning.c"
+
+# Topics in the corpus the workloads match.
+CORPUS_COUNT = 3000
+
+SECTION_GROUPS = [
+    ("text", re.compile(r"^\.text(\.|$)")),
+    ("rodata", re.compile(r"^\.s?rodata(\.|$)")),
+    ("data", re.compile(r"^\.s?data(\.|$)")),
+    ("bss", re.compile(r"^\.s?bss(\.|$)")),
+]
+
+
+def get_args():
+    """Parse arguments for the report."""
+    parser = argparse.ArgumentParser(description=DESCRIPTION)
+    parser.add_argument("--size", required=True,
+                        help="size tool of the target")
+    parser.add_argument("--corpus-generator", required=True,
+                        help="fleet_provisioning_corpus built for the target")
+    parser.add_argument("--emulator", default="",
+                        help="command running target programs, if any")
+    parser.add_argument("--qemu-plugin", default="",
+                        help="QEMU plugin counting instructions (libinsn.so)")
+    parser.add_argument("--valgrind", default="",
+                        help="valgrind, to count instructions natively")
+    parser.add_argument("--target", default="",
+                        help="target processor, for the report")
+    parser.add_argument("--optimization", default="",
+                        help="optimization flags, for the report")
+    parser.add_argument("--configuration", action="append", default=[],
+                        help="name of a feature configuration")
+    parser.add_argument("--library", action="append", default=[],
+                        help="library of the configuration")
+    parser.add_argument("--objects", action="append", default=[],
+                        help="object directory of the library")
+    parser.add_argument("--bench", action="append", default=[],
+                        help="fleet_provisioning_mcu_bench of the configuration")
+    parser.add_argument("--passes", type=int, default=20,
+                        help="passes over the workloads")
+    parser.add_argument("--output", required=True,
+                        help="path of the report, without extension")
+    args = parser.parse_args()
+    counts = {len(args.configuration), len(args.library),
+              len(args.objects), len(args.bench)}
+    if len(counts) != 1:
+        parser.error("each --configuration needs a --library, --objects and --bench")
+    return args
+
+
+def _run(command, **kwargs):
+    result = subprocess.run(command, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, text=True, check=False,
+                            **kwargs)
+    if result.returncode != 0:
+        sys.exit("%s failed:\n%s%s" % (" ".join(command), result.stdout,
+                                       result.stderr))
+    return result.stdout
+
+
+# ---------------------------------------------------------------------------
+# Size
+# ---------------------------------------------------------------------------
+
+
+def get_sizes(size_tool, library):
+    """Sum the sections of the library by group, for the whole library and
+    for the object of the topic functions. As the library is compiled with
+    -ffunction-sections, an application only links the functions it calls,
+    and the library total is an upper bound."""
+    total = {group: 0 for group, _ in SECTION_GROUPS}
+    topics = {group: 0 for group, _ in SECTION_GROUPS}
+    member = None
+    for line in _run([size_tool, "-A", library]).splitlines():
+        header = re.match(r"^(\S+)\s+\(ex ", line)
+        if header:
+            member = os.path.basename(header.group(1))
+            continue
+        fields = line.split()
+        if len(fields) < 2 or not fields[1].isdigit():
+            continue
+        for group, pattern in SECTION_GROUPS:
+            if pattern.match(fields[0]):
+                total[group] += int(fields[1])
+                if member is not None and member.startswith(TOPIC_OBJECT):
+                    topics[group] += int(fields[1])
+    return {"library": total, "topic_functions": topics}
+
+
+# ---------------------------------------------------------------------------
+# Stack
+# ---------------------------------------------------------------------------
+
+
+def _read_call_graph(objects):
+    """Read the call graphs GCC wrote with -fcallgraph-info=su. Returns the
+    frame of each function, None for functions outside the library, and the
+    callees of each function."""
+    frames = {}
+    callees = {}
+    node = re.compile(r'^node: \{ title: "([^"]+)" label: "([^"]*)"')
+    edge = re.compile(r'^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+    usage = re.compile(r"\\n(\d+) bytes \(([^)]*)\)")
+    for path in glob.glob(os.path.join(objects, "**", "*.ci"), recursive=True):
+        with open(path, encoding="utf-8") as handle:
+            for line in handle:
+                match = node.match(line)
+                if match:
+                    frame = usage.search(match.group(2))
+                    if frame:
+                        frames[match.group(1)] = (int(frame.group(1)),
+                                                  frame.group(2))
+                    else:
+                        frames.setdefault(match.group(1), None)
+                    continue
+                match = edge.match(line)
+                if match:
+                    callees.setdefault(match.group(1), set()).add(
+                        match.group(2))
+    return frames, callees
+
+
+def _worst_stack(function, frames, callees, path):
+    """Return the worst stack depth from a function, whether it is bounded,
+    and the functions outside the library it calls."""
+    frame = frames.get(function)
+    if frame is None:
+        return 0, True, {function.split(":")[-1]}
+    depth, qualifier = frame
+    bounded = qualifier in ("static", "dynamic,bounded")
+    external = set()
+    deepest = 0
+    for callee in sorted(callees.get(function, ())):
+        if callee in path:
+            bounded = False
+            continue
+        callee_depth, callee_bounded, callee_external = _worst_stack(
+            callee, frames, callees, path | {callee})
+        deepest = max(deepest, callee_depth)
+        bounded = bounded and callee_bounded
+        external |= callee_external
+    return depth + deepest, bounded, external
+
+
+def get_stacks(objects):
+    """Return the worst stack depth of each root function, or None without
+    call graphs."""
+    frames, callees = _read_call_graph(objects)
+    stacks = {}
+    for root in STACK_ROOTS:
+        if frames.get(root) is None:
+            stacks[root] = None
+            continue
+        depth, bounded, external = _worst_stack(root, frames, callees,
+                                                {root})
+        stacks[root] = {
+            "bytes": depth,
+            "bounded": bounded,
+            "external_calls": sorted(external),
+        }
+    return stacks
+
+
+# ---------------------------------------------------------------------------
+# Instructions
+# ---------------------------------------------------------------------------
+
+
+class InstructionCounter:
+    """Run target programs, under an emulator if cross compiled, and count
+    the instructions they retire when a counter is available."""
+
+    def __init__(self, args, scratch):
+        self.emulator = shlex.split(args.emulator)
+        self.scratch = scratch
+        if self.emulator and args.qemu_plugin:
+            self.kind = "qemu plugin"
+            self.plugin = args.qemu_plugin
+        elif not self.emulator and args.valgrind:
+            self.kind = "callgrind"
+            self.valgrind = args.valgrind
+        else:
+            self.kind = None
+
+    def run(self, command):
+        """Run a program. Returns its output and the instructions it
+        retired, or None."""
+        log = os.path.join(self.scratch, "instructions.log")
+        if self.kind == "qemu plugin":
+            output = _run(self.emulator + ["-plugin", self.plugin, "-d",
+                                           "plugin", "-D", log] + command)
+            with open(log, encoding="utf-8") as handle:
+                counts = re.findall(r"insns: (\d+)", handle.read())
+            return output, sum(int(count) for count in counts)
+        if self.kind == "callgrind":
+            output = _run([self.valgrind, "--tool=callgrind",
+                           "--callgrind-out-file=" + log] + command)
+            with open(log, encoding="utf-8") as handle:
+                totals = re.search(r"^(?:summary|totals): (\d+)",
+                                   handle.read(), re.MULTILINE)
+            return output, int(totals.group(1))
+        return _run(self.emulator + command), None
+
+
+def _calls(output):
+    match = re.search(r"^calls: (\d+)$", output, re.MULTILINE)
+    if not match:
+        sys.exit("Unexpected workload output:\n" + output)
+    return int(match.group(1))
+
+
+def get_instructions(counter, bench, corpus, passes):
+    """Return the instructions retired per call of each workload, or None
+    without a counter. The workloads run with N and 2N passes, and the
+    difference is taken, so that the startup and the loading of the corpus
+    are not counted."""
+    instructions = {}
+    for name, workload in WORKLOADS:
+        command = [bench] + workload
+        if "--match" in workload:
+            command += ["--corpus", corpus]
+        first, first_count = counter.run(command + ["--passes", str(passes)])
+        if counter.kind is None:
+            _calls(first)
+            instructions[name] = None
+            continue
+        second, second_count = counter.run(
+            command + ["--passes", str(2 * passes)])
+        calls = _calls(second) - _calls(first)
+        instructions[name] = round((second_count - first_count) / calls, 1)
+    return instructions
+
+
+# ---------------------------------------------------------------------------
+# Report
+# ---------------------------------------------------------------------------
+
+
+def _table(header, rows):
+    lines = ["| " + " | ".join(header) + " |",
+             "|" + "|".join(" --- " for _ in header) + "|"]
+    for row in rows:
+        lines.append("| " + " | ".join(row) + " |")
+    return "\n".join(lines) + "\n"
+
+
+def _stack_cell(stack):
+    if stack is None:
+        return "n/a"
+    cell = str(stack["bytes"])
+    if not stack["bounded"]:
+        cell += " (unbounded)"
+    if stack["external_calls"]:
+        cell += " + " + ", ".join(stack["external_calls"])
+    return cell
+
+
+def _instruction_cell(count):
+    return "n/a" if count is None else "%.1f" % count
+
+
+def render_markdown(report):
+    """Render the report as GitHub-flavored Markdown."""
+    text = ["# Fleet Provisioning MCU cost\n\n",
+            "Target: %s. Optimization: %s. Instructions counted with: %s.\n"
+            % (report["target"] or "host", report["optimization"] or "none",
+               report["instruction_counter"] or "n/a")]
+
+    text.append("\n## Size in bytes\n\n")
+    rows = []
+    for name, result in report["configurations"].items():
+        library = result["size"]["library"]
+        topics = result["size"]["topic_functions"]
+        rows.append([name] + [str(library[group]) for group, _ in SECTION_GROUPS]
+                    + [str(topics["text"]), str(topics["rodata"])])
+    text.append(_table(["Configuration", ".text", ".rodata", ".data", ".bss",
+                        TOPIC_OBJECT + " .text", TOPIC_OBJECT + " .rodata"],
+                       rows))
+
+    text.append("\n## Worst-case stack depth in bytes\n\n")
+    text.append("Calls outside the library, whose stack is not counted, "
+                "are listed after the depth.\n\n")
+    rows = []
+    for name, result in report["configurations"].items():
+        rows.append([name] + [_stack_cell(result["stack"][root])
+                              for root in STACK_ROOTS])
+    text.append(_table(["Configuration"] + STACK_ROOTS, rows))
+
+    text.append("\n## Instructions retired per call\n\n")
+    rows = []
+    for name, result in report["configurations"].items():
+        rows.append([name] + [_instruction_cell(result["instructions"][workload])
+                              for workload, _ in WORKLOADS])
+    text.append(_table(["Configuration"] + [workload for workload, _ in WORKLOADS],
+                       rows))
+    return "".join(text)
+
+
+def main():
+    args = get_args()
+    with tempfile.TemporaryDirectory() as scratch:
+        counter = InstructionCounter(args, scratch)
+        corpus = os.path.join(scratch, "topics.corpus")
+        _run(counter.emulator + [args.corpus_generator, "--count",
+                                 str(CORPUS_COUNT), "--seed", "1",
+                                 "--output", corpus])
+
+        report = {
+            "target": args.target,
+            "optimization": args.optimization,
+            "instruction_counter": counter.kind,
+            "configurations": {},
+        }
+        for name, library, objects, bench in zip(
+                args.configuration, args.library, args.objects, args.bench):
+            report["configurations"][name] = {
+                "size": get_sizes(args.size, library),
+                "stack": get_stacks(objects),
+                "instructions": get_instructions(counter, bench, corpus,
+                                                 args.passes),
+            }
+
+    markdown = render_markdown(report)
+    with open(args.output + ".md", "w", encoding="utf-8") as handle:
+        handle.write(markdown)
+    with open(args.output + ".json", "w", encoding="utf-8") as handle:
+        json.dump(report, handle, indent=2)
+        handle.write("\n")
+    print(markdown)
+
+
+if __name__ == "__main__":
+    main()
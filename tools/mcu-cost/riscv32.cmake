@@ -0,0 +1,32 @@
+# Toolchain for the MCU cost report of test/mcu-cost on a 32-bit RISC-V
+# microcontroller core, with a GNU RISC-V bare-metal toolchain built with
+# multilib. The workloads run under QEMU user mode, which serves the system
+# calls of libgloss:
+#
+#   cmake -S test -B build-riscv32 -DMCU_COST=1 \
+#         -DCMAKE_TOOLCHAIN_FILE=tools/mcu-cost/riscv32.cmake \
+#         -DMCU_COST_QEMU_PLUGIN=/path/to/qemu/build/tests/plugin/libinsn.so
+#   cmake --build build-riscv32 --target mcu_cost
+#
+# Set RISCV_TOOLCHAIN_PREFIX for toolchains with another prefix, such as
+# riscv32-unknown-elf-.
+
+set( CMAKE_SYSTEM_NAME Generic )
+set( CMAKE_SYSTEM_PROCESSOR rv32imac )
+
+if( NOT DEFINED RISCV_TOOLCHAIN_PREFIX )
+    set( RISCV_TOOLCHAIN_PREFIX riscv64-unknown-elf- )
+endif()
+
+# Pass the prefix on to the compiler checks.
+list( APPEND CMAKE_TRY_COMPILE_PLATFORM_VARIABLES RISCV_TOOLCHAIN_PREFIX )
+
+set( CMAKE_C_COMPILER ${RISCV_TOOLCHAIN_PREFIX}gcc )
+set( CMAKE_C_FLAGS_INIT "-march=rv32imac -mabi=ilp32 -mcmodel=medlow" )
+
+set( CMAKE_CROSSCOMPILING_EMULATOR qemu-riscv32 )
+set( MCU_COST_SIZE ${RISCV_TOOLCHAIN_PREFIX}size )
+
+set( CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER )
+set( CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY )
+set( CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY )